@@ -800,9 +800,11 @@ sub close_function($)
 
 sub process_changelog($)
 {
-	my $table_type = shift;
+	my ($table_type, $flags) = split(/\|/, shift);
 
-	if ($delete_cascade)
+	# deletes made by cascading foreign keys are not recorded on all databases, such changelog
+	# can be used only to detect changes and must be explicitly allowed with CASCADE flag
+	if ($delete_cascade && (!defined($flags) || $flags ne "CASCADE"))
 	{
 		die("table '$table_name' foreign keys without RESTRICT flag are not compatible with table CHANGELOG token");
 	}
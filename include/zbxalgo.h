@@ -181,6 +181,63 @@ void	*zbx_hashset_iter_next(zbx_hashset_iter_t *iter);
 void	zbx_hashset_iter_remove(zbx_hashset_iter_t *iter);
 void	zbx_hashset_copy(zbx_hashset_t *dst, const zbx_hashset_t *src, size_t size);
 
+/* flatset */
+
+/* open addressing hashset of entries starting with zbx_uint64_t identifier, */
+/* the identifiers are kept in slot array next to the entry pointers so      */
+/* that lookups do not dereference entries until the match is found          */
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	void		*data;
+}
+zbx_flatset_slot_t;
+
+typedef struct
+{
+	unsigned char		*ctrl;		/* slot control bytes, probed in groups of ZBX_FLATSET_GROUP_SIZE */
+	zbx_flatset_slot_t	*slots;
+	int			num_slots;
+	int			num_data;
+	int			num_deleted;
+	zbx_clean_func_t	clean_func;
+	zbx_mem_malloc_func_t	mem_malloc_func;
+	zbx_mem_realloc_func_t	mem_realloc_func;
+	zbx_mem_free_func_t	mem_free_func;
+}
+zbx_flatset_t;
+
+#define ZBX_FLATSET_GROUP_SIZE	16
+
+void	zbx_flatset_create(zbx_flatset_t *fs, size_t init_size);
+void	zbx_flatset_create_ext(zbx_flatset_t *fs, size_t init_size,
+				zbx_clean_func_t clean_func,
+				zbx_mem_malloc_func_t mem_malloc_func,
+				zbx_mem_realloc_func_t mem_realloc_func,
+				zbx_mem_free_func_t mem_free_func);
+void	zbx_flatset_destroy(zbx_flatset_t *fs);
+
+int	zbx_flatset_reserve(zbx_flatset_t *fs, int num_data_req);
+void	*zbx_flatset_insert(zbx_flatset_t *fs, const void *data, size_t size);
+void	*zbx_flatset_insert_ext(zbx_flatset_t *fs, const void *data, size_t size, size_t offset);
+void	*zbx_flatset_search(const zbx_flatset_t *fs, const void *data);
+void	zbx_flatset_remove(zbx_flatset_t *fs, const void *data);
+void	zbx_flatset_remove_direct(zbx_flatset_t *fs, const void *data);
+
+void	zbx_flatset_clear(zbx_flatset_t *fs);
+
+typedef struct
+{
+	zbx_flatset_t	*flatset;
+	int		slot;
+}
+zbx_flatset_iter_t;
+
+void	zbx_flatset_iter_reset(zbx_flatset_t *fs, zbx_flatset_iter_t *iter);
+void	*zbx_flatset_iter_next(zbx_flatset_iter_t *iter);
+void	zbx_flatset_iter_remove(zbx_flatset_iter_t *iter);
+
 /* hashmap */
 
 /* currently, we only have a very specialized hashmap */
@@ -281,6 +338,58 @@ void			zbx_binary_heap_remove_direct(zbx_binary_heap_t *heap, zbx_uint64_t key);
 
 void			zbx_binary_heap_clear(zbx_binary_heap_t *heap);
 
+/* hierarchical timing wheel */
+
+/* Nodes are embedded into the scheduled objects, so insert and remove are O(1) and do not  */
+/* allocate memory. The wheel has 1 second resolution - root level holds nodes expiring in */
+/* the next 256 seconds, upper levels cover ~4.5 hours, ~12 days and ~2 years. Expired     */
+/* nodes are moved to the expired list, sorted by the compare function one second at a    */
+/* time, so the expired list is ordered in the same way as binary heap would be.           */
+
+#define ZBX_TIMING_WHEEL_ROOT_BITS	8
+#define ZBX_TIMING_WHEEL_ROOT_SIZE	(1 << ZBX_TIMING_WHEEL_ROOT_BITS)
+#define ZBX_TIMING_WHEEL_LEVEL_BITS	6
+#define ZBX_TIMING_WHEEL_LEVEL_SIZE	(1 << ZBX_TIMING_WHEEL_LEVEL_BITS)
+#define ZBX_TIMING_WHEEL_LEVELS		3
+
+typedef struct zbx_timing_wheel_node
+{
+	/* must be the first member, see zbx_timing_wheel_remove() */
+	struct zbx_timing_wheel_node	*next;
+	struct zbx_timing_wheel_node	**pprev;
+	const void			*data;
+	int				expires;
+}
+zbx_timing_wheel_node_t;
+
+typedef struct
+{
+	zbx_timing_wheel_node_t		*root[ZBX_TIMING_WHEEL_ROOT_SIZE];
+	zbx_timing_wheel_node_t		*levels[ZBX_TIMING_WHEEL_LEVELS][ZBX_TIMING_WHEEL_LEVEL_SIZE];
+	zbx_timing_wheel_node_t		*expired;
+	zbx_timing_wheel_node_t		*expired_tail;
+	int				now;		/* the next second to be expired */
+	int				nodes_num;
+	int				expired_num;
+	zbx_compare_func_t		compare_func;	/* compares nodes expiring at the same second, */
+							/* can be NULL if their order is not important */
+}
+zbx_timing_wheel_t;
+
+void			zbx_timing_wheel_create(zbx_timing_wheel_t *wheel, int now, zbx_compare_func_t compare_func);
+void			zbx_timing_wheel_destroy(zbx_timing_wheel_t *wheel);
+void			zbx_timing_wheel_clear(zbx_timing_wheel_t *wheel);
+
+void			zbx_timing_wheel_insert(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t *node,
+				int expires);
+void			zbx_timing_wheel_remove(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t *node);
+void			zbx_timing_wheel_update(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t *node,
+				int expires);
+
+int			zbx_timing_wheel_advance(zbx_timing_wheel_t *wheel, int now);
+zbx_timing_wheel_node_t	*zbx_timing_wheel_first_expired(const zbx_timing_wheel_t *wheel);
+int			zbx_timing_wheel_next_expiry(const zbx_timing_wheel_t *wheel);
+
 /* vector implementation start */
 
 #define ZBX_VECTOR_DECL(__id, __type)										\
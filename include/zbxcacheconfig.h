@@ -156,36 +156,35 @@ typedef struct
 	unsigned char		verify_peer;
 	unsigned char		verify_host;
 	unsigned char		allow_traps;
-	char			key_orig[ZBX_ITEM_KEY_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1], *key;
+	char			*key_orig, *key;
 	char			*delay;
 	int			mtime;
-	char			trapper_hosts[ZBX_ITEM_TRAPPER_HOSTS_LEN_MAX];
-	char			logtimefmt[ZBX_ITEM_LOGTIMEFMT_LEN_MAX];
-	char			snmp_community_orig[ZBX_ITEM_SNMP_COMMUNITY_LEN_MAX], *snmp_community;
-	char			snmp_oid_orig[ZBX_ITEM_SNMP_OID_LEN_MAX], *snmp_oid;
-	char			snmpv3_securityname_orig[ZBX_ITEM_SNMPV3_SECURITYNAME_LEN_MAX], *snmpv3_securityname;
-	char			snmpv3_authpassphrase_orig[ZBX_ITEM_SNMPV3_AUTHPASSPHRASE_LEN_MAX],
-				*snmpv3_authpassphrase;
-	char			snmpv3_privpassphrase_orig[ZBX_ITEM_SNMPV3_PRIVPASSPHRASE_LEN_MAX],
-				*snmpv3_privpassphrase;
-	char			ipmi_sensor[ZBX_ITEM_IPMI_SENSOR_LEN_MAX];
+	/* type specific strings are copied from configuration cache only for the item type using them, */
+	/* macros are expanded in place by the caller                                                    */
+	char			*logtimefmt;
+	char			*snmp_community;
+	char			*snmp_oid;
+	char			*snmpv3_securityname;
+	char			*snmpv3_authpassphrase;
+	char			*snmpv3_privpassphrase;
+	char			*snmpv3_contextname;
+	char			*ipmi_sensor;
 	char			*params;
-	char			username_orig[ZBX_ITEM_USERNAME_LEN_MAX], *username;
-	char			publickey_orig[ZBX_ITEM_PUBLICKEY_LEN_MAX], *publickey;
-	char			privatekey_orig[ZBX_ITEM_PRIVATEKEY_LEN_MAX], *privatekey;
-	char			password_orig[ZBX_ITEM_PASSWORD_LEN_MAX], *password;
-	char			snmpv3_contextname_orig[ZBX_ITEM_SNMPV3_CONTEXTNAME_LEN_MAX], *snmpv3_contextname;
-	char			jmx_endpoint_orig[ZBX_ITEM_JMX_ENDPOINT_LEN_MAX], *jmx_endpoint;
-	char			timeout_orig[ZBX_ITEM_TIMEOUT_LEN_MAX], *timeout;
-	char			url_orig[ZBX_ITEM_URL_LEN_MAX], *url;
-	char			query_fields_orig[ZBX_ITEM_QUERY_FIELDS_LEN_MAX], *query_fields;
+	char			*username;
+	char			*publickey;
+	char			*privatekey;
+	char			*password;
+	char			*jmx_endpoint;
+	char			*timeout;
+	char			*url;
+	char			*query_fields;
 	char			*posts;
-	char			status_codes_orig[ZBX_ITEM_STATUS_CODES_LEN_MAX], *status_codes;
-	char			http_proxy_orig[ZBX_ITEM_HTTP_PROXY_LEN_MAX], *http_proxy;
+	char			*status_codes;
+	char			*http_proxy;
 	char			*headers;
-	char			ssl_cert_file_orig[ZBX_ITEM_SSL_CERT_FILE_LEN_MAX], *ssl_cert_file;
-	char			ssl_key_file_orig[ZBX_ITEM_SSL_KEY_FILE_LEN_MAX], *ssl_key_file;
-	char			ssl_key_password_orig[ZBX_ITEM_SSL_KEY_PASSWORD_LEN_MAX], *ssl_key_password;
+	char			*ssl_cert_file;
+	char			*ssl_key_file;
+	char			*ssl_key_password;
 	char			*script_params;
 	char			*error;
 	unsigned char		*formula_bin;
@@ -644,6 +643,10 @@ void	DCsync_configuration(unsigned char mode, zbx_synced_new_config_t synced, zb
 void	DCsync_kvs_paths(const struct zbx_json_parse *jp_kvs_paths, const zbx_config_vault_t *config_vault);
 int	init_configuration_cache(char **error);
 void	free_configuration_cache(void);
+void	zbx_dc_set_lock_wait_process(unsigned char process_type, int process_num);
+double	zbx_dc_get_lock_wait(unsigned char process_type);
+int	zbx_dc_config_load_snapshot(const char *filename, const char *source);
+void	zbx_dc_config_save_snapshot(void);
 
 void	DCconfig_get_triggers_by_triggerids(DC_TRIGGER *triggers, const zbx_uint64_t *triggerids, int *errcode,
 		size_t num);
@@ -834,6 +837,26 @@ void	zbx_dc_get_hostids_by_group_name(const char *name, zbx_vector_uint64_t *hos
 #define ZBX_DC_FLAG_NOHISTORY	0x10	/* values should not be kept in history */
 #define ZBX_DC_FLAG_NOTRENDS	0x20	/* values should not be kept in trends */
 
+/* numeric value without metadata, packed into history cache data */
+typedef struct
+{
+	zbx_timespec_t		ts;
+	zbx_history_value_t	value;
+}
+zbx_hc_packed_value_t;
+
+/* numeric values of the same type and flags received after history cache data value */
+typedef struct
+{
+	int			first;	/* the index of the oldest unprocessed value */
+	int			num;
+	int			alloc;
+	unsigned char		value_type;
+	unsigned char		flags;
+	zbx_hc_packed_value_t	*values;
+}
+zbx_hc_packed_t;
+
 typedef struct zbx_hc_data
 {
 	zbx_history_value_t	value;
@@ -844,6 +867,9 @@ typedef struct zbx_hc_data
 	unsigned char		flags;
 	unsigned char		state;
 
+	/* the values queued after this value and before the next data, NULL if none */
+	zbx_hc_packed_t		*packed;
+
 	struct zbx_hc_data	*next;
 }
 zbx_hc_data_t;
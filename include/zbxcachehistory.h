@@ -29,6 +29,9 @@
 extern zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE;
 extern zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE;
 extern zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE;
+extern char		*CONFIG_HISTORY_SPILL_FILE;
+extern zbx_uint64_t	CONFIG_HISTORY_SPILL_SIZE;
+extern int		CONFIG_TRENDS_FLUSH_SPREAD;
 
 typedef struct
 {
@@ -55,6 +58,15 @@ typedef struct
 }
 zbx_wcache_info_t;
 
+/* history synchronization stages, the order matches ZBX_STATS_SYNC_* requests */
+#define ZBX_HC_SYNC_STAGE_ITEMS		0
+#define ZBX_HC_SYNC_STAGE_HISTORY	1
+#define ZBX_HC_SYNC_STAGE_TRENDS	2
+#define ZBX_HC_SYNC_STAGE_TRIGGERS	3
+#define ZBX_HC_SYNC_STAGE_EVENTS	4
+#define ZBX_HC_SYNC_STAGE_COMMIT	5
+#define ZBX_HC_SYNC_STAGE_COUNT		6
+
 void	zbx_sync_history_cache(int *values_num, int *triggers_num, int *more);
 void	zbx_log_sync_history_cache_progress(void);
 
@@ -90,6 +102,18 @@ int	get_proxy_history_count(void);
 #define ZBX_STATS_HISTORY_INDEX_FREE	19
 #define ZBX_STATS_HISTORY_INDEX_PUSED	20
 #define ZBX_STATS_HISTORY_INDEX_PFREE	21
+#define ZBX_STATS_SPILL_VALUES		22
+#define ZBX_STATS_SPILL_TOTAL		23
+#define ZBX_STATS_SPILL_USED		24
+#define ZBX_STATS_SPILL_FREE		25
+#define ZBX_STATS_SPILL_PUSED		26
+#define ZBX_STATS_SYNC_ITEMS		27
+#define ZBX_STATS_SYNC_HISTORY		28
+#define ZBX_STATS_SYNC_TRENDS		29
+#define ZBX_STATS_SYNC_TRIGGERS		30
+#define ZBX_STATS_SYNC_EVENTS		31
+#define ZBX_STATS_SYNC_COMMIT		32
+#define ZBX_STATS_SYNC_BATCHES		33
 void	*DCget_stats(int request);
 void	DCget_stats_all(zbx_wcache_info_t *wcache_info);
 
@@ -100,6 +124,7 @@ void	DCupdate_interfaces_availability(void);
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num);
 void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index);
 void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items);
+void	zbx_hc_get_sync_stats(double *stage_time, zbx_uint64_t *batches_num);
 
 int	zbx_db_trigger_queue_locked(void);
 void	zbx_db_trigger_queue_unlock(void);
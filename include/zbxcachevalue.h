@@ -50,11 +50,18 @@
  *   either zbx_history_record_vector_destroy() function (free the zbx_vc_get_values()
  *   call output) or zbx_history_record_clear() function (free the zbx_vc_get_value() call output).
  *
+ *   Sum, count, minimum and maximum of numeric item values over time period can be retrieved
+ *   with zbx_vc_get_aggregate() function. The aggregates are maintained incrementally as new
+ *   values are added, so the function fails until the aggregate for the requested period is
+ *   created (after the next zbx_vc_flush_stats() call) and the caller must fall back to
+ *   zbx_vc_get_values().
+ *
  * Locking
  *
  *   The cache ensures synchronization between processes by using automatic locks whenever
- *   a cache function (zbx_vc_*) is called and by providing manual cache locking functionality
- *   with zbx_vc_lock()/zbx_vc_unlock() functions.
+ *   a cache function (zbx_vc_*) is called. The cache is partitioned by itemid into shards
+ *   with separate memory, statistics and read-write locks, so requests for items in
+ *   different shards do not block each other.
  *
  */
 
@@ -92,10 +99,66 @@ typedef struct
 }
 zbx_vc_item_stats_t;
 
+/* admission/eviction policy diagnostic statistics */
+typedef struct
+{
+	/* the number of items and cache hits in probation and protected segments */
+	zbx_uint64_t	items_probation;
+	zbx_uint64_t	items_protected;
+	zbx_uint64_t	hits_probation;
+	zbx_uint64_t	hits_protected;
+
+	/* the number of cache misses */
+	zbx_uint64_t	misses;
+
+	/* the number of items removed to free space for other items */
+	zbx_uint64_t	evictions;
+
+	/* the number of space requests refused by admission policy */
+	zbx_uint64_t	admissions_rejected;
+}
+zbx_vc_policy_stats_t;
+
+/* sliding window aggregates for zbx_vc_get_aggregate() */
+#define ZBX_VC_AGGREGATE_MIN	0x01
+#define ZBX_VC_AGGREGATE_MAX	0x02
+
+/* the item value aggregates over time period */
+typedef struct
+{
+	/* the number of values in period */
+	int			count;
+
+	/* the sum of values - sum_ui64 is set only for unsigned items */
+	zbx_uint64_t		sum_ui64;
+	double			sum_dbl;
+
+	/* the minimum/maximum value, set if requested and period is not empty */
+	zbx_history_value_t	min;
+	zbx_history_value_t	max;
+}
+zbx_vc_aggregate_t;
+
+/* the item values request, used to prefetch values of multiple items */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	unsigned char	value_type;
+	int		seconds;
+	zbx_timespec_t	ts;
+}
+zbx_vc_request_t;
+
+ZBX_VECTOR_DECL(vc_request, zbx_vc_request_t)
+
 int	zbx_vc_init(char **error);
 
 void	zbx_vc_destroy(void);
 
+int	zbx_vc_load_snapshot(const char *filename, const char *source);
+
+void	zbx_vc_save_snapshot(const char *filename, const char *source);
+
 void	zbx_vc_reset(void);
 
 void	zbx_vc_enable(void);
@@ -105,10 +168,16 @@ void	zbx_vc_disable(void);
 int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
 		int seconds, int count, const zbx_timespec_t *ts);
 
+void	zbx_vc_prefetch_values(const zbx_vector_vc_request_t *requests);
+
 int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
 		zbx_history_record_t *value);
 
 int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush);
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, unsigned char value_type, int seconds, const zbx_timespec_t *ts,
+		unsigned char flags, zbx_vc_aggregate_t *aggregate);
+int	zbx_vc_get_percentile(zbx_uint64_t itemid, unsigned char value_type, int seconds, const zbx_timespec_t *ts,
+		double percentage, zbx_history_value_t *value);
 
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats);
 
@@ -116,6 +185,7 @@ void	zbx_vc_remove_items_by_ids(zbx_vector_uint64_t *itemids);
 
 void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, int *mode);
 void	zbx_vc_get_mem_stats(zbx_shmem_stats_t *mem);
+void	zbx_vc_get_policy_stats(zbx_vc_policy_stats_t *stats);
 void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats);
 void	zbx_vc_flush_stats(void);
 
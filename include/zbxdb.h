@@ -69,6 +69,7 @@ void	zbx_db_close_basic(void);
 int	zbx_db_begin_basic(void);
 int	zbx_db_commit_basic(void);
 int	zbx_db_rollback_basic(void);
+void	zbx_db_pipeline_begin_basic(void);
 int	zbx_db_txn_level(void);
 int	zbx_db_txn_error(void);
 int	zbx_db_txn_end_error(void);
@@ -119,6 +120,9 @@ void		zbx_db_clean_bind_context(zbx_db_bind_context_t *context);
 int		zbx_db_statement_execute(int iters);
 #endif
 int		zbx_db_vexecute(const char *fmt, va_list args);
+#if defined(HAVE_POSTGRESQL)
+int		zbx_db_copy_basic(const char *sql, const char *data, size_t size);
+#endif
 DB_RESULT	zbx_db_vselect(const char *fmt, va_list args);
 DB_RESULT	zbx_db_select_n_basic(const char *query, int n);
 
@@ -511,6 +511,7 @@ void		zbx_db_begin(void);
 int		zbx_db_commit(void);
 void		zbx_db_rollback(void);
 int		zbx_db_end(int ret);
+void		zbx_db_pipeline_begin(void);
 
 const ZBX_TABLE	*zbx_db_get_table(const char *tablename);
 const ZBX_FIELD	*zbx_db_get_field(const ZBX_TABLE *table, const char *fieldname);
@@ -662,6 +663,8 @@ typedef struct
 	zbx_vector_ptr_t	rows;
 	/* index of autoincrement field */
 	int			autoincrement;
+	/* use COPY instead of INSERT statements when supported by database */
+	unsigned char		copy;
 }
 zbx_db_insert_t;
 
@@ -673,6 +676,7 @@ void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...);
 int	zbx_db_insert_execute(zbx_db_insert_t *self);
 void	zbx_db_insert_clean(zbx_db_insert_t *self);
 void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name);
+void	zbx_db_insert_enable_copy(zbx_db_insert_t *self);
 int	zbx_db_get_database_type(void);
 
 typedef struct
@@ -60,6 +60,22 @@ int	zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush);
 int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
 
+/* the item history period, used to read values of multiple items at once */
+typedef struct
+{
+	zbx_uint64_t			itemid;
+
+	/* the ]start,end] period */
+	int				start;
+	int				end;
+
+	/* the item values, not sorted */
+	zbx_vector_history_record_t	values;
+}
+zbx_history_range_t;
+
+int	zbx_history_get_values_multi(int value_type, zbx_history_range_t *ranges, int ranges_num);
+
 int	zbx_history_requires_trends(int value_type);
 void	zbx_history_check_version(struct zbx_json *json, int *result);
 
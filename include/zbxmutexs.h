@@ -35,6 +35,12 @@ typedef HANDLE zbx_mutex_t;
 #	define zbx_mutex_lock(mutex)		__zbx_mutex_lock(__FILE__, __LINE__, mutex)
 #	define zbx_mutex_unlock(mutex)		__zbx_mutex_unlock(__FILE__, __LINE__, mutex)
 #else	/* not _WINDOWS */
+/* the number of history cache shard mutexes */
+#define ZBX_MUTEX_CACHE_SHARDS	8
+
+/* the number of value cache shard read-write locks */
+#define ZBX_RWLOCK_VALUECACHE_SHARDS	8
+
 typedef enum
 {
 	ZBX_MUTEX_LOG = 0,
@@ -54,6 +60,9 @@ typedef enum
 #endif
 	ZBX_MUTEX_MODBUS,
 	ZBX_MUTEX_TREND_FUNC,
+	ZBX_MUTEX_CACHE_SPILL,
+	ZBX_MUTEX_CACHE_SHARD,
+	ZBX_MUTEX_CACHE_SHARD_LAST = ZBX_MUTEX_CACHE_SHARD + ZBX_MUTEX_CACHE_SHARDS - 1,
 	/* NOTE: Do not forget to sync changes here with mutex names in diag_add_locks_info()! */
 	ZBX_MUTEX_COUNT
 }
@@ -64,6 +73,7 @@ typedef enum
 	ZBX_RWLOCK_CONFIG = 0,
 	ZBX_RWLOCK_CONFIG_HISTORY,
 	ZBX_RWLOCK_VALUECACHE,
+	ZBX_RWLOCK_VALUECACHE_LAST = ZBX_RWLOCK_VALUECACHE + ZBX_RWLOCK_VALUECACHE_SHARDS - 1,
 	ZBX_RWLOCK_COUNT,
 }
 zbx_rwlock_name_t;
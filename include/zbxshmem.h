@@ -28,6 +28,24 @@
 #define SHMEM_MAX_BUCKET_SIZE		256 /* starting from this size all free chunks are put into the same bucket */
 #define ZBX_SHMEM_BUCKET_COUNT		((SHMEM_MAX_BUCKET_SIZE - ZBX_SHMEM_MIN_BUCKET_SIZE) / 8 + 1)
 
+/* zbx_shmem_create() flags */
+#define ZBX_SHMEM_FLAG_SLABS		0x01	/* serve small allocations from size class slabs */
+
+#define ZBX_SHMEM_SLAB_CLASS_COUNT	14
+
+/* shared memory page backing */
+#define ZBX_SHMEM_PAGES_NORMAL		0
+#define ZBX_SHMEM_PAGES_HUGE		1
+
+/* shared memory NUMA memory policy */
+#define ZBX_SHMEM_NUMA_DEFAULT		0
+#define ZBX_SHMEM_NUMA_INTERLEAVE	1
+#define ZBX_SHMEM_NUMA_BIND		2
+
+#define ZBX_SHMEM_NUMA_NODES_MAX	1024
+
+typedef struct zbx_shmem_slab_class zbx_shmem_slab_class_t;
+
 typedef struct
 {
 	void		*base;
@@ -47,9 +65,38 @@ typedef struct
 
 	const char	*mem_descr;
 	const char	*mem_param;
+
+	/* Size class slabs (ZBX_SHMEM_FLAG_SLABS). Slabs are carved from the top of */
+	/* chunk area, so they occupy [hi_bound, slab_hi) and hi_bound moves down.   */
+	zbx_shmem_slab_class_t	*slab_classes;
+	void			*slab_empty;
+	void			*slab_hi;
+	zbx_uint64_t		slab_overhead;
+
+	/* page backing and NUMA policy the segment actually got, which can differ */
+	/* from the configured ones when huge pages or NUMA are not available       */
+	int			pages;
+	int			numa_policy;
+	zbx_uint64_t		page_size;
 }
 zbx_shmem_info_t;
 
+typedef struct
+{
+	int		policy;
+	unsigned long	nodes[ZBX_SHMEM_NUMA_NODES_MAX / (8 * sizeof(unsigned long))];
+}
+zbx_shmem_numa_t;
+
+typedef struct
+{
+	zbx_uint64_t	size;
+	unsigned int	slabs_num;
+	unsigned int	used_objects;
+	unsigned int	free_objects;
+}
+zbx_shmem_slab_stats_t;
+
 typedef struct
 {
 	zbx_uint64_t	free_size;
@@ -60,11 +107,16 @@ typedef struct
 	unsigned int	chunks_num[ZBX_SHMEM_BUCKET_COUNT];
 	unsigned int	free_chunks;
 	unsigned int	used_chunks;
+
+	/* size class slab occupancy, slab_classes_num is 0 when slabs are not enabled */
+	unsigned int		slab_classes_num;
+	unsigned int		empty_slabs;
+	zbx_shmem_slab_stats_t	slabs[ZBX_SHMEM_SLAB_CLASS_COUNT];
 }
 zbx_shmem_stats_t;
 
 int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
-		int allow_oom, char **error);
+		int allow_oom, int flags, char **error);
 void	zbx_shmem_destroy(zbx_shmem_info_t *info);
 
 #define	zbx_shmem_malloc(info, old, size) __zbx_shmem_malloc(__FILE__, __LINE__, info, old, size)
@@ -85,8 +137,15 @@ void	__zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *
 void	zbx_shmem_clear(zbx_shmem_info_t *info);
 
 void	zbx_shmem_get_stats(const zbx_shmem_info_t *info, zbx_shmem_stats_t *stats);
+void	zbx_shmem_add_stats(zbx_shmem_stats_t *total, const zbx_shmem_stats_t *stats);
 void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info);
 
+int		zbx_shmem_parse_numa_policy(const char *str, zbx_shmem_numa_t *numa, char **error);
+int		zbx_shmem_set_placement(const char *param, int huge_pages, const char *numa_policy, char **error);
+int		zbx_shmem_get_placement(const char *param, int segment, int *pages, int *numa_policy);
+const char	*zbx_shmem_pages_string(int pages);
+const char	*zbx_shmem_numa_policy_string(int numa_policy);
+
 size_t		zbx_shmem_required_size(int chunks_num, const char *descr, const char *param);
 zbx_uint64_t	zbx_shmem_required_chunk_size(zbx_uint64_t size);
 
@@ -0,0 +1,490 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxalgo.h"
+
+#include "zbxcommon.h"
+#include "log.h"
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Slots are split into groups of ZBX_FLATSET_GROUP_SIZE. Each slot has a     *
+ * control byte that is either FLATSET_EMPTY, FLATSET_DELETED or, for used    *
+ * slots, the 7 high bits of identifier hash. Lookup probes groups starting   *
+ * from the one selected by the low hash bits, matching control bytes of the  *
+ * whole group at once and comparing identifiers only for the candidates.     *
+ * Probing stops at the first group having an empty slot.                     *
+ *                                                                            *
+ * Entries are allocated separately, so the pointers returned to user stay    *
+ * valid until the entry is removed.                                          *
+ *                                                                            *
+ ******************************************************************************/
+
+#define FLATSET_EMPTY		0x80
+#define FLATSET_DELETED		0xfe
+
+#define FLATSET_IS_USED(ctrl)	(0 == ((ctrl) & 0x80))
+
+/* maximum load factor 7/8 */
+#define FLATSET_MAX_DATA(num_slots)	((num_slots) - (num_slots) / 8)
+
+#define	ITER_START	(-1)
+#define	ITER_FINISH	(-2)
+
+static zbx_hash_t	flatset_hash(zbx_uint64_t id)
+{
+	return zbx_hash_splittable64(&id);
+}
+
+static unsigned char	flatset_h2(zbx_hash_t hash)
+{
+	return (unsigned char)(hash >> 25);
+}
+
+static int	flatset_group(const zbx_flatset_t *fs, zbx_hash_t hash)
+{
+	return (int)(hash & (zbx_hash_t)(fs->num_slots / ZBX_FLATSET_GROUP_SIZE - 1)) * ZBX_FLATSET_GROUP_SIZE;
+}
+
+static int	flatset_next_group(const zbx_flatset_t *fs, int group, int probe)
+{
+	return (group + probe * ZBX_FLATSET_GROUP_SIZE) & (fs->num_slots - 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get bitmask of group slots having the specified control byte      *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned int	flatset_group_match(const unsigned char *ctrl, unsigned char value)
+{
+#if defined(__SSE2__)
+	__m128i	group = _mm_loadu_si128((const __m128i *)ctrl);
+
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)value)));
+#else
+	unsigned int	i, mask = 0;
+
+	for (i = 0; i < ZBX_FLATSET_GROUP_SIZE; i++)
+	{
+		if (ctrl[i] == value)
+			mask |= 1u << i;
+	}
+
+	return mask;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get bitmask of group slots that are empty or deleted              *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned int	flatset_group_match_free(const unsigned char *ctrl)
+{
+#if defined(__SSE2__)
+	return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+	unsigned int	i, mask = 0;
+
+	for (i = 0; i < ZBX_FLATSET_GROUP_SIZE; i++)
+	{
+		if (!FLATSET_IS_USED(ctrl[i]))
+			mask |= 1u << i;
+	}
+
+	return mask;
+#endif
+}
+
+static int	flatset_lowest_bit(unsigned int mask)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+	int	bit = 0;
+
+	while (0 == (mask & 1))
+	{
+		mask >>= 1;
+		bit++;
+	}
+
+	return bit;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find slot index of the specified identifier                       *
+ *                                                                            *
+ * Return value: slot index or -1 if the identifier was not found             *
+ *                                                                            *
+ ******************************************************************************/
+static int	flatset_find(const zbx_flatset_t *fs, zbx_uint64_t id)
+{
+	zbx_hash_t	hash;
+	unsigned char	h2;
+	int		group, probe;
+
+	if (0 == fs->num_slots)
+		return -1;
+
+	hash = flatset_hash(id);
+	h2 = flatset_h2(hash);
+	group = flatset_group(fs, hash);
+
+	for (probe = 1; probe <= fs->num_slots / ZBX_FLATSET_GROUP_SIZE; probe++)
+	{
+		unsigned int	mask;
+
+		mask = flatset_group_match(fs->ctrl + group, h2);
+
+		while (0 != mask)
+		{
+			int	slot = group + flatset_lowest_bit(mask);
+
+			if (fs->slots[slot].id == id)
+				return slot;
+
+			mask &= mask - 1;
+		}
+
+		if (0 != flatset_group_match(fs->ctrl + group, FLATSET_EMPTY))
+			break;
+
+		group = flatset_next_group(fs, group, probe);
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find the first empty or deleted slot for the specified hash       *
+ *                                                                            *
+ ******************************************************************************/
+static int	flatset_find_free(const zbx_flatset_t *fs, zbx_hash_t hash)
+{
+	int	group, probe;
+
+	group = flatset_group(fs, hash);
+
+	for (probe = 1;; probe++)
+	{
+		unsigned int	mask;
+
+		if (0 != (mask = flatset_group_match_free(fs->ctrl + group)))
+			return group + flatset_lowest_bit(mask);
+
+		group = flatset_next_group(fs, group, probe);
+	}
+}
+
+static int	flatset_alloc_slots(zbx_flatset_t *fs, int num_slots)
+{
+	void	*ptr;
+
+	if (NULL == (ptr = fs->mem_malloc_func(NULL, (size_t)num_slots * (sizeof(zbx_flatset_slot_t) + 1))))
+		return FAIL;
+
+	fs->slots = (zbx_flatset_slot_t *)ptr;
+	fs->ctrl = (unsigned char *)(fs->slots + num_slots);
+	fs->num_slots = num_slots;
+	fs->num_deleted = 0;
+	memset(fs->ctrl, FLATSET_EMPTY, (size_t)num_slots);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: move all entries to newly allocated slots, dropping deleted slots *
+ *                                                                            *
+ ******************************************************************************/
+static int	flatset_rehash(zbx_flatset_t *fs, int num_slots)
+{
+	unsigned char		*ctrl = fs->ctrl;
+	zbx_flatset_slot_t	*slots = fs->slots;
+	int			i, old_num_slots = fs->num_slots;
+
+	if (SUCCEED != flatset_alloc_slots(fs, num_slots))
+	{
+		fs->ctrl = ctrl;
+		fs->slots = slots;
+
+		return FAIL;
+	}
+
+	for (i = 0; i < old_num_slots; i++)
+	{
+		zbx_hash_t	hash;
+		int		slot;
+
+		if (!FLATSET_IS_USED(ctrl[i]))
+			continue;
+
+		hash = flatset_hash(slots[i].id);
+		slot = flatset_find_free(fs, hash);
+		fs->ctrl[slot] = flatset_h2(hash);
+		fs->slots[slot] = slots[i];
+	}
+
+	if (NULL != slots)
+		fs->mem_free_func(slots);
+
+	return SUCCEED;
+}
+
+static void	flatset_free_slot(zbx_flatset_t *fs, int slot)
+{
+	if (NULL != fs->clean_func)
+		fs->clean_func(fs->slots[slot].data);
+
+	fs->mem_free_func(fs->slots[slot].data);
+	fs->num_data--;
+
+	/* if the group has an empty slot then no probe sequence continued past it */
+	if (0 != flatset_group_match(fs->ctrl + (slot & ~(ZBX_FLATSET_GROUP_SIZE - 1)), FLATSET_EMPTY))
+	{
+		fs->ctrl[slot] = FLATSET_EMPTY;
+	}
+	else
+	{
+		fs->ctrl[slot] = FLATSET_DELETED;
+		fs->num_deleted++;
+	}
+}
+
+/* public flatset interface */
+
+void	zbx_flatset_create(zbx_flatset_t *fs, size_t init_size)
+{
+	zbx_flatset_create_ext(fs, init_size, NULL, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+}
+
+void	zbx_flatset_create_ext(zbx_flatset_t *fs, size_t init_size,
+				zbx_clean_func_t clean_func,
+				zbx_mem_malloc_func_t mem_malloc_func,
+				zbx_mem_realloc_func_t mem_realloc_func,
+				zbx_mem_free_func_t mem_free_func)
+{
+	fs->ctrl = NULL;
+	fs->slots = NULL;
+	fs->num_slots = 0;
+	fs->num_data = 0;
+	fs->num_deleted = 0;
+	fs->clean_func = clean_func;
+	fs->mem_malloc_func = mem_malloc_func;
+	fs->mem_realloc_func = mem_realloc_func;
+	fs->mem_free_func = mem_free_func;
+
+	if (0 != init_size)
+		zbx_flatset_reserve(fs, (int)init_size);
+}
+
+void	zbx_flatset_destroy(zbx_flatset_t *fs)
+{
+	zbx_flatset_clear(fs);
+
+	if (NULL != fs->slots)
+	{
+		fs->mem_free_func(fs->slots);
+		fs->slots = NULL;
+		fs->ctrl = NULL;
+	}
+
+	fs->num_slots = 0;
+	fs->num_deleted = 0;
+	fs->mem_malloc_func = NULL;
+	fs->mem_realloc_func = NULL;
+	fs->mem_free_func = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocate enough slots to store the required number of entries     *
+ *                                                                            *
+ * Parameters: fs           - [IN] the flatset                                *
+ *             num_data_req - [IN] the number of entries                      *
+ *                                                                            *
+ * Comments: Deleted slots are counted as used, they are dropped when slots   *
+ *           are rehashed.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_flatset_reserve(zbx_flatset_t *fs, int num_data_req)
+{
+	int	num_slots;
+
+	if (num_data_req + fs->num_deleted <= FLATSET_MAX_DATA(fs->num_slots))
+		return SUCCEED;
+
+	/* reuse deleted slots if it would free enough space, otherwise grow */
+	if (num_data_req <= FLATSET_MAX_DATA(fs->num_slots) / 2)
+		return flatset_rehash(fs, fs->num_slots);
+
+	num_slots = MAX(fs->num_slots, ZBX_FLATSET_GROUP_SIZE);
+
+	while (num_data_req > FLATSET_MAX_DATA(num_slots))
+		num_slots *= 2;
+
+	return flatset_rehash(fs, num_slots);
+}
+
+void	*zbx_flatset_insert(zbx_flatset_t *fs, const void *data, size_t size)
+{
+	return zbx_flatset_insert_ext(fs, data, size, 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: insert entry if an entry with the same identifier does not exist  *
+ *                                                                            *
+ * Parameters: fs     - [IN] the flatset                                      *
+ *             data   - [IN] the entry data, starting with zbx_uint64_t id    *
+ *             size   - [IN] the entry size                                   *
+ *             offset - [IN] the offset of data to copy                       *
+ *                                                                            *
+ * Return value: the inserted or existing entry or NULL on allocation failure *
+ *                                                                            *
+ ******************************************************************************/
+void	*zbx_flatset_insert_ext(zbx_flatset_t *fs, const void *data, size_t size, size_t offset)
+{
+	zbx_uint64_t	id = *(const zbx_uint64_t *)data;
+	zbx_hash_t	hash;
+	void		*entry;
+	int		slot;
+
+	if (-1 != (slot = flatset_find(fs, id)))
+		return fs->slots[slot].data;
+
+	if (SUCCEED != zbx_flatset_reserve(fs, fs->num_data + 1))
+		return NULL;
+
+	if (NULL == (entry = fs->mem_malloc_func(NULL, size)))
+		return NULL;
+
+	memcpy((char *)entry + offset, (const char *)data + offset, size - offset);
+
+	hash = flatset_hash(id);
+	slot = flatset_find_free(fs, hash);
+
+	if (FLATSET_DELETED == fs->ctrl[slot])
+		fs->num_deleted--;
+
+	fs->ctrl[slot] = flatset_h2(hash);
+	fs->slots[slot].id = id;
+	fs->slots[slot].data = entry;
+	fs->num_data++;
+
+	return entry;
+}
+
+void	*zbx_flatset_search(const zbx_flatset_t *fs, const void *data)
+{
+	int	slot;
+
+	if (-1 == (slot = flatset_find(fs, *(const zbx_uint64_t *)data)))
+		return NULL;
+
+	return fs->slots[slot].data;
+}
+
+void	zbx_flatset_remove(zbx_flatset_t *fs, const void *data)
+{
+	int	slot;
+
+	if (-1 != (slot = flatset_find(fs, *(const zbx_uint64_t *)data)))
+		flatset_free_slot(fs, slot);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove a flatset entry using a data pointer returned to the user  *
+ *          by zbx_flatset_insert[_ext]() and zbx_flatset_search() functions  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_flatset_remove_direct(zbx_flatset_t *fs, const void *data)
+{
+	int	slot;
+
+	if (-1 != (slot = flatset_find(fs, *(const zbx_uint64_t *)data)) && fs->slots[slot].data == data)
+		flatset_free_slot(fs, slot);
+}
+
+void	zbx_flatset_clear(zbx_flatset_t *fs)
+{
+	int	slot;
+
+	for (slot = 0; slot < fs->num_slots; slot++)
+	{
+		if (!FLATSET_IS_USED(fs->ctrl[slot]))
+			continue;
+
+		if (NULL != fs->clean_func)
+			fs->clean_func(fs->slots[slot].data);
+
+		fs->mem_free_func(fs->slots[slot].data);
+	}
+
+	if (0 != fs->num_slots)
+		memset(fs->ctrl, FLATSET_EMPTY, (size_t)fs->num_slots);
+
+	fs->num_data = 0;
+	fs->num_deleted = 0;
+}
+
+void	zbx_flatset_iter_reset(zbx_flatset_t *fs, zbx_flatset_iter_t *iter)
+{
+	iter->flatset = fs;
+	iter->slot = ITER_START;
+}
+
+void	*zbx_flatset_iter_next(zbx_flatset_iter_t *iter)
+{
+	if (ITER_FINISH == iter->slot)
+		return NULL;
+
+	while (++iter->slot < iter->flatset->num_slots)
+	{
+		if (FLATSET_IS_USED(iter->flatset->ctrl[iter->slot]))
+			return iter->flatset->slots[iter->slot].data;
+	}
+
+	iter->slot = ITER_FINISH;
+
+	return NULL;
+}
+
+void	zbx_flatset_iter_remove(zbx_flatset_iter_t *iter)
+{
+	if (ITER_START == iter->slot || ITER_FINISH == iter->slot ||
+			!FLATSET_IS_USED(iter->flatset->ctrl[iter->slot]))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "removing a flatset entry through a bad iterator");
+		exit(EXIT_FAILURE);
+	}
+
+	flatset_free_slot(iter->flatset, iter->slot);
+}
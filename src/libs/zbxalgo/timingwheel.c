@@ -0,0 +1,488 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxalgo.h"
+
+#include "zbxcommon.h"
+
+#define TW_ROOT_MASK		(ZBX_TIMING_WHEEL_ROOT_SIZE - 1)
+#define TW_LEVEL_MASK		(ZBX_TIMING_WHEEL_LEVEL_SIZE - 1)
+#define TW_LEVEL_SHIFT(level)	(ZBX_TIMING_WHEEL_ROOT_BITS + (level) * ZBX_TIMING_WHEEL_LEVEL_BITS)
+
+/* the time span covered by the wheel */
+#define TW_RANGE		((zbx_int64_t)1 << TW_LEVEL_SHIFT(ZBX_TIMING_WHEEL_LEVELS))
+
+/* private timing wheel functions */
+
+static void	tw_list_push(zbx_timing_wheel_node_t **head, zbx_timing_wheel_node_t *node)
+{
+	if (NULL != (node->next = *head))
+		node->next->pprev = &node->next;
+
+	node->pprev = head;
+	*head = node;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds wheel slot for the specified expiry time                    *
+ *                                                                            *
+ * Comments: The expiry time must not be less than wheel time.                *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_timing_wheel_node_t	**tw_get_slot(zbx_timing_wheel_t *wheel, int expires)
+{
+	zbx_int64_t	delta = (zbx_int64_t)expires - wheel->now;
+	int		level;
+
+	if (ZBX_TIMING_WHEEL_ROOT_SIZE > delta)
+		return &wheel->root[(unsigned int)expires & TW_ROOT_MASK];
+
+	for (level = 0; level < ZBX_TIMING_WHEEL_LEVELS; level++)
+	{
+		if (((zbx_int64_t)1 << TW_LEVEL_SHIFT(level + 1)) > delta)
+		{
+			return &wheel->levels[level][((unsigned int)expires >> TW_LEVEL_SHIFT(level)) &
+					TW_LEVEL_MASK];
+		}
+	}
+
+	/* nodes beyond wheel range are parked in the farthest slot and rescheduled when it's cascaded */
+	expires = (int)(wheel->now + TW_RANGE - 1);
+	level = ZBX_TIMING_WHEEL_LEVELS - 1;
+
+	return &wheel->levels[level][((unsigned int)expires >> TW_LEVEL_SHIFT(level)) & TW_LEVEL_MASK];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sorts singly linked node list                                     *
+ *                                                                            *
+ * Comments: Stable bottom-up merge sort, pprev links are not updated.        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_timing_wheel_node_t	*tw_list_sort(zbx_timing_wheel_node_t *list, zbx_compare_func_t compare_func)
+{
+	int			size = 1, merges, psize, qsize;
+	zbx_timing_wheel_node_t	*p, *q, *node, *tail;
+
+	do
+	{
+		p = list;
+		list = tail = NULL;
+		merges = 0;
+
+		while (NULL != p)
+		{
+			merges++;
+
+			for (q = p, psize = 0; psize < size && NULL != q; psize++)
+				q = q->next;
+
+			qsize = size;
+
+			while (0 < psize || (0 < qsize && NULL != q))
+			{
+				if (0 == psize)
+				{
+					node = q;
+					q = q->next;
+					qsize--;
+				}
+				else if (0 == qsize || NULL == q || 0 >= compare_func(p, q))
+				{
+					node = p;
+					p = p->next;
+					psize--;
+				}
+				else
+				{
+					node = q;
+					q = q->next;
+					qsize--;
+				}
+
+				if (NULL != tail)
+					tail->next = node;
+				else
+					list = node;
+
+				tail = node;
+			}
+
+			p = q;
+		}
+
+		tail->next = NULL;
+		size *= 2;
+	}
+	while (1 < merges);
+
+	return list;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates pprev links and tail of expired list starting with the    *
+ *          specified link                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	tw_expired_relink(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t **pnext)
+{
+	zbx_timing_wheel_node_t	*node;
+
+	for (; NULL != (node = *pnext); pnext = &node->next)
+	{
+		node->pprev = pnext;
+		wheel->expired_tail = node;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: merges sorted node list into expired list                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	tw_expired_merge(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t *list)
+{
+	zbx_timing_wheel_node_t	**pnext, *node, *expired;
+
+	if (NULL == wheel->expired_tail || NULL == wheel->compare_func ||
+			0 >= wheel->compare_func(wheel->expired_tail, list))
+	{
+		/* the usual case - pollers keep up and expired list is empty */
+		pnext = (NULL == wheel->expired_tail ? &wheel->expired : &wheel->expired_tail->next);
+		*pnext = list;
+		tw_expired_relink(wheel, pnext);
+
+		return;
+	}
+
+	expired = wheel->expired;
+	pnext = &wheel->expired;
+
+	while (NULL != expired && NULL != list)
+	{
+		if (0 < wheel->compare_func(expired, list))
+		{
+			node = list;
+			list = list->next;
+		}
+		else
+		{
+			node = expired;
+			expired = expired->next;
+		}
+
+		*pnext = node;
+		node->pprev = pnext;
+		pnext = &node->next;
+	}
+
+	*pnext = (NULL != expired ? expired : list);
+	tw_expired_relink(wheel, pnext);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: inserts node into expired list keeping it sorted                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	tw_expired_insert(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t *node)
+{
+	zbx_timing_wheel_node_t	**pnext;
+
+	if (NULL == wheel->expired_tail || NULL == wheel->compare_func ||
+			0 >= wheel->compare_func(wheel->expired_tail, node))
+	{
+		pnext = (NULL == wheel->expired_tail ? &wheel->expired : &wheel->expired_tail->next);
+	}
+	else
+	{
+		/* the tail is greater than inserted node, so the search stops before reaching it */
+		for (pnext = &wheel->expired; 0 >= wheel->compare_func(*pnext, node); pnext = &(*pnext)->next)
+			;
+	}
+
+	if (NULL != (node->next = *pnext))
+		node->next->pprev = &node->next;
+	else
+		wheel->expired_tail = node;
+
+	node->pprev = pnext;
+	*pnext = node;
+
+	wheel->expired_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves nodes from the current slot of the specified level to lower *
+ *          levels                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	tw_cascade(zbx_timing_wheel_t *wheel, int level)
+{
+	unsigned int		index;
+	zbx_timing_wheel_node_t	*node, *next;
+
+	index = ((unsigned int)wheel->now >> TW_LEVEL_SHIFT(level)) & TW_LEVEL_MASK;
+
+	if (0 == index && ZBX_TIMING_WHEEL_LEVELS > level + 1)
+		tw_cascade(wheel, level + 1);
+
+	node = wheel->levels[level][index];
+	wheel->levels[level][index] = NULL;
+
+	for (; NULL != node; node = next)
+	{
+		next = node->next;
+		tw_list_push(tw_get_slot(wheel, node->expires), node);
+	}
+}
+
+/* public timing wheel interface */
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates timing wheel                                              *
+ *                                                                            *
+ * Parameters: wheel        - [OUT] the timing wheel                          *
+ *             now          - [IN] the current time                           *
+ *             compare_func - [IN] the function to order nodes expiring at    *
+ *                                 the same second, optional                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_timing_wheel_create(zbx_timing_wheel_t *wheel, int now, zbx_compare_func_t compare_func)
+{
+	memset(wheel, 0, sizeof(zbx_timing_wheel_t));
+
+	wheel->now = now;
+	wheel->compare_func = compare_func;
+}
+
+void	zbx_timing_wheel_destroy(zbx_timing_wheel_t *wheel)
+{
+	zbx_timing_wheel_clear(wheel);
+	wheel->compare_func = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes all nodes from timing wheel                               *
+ *                                                                            *
+ * Comments: The nodes are owned by caller and are not unlinked.              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_timing_wheel_clear(zbx_timing_wheel_t *wheel)
+{
+	memset(wheel->root, 0, sizeof(wheel->root));
+	memset(wheel->levels, 0, sizeof(wheel->levels));
+
+	wheel->expired = NULL;
+	wheel->expired_tail = NULL;
+	wheel->nodes_num = 0;
+	wheel->expired_num = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: schedules node                                                    *
+ *                                                                            *
+ * Parameters: wheel   - [IN] the timing wheel                                *
+ *             node    - [IN] the node to schedule, must not be linked in any *
+ *                            timing wheel                                    *
+ *             expires - [IN] the expiry time                                 *
+ *                                                                            *
+ * Comments: Nodes with expiry time in the past are added directly to the     *
+ *           expired list.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_timing_wheel_insert(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t *node, int expires)
+{
+	node->expires = expires;
+	wheel->nodes_num++;
+
+	if (expires < wheel->now)
+		tw_expired_insert(wheel, node);
+	else
+		tw_list_push(tw_get_slot(wheel, expires), node);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes scheduled or expired node                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_timing_wheel_remove(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t *node)
+{
+	if (NULL != (*node->pprev = node->next))
+		node->next->pprev = node->pprev;
+
+	/* only expired nodes can have expiry time before wheel time */
+	if (node->expires < wheel->now)
+	{
+		if (wheel->expired_tail == node)
+		{
+			/* pprev points at the next member of previous node, which is its first member */
+			wheel->expired_tail = (&wheel->expired == node->pprev ? NULL :
+					(zbx_timing_wheel_node_t *)node->pprev);
+		}
+
+		wheel->expired_num--;
+	}
+
+	wheel->nodes_num--;
+
+	node->next = NULL;
+	node->pprev = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reschedules node                                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_timing_wheel_update(zbx_timing_wheel_t *wheel, zbx_timing_wheel_node_t *node, int expires)
+{
+	zbx_timing_wheel_remove(wheel, node);
+	zbx_timing_wheel_insert(wheel, node, expires);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves nodes expiring up to the specified time to expired list     *
+ *                                                                            *
+ * Parameters: wheel - [IN] the timing wheel                                  *
+ *             now   - [IN] the current time                                  *
+ *                                                                            *
+ * Return value: the number of expired nodes                                  *
+ *                                                                            *
+ * Comments: Nodes expiring at the same second are moved in one batch.        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_timing_wheel_advance(zbx_timing_wheel_t *wheel, int now)
+{
+	int	expired_num = wheel->expired_num;
+
+	while (wheel->now <= now)
+	{
+		unsigned int		index;
+		zbx_timing_wheel_node_t	*list, *node;
+
+		/* nothing is scheduled, the wheel can be moved forward right away */
+		if (wheel->nodes_num == wheel->expired_num)
+		{
+			wheel->now = now + 1;
+			break;
+		}
+
+		if (0 == (index = (unsigned int)wheel->now & TW_ROOT_MASK))
+			tw_cascade(wheel, 0);
+
+		if (NULL != (list = wheel->root[index]))
+		{
+			wheel->root[index] = NULL;
+
+			for (node = list; NULL != node; node = node->next)
+				wheel->expired_num++;
+
+			if (NULL != wheel->compare_func && NULL != list->next)
+				list = tw_list_sort(list, wheel->compare_func);
+
+			tw_expired_merge(wheel, list);
+		}
+
+		wheel->now++;
+	}
+
+	return wheel->expired_num - expired_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the first expired node                                    *
+ *                                                                            *
+ * Return value: The first node in expired list or NULL if there are no       *
+ *               expired nodes.                                               *
+ *                                                                            *
+ * Comments: Expired nodes stay in the timing wheel until removed.            *
+ *                                                                            *
+ ******************************************************************************/
+zbx_timing_wheel_node_t	*zbx_timing_wheel_first_expired(const zbx_timing_wheel_t *wheel)
+{
+	return wheel->expired;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the nearest expiry time without advancing the wheel       *
+ *                                                                            *
+ * Return value: The expiry time of the first expired node or the nearest     *
+ *               expiry time of scheduled nodes. FAIL if there are no nodes.  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_timing_wheel_next_expiry(const zbx_timing_wheel_t *wheel)
+{
+	int				i, level, expires = FAIL;
+	const zbx_timing_wheel_node_t	*node;
+
+	if (NULL != wheel->expired)
+		return wheel->expired->expires;
+
+	if (0 == wheel->nodes_num)
+		return FAIL;
+
+	/* root slots are unique per second and ordered starting with wheel time */
+	for (i = 0; i < ZBX_TIMING_WHEEL_ROOT_SIZE; i++)
+	{
+		if (NULL == (node = wheel->root[((unsigned int)wheel->now + (unsigned int)i) & TW_ROOT_MASK]))
+			continue;
+
+		/* until the next cascade upper levels cannot have nodes expiring earlier */
+		if (ZBX_TIMING_WHEEL_ROOT_SIZE - (int)((unsigned int)wheel->now & TW_ROOT_MASK) > i)
+			return node->expires;
+
+		expires = node->expires;
+		break;
+	}
+
+	/* upper level slots are ordered starting with the one after current, the first used slot */
+	/* of each level holds nodes with the nearest expiry time on that level                    */
+	for (level = 0; level < ZBX_TIMING_WHEEL_LEVELS; level++)
+	{
+		unsigned int	index = ((unsigned int)wheel->now >> TW_LEVEL_SHIFT(level)) & TW_LEVEL_MASK;
+
+		for (i = 1; i <= ZBX_TIMING_WHEEL_LEVEL_SIZE; i++)
+		{
+			if (NULL == (node = wheel->levels[level][(index + (unsigned int)i) & TW_LEVEL_MASK]))
+				continue;
+
+			for (; NULL != node; node = node->next)
+			{
+				if (FAIL == expires || node->expires < expires)
+					expires = node->expires;
+			}
+
+			break;
+		}
+	}
+
+	return expires;
+}
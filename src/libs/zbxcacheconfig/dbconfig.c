@@ -46,8 +46,134 @@
 
 int	sync_in_progress = 0;
 
-#define START_SYNC	WRLOCK_CACHE_CONFIG_HISTORY; WRLOCK_CACHE; sync_in_progress = 1
-#define FINISH_SYNC	sync_in_progress = 0; UNLOCK_CACHE; UNLOCK_CACHE_CONFIG_HISTORY;
+#define START_SYNC	WRLOCK_CACHE_CONFIG_HISTORY; WRLOCK_CACHE; sync_in_progress = 1; dc_sync_lock_start()
+#define FINISH_SYNC	dc_sync_lock_finish(); sync_in_progress = 0; UNLOCK_CACHE; UNLOCK_CACHE_CONFIG_HISTORY;
+
+/* statistics of configuration cache lock hold time by configuration sync sections */
+static double	sync_lock_start, sync_lock_max;
+static int	sync_lock_slices;
+
+/* lock slice statistics are collected only during configuration sync, other sections */
+/* (for example vault secret sync) lock the cache outside of it                       */
+static int	sync_lock_stats;
+
+static void	dc_sync_lock_start(void)
+{
+	sync_lock_start = zbx_time();
+}
+
+static void	dc_sync_lock_finish(void)
+{
+	double	sec;
+
+	if (0 == sync_lock_stats)
+		return;
+
+	if (sync_lock_max < (sec = zbx_time() - sync_lock_start))
+		sync_lock_max = sec;
+
+	sync_lock_slices++;
+}
+
+/* time spent by the current process waiting for configuration cache lock, points */
+/* to the process slot in configuration cache, see zbx_dc_set_lock_wait_process() */
+static double	*dc_lock_wait = NULL;
+
+/* lock wait time is measured for every ZBX_DC_LOCK_WAIT_SAMPLE-th lock and scaled, */
+/* so that the frequent cache locking is not slowed down by time measurements     */
+#define ZBX_DC_LOCK_WAIT_SAMPLE	64
+
+static unsigned int	dc_lock_num = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read lock configuration cache, accounting the lock wait time      *
+ *                                                                            *
+ ******************************************************************************/
+void	dc_rdlock_cache(void)
+{
+	double	sec;
+
+	if (NULL == dc_lock_wait || 0 != ++dc_lock_num % ZBX_DC_LOCK_WAIT_SAMPLE)
+	{
+		zbx_rwlock_rdlock(config_lock);
+		return;
+	}
+
+	sec = zbx_time();
+	zbx_rwlock_rdlock(config_lock);
+	*dc_lock_wait += (zbx_time() - sec) * ZBX_DC_LOCK_WAIT_SAMPLE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write lock configuration cache, accounting the lock wait time     *
+ *                                                                            *
+ ******************************************************************************/
+void	dc_wrlock_cache(void)
+{
+	double	sec;
+
+	if (NULL == dc_lock_wait || 0 != ++dc_lock_num % ZBX_DC_LOCK_WAIT_SAMPLE)
+	{
+		zbx_rwlock_wrlock(config_lock);
+		return;
+	}
+
+	sec = zbx_time();
+	zbx_rwlock_wrlock(config_lock);
+	*dc_lock_wait += (zbx_time() - sec) * ZBX_DC_LOCK_WAIT_SAMPLE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set process which configuration cache lock wait time is accounted *
+ *          by the current process and processes forked from it               *
+ *                                                                            *
+ * Parameters: process_type - [IN] the process type, ZBX_PROCESS_TYPE_UNKNOWN *
+ *                                 to stop accounting                         *
+ *             process_num  - [IN] the process number (1..forks)              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_set_lock_wait_process(unsigned char process_type, int process_num)
+{
+	if (NULL == config || ZBX_PROCESS_TYPE_COUNT <= process_type || 0 >= process_num ||
+			CONFIG_FORKS[process_type] < process_num || NULL == config->lock_wait[process_type])
+	{
+		dc_lock_wait = NULL;
+		return;
+	}
+
+	dc_lock_wait = &config->lock_wait[process_type][process_num - 1];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get time spent waiting for configuration cache lock by processes  *
+ *          of the specified type                                             *
+ *                                                                            *
+ * Parameters: process_type - [IN] the process type                           *
+ *                                                                            *
+ * Return value: The total lock wait time in seconds, estimated from sampled  *
+ *               lock waits.                                                  *
+ *                                                                            *
+ * Comments: Every process updates only its own slot, so the slots are read   *
+ *           without locking.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_dc_get_lock_wait(unsigned char process_type)
+{
+	double	sec = 0;
+	int	i;
+
+	if (ZBX_PROCESS_TYPE_COUNT <= process_type || NULL == config->lock_wait[process_type])
+		return 0;
+
+	for (i = 0; i < CONFIG_FORKS[process_type]; i++)
+		sec += config->lock_wait[process_type][i];
+
+	return sec;
+}
 
 #define ZBX_SNMP_OID_TYPE_NORMAL	0
 #define ZBX_SNMP_OID_TYPE_DYNAMIC	1
@@ -656,15 +782,13 @@ int	dc_strpool_replace(int found, const char **curr, const char *new_str)
 
 static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type, int old_nextcheck)
 {
-	zbx_binary_heap_elem_t	elem;
-
 	if (ZBX_LOC_POLLER == item->location)
 		return;
 
 	if (ZBX_LOC_QUEUE == item->location && old_poller_type != item->poller_type)
 	{
 		item->location = ZBX_LOC_NOWHERE;
-		zbx_binary_heap_remove_direct(&config->queues[old_poller_type], item->itemid);
+		zbx_timing_wheel_remove(&config->queues[old_poller_type], &item->queue_node);
 	}
 
 	if (item->poller_type == ZBX_NO_POLLER)
@@ -673,16 +797,14 @@ static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type
 	if (ZBX_LOC_QUEUE == item->location && old_nextcheck == item->nextcheck)
 		return;
 
-	elem.key = item->itemid;
-	elem.data = (const void *)item;
-
 	if (ZBX_LOC_QUEUE != item->location)
 	{
 		item->location = ZBX_LOC_QUEUE;
-		zbx_binary_heap_insert(&config->queues[item->poller_type], &elem);
+		item->queue_node.data = (const void *)item;
+		zbx_timing_wheel_insert(&config->queues[item->poller_type], &item->queue_node, item->nextcheck);
 	}
 	else
-		zbx_binary_heap_update_direct(&config->queues[item->poller_type], &elem);
+		zbx_timing_wheel_update(&config->queues[item->poller_type], &item->queue_node, item->nextcheck);
 }
 
 static void	DCupdate_proxy_queue(ZBX_DC_PROXY *proxy)
@@ -2409,7 +2531,7 @@ static void	dc_masteritem_remove_depitem(zbx_uint64_t master_itemid, zbx_uint64_
 	int			index;
 	zbx_uint64_pair_t	pair;
 
-	if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &master_itemid)))
+	if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &master_itemid)))
 		return;
 
 	if (NULL == (masteritem = item->master_item))
@@ -2542,7 +2664,18 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		if (NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)))
 			continue;
 
-		item = (ZBX_DC_ITEM *)DCfind_id(&config->items, itemid, sizeof(ZBX_DC_ITEM), &found);
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemid)))
+		{
+			ZBX_DC_ITEM	item_local;
+
+			found = 0;
+			item_local.itemid = itemid;
+			item = (ZBX_DC_ITEM *)zbx_flatset_insert(&config->items, &item_local, sizeof(ZBX_DC_ITEM));
+		}
+		else
+		{
+			found = 1;
+		}
 
 		/* template item */
 		ZBX_DBROW2UINT64(item->templateid, row[48]);
@@ -3083,7 +3216,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		depitem = (ZBX_DC_DEPENDENTITEM *)dep_items.values[i];
 		dc_masteritem_remove_depitem(depitem->last_master_itemid, depitem->itemid);
 
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &depitem->master_itemid)))
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &depitem->master_itemid)))
 			continue;
 
 		pair.first = depitem->itemid;
@@ -3112,7 +3245,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		if (NULL != deleted_itemids)
 			zbx_vector_uint64_append(deleted_itemids, rowid);
 
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &rowid)))
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &rowid)))
 			continue;
 
 		if (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)))
@@ -3325,7 +3458,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		}
 
 		if (ZBX_LOC_QUEUE == item->location)
-			zbx_binary_heap_remove_direct(&config->queues[item->poller_type], item->itemid);
+			zbx_timing_wheel_remove(&config->queues[item->poller_type], &item->queue_node);
 
 		dc_strpool_release(item->key);
 		dc_strpool_release(item->error);
@@ -3346,7 +3479,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		if (NULL != item->master_item)
 			dc_masteritem_free(item->master_item);
 
-		zbx_hashset_remove_direct(&config->items, item);
+		zbx_flatset_remove_direct(&config->items, item);
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -3550,7 +3683,7 @@ static void	DCsync_triggers(zbx_dbsync_t *sync, zbx_uint64_t revision)
 				{
 					for (itemid = trigger->itemids; 0 != *itemid; itemid++)
 					{
-						if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items,
+						if (NULL != (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items,
 								itemid)))
 						{
 							dc_item_reset_triggers(item, trigger);
@@ -3876,7 +4009,7 @@ static zbx_trigger_timer_t	*dc_trigger_function_timer_create(ZBX_DC_FUNCTION *fu
 
 	if (ZBX_FUNCTION_TYPE_TRENDS == function->type)
 	{
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &function->itemid)))
 			return NULL;
 
 		type = ZBX_TRIGGER_TIMER_FUNCTION_TREND;
@@ -4091,7 +4224,7 @@ static void	DCsync_functions(zbx_dbsync_t *sync, zbx_uint64_t revision)
 		ZBX_STR2UINT64(functionid, row[0]);
 		ZBX_STR2UINT64(triggerid, row[4]);
 
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemid)))
 			continue;
 
 		/* process function information */
@@ -4104,7 +4237,7 @@ static void	DCsync_functions(zbx_dbsync_t *sync, zbx_uint64_t revision)
 			{
 				ZBX_DC_ITEM	*item_last;
 
-				if (NULL != (item_last = zbx_hashset_search(&config->items, &function->itemid)))
+				if (NULL != (item_last = zbx_flatset_search(&config->items, &function->itemid)))
 					dc_item_reset_triggers(item_last, NULL);
 			}
 		}
@@ -4127,7 +4260,7 @@ static void	DCsync_functions(zbx_dbsync_t *sync, zbx_uint64_t revision)
 		if (NULL == (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions, &rowid)))
 			continue;
 
-		if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
+		if (NULL != (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &function->itemid)))
 			dc_item_reset_triggers(item, NULL);
 
 		dc_strpool_release(function->function);
@@ -5083,7 +5216,7 @@ static void	DCsync_item_tags(zbx_dbsync_t *sync)
 
 		ZBX_STR2UINT64(itemid, row[1]);
 
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemid)))
 			continue;
 
 		ZBX_STR2UINT64(itemtagid, row[0]);
@@ -5107,7 +5240,7 @@ static void	DCsync_item_tags(zbx_dbsync_t *sync)
 		if (NULL == (item_tag = (zbx_dc_item_tag_t *)zbx_hashset_search(&config->item_tags, &rowid)))
 			continue;
 
-		if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &item_tag->itemid)))
+		if (NULL != (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &item_tag->itemid)))
 		{
 			if (FAIL != (index = zbx_vector_ptr_search(&item->tags, item_tag,
 					ZBX_DEFAULT_PTR_COMPARE_FUNC)))
@@ -5305,7 +5438,7 @@ static void	DCsync_item_preproc(zbx_dbsync_t *sync, zbx_uint64_t revision)
 
 		ZBX_STR2UINT64(itemid, row[1]);
 
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemid)))
 			continue;
 
 		if (NULL == (preprocitem = item->preproc_item))
@@ -5344,7 +5477,7 @@ static void	DCsync_item_preproc(zbx_dbsync_t *sync, zbx_uint64_t revision)
 		if (NULL == (op = (zbx_dc_preproc_op_t *)zbx_hashset_search(&config->preprocops, &rowid)))
 			continue;
 
-		if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &op->itemid)) &&
+		if (NULL != (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &op->itemid)) &&
 				NULL != (preprocitem = item->preproc_item))
 		{
 			if (FAIL != (index = zbx_vector_ptr_search(&preprocitem->preproc_ops, op,
@@ -5483,7 +5616,7 @@ static void	DCsync_itemscript_param(zbx_dbsync_t *sync, zbx_uint64_t revision)
 	{
 		scriptitem = (ZBX_DC_SCRIPTITEM *)items.values[i];
 
-		if (NULL != (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &scriptitem->itemid)))
+		if (NULL != (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &scriptitem->itemid)))
 			dc_item_update_revision(dc_item, revision);
 
 		if (0 < scriptitem->params.values_num)
@@ -6297,7 +6430,7 @@ static void	dc_trigger_update_cache(void)
 	zbx_hashset_iter_reset(&config->functions, &iter);
 	while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
 	{
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)) ||
+		if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &function->itemid)) ||
 				NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers,
 				&function->triggerid)))
 		{
@@ -6513,9 +6646,9 @@ void	DCsync_configuration(unsigned char mode, zbx_synced_new_config_t synced, zb
 
 	zbx_hashset_create(&activated_hosts, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	sec = zbx_time();
-	changelog_num = zbx_dbsync_env_prepare(mode);
-	changelog_sec = zbx_time() - sec;
+	sync_lock_max = 0;
+	sync_lock_slices = 0;
+	sync_lock_stats = 1;
 
 	if (ZBX_DBSYNC_INIT == mode)
 	{
@@ -6525,6 +6658,10 @@ void	DCsync_configuration(unsigned char mode, zbx_synced_new_config_t synced, zb
 	else if (ZBX_DBSYNC_STATUS_INITIALIZED != sync_status)
 		changelog_sync_mode = ZBX_DBSYNC_INIT;
 
+	sec = zbx_time();
+	changelog_num = zbx_dbsync_env_prepare(mode, changelog_sync_mode);
+	changelog_sec = zbx_time() - sec;
+
 	/* global configuration must be synchronized directly with database */
 	zbx_dbsync_init(&config_sync, ZBX_DBSYNC_INIT);
 
@@ -7167,6 +7304,8 @@ void	DCsync_configuration(unsigned char mode, zbx_synced_new_config_t synced, zb
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() total sql  : " ZBX_FS_DBL " sec.", __func__, total);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() total sync : " ZBX_FS_DBL " sec.", __func__, total2);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() lock slices: %d (max " ZBX_FS_DBL " sec.)", __func__,
+				sync_lock_slices, sync_lock_max);
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() proxies    : %d (%d slots)", __func__,
 				config->proxies.num_data, config->proxies.num_slots);
@@ -7287,8 +7426,8 @@ void	DCsync_configuration(unsigned char mode, zbx_synced_new_config_t synced, zb
 
 		for (i = 0; ZBX_POLLER_TYPE_COUNT > i; i++)
 		{
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() queue[%d]   : %d (%d allocated)", __func__,
-					i, config->queues[i].elems_num, config->queues[i].elems_alloc);
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() queue[%d]   : %d (%d expired)", __func__,
+					i, config->queues[i].nodes_num, config->queues[i].expired_num);
 		}
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() pqueue     : %d (%d allocated)", __func__,
@@ -7318,6 +7457,8 @@ out:
 
 	FINISH_SYNC;
 
+	sync_lock_stats = 0;
+
 #ifdef HAVE_ORACLE
 	if (ZBX_DB_OK == dberr)
 		dberr = zbx_db_commit();
@@ -7331,6 +7472,8 @@ out:
 				zbx_dbsync_env_flush_changelog();
 			else
 				sync_status = ZBX_DBSYNC_STATUS_INITIALIZED;
+
+			zbx_dbsync_env_flush_snapshot();
 			break;
 		case ZBX_DB_FAIL:
 			/* non recoverable database error is encountered */
@@ -7411,6 +7554,78 @@ clean:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads configuration cache snapshot written on previous shutdown   *
+ *                                                                            *
+ * Parameters: filename - [IN] the snapshot file                              *
+ *             source   - [IN] the configuration database identity            *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded, the initial configuration *
+ *                         sync restores objects tracked by changelog from    *
+ *                         snapshot and the next update sync applies changes  *
+ *                         made after it                                      *
+ *               FAIL    - the snapshot does not exist or cannot be used      *
+ *                                                                            *
+ * Comments: Must be called by configuration syncer before the initial sync.  *
+ *           Snapshot writing is enabled regardless of the result.            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_config_load_snapshot(const char *filename, const char *source)
+{
+	return zbx_dbsync_env_load_snapshot(filename, source);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes configuration cache snapshot on clean shutdown             *
+ *                                                                            *
+ * Comments: The proxy runtime data not tracked by changelog is copied from   *
+ *           configuration cache and written to snapshot after releasing the  *
+ *           cache lock, so file writing does not block other processes.      *
+ *           Item runtime data is not written, it is flushed to database by   *
+ *           history syncers after the snapshot and is read from there when   *
+ *           snapshot is loaded.                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_config_save_snapshot(void)
+{
+	zbx_hashset_iter_t		iter;
+	ZBX_DC_PROXY			*proxy;
+	zbx_uint64_t			revision;
+	zbx_vector_uint64_pair_t	proxies;
+	zbx_uint64_pair_t		pair;
+	int				i;
+
+	if (SUCCEED != zbx_dbsync_env_snapshot_writable())
+		return;
+
+	zbx_vector_uint64_pair_create(&proxies);
+
+	RDLOCK_CACHE;
+
+	zbx_vector_uint64_pair_reserve(&proxies, (size_t)config->proxies.num_data);
+
+	zbx_hashset_iter_reset(&config->proxies, &iter);
+	while (NULL != (proxy = (ZBX_DC_PROXY *)zbx_hashset_iter_next(&iter)))
+	{
+		pair.first = proxy->hostid;
+		pair.second = (zbx_uint64_t)proxy->lastaccess;
+		zbx_vector_uint64_pair_append(&proxies, pair);
+	}
+
+	revision = config->revision.config;
+
+	UNLOCK_CACHE;
+
+	for (i = 0; i < proxies.values_num; i++)
+		zbx_dbsync_env_add_proxy_rtdata(proxies.values[i].first, (int)proxies.values[i].second);
+
+	zbx_vector_uint64_pair_destroy(&proxies);
+
+	zbx_dbsync_env_close_snapshot(revision);
+}
+
 /******************************************************************************
  *                                                                            *
  * Helper functions for configuration cache data structure element comparison *
@@ -7537,13 +7752,13 @@ static int	__config_snmp_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *
 	return 0;
 }
 
-static int	__config_heap_elem_compare(const void *d1, const void *d2)
+static int	__config_item_node_compare(const void *d1, const void *d2)
 {
-	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
-	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const zbx_timing_wheel_node_t	*n1 = (const zbx_timing_wheel_node_t *)d1;
+	const zbx_timing_wheel_node_t	*n2 = (const zbx_timing_wheel_node_t *)d2;
 
-	const ZBX_DC_ITEM		*i1 = (const ZBX_DC_ITEM *)e1->data;
-	const ZBX_DC_ITEM		*i2 = (const ZBX_DC_ITEM *)e2->data;
+	const ZBX_DC_ITEM		*i1 = (const ZBX_DC_ITEM *)n1->data;
+	const ZBX_DC_ITEM		*i2 = (const ZBX_DC_ITEM *)n2->data;
 
 	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
 	ZBX_RETURN_IF_NOT_EQUAL(i1->queue_priority, i2->queue_priority);
@@ -7564,13 +7779,13 @@ static int	__config_heap_elem_compare(const void *d1, const void *d2)
 	}
 }
 
-static int	__config_pinger_elem_compare(const void *d1, const void *d2)
+static int	__config_pinger_node_compare(const void *d1, const void *d2)
 {
-	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
-	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const zbx_timing_wheel_node_t	*n1 = (const zbx_timing_wheel_node_t *)d1;
+	const zbx_timing_wheel_node_t	*n2 = (const zbx_timing_wheel_node_t *)d2;
 
-	const ZBX_DC_ITEM		*i1 = (const ZBX_DC_ITEM *)e1->data;
-	const ZBX_DC_ITEM		*i2 = (const ZBX_DC_ITEM *)e2->data;
+	const ZBX_DC_ITEM		*i1 = (const ZBX_DC_ITEM *)n1->data;
+	const ZBX_DC_ITEM		*i2 = (const ZBX_DC_ITEM *)n2->data;
 
 	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
 	ZBX_RETURN_IF_NOT_EQUAL(i1->queue_priority, i2->queue_priority);
@@ -7596,13 +7811,13 @@ static int	__config_java_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *
 	return 0;
 }
 
-static int	__config_java_elem_compare(const void *d1, const void *d2)
+static int	__config_java_node_compare(const void *d1, const void *d2)
 {
-	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
-	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const zbx_timing_wheel_node_t	*n1 = (const zbx_timing_wheel_node_t *)d1;
+	const zbx_timing_wheel_node_t	*n2 = (const zbx_timing_wheel_node_t *)d2;
 
-	const ZBX_DC_ITEM		*i1 = (const ZBX_DC_ITEM *)e1->data;
-	const ZBX_DC_ITEM		*i2 = (const ZBX_DC_ITEM *)e2->data;
+	const ZBX_DC_ITEM		*i1 = (const ZBX_DC_ITEM *)n1->data;
+	const ZBX_DC_ITEM		*i2 = (const ZBX_DC_ITEM *)n2->data;
 
 	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
 	ZBX_RETURN_IF_NOT_EQUAL(i1->queue_priority, i2->queue_priority);
@@ -7738,7 +7953,7 @@ int	init_configuration_cache(char **error)
 		goto out;
 
 	if (SUCCEED != (ret = zbx_shmem_create(&config_mem, CONFIG_CONF_CACHE_SIZE, "configuration cache",
-			"CacheSize", 0, error)))
+			"CacheSize", 0, 0, error)))
 	{
 		goto out;
 	}
@@ -7746,6 +7961,21 @@ int	init_configuration_cache(char **error)
 	config = (ZBX_DC_CONFIG *)__config_shmem_malloc_func(NULL, sizeof(ZBX_DC_CONFIG) +
 			(size_t)CONFIG_FORKS[ZBX_PROCESS_TYPE_TIMER] * sizeof(zbx_vector_ptr_t));
 
+	for (i = 0; i < ZBX_PROCESS_TYPE_COUNT; i++)
+	{
+		size_t	size;
+
+		if (0 == CONFIG_FORKS[i])
+		{
+			config->lock_wait[i] = NULL;
+			continue;
+		}
+
+		size = sizeof(double) * (size_t)CONFIG_FORKS[i];
+		config->lock_wait[i] = (double *)__config_shmem_malloc_func(NULL, size);
+		memset(config->lock_wait[i], 0, size);
+	}
+
 #define CREATE_HASHSET(hashset, hashset_size)									\
 														\
 	CREATE_HASHSET_EXT(hashset, hashset_size, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC)
@@ -7755,7 +7985,8 @@ int	init_configuration_cache(char **error)
 	zbx_hashset_create_ext(&hashset, hashset_size, hash_func, compare_func, NULL,				\
 			__config_shmem_malloc_func, __config_shmem_realloc_func, __config_shmem_free_func)
 
-	CREATE_HASHSET(config->items, 100);
+	zbx_flatset_create_ext(&config->items, 100, NULL, __config_shmem_malloc_func, __config_shmem_realloc_func,
+			__config_shmem_free_func);
 	CREATE_HASHSET(config->numitems, 0);
 	CREATE_HASHSET(config->snmpitems, 0);
 	CREATE_HASHSET(config->ipmiitems, 0);
@@ -7834,28 +8065,13 @@ int	init_configuration_cache(char **error)
 		switch (i)
 		{
 			case ZBX_POLLER_TYPE_JAVA:
-				zbx_binary_heap_create_ext(&config->queues[i],
-						__config_java_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
-						__config_shmem_malloc_func,
-						__config_shmem_realloc_func,
-						__config_shmem_free_func);
+				zbx_timing_wheel_create(&config->queues[i], (int)time(NULL), __config_java_node_compare);
 				break;
 			case ZBX_POLLER_TYPE_PINGER:
-				zbx_binary_heap_create_ext(&config->queues[i],
-						__config_pinger_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
-						__config_shmem_malloc_func,
-						__config_shmem_realloc_func,
-						__config_shmem_free_func);
+				zbx_timing_wheel_create(&config->queues[i], (int)time(NULL), __config_pinger_node_compare);
 				break;
 			default:
-				zbx_binary_heap_create_ext(&config->queues[i],
-						__config_heap_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
-						__config_shmem_malloc_func,
-						__config_shmem_realloc_func,
-						__config_shmem_free_func);
+				zbx_timing_wheel_create(&config->queues[i], (int)time(NULL), __config_item_node_compare);
 				break;
 		}
 	}
@@ -8491,7 +8707,6 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 	const ZBX_DC_LOGITEM		*logitem;
 	const ZBX_DC_SNMPITEM		*snmpitem;
 	const ZBX_DC_SNMPINTERFACE	*snmp;
-	const ZBX_DC_TRAPITEM		*trapitem;
 	const ZBX_DC_IPMIITEM		*ipmiitem;
 	const ZBX_DC_DBITEM		*dbitem;
 	const ZBX_DC_SSHITEM		*sshitem;
@@ -8512,7 +8727,7 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 
 	dst_item->status = src_item->status;
 
-	zbx_strscpy(dst_item->key_orig, src_item->key);
+	dst_item->key_orig = zbx_strdup(NULL, src_item->key);
 
 	dst_item->itemid = src_item->itemid;
 	dst_item->flags = src_item->flags;
@@ -8531,10 +8746,10 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 			if (NULL != (logitem = (ZBX_DC_LOGITEM *)zbx_hashset_search(&config->logitems,
 					&src_item->itemid)))
 			{
-				zbx_strscpy(dst_item->logtimefmt, logitem->logtimefmt);
+				dst_item->logtimefmt = zbx_strdup(NULL, logitem->logtimefmt);
 			}
 			else
-				*dst_item->logtimefmt = '\0';
+				dst_item->logtimefmt = zbx_strdup(NULL, "");
 			break;
 	}
 
@@ -8551,60 +8766,43 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 
 			if (NULL != snmpitem && NULL != snmp)
 			{
-				zbx_strscpy(dst_item->snmp_community_orig, snmp->community);
-				zbx_strscpy(dst_item->snmp_oid_orig, snmpitem->snmp_oid);
-				zbx_strscpy(dst_item->snmpv3_securityname_orig, snmp->securityname);
+				dst_item->snmp_community = zbx_strdup(NULL, snmp->community);
+				dst_item->snmp_oid = zbx_strdup(NULL, snmpitem->snmp_oid);
+				dst_item->snmpv3_securityname = zbx_strdup(NULL, snmp->securityname);
 				dst_item->snmpv3_securitylevel = snmp->securitylevel;
-				zbx_strscpy(dst_item->snmpv3_authpassphrase_orig, snmp->authpassphrase);
-				zbx_strscpy(dst_item->snmpv3_privpassphrase_orig, snmp->privpassphrase);
+				dst_item->snmpv3_authpassphrase = zbx_strdup(NULL, snmp->authpassphrase);
+				dst_item->snmpv3_privpassphrase = zbx_strdup(NULL, snmp->privpassphrase);
 				dst_item->snmpv3_authprotocol = snmp->authprotocol;
 				dst_item->snmpv3_privprotocol = snmp->privprotocol;
-				zbx_strscpy(dst_item->snmpv3_contextname_orig, snmp->contextname);
+				dst_item->snmpv3_contextname = zbx_strdup(NULL, snmp->contextname);
 				dst_item->snmp_version = snmp->version;
 				dst_item->snmp_max_repetitions = snmp->max_repetitions;
 			}
 			else
 			{
-				*dst_item->snmp_community_orig = '\0';
-				*dst_item->snmp_oid_orig = '\0';
-				*dst_item->snmpv3_securityname_orig = '\0';
+				dst_item->snmp_community = zbx_strdup(NULL, "");
+				dst_item->snmp_oid = zbx_strdup(NULL, "");
+				dst_item->snmpv3_securityname = zbx_strdup(NULL, "");
 				dst_item->snmpv3_securitylevel = ZBX_ITEM_SNMPV3_SECURITYLEVEL_NOAUTHNOPRIV;
-				*dst_item->snmpv3_authpassphrase_orig = '\0';
-				*dst_item->snmpv3_privpassphrase_orig = '\0';
+				dst_item->snmpv3_authpassphrase = zbx_strdup(NULL, "");
+				dst_item->snmpv3_privpassphrase = zbx_strdup(NULL, "");
 				dst_item->snmpv3_authprotocol = 0;
 				dst_item->snmpv3_privprotocol = 0;
-				*dst_item->snmpv3_contextname_orig = '\0';
+				dst_item->snmpv3_contextname = zbx_strdup(NULL, "");
 				dst_item->snmp_version = ZBX_IF_SNMP_VERSION_2;
 				dst_item->snmp_max_repetitions = 0;
 			}
 
-			dst_item->snmp_community = NULL;
-			dst_item->snmp_oid = NULL;
-			dst_item->snmpv3_securityname = NULL;
-			dst_item->snmpv3_authpassphrase = NULL;
-			dst_item->snmpv3_privpassphrase = NULL;
-			dst_item->snmpv3_contextname = NULL;
-			break;
-		case ITEM_TYPE_TRAPPER:
-			if (NULL != (trapitem = (ZBX_DC_TRAPITEM *)zbx_hashset_search(&config->trapitems,
-					&src_item->itemid)))
-			{
-				zbx_strscpy(dst_item->trapper_hosts, trapitem->trapper_hosts);
-			}
-			else
-			{
-				*dst_item->trapper_hosts = '\0';
-			}
 			break;
 		case ITEM_TYPE_IPMI:
 			if (NULL != (ipmiitem = (ZBX_DC_IPMIITEM *)zbx_hashset_search(&config->ipmiitems,
 					&src_item->itemid)))
 			{
-				zbx_strscpy(dst_item->ipmi_sensor, ipmiitem->ipmi_sensor);
+				dst_item->ipmi_sensor = zbx_strdup(NULL, ipmiitem->ipmi_sensor);
 			}
 			else
 			{
-				*dst_item->ipmi_sensor = '\0';
+				dst_item->ipmi_sensor = zbx_strdup(NULL, "");
 			}
 			break;
 		case ITEM_TYPE_DB_MONITOR:
@@ -8612,17 +8810,15 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 					&src_item->itemid)))
 			{
 				dst_item->params = zbx_strdup(NULL, dbitem->params);
-				zbx_strscpy(dst_item->username_orig, dbitem->username);
-				zbx_strscpy(dst_item->password_orig, dbitem->password);
+				dst_item->username = zbx_strdup(NULL, dbitem->username);
+				dst_item->password = zbx_strdup(NULL, dbitem->password);
 			}
 			else
 			{
 				dst_item->params = zbx_strdup(NULL, "");
-				*dst_item->username_orig = '\0';
-				*dst_item->password_orig = '\0';
+				dst_item->username = zbx_strdup(NULL, "");
+				dst_item->password = zbx_strdup(NULL, "");
 			}
-			dst_item->username = NULL;
-			dst_item->password = NULL;
 
 			break;
 		case ITEM_TYPE_SSH:
@@ -8630,88 +8826,72 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 					&src_item->itemid)))
 			{
 				dst_item->authtype = sshitem->authtype;
-				zbx_strscpy(dst_item->username_orig, sshitem->username);
-				zbx_strscpy(dst_item->publickey_orig, sshitem->publickey);
-				zbx_strscpy(dst_item->privatekey_orig, sshitem->privatekey);
-				zbx_strscpy(dst_item->password_orig, sshitem->password);
+				dst_item->username = zbx_strdup(NULL, sshitem->username);
+				dst_item->publickey = zbx_strdup(NULL, sshitem->publickey);
+				dst_item->privatekey = zbx_strdup(NULL, sshitem->privatekey);
+				dst_item->password = zbx_strdup(NULL, sshitem->password);
 				dst_item->params = zbx_strdup(NULL, sshitem->params);
 			}
 			else
 			{
 				dst_item->authtype = 0;
-				*dst_item->username_orig = '\0';
-				*dst_item->publickey_orig = '\0';
-				*dst_item->privatekey_orig = '\0';
-				*dst_item->password_orig = '\0';
+				dst_item->username = zbx_strdup(NULL, "");
+				dst_item->publickey = zbx_strdup(NULL, "");
+				dst_item->privatekey = zbx_strdup(NULL, "");
+				dst_item->password = zbx_strdup(NULL, "");
 				dst_item->params = zbx_strdup(NULL, "");
 			}
-			dst_item->username = NULL;
-			dst_item->publickey = NULL;
-			dst_item->privatekey = NULL;
-			dst_item->password = NULL;
 			break;
 		case ITEM_TYPE_HTTPAGENT:
 			if (NULL != (httpitem = (ZBX_DC_HTTPITEM *)zbx_hashset_search(&config->httpitems,
 					&src_item->itemid)))
 			{
-				zbx_strscpy(dst_item->timeout_orig, httpitem->timeout);
-				zbx_strscpy(dst_item->url_orig, httpitem->url);
-				zbx_strscpy(dst_item->query_fields_orig, httpitem->query_fields);
-				zbx_strscpy(dst_item->status_codes_orig, httpitem->status_codes);
+				dst_item->timeout = zbx_strdup(NULL, httpitem->timeout);
+				dst_item->url = zbx_strdup(NULL, httpitem->url);
+				dst_item->query_fields = zbx_strdup(NULL, httpitem->query_fields);
+				dst_item->status_codes = zbx_strdup(NULL, httpitem->status_codes);
 				dst_item->follow_redirects = httpitem->follow_redirects;
 				dst_item->post_type = httpitem->post_type;
-				zbx_strscpy(dst_item->http_proxy_orig, httpitem->http_proxy);
+				dst_item->http_proxy = zbx_strdup(NULL, httpitem->http_proxy);
 				dst_item->headers = zbx_strdup(NULL, httpitem->headers);
 				dst_item->retrieve_mode = httpitem->retrieve_mode;
 				dst_item->request_method = httpitem->request_method;
 				dst_item->output_format = httpitem->output_format;
-				zbx_strscpy(dst_item->ssl_cert_file_orig, httpitem->ssl_cert_file);
-				zbx_strscpy(dst_item->ssl_key_file_orig, httpitem->ssl_key_file);
-				zbx_strscpy(dst_item->ssl_key_password_orig, httpitem->ssl_key_password);
+				dst_item->ssl_cert_file = zbx_strdup(NULL, httpitem->ssl_cert_file);
+				dst_item->ssl_key_file = zbx_strdup(NULL, httpitem->ssl_key_file);
+				dst_item->ssl_key_password = zbx_strdup(NULL, httpitem->ssl_key_password);
 				dst_item->verify_peer = httpitem->verify_peer;
 				dst_item->verify_host = httpitem->verify_host;
 				dst_item->authtype = httpitem->authtype;
-				zbx_strscpy(dst_item->username_orig, httpitem->username);
-				zbx_strscpy(dst_item->password_orig, httpitem->password);
+				dst_item->username = zbx_strdup(NULL, httpitem->username);
+				dst_item->password = zbx_strdup(NULL, httpitem->password);
 				dst_item->posts = zbx_strdup(NULL, httpitem->posts);
 				dst_item->allow_traps = httpitem->allow_traps;
-				zbx_strscpy(dst_item->trapper_hosts, httpitem->trapper_hosts);
 			}
 			else
 			{
-				*dst_item->timeout_orig = '\0';
-				*dst_item->url_orig = '\0';
-				*dst_item->query_fields_orig = '\0';
-				*dst_item->status_codes_orig = '\0';
+				dst_item->timeout = zbx_strdup(NULL, "");
+				dst_item->url = zbx_strdup(NULL, "");
+				dst_item->query_fields = zbx_strdup(NULL, "");
+				dst_item->status_codes = zbx_strdup(NULL, "");
 				dst_item->follow_redirects = 0;
 				dst_item->post_type = 0;
-				*dst_item->http_proxy_orig = '\0';
+				dst_item->http_proxy = zbx_strdup(NULL, "");
 				dst_item->headers = zbx_strdup(NULL, "");
 				dst_item->retrieve_mode = 0;
 				dst_item->request_method = 0;
 				dst_item->output_format = 0;
-				*dst_item->ssl_cert_file_orig = '\0';
-				*dst_item->ssl_key_file_orig = '\0';
-				*dst_item->ssl_key_password_orig = '\0';
+				dst_item->ssl_cert_file = zbx_strdup(NULL, "");
+				dst_item->ssl_key_file = zbx_strdup(NULL, "");
+				dst_item->ssl_key_password = zbx_strdup(NULL, "");
 				dst_item->verify_peer = 0;
 				dst_item->verify_host = 0;
 				dst_item->authtype = 0;
-				*dst_item->username_orig = '\0';
-				*dst_item->password_orig = '\0';
+				dst_item->username = zbx_strdup(NULL, "");
+				dst_item->password = zbx_strdup(NULL, "");
 				dst_item->posts = zbx_strdup(NULL, "");
 				dst_item->allow_traps = 0;
-				*dst_item->trapper_hosts = '\0';
-			}
-			dst_item->timeout = NULL;
-			dst_item->url = NULL;
-			dst_item->query_fields = NULL;
-			dst_item->status_codes = NULL;
-			dst_item->http_proxy = NULL;
-			dst_item->ssl_cert_file = NULL;
-			dst_item->ssl_key_file = NULL;
-			dst_item->ssl_key_password = NULL;
-			dst_item->username = NULL;
-			dst_item->password = NULL;
+			}
 			break;
 		case ITEM_TYPE_SCRIPT:
 			if (NULL != (scriptitem = (ZBX_DC_SCRIPTITEM *)zbx_hashset_search(&config->scriptitems,
@@ -8722,7 +8902,7 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 
 				zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 
-				zbx_strscpy(dst_item->timeout_orig, scriptitem->timeout);
+				dst_item->timeout = zbx_strdup(NULL, scriptitem->timeout);
 				dst_item->params = zbx_strdup(NULL, scriptitem->script);
 
 				for (i = 0; i < scriptitem->params.values_num; i++)
@@ -8738,62 +8918,54 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 			}
 			else
 			{
-				*dst_item->timeout_orig = '\0';
+				dst_item->timeout = zbx_strdup(NULL, "");
 				dst_item->params = zbx_strdup(NULL, "");
 				dst_item->script_params = zbx_strdup(NULL, "");
 			}
 
-			dst_item->timeout = NULL;
 			break;
 		case ITEM_TYPE_TELNET:
 			if (NULL != (telnetitem = (ZBX_DC_TELNETITEM *)zbx_hashset_search(&config->telnetitems,
 					&src_item->itemid)))
 			{
-				zbx_strscpy(dst_item->username_orig, telnetitem->username);
-				zbx_strscpy(dst_item->password_orig, telnetitem->password);
+				dst_item->username = zbx_strdup(NULL, telnetitem->username);
+				dst_item->password = zbx_strdup(NULL, telnetitem->password);
 				dst_item->params = zbx_strdup(NULL, telnetitem->params);
 			}
 			else
 			{
-				*dst_item->username_orig = '\0';
-				*dst_item->password_orig = '\0';
+				dst_item->username = zbx_strdup(NULL, "");
+				dst_item->password = zbx_strdup(NULL, "");
 				dst_item->params = zbx_strdup(NULL, "");
 			}
-			dst_item->username = NULL;
-			dst_item->password = NULL;
 			break;
 		case ITEM_TYPE_SIMPLE:
 			if (NULL != (simpleitem = (ZBX_DC_SIMPLEITEM *)zbx_hashset_search(&config->simpleitems,
 					&src_item->itemid)))
 			{
-				zbx_strscpy(dst_item->username_orig, simpleitem->username);
-				zbx_strscpy(dst_item->password_orig, simpleitem->password);
+				dst_item->username = zbx_strdup(NULL, simpleitem->username);
+				dst_item->password = zbx_strdup(NULL, simpleitem->password);
 			}
 			else
 			{
-				*dst_item->username_orig = '\0';
-				*dst_item->password_orig = '\0';
+				dst_item->username = zbx_strdup(NULL, "");
+				dst_item->password = zbx_strdup(NULL, "");
 			}
-			dst_item->username = NULL;
-			dst_item->password = NULL;
 			break;
 		case ITEM_TYPE_JMX:
 			if (NULL != (jmxitem = (ZBX_DC_JMXITEM *)zbx_hashset_search(&config->jmxitems,
 					&src_item->itemid)))
 			{
-				zbx_strscpy(dst_item->username_orig, jmxitem->username);
-				zbx_strscpy(dst_item->password_orig, jmxitem->password);
-				zbx_strscpy(dst_item->jmx_endpoint_orig, jmxitem->jmx_endpoint);
+				dst_item->username = zbx_strdup(NULL, jmxitem->username);
+				dst_item->password = zbx_strdup(NULL, jmxitem->password);
+				dst_item->jmx_endpoint = zbx_strdup(NULL, jmxitem->jmx_endpoint);
 			}
 			else
 			{
-				*dst_item->username_orig = '\0';
-				*dst_item->password_orig = '\0';
-				*dst_item->jmx_endpoint_orig = '\0';
+				dst_item->username = zbx_strdup(NULL, "");
+				dst_item->password = zbx_strdup(NULL, "");
+				dst_item->jmx_endpoint = zbx_strdup(NULL, "");
 			}
-			dst_item->username = NULL;
-			dst_item->password = NULL;
-			dst_item->jmx_endpoint = NULL;
 			break;
 		case ITEM_TYPE_CALCULATED:
 			if (NULL != (calcitem = (ZBX_DC_CALCITEM *)zbx_hashset_search(&config->calcitems,
@@ -8823,19 +8995,57 @@ void	DCconfig_clean_items(DC_ITEM *items, int *errcodes, size_t num)
 		if (NULL != errcodes && SUCCEED != errcodes[i])
 			continue;
 
+		if (ITEM_VALUE_TYPE_LOG == items[i].value_type)
+			zbx_free(items[i].logtimefmt);
+
 		switch (items[i].type)
 		{
+			case ITEM_TYPE_SNMP:
+				zbx_free(items[i].snmp_community);
+				zbx_free(items[i].snmp_oid);
+				zbx_free(items[i].snmpv3_securityname);
+				zbx_free(items[i].snmpv3_authpassphrase);
+				zbx_free(items[i].snmpv3_privpassphrase);
+				zbx_free(items[i].snmpv3_contextname);
+				break;
+			case ITEM_TYPE_IPMI:
+				zbx_free(items[i].ipmi_sensor);
+				break;
 			case ITEM_TYPE_HTTPAGENT:
+				zbx_free(items[i].timeout);
+				zbx_free(items[i].url);
+				zbx_free(items[i].query_fields);
+				zbx_free(items[i].status_codes);
+				zbx_free(items[i].http_proxy);
+				zbx_free(items[i].ssl_cert_file);
+				zbx_free(items[i].ssl_key_file);
+				zbx_free(items[i].ssl_key_password);
+				zbx_free(items[i].username);
+				zbx_free(items[i].password);
 				zbx_free(items[i].headers);
 				zbx_free(items[i].posts);
 				break;
 			case ITEM_TYPE_SCRIPT:
+				zbx_free(items[i].timeout);
 				zbx_free(items[i].script_params);
+				zbx_free(items[i].params);
+				break;
+			case ITEM_TYPE_SSH:
+				zbx_free(items[i].publickey);
+				zbx_free(items[i].privatekey);
 				ZBX_FALLTHROUGH;
 			case ITEM_TYPE_DB_MONITOR:
-			case ITEM_TYPE_SSH:
 			case ITEM_TYPE_TELNET:
 				zbx_free(items[i].params);
+				ZBX_FALLTHROUGH;
+			case ITEM_TYPE_SIMPLE:
+				zbx_free(items[i].username);
+				zbx_free(items[i].password);
+				break;
+			case ITEM_TYPE_JMX:
+				zbx_free(items[i].username);
+				zbx_free(items[i].password);
+				zbx_free(items[i].jmx_endpoint);
 				break;
 			case ITEM_TYPE_CALCULATED:
 				zbx_free(items[i].params);
@@ -8843,6 +9053,7 @@ void	DCconfig_clean_items(DC_ITEM *items, int *errcodes, size_t num)
 				break;
 		}
 
+		zbx_free(items[i].key_orig);
 		zbx_free(items[i].delay);
 		zbx_free(items[i].error);
 	}
@@ -9046,7 +9257,7 @@ void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids,
 
 	for (i = 0; i < num; i++)
 	{
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) ||
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemids[i])) ||
 				NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
 		{
 			errcodes[i] = FAIL;
@@ -9290,7 +9501,7 @@ static void	dc_preproc_add_item_rec(ZBX_DC_ITEM *dc_item, zbx_vector_dc_item_ptr
 		{
 			ZBX_DC_ITEM	*dep_item;
 
-			if (NULL == (dep_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items,
+			if (NULL == (dep_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items,
 					&dc_item->master_item->dep_itemids.values[i].first)))
 			{
 				continue;
@@ -9419,7 +9630,7 @@ void	DCconfig_get_hosts_by_itemids(DC_HOST *hosts, const zbx_uint64_t *itemids,
 
 	for (i = 0; i < num; i++)
 	{
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) ||
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemids[i])) ||
 				NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
 		{
 			errcodes[i] = FAIL;
@@ -9599,7 +9810,7 @@ int	DCconfig_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items, zbx
 		if (0 != (ZBX_DC_FLAG_NOVALUE & history_item->tail->flags))
 			continue;
 
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &history_item->itemid)))
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &history_item->itemid)))
 			continue;
 
 		if (NULL == dc_item->triggers)
@@ -9747,7 +9958,7 @@ static int	DCconfig_find_active_time_function(const char *expression, const unsi
 		if (ZBX_TRIGGER_TIMER_DEFAULT != trigger_timer || ZBX_FUNCTION_TYPE_TRENDS == dc_function->type ||
 				ZBX_FUNCTION_TYPE_TIMER == dc_function->type)
 		{
-			if (NULL == (dc_item = zbx_hashset_search(&config->items, &dc_function->itemid)))
+			if (NULL == (dc_item = zbx_flatset_search(&config->items, &dc_function->itemid)))
 				continue;
 
 			if (NULL == (dc_host = zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -10272,7 +10483,7 @@ int	DCconfig_get_interface(DC_INTERFACE *interface, zbx_uint64_t hostid, zbx_uin
 
 	if (0 != itemid)
 	{
-		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemid)))
 			goto unlock;
 
 		if (0 != dc_item->interfaceid)
@@ -10315,23 +10526,9 @@ unlock:
  * Return value: nextcheck or FAIL if no items for the specified queue        *
  *                                                                            *
  ******************************************************************************/
-static int	dc_config_get_queue_nextcheck(zbx_binary_heap_t *queue)
+static int	dc_config_get_queue_nextcheck(const zbx_timing_wheel_t *queue)
 {
-	int				nextcheck;
-	const zbx_binary_heap_elem_t	*min;
-	const ZBX_DC_ITEM		*dc_item;
-
-	if (FAIL == zbx_binary_heap_empty(queue))
-	{
-		min = zbx_binary_heap_find_min(queue);
-		dc_item = (const ZBX_DC_ITEM *)min->data;
-
-		nextcheck = dc_item->nextcheck;
-	}
-	else
-		nextcheck = FAIL;
-
-	return nextcheck;
+	return zbx_timing_wheel_next_expiry(queue);
 }
 
 /******************************************************************************
@@ -10346,7 +10543,7 @@ static int	dc_config_get_queue_nextcheck(zbx_binary_heap_t *queue)
 int	DCconfig_get_poller_nextcheck(unsigned char poller_type)
 {
 	int			nextcheck;
-	zbx_binary_heap_t	*queue;
+	zbx_timing_wheel_t	*queue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
@@ -10428,7 +10625,8 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
 int	DCconfig_get_poller_items(unsigned char poller_type, int config_timeout, DC_ITEM **items)
 {
 	int			now, num = 0, max_items;
-	zbx_binary_heap_t	*queue;
+	zbx_timing_wheel_t	*queue;
+	zbx_timing_wheel_node_t	*node;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
@@ -10450,17 +10648,17 @@ int	DCconfig_get_poller_items(unsigned char poller_type, int config_timeout, DC_
 
 	WRLOCK_CACHE;
 
-	while (num < max_items && FAIL == zbx_binary_heap_empty(queue))
+	zbx_timing_wheel_advance(queue, now);
+
+	while (num < max_items && NULL != (node = zbx_timing_wheel_first_expired(queue)))
 	{
 		int				disable_until;
-		const zbx_binary_heap_elem_t	*min;
 		ZBX_DC_HOST			*dc_host;
 		ZBX_DC_INTERFACE		*dc_interface;
 		ZBX_DC_ITEM			*dc_item;
 		static const ZBX_DC_ITEM	*dc_item_prev = NULL;
 
-		min = zbx_binary_heap_find_min(queue);
-		dc_item = (ZBX_DC_ITEM *)min->data;
+		dc_item = (ZBX_DC_ITEM *)node->data;
 
 		if (dc_item->nextcheck > now)
 			break;
@@ -10479,7 +10677,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, int config_timeout, DC_
 			}
 		}
 
-		zbx_binary_heap_remove_min(queue);
+		zbx_timing_wheel_remove(queue, node);
 		dc_item->location = ZBX_LOC_NOWHERE;
 
 		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -10583,7 +10781,8 @@ int	DCconfig_get_poller_items(unsigned char poller_type, int config_timeout, DC_
 int	DCconfig_get_ipmi_poller_items(int now, int items_num, int config_timeout, DC_ITEM *items, int *nextcheck)
 {
 	int			num = 0;
-	zbx_binary_heap_t	*queue;
+	zbx_timing_wheel_t	*queue;
+	zbx_timing_wheel_node_t	*node;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -10591,21 +10790,21 @@ int	DCconfig_get_ipmi_poller_items(int now, int items_num, int config_timeout, D
 
 	WRLOCK_CACHE;
 
-	while (num < items_num && FAIL == zbx_binary_heap_empty(queue))
+	zbx_timing_wheel_advance(queue, now);
+
+	while (num < items_num && NULL != (node = zbx_timing_wheel_first_expired(queue)))
 	{
 		int				disable_until;
-		const zbx_binary_heap_elem_t	*min;
 		ZBX_DC_HOST			*dc_host;
 		ZBX_DC_INTERFACE		*dc_interface;
 		ZBX_DC_ITEM			*dc_item;
 
-		min = zbx_binary_heap_find_min(queue);
-		dc_item = (ZBX_DC_ITEM *)min->data;
+		dc_item = (ZBX_DC_ITEM *)node->data;
 
 		if (dc_item->nextcheck > now)
 			break;
 
-		zbx_binary_heap_remove_min(queue);
+		zbx_timing_wheel_remove(queue, node);
 		dc_item->location = ZBX_LOC_NOWHERE;
 
 		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -10736,7 +10935,7 @@ size_t	DCconfig_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, DC_ITEM
 
 	for (i = 0; i < dc_interface_snmpitem->itemids.values_num; i++)
 	{
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items,
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items,
 				&dc_interface_snmpitem->itemids.values[i])))
 		{
 			continue;
@@ -10778,7 +10977,7 @@ static void	dc_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks,
 		if (FAIL == errcodes[i])
 			continue;
 
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemids[i])))
 			continue;
 
 		if (ZBX_LOC_POLLER == dc_item->location)
@@ -10867,7 +11066,7 @@ void	zbx_dc_requeue_unreachable_items(zbx_uint64_t *itemids, size_t itemids_num)
 
 	for (i = 0; i < itemids_num; i++)
 	{
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemids[i])))
 			continue;
 
 		if (ZBX_LOC_POLLER == dc_item->location)
@@ -12442,7 +12641,7 @@ int	DCget_data_expected_from(zbx_uint64_t itemid, int *seconds)
 
 	RDLOCK_CACHE;
 
-	if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
+	if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemid)))
 		goto unlock;
 
 	if (ITEM_STATUS_ACTIVE != dc_item->status)
@@ -12489,7 +12688,7 @@ void	dc_get_hostids_by_functionids(const zbx_uint64_t *functionids, int function
 				continue;
 		}
 
-		if (NULL != (item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
+		if (NULL != (item = (const ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &function->itemid)))
 			zbx_vector_uint64_append(hostids, item->hostid);
 	}
 
@@ -12543,7 +12742,7 @@ static void	dc_get_hosts_by_functionids(const zbx_uint64_t *functionids, int fun
 			continue;
 		}
 
-		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &dc_function->itemid)))
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &dc_function->itemid)))
 			continue;
 
 		if (NULL == (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -13649,7 +13848,7 @@ void	DCconfig_items_apply_changes(const zbx_vector_ptr_t *item_diff)
 	{
 		diff = (const zbx_item_diff_t *)item_diff->values[i];
 
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &diff->itemid)))
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &diff->itemid)))
 			continue;
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTLOGSIZE & diff->flags))
@@ -13745,7 +13944,7 @@ int	DCget_host_inventory_value_by_itemid(zbx_uint64_t itemid, char **replace_to,
 
 	RDLOCK_CACHE;
 
-	if (NULL != (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
+	if (NULL != (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemid)))
 		ret = dc_get_host_inventory_value_by_hostid(dc_item->hostid, replace_to, value_idx);
 
 	UNLOCK_CACHE;
@@ -13863,7 +14062,7 @@ void	zbx_dc_reschedule_items(const zbx_vector_uint64_t *itemids, int nextcheck,
 
 	for (i = 0; i < itemids->values_num; i++)
 	{
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids->values[i])) ||
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemids->values[i])) ||
 				NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "cannot perform check now for itemid [" ZBX_FS_UI64 "]"
@@ -14301,7 +14500,7 @@ void	zbx_get_item_tags(zbx_uint64_t itemid, zbx_vector_ptr_t *item_tags)
 	zbx_item_tag_t		*tag;
 	int			n, i;
 
-	if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
+	if (NULL == (item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemid)))
 		return;
 
 	n = item_tags->values_num;
@@ -14960,15 +15159,15 @@ static void	dc_check_item_activation(ZBX_DC_ITEM *item, ZBX_DC_HOST *host,
 static void	dc_get_items_to_reschedule(const zbx_hashset_t *activated_hosts, zbx_vector_item_delay_t *items,
 		zbx_vector_ptr_pair_t *activated_items)
 {
-	zbx_hashset_iter_t	iter;
+	zbx_flatset_iter_t	iter;
 	ZBX_DC_ITEM		*item;
 	ZBX_DC_HOST		*host;
 	char			*delay_ex;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_hashset_iter_reset(&config->items, &iter);
-	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+	zbx_flatset_iter_reset(&config->items, &iter);
+	while (NULL != (item = (ZBX_DC_ITEM *)zbx_flatset_iter_next(&iter)))
 	{
 		if (ITEM_STATUS_ACTIVE != item->status ||
 				SUCCEED != zbx_is_counted_in_item_queue(item->type, item->key))
@@ -151,6 +151,8 @@ typedef struct
 	ZBX_DC_MASTERITEM	*master_item;
 
 	zbx_vector_ptr_t	tags;
+
+	zbx_timing_wheel_node_t	queue_node;
 }
 ZBX_DC_ITEM;
 
@@ -877,7 +879,7 @@ typedef struct
 
 	char			*session_token;
 
-	zbx_hashset_t		items;
+	zbx_flatset_t		items;
 	zbx_hashset_t		items_hk;		/* hostid, key */
 	zbx_hashset_t		item_discovery;
 	zbx_hashset_t		template_items;		/* template items selected from items table */
@@ -950,11 +952,13 @@ typedef struct
 	zbx_hashset_t		httpsteps;
 	zbx_hashset_t		httpstep_fields;
 	zbx_hashset_t		sessions[ZBX_SESSION_TYPE_COUNT];
-	zbx_binary_heap_t	queues[ZBX_POLLER_TYPE_COUNT];
+	zbx_timing_wheel_t	queues[ZBX_POLLER_TYPE_COUNT];
 	zbx_binary_heap_t	pqueue;
 	zbx_binary_heap_t	trigger_queue;
 	zbx_binary_heap_t	drule_queue;
 	zbx_binary_heap_t	httptest_queue;		/* web scenario queue */
+	double			*lock_wait[ZBX_PROCESS_TYPE_COUNT];	/* time spent waiting for cache lock by */
+									/* process type and process number      */
 	ZBX_DC_CONFIG_TABLE	*config;
 	ZBX_DC_STATUS		*status;
 	zbx_hashset_t		strpool;
@@ -969,8 +973,11 @@ extern ZBX_DC_CONFIG	*config;
 extern zbx_rwlock_t	config_lock;
 extern int		CONFIG_FORKS[ZBX_PROCESS_TYPE_COUNT];
 
-#define	RDLOCK_CACHE	if (0 == sync_in_progress) zbx_rwlock_rdlock(config_lock)
-#define	WRLOCK_CACHE	if (0 == sync_in_progress) zbx_rwlock_wrlock(config_lock)
+void	dc_rdlock_cache(void);
+void	dc_wrlock_cache(void);
+
+#define	RDLOCK_CACHE	if (0 == sync_in_progress) dc_rdlock_cache()
+#define	WRLOCK_CACHE	if (0 == sync_in_progress) dc_wrlock_cache()
 #define	UNLOCK_CACHE	if (0 == sync_in_progress) zbx_rwlock_unlock(config_lock)
 
 extern zbx_rwlock_t	config_history_lock;
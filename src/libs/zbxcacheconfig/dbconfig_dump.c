@@ -563,7 +563,7 @@ static void	DCdump_item_tags(const ZBX_DC_ITEM *item)
 static void	DCdump_items(void)
 {
 	ZBX_DC_ITEM		*item;
-	zbx_hashset_iter_t	iter;
+	zbx_flatset_iter_t	iter;
 	int			i, j;
 	zbx_vector_ptr_t	index;
 	void			*ptr;
@@ -587,9 +587,9 @@ static void	DCdump_items(void)
 	zabbix_log(LOG_LEVEL_TRACE, "In %s()", __func__);
 
 	zbx_vector_ptr_create(&index);
-	zbx_hashset_iter_reset(&config->items, &iter);
+	zbx_flatset_iter_reset(&config->items, &iter);
 
-	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+	while (NULL != (item = (ZBX_DC_ITEM *)zbx_flatset_iter_next(&iter)))
 		zbx_vector_ptr_append(&index, item);
 
 	zbx_vector_ptr_sort(&index, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
@@ -159,7 +159,7 @@ void	zbx_dc_config_history_sync_get_items_by_itemids(zbx_history_sync_item_t *it
 
 	for (i = 0; i < num; i++)
 	{
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemids[i])))
 		{
 			errcodes[i] = FAIL;
 			continue;
@@ -224,7 +224,7 @@ void	zbx_dc_config_history_sync_unset_existing_itemids(zbx_vector_uint64_t *item
 
 	for (i = 0; i < itemids->values_num; i++)
 	{
-		if (NULL != zbx_hashset_search(&config->items, &itemids->values[i]))
+		if (NULL != zbx_flatset_search(&config->items, &itemids->values[i]))
 			zbx_vector_uint64_remove_noorder(itemids, i--);
 	}
 
@@ -329,7 +329,7 @@ void	zbx_dc_config_history_sync_get_triggers_by_itemids(zbx_hashset_t *trigger_i
 	{
 		/* skip items which are not in configuration cache and items without triggers */
 
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) ||
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemids[i])) ||
 				NULL == dc_item->triggers)
 		{
 			continue;
@@ -721,7 +721,7 @@ void	zbx_dc_config_history_recv_get_items_by_itemids(zbx_history_recv_item_t *it
 
 	for (i = 0; i < num; i++)
 	{
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &itemids[i])))
 		{
 			errcodes[i] = FAIL;
 			continue;
@@ -777,7 +777,7 @@ void	zbx_dc_items_update_nextcheck(zbx_history_recv_item_t *items, zbx_agent_val
 		if (FAIL == zbx_is_counted_in_item_queue(items[i].type, items[i].key_orig))
 			continue;
 
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &items[i].itemid)))
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_flatset_search(&config->items, &items[i].itemid)))
 			continue;
 
 		if (ITEM_STATUS_ACTIVE != dc_item->status)
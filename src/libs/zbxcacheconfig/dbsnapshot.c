@@ -0,0 +1,845 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dbsnapshot.h"
+
+#include "zbxcommon.h"
+#include "zbxstr.h"
+#include "log.h"
+#include "zbxtime.h"
+#include "version.h"
+
+#include <sys/mman.h>
+
+/*
+ * Configuration cache snapshot file layout:
+ *
+ *   header | record | record | ... | footer
+ *
+ * The records are appended while the configuration is synchronized - rows of the initial
+ * synchronization followed by the changed rows read from changelog journals. The footer
+ * is written only when the snapshot is closed on clean shutdown, so a snapshot without
+ * footer is never loaded.
+ *
+ * Each record starts with zbx_dbsnapshot_rec_t header followed by values_num values,
+ * stored as 32 bit length (ZBX_DBSNAPSHOT_NULL for NULL values) and zero terminated
+ * string. Records are padded to 8 bytes.
+ */
+
+#define ZBX_DBSNAPSHOT_MAGIC		"ZBXCSNAP"
+#define ZBX_DBSNAPSHOT_FOOTER_MAGIC	"ZBXCSEND"
+#define ZBX_DBSNAPSHOT_VERSION		1
+
+#define ZBX_DBSNAPSHOT_NULL		0xffffffff
+#define ZBX_DBSNAPSHOT_ALIGN(x)		(((x) + 7) & ~(size_t)7)
+
+/* compact the snapshot when appended changes exceed the initial size and this limit */
+#define ZBX_DBSNAPSHOT_COMPACT_MIN	(16 * ZBX_MEBIBYTE)
+
+typedef struct
+{
+	char		magic[8];
+	zbx_uint32_t	version;
+	zbx_uint32_t	header_size;
+	char		build[64];
+	char		source[128];
+}
+zbx_dbsnapshot_header_t;
+
+typedef struct
+{
+	zbx_uint64_t	revision;
+	zbx_uint64_t	records_size;
+	zbx_uint32_t	clock;
+	zbx_uint32_t	reserved;
+	char		magic[8];
+}
+zbx_dbsnapshot_footer_t;
+
+typedef struct
+{
+	zbx_uint64_t	rowid;
+	zbx_uint32_t	size;
+	unsigned char	type;
+	unsigned char	object;
+	unsigned short	values_num;
+}
+zbx_dbsnapshot_rec_t;
+
+struct zbx_dbsnapshot_writer
+{
+	char		*filename;
+	char		*source;
+	FILE		*file;
+
+	/* the size of records written to the file */
+	zbx_uint64_t	size;
+
+	/* the size of records after the initial synchronization or last compaction */
+	zbx_uint64_t	base_size;
+
+	/* the record serialization buffer */
+	unsigned char	*buf;
+	size_t		buf_alloc;
+};
+
+ZBX_VECTOR_IMPL(dbsnapshot_row, zbx_dbsnapshot_row_t)
+
+static void	dbsnapshot_init(zbx_dbsnapshot_t *snapshot)
+{
+	int	i;
+
+	memset(snapshot, 0, sizeof(zbx_dbsnapshot_t));
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_OBJ_MAX; i++)
+	{
+		zbx_vector_dbsnapshot_row_create(&snapshot->rows[i]);
+		zbx_vector_dbsnapshot_row_create(&snapshot->rtdata[i]);
+	}
+
+	zbx_vector_dbsnapshot_row_create(&snapshot->changelog);
+}
+
+static void	dbsnapshot_header_init(zbx_dbsnapshot_header_t *header, const char *source)
+{
+	memset(header, 0, sizeof(zbx_dbsnapshot_header_t));
+	memcpy(header->magic, ZBX_DBSNAPSHOT_MAGIC, sizeof(header->magic));
+	header->version = ZBX_DBSNAPSHOT_VERSION;
+	header->header_size = sizeof(zbx_dbsnapshot_header_t);
+	/* changeset columns depend on build options */
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	zbx_strscpy(header->build, ZABBIX_VERSION " (revision " ZABBIX_REVISION ", TLS)");
+#else
+	zbx_strscpy(header->build, ZABBIX_VERSION " (revision " ZABBIX_REVISION ")");
+#endif
+	zbx_strscpy(header->source, source);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validates record and returns its size                             *
+ *                                                                            *
+ * Parameters: data - [IN] the record data                                    *
+ *             left - [IN] the number of bytes left in records area           *
+ *             rec  - [OUT] the record header                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the record is valid                                *
+ *               FAIL    - the record is corrupted                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_check_record(const unsigned char *data, size_t left, zbx_dbsnapshot_rec_t *rec)
+{
+	const unsigned char	*ptr, *end;
+	zbx_uint32_t		len;
+	int			i;
+
+	if (left < sizeof(zbx_dbsnapshot_rec_t))
+		return FAIL;
+
+	memcpy(rec, data, sizeof(zbx_dbsnapshot_rec_t));
+
+	if (rec->size > left || rec->size < sizeof(zbx_dbsnapshot_rec_t) || 0 != rec->size % 8)
+		return FAIL;
+
+	if (ZBX_DBSNAPSHOT_OBJ_MAX <= rec->object || ZBX_DBSNAPSHOT_REC_ADD > rec->type ||
+			ZBX_DBSNAPSHOT_REC_CHANGELOG < rec->type)
+	{
+		return FAIL;
+	}
+
+	ptr = data + sizeof(zbx_dbsnapshot_rec_t);
+	end = data + rec->size;
+
+	for (i = 0; i < rec->values_num; i++)
+	{
+		if ((size_t)(end - ptr) < sizeof(len))
+			return FAIL;
+
+		memcpy(&len, ptr, sizeof(len));
+		ptr += sizeof(len);
+
+		if (ZBX_DBSNAPSHOT_NULL == len)
+			continue;
+
+		if ((size_t)(end - ptr) <= len || '\0' != ptr[len])
+			return FAIL;
+
+		ptr += len + 1;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replays snapshot records, keeping only the last row of objects    *
+ *                                                                            *
+ * Parameters: snapshot - [IN/OUT] the snapshot                               *
+ *             data     - [IN] the records                                    *
+ *             size     - [IN] the records size                               *
+ *                                                                            *
+ * Return value: SUCCEED - the records were replayed                          *
+ *               FAIL    - the records are corrupted                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_replay(zbx_dbsnapshot_t *snapshot, const unsigned char *data, size_t size)
+{
+	zbx_hashset_t		rows[ZBX_DBSNAPSHOT_OBJ_MAX];
+	zbx_hashset_iter_t	iter;
+	zbx_dbsnapshot_rec_t	rec;
+	zbx_dbsnapshot_row_t	row_local, *row;
+	const unsigned char	*ptr = data, *end = data + size;
+	int			i, ret = FAIL;
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_OBJ_MAX; i++)
+		zbx_hashset_create(&rows[i], 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (; ptr < end; ptr += rec.size)
+	{
+		if (SUCCEED != dbsnapshot_check_record(ptr, (size_t)(end - ptr), &rec))
+			goto out;
+
+		row_local.rowid = rec.rowid;
+		row_local.data = ptr;
+
+		switch (rec.type)
+		{
+			case ZBX_DBSNAPSHOT_REC_ADD:
+			case ZBX_DBSNAPSHOT_REC_UPDATE:
+				if (NULL != (row = (zbx_dbsnapshot_row_t *)zbx_hashset_search(&rows[rec.object],
+						&row_local)))
+				{
+					row->data = ptr;
+				}
+				else
+					zbx_hashset_insert(&rows[rec.object], &row_local, sizeof(row_local));
+				break;
+			case ZBX_DBSNAPSHOT_REC_REMOVE:
+				zbx_hashset_remove(&rows[rec.object], &row_local);
+				break;
+			case ZBX_DBSNAPSHOT_REC_RTDATA:
+				zbx_vector_dbsnapshot_row_append(&snapshot->rtdata[rec.object], row_local);
+				break;
+			case ZBX_DBSNAPSHOT_REC_CHANGELOG:
+				zbx_vector_dbsnapshot_row_append(&snapshot->changelog, row_local);
+				break;
+		}
+	}
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_OBJ_MAX; i++)
+	{
+		zbx_vector_dbsnapshot_row_reserve(&snapshot->rows[i], (size_t)rows[i].num_data);
+
+		zbx_hashset_iter_reset(&rows[i], &iter);
+		while (NULL != (row = (zbx_dbsnapshot_row_t *)zbx_hashset_iter_next(&iter)))
+			zbx_vector_dbsnapshot_row_append(&snapshot->rows[i], *row);
+
+		zbx_vector_dbsnapshot_row_sort(&snapshot->rows[i], ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_dbsnapshot_row_sort(&snapshot->rtdata[i], ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	ret = SUCCEED;
+out:
+	for (i = 0; i < ZBX_DBSNAPSHOT_OBJ_MAX; i++)
+		zbx_hashset_destroy(&rows[i]);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: maps snapshot file into memory                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_map(zbx_dbsnapshot_t *snapshot, const char *filename, char **error)
+{
+	int		fd, ret = FAIL;
+	zbx_stat_t	st;
+
+	if (-1 == (fd = open(filename, O_RDONLY)))
+	{
+		if (ENOENT != errno)
+			*error = zbx_dsprintf(*error, "cannot open file: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 != zbx_fstat(fd, &st))
+	{
+		*error = zbx_dsprintf(*error, "cannot obtain file information: %s", zbx_strerror(errno));
+		goto out;
+	}
+
+	if ((zbx_uint64_t)st.st_size < sizeof(zbx_dbsnapshot_header_t) + sizeof(zbx_dbsnapshot_footer_t))
+	{
+		*error = zbx_strdup(*error, "file is too small");
+		goto out;
+	}
+
+	/* private writable mapping allows using the values in place as database row columns */
+	if (MAP_FAILED == (snapshot->map = (unsigned char *)mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE, fd, 0)))
+	{
+		snapshot->map = NULL;
+		*error = zbx_dsprintf(*error, "cannot map file: %s", zbx_strerror(errno));
+		goto out;
+	}
+
+	snapshot->map_size = (size_t)st.st_size;
+
+	ret = SUCCEED;
+out:
+	close(fd);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads configuration cache snapshot                                *
+ *                                                                            *
+ * Parameters: snapshot - [OUT] the snapshot                                  *
+ *             filename - [IN] the snapshot file name                         *
+ *             source   - [IN] the configuration source (database) identity,  *
+ *                             must match the one snapshot was written with   *
+ *             max_age  - [IN] the maximum snapshot age in seconds            *
+ *             error    - [OUT] the error message, NULL if snapshot file does *
+ *                              not exist                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded                            *
+ *               FAIL    - the snapshot does not exist or cannot be used      *
+ *                                                                            *
+ * Comments: The snapshot must be freed with zbx_dbsnapshot_free() also when  *
+ *           loading fails.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_load(zbx_dbsnapshot_t *snapshot, const char *filename, const char *source, int max_age,
+		char **error)
+{
+	zbx_dbsnapshot_header_t	header, header_local;
+	zbx_dbsnapshot_footer_t	footer;
+	int			now;
+
+	dbsnapshot_init(snapshot);
+
+	if (SUCCEED != dbsnapshot_map(snapshot, filename, error))
+		return FAIL;
+
+	memcpy(&header, snapshot->map, sizeof(header));
+	memcpy(&footer, snapshot->map + snapshot->map_size - sizeof(footer), sizeof(footer));
+
+	dbsnapshot_header_init(&header_local, source);
+
+	if (0 != memcmp(header.magic, header_local.magic, sizeof(header.magic)) ||
+			header.version != header_local.version || header.header_size != header_local.header_size)
+	{
+		*error = zbx_strdup(*error, "unsupported file format");
+		return FAIL;
+	}
+
+	if (0 != strncmp(header.build, header_local.build, sizeof(header.build)))
+	{
+		*error = zbx_dsprintf(*error, "snapshot was written by different version \"%.*s\"",
+				(int)sizeof(header.build), header.build);
+		return FAIL;
+	}
+
+	if (0 != strncmp(header.source, header_local.source, sizeof(header.source)))
+	{
+		*error = zbx_strdup(*error, "snapshot was written from different database");
+		return FAIL;
+	}
+
+	if (0 != memcmp(footer.magic, ZBX_DBSNAPSHOT_FOOTER_MAGIC, sizeof(footer.magic)) ||
+			footer.records_size != snapshot->map_size - sizeof(header) - sizeof(footer))
+	{
+		*error = zbx_strdup(*error, "snapshot was not closed properly");
+		return FAIL;
+	}
+
+	now = (int)time(NULL);
+
+	if (now - (int)footer.clock > max_age || (int)footer.clock > now)
+	{
+		*error = zbx_dsprintf(*error, "snapshot is too old (%d seconds)", now - (int)footer.clock);
+		return FAIL;
+	}
+
+	if (SUCCEED != dbsnapshot_replay(snapshot, snapshot->map + sizeof(header), (size_t)footer.records_size))
+	{
+		*error = zbx_strdup(*error, "snapshot is corrupted");
+		return FAIL;
+	}
+
+	snapshot->revision = footer.revision;
+	snapshot->clock = (int)footer.clock;
+
+	return SUCCEED;
+}
+
+void	zbx_dbsnapshot_free(zbx_dbsnapshot_t *snapshot)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_OBJ_MAX; i++)
+	{
+		zbx_vector_dbsnapshot_row_destroy(&snapshot->rows[i]);
+		zbx_vector_dbsnapshot_row_destroy(&snapshot->rtdata[i]);
+	}
+
+	zbx_vector_dbsnapshot_row_destroy(&snapshot->changelog);
+
+	if (NULL != snapshot->map)
+	{
+		munmap(snapshot->map, snapshot->map_size);
+		snapshot->map = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets snapshot row values                                          *
+ *                                                                            *
+ * Parameters: row        - [IN] the snapshot row                             *
+ *             values     - [OUT] the row values, pointing to mapped file     *
+ *             values_num - [IN] the number of values to get                  *
+ *                                                                            *
+ * Return value: SUCCEED - the values were retrieved                          *
+ *               FAIL    - the row has different number of values             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_get_row(const zbx_dbsnapshot_row_t *row, char **values, int values_num)
+{
+	zbx_dbsnapshot_rec_t	rec;
+	const unsigned char	*ptr;
+	zbx_uint32_t		len;
+	int			i;
+
+	memcpy(&rec, row->data, sizeof(rec));
+
+	if (rec.values_num != values_num)
+		return FAIL;
+
+	ptr = row->data + sizeof(rec);
+
+	/* the values were validated when replaying snapshot records */
+	for (i = 0; i < values_num; i++)
+	{
+		memcpy(&len, ptr, sizeof(len));
+		ptr += sizeof(len);
+
+		if (ZBX_DBSNAPSHOT_NULL == len)
+		{
+			values[i] = NULL;
+			continue;
+		}
+
+		values[i] = (char *)ptr;
+		ptr += len + 1;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds object runtime data                                         *
+ *                                                                            *
+ ******************************************************************************/
+const zbx_dbsnapshot_row_t	*zbx_dbsnapshot_get_rtdata(const zbx_dbsnapshot_t *snapshot, unsigned char object,
+		zbx_uint64_t rowid)
+{
+	zbx_dbsnapshot_row_t	row_local;
+	int			i;
+
+	row_local.rowid = rowid;
+
+	if (FAIL == (i = zbx_vector_dbsnapshot_row_bsearch(&snapshot->rtdata[object], row_local,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+	{
+		return NULL;
+	}
+
+	return &snapshot->rtdata[object].values[i];
+}
+
+static int	dbsnapshot_write(zbx_dbsnapshot_writer_t *writer, const void *data, size_t size, char **error)
+{
+	if (1 != fwrite(data, size, 1, writer->file))
+	{
+		*error = zbx_dsprintf(*error, "cannot write to file \"%s\": %s", writer->filename,
+				zbx_strerror(errno));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static FILE	*dbsnapshot_create(const char *filename, const char *source, char **error)
+{
+	FILE			*file;
+	int			fd;
+	zbx_dbsnapshot_header_t	header;
+
+	/* unlink the old file instead of truncating it - it can still be mapped by loaded snapshot */
+	if (0 != unlink(filename) && ENOENT != errno)
+	{
+		*error = zbx_dsprintf(*error, "cannot remove file \"%s\": %s", filename, zbx_strerror(errno));
+		return NULL;
+	}
+
+	/* the snapshot contains secrets (PSK, credentials), it must be readable only by owner */
+	if (-1 == (fd = open(filename, O_WRONLY | O_CREAT | O_EXCL, 0600)))
+	{
+		*error = zbx_dsprintf(*error, "cannot create file \"%s\": %s", filename, zbx_strerror(errno));
+		return NULL;
+	}
+
+	if (NULL == (file = fdopen(fd, "wb")))
+	{
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", filename, zbx_strerror(errno));
+		close(fd);
+		return NULL;
+	}
+
+	dbsnapshot_header_init(&header, source);
+
+	if (1 != fwrite(&header, sizeof(header), 1, file))
+	{
+		*error = zbx_dsprintf(*error, "cannot write to file \"%s\": %s", filename, zbx_strerror(errno));
+		fclose(file);
+		return NULL;
+	}
+
+	return file;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates new snapshot file for writing                             *
+ *                                                                            *
+ * Parameters: filename - [IN] the snapshot file name                         *
+ *             source   - [IN] the configuration source (database) identity   *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: the snapshot writer or NULL on error                         *
+ *                                                                            *
+ ******************************************************************************/
+zbx_dbsnapshot_writer_t	*zbx_dbsnapshot_writer_open(const char *filename, const char *source, char **error)
+{
+	zbx_dbsnapshot_writer_t	*writer;
+	FILE			*file;
+
+	if (NULL == (file = dbsnapshot_create(filename, source, error)))
+		return NULL;
+
+	writer = (zbx_dbsnapshot_writer_t *)zbx_malloc(NULL, sizeof(zbx_dbsnapshot_writer_t));
+	memset(writer, 0, sizeof(zbx_dbsnapshot_writer_t));
+
+	writer->filename = zbx_strdup(NULL, filename);
+	writer->source = zbx_strdup(NULL, source);
+	writer->file = file;
+
+	return writer;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends record to snapshot                                        *
+ *                                                                            *
+ * Parameters: writer     - [IN] the snapshot writer                          *
+ *             type       - [IN] the record type (ZBX_DBSNAPSHOT_REC_*)       *
+ *             object     - [IN] the object the record belongs to             *
+ *             rowid      - [IN] the row identifier                           *
+ *             values     - [IN] the values, can be NULL for removed rows     *
+ *             values_num - [IN] the number of values                         *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value: SUCCEED - the record was written                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_writer_add(zbx_dbsnapshot_writer_t *writer, unsigned char type, unsigned char object,
+		zbx_uint64_t rowid, char **values, int values_num, char **error)
+{
+	zbx_dbsnapshot_rec_t	rec;
+	size_t			size, len;
+	zbx_uint32_t		len32;
+	unsigned char		*ptr;
+	int			i;
+
+	if (NULL == values)
+		values_num = 0;
+
+	size = sizeof(rec);
+
+	for (i = 0; i < values_num; i++)
+		size += sizeof(len32) + (NULL == values[i] ? 0 : strlen(values[i]) + 1);
+
+	size = ZBX_DBSNAPSHOT_ALIGN(size);
+
+	if (UINT32_MAX < size)
+	{
+		*error = zbx_dsprintf(*error, "row " ZBX_FS_UI64 " is too large", rowid);
+		return FAIL;
+	}
+
+	if (writer->buf_alloc < size)
+	{
+		writer->buf_alloc = size;
+		writer->buf = (unsigned char *)zbx_realloc(writer->buf, writer->buf_alloc);
+	}
+
+	memset(&rec, 0, sizeof(rec));
+	rec.rowid = rowid;
+	rec.size = (zbx_uint32_t)size;
+	rec.type = type;
+	rec.object = object;
+	rec.values_num = (unsigned short)values_num;
+
+	memcpy(writer->buf, &rec, sizeof(rec));
+	ptr = writer->buf + sizeof(rec);
+
+	for (i = 0; i < values_num; i++)
+	{
+		if (NULL == values[i])
+		{
+			len32 = ZBX_DBSNAPSHOT_NULL;
+			memcpy(ptr, &len32, sizeof(len32));
+			ptr += sizeof(len32);
+			continue;
+		}
+
+		len = strlen(values[i]);
+		len32 = (zbx_uint32_t)len;
+		memcpy(ptr, &len32, sizeof(len32));
+		ptr += sizeof(len32);
+		memcpy(ptr, values[i], len + 1);
+		ptr += len + 1;
+	}
+
+	memset(ptr, 0, size - (size_t)(ptr - writer->buf));
+
+	if (SUCCEED != dbsnapshot_write(writer, writer->buf, size, error))
+		return FAIL;
+
+	writer->size += size;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: rewrites snapshot keeping only the last rows of objects           *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_compact(zbx_dbsnapshot_writer_t *writer, char **error)
+{
+	zbx_dbsnapshot_t	snapshot;
+	FILE			*file = NULL;
+	char			*filename_tmp;
+	int			i, j, ret = FAIL;
+	zbx_uint64_t		size = 0;
+	double			sec;
+
+	sec = zbx_time();
+	filename_tmp = zbx_dsprintf(NULL, "%s.tmp", writer->filename);
+
+	dbsnapshot_init(&snapshot);
+
+	if (SUCCEED != dbsnapshot_map(&snapshot, writer->filename, error))
+	{
+		if (NULL == *error)
+			*error = zbx_dsprintf(*error, "file \"%s\" was removed", writer->filename);
+		goto out;
+	}
+
+	if (SUCCEED != dbsnapshot_replay(&snapshot, snapshot.map + sizeof(zbx_dbsnapshot_header_t),
+			(size_t)writer->size))
+	{
+		*error = zbx_dsprintf(*error, "file \"%s\" is corrupted", writer->filename);
+		goto out;
+	}
+
+	if (NULL == (file = dbsnapshot_create(filename_tmp, writer->source, error)))
+		goto out;
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_OBJ_MAX; i++)
+	{
+		for (j = 0; j < snapshot.rows[i].values_num; j++)
+		{
+			zbx_dbsnapshot_rec_t	rec;
+			zbx_dbsnapshot_row_t	*row = &snapshot.rows[i].values[j];
+
+			memcpy(&rec, row->data, sizeof(rec));
+
+			/* the surviving rows become initial rows of the compacted snapshot */
+			if (ZBX_DBSNAPSHOT_REC_ADD != rec.type)
+			{
+				rec.type = ZBX_DBSNAPSHOT_REC_ADD;
+
+				if (1 != fwrite(&rec, sizeof(rec), 1, file) || 1 != fwrite(row->data + sizeof(rec),
+						rec.size - sizeof(rec), 1, file))
+				{
+					goto write_error;
+				}
+			}
+			else if (1 != fwrite(row->data, rec.size, 1, file))
+				goto write_error;
+
+			size += rec.size;
+		}
+	}
+
+	if (0 != fflush(file))
+		goto write_error;
+
+	if (0 != rename(filename_tmp, writer->filename))
+	{
+		*error = zbx_dsprintf(*error, "cannot rename file \"%s\": %s", filename_tmp, zbx_strerror(errno));
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "compacted configuration cache snapshot from " ZBX_FS_UI64 " to " ZBX_FS_UI64
+			" bytes in " ZBX_FS_DBL " sec", writer->size, size, zbx_time() - sec);
+
+	fclose(writer->file);
+	writer->file = file;
+	writer->size = size;
+	writer->base_size = size;
+	file = NULL;
+
+	ret = SUCCEED;
+	goto out;
+write_error:
+	*error = zbx_dsprintf(*error, "cannot write to file \"%s\": %s", filename_tmp, zbx_strerror(errno));
+out:
+	if (NULL != file)
+	{
+		fclose(file);
+		unlink(filename_tmp);
+	}
+
+	zbx_dbsnapshot_free(&snapshot);
+	zbx_free(filename_tmp);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: flushes written records to file, compacting the snapshot when the *
+ *          appended changes outgrow the initial rows                         *
+ *                                                                            *
+ * Parameters: writer - [IN] the snapshot writer                              *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - the records were flushed                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_writer_flush(zbx_dbsnapshot_writer_t *writer, char **error)
+{
+	if (0 != fflush(writer->file))
+	{
+		*error = zbx_dsprintf(*error, "cannot write to file \"%s\": %s", writer->filename,
+				zbx_strerror(errno));
+		return FAIL;
+	}
+
+	/* the first flush is done after initial synchronization */
+	if (0 == writer->base_size)
+	{
+		writer->base_size = writer->size;
+		return SUCCEED;
+	}
+
+	if (writer->size - writer->base_size < MAX(writer->base_size, ZBX_DBSNAPSHOT_COMPACT_MIN))
+		return SUCCEED;
+
+	return dbsnapshot_compact(writer, error);
+}
+
+static void	dbsnapshot_writer_free(zbx_dbsnapshot_writer_t *writer)
+{
+	zbx_free(writer->buf);
+	zbx_free(writer->source);
+	zbx_free(writer->filename);
+	zbx_free(writer);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: closes snapshot making it available for loading                   *
+ *                                                                            *
+ * Parameters: writer   - [IN] the snapshot writer, freed by this function    *
+ *             revision - [IN] the configuration revision                     *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was closed                            *
+ *               FAIL    - otherwise, the snapshot file is removed            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_writer_close(zbx_dbsnapshot_writer_t *writer, zbx_uint64_t revision, char **error)
+{
+	zbx_dbsnapshot_footer_t	footer;
+	int			ret = FAIL;
+
+	memset(&footer, 0, sizeof(footer));
+	footer.revision = revision;
+	footer.records_size = writer->size;
+	footer.clock = (zbx_uint32_t)time(NULL);
+	memcpy(footer.magic, ZBX_DBSNAPSHOT_FOOTER_MAGIC, sizeof(footer.magic));
+
+	if (SUCCEED != dbsnapshot_write(writer, &footer, sizeof(footer), error))
+		goto out;
+
+	if (0 != fflush(writer->file) || 0 != fsync(fileno(writer->file)))
+	{
+		*error = zbx_dsprintf(*error, "cannot write to file \"%s\": %s", writer->filename,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	if (0 != fclose(writer->file) && SUCCEED == ret)
+	{
+		*error = zbx_dsprintf(*error, "cannot close file \"%s\": %s", writer->filename, zbx_strerror(errno));
+		ret = FAIL;
+	}
+
+	if (SUCCEED != ret)
+		unlink(writer->filename);
+
+	dbsnapshot_writer_free(writer);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: closes and removes unfinished snapshot                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsnapshot_writer_discard(zbx_dbsnapshot_writer_t *writer)
+{
+	fclose(writer->file);
+	unlink(writer->filename);
+	dbsnapshot_writer_free(writer);
+}
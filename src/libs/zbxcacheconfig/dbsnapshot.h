@@ -0,0 +1,83 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_DBSNAPSHOT_H
+#define ZABBIX_DBSNAPSHOT_H
+
+#include "zbxalgo.h"
+
+/* row records, the values match ZBX_DBSYNC_ROW_* defines */
+#define ZBX_DBSNAPSHOT_REC_ADD		1
+#define ZBX_DBSNAPSHOT_REC_UPDATE	2
+#define ZBX_DBSNAPSHOT_REC_REMOVE	3
+/* runtime data of cached object, overriding the row columns */
+#define ZBX_DBSNAPSHOT_REC_RTDATA	4
+/* processed changelog record, the row identifier is changelogid and the only column is clock */
+#define ZBX_DBSNAPSHOT_REC_CHANGELOG	5
+
+/* the maximum number of objects that can be stored in snapshot */
+#define ZBX_DBSNAPSHOT_OBJ_MAX		32
+
+typedef struct
+{
+	zbx_uint64_t		rowid;
+	const unsigned char	*data;
+}
+zbx_dbsnapshot_row_t;
+
+ZBX_VECTOR_DECL(dbsnapshot_row, zbx_dbsnapshot_row_t)
+
+typedef struct zbx_dbsnapshot_writer	zbx_dbsnapshot_writer_t;
+
+typedef struct
+{
+	/* the mapped file and its size */
+	unsigned char			*map;
+	size_t				map_size;
+
+	/* the last rows of objects, sorted by row identifier */
+	zbx_vector_dbsnapshot_row_t	rows[ZBX_DBSNAPSHOT_OBJ_MAX];
+
+	/* the object runtime data, sorted by row identifier */
+	zbx_vector_dbsnapshot_row_t	rtdata[ZBX_DBSNAPSHOT_OBJ_MAX];
+
+	/* the processed changelog records */
+	zbx_vector_dbsnapshot_row_t	changelog;
+
+	/* the configuration revision and time when snapshot was closed */
+	zbx_uint64_t			revision;
+	int				clock;
+}
+zbx_dbsnapshot_t;
+
+int	zbx_dbsnapshot_load(zbx_dbsnapshot_t *snapshot, const char *filename, const char *source, int max_age,
+		char **error);
+void	zbx_dbsnapshot_free(zbx_dbsnapshot_t *snapshot);
+int	zbx_dbsnapshot_get_row(const zbx_dbsnapshot_row_t *row, char **values, int values_num);
+const zbx_dbsnapshot_row_t	*zbx_dbsnapshot_get_rtdata(const zbx_dbsnapshot_t *snapshot, unsigned char object,
+		zbx_uint64_t rowid);
+
+zbx_dbsnapshot_writer_t	*zbx_dbsnapshot_writer_open(const char *filename, const char *source, char **error);
+int	zbx_dbsnapshot_writer_add(zbx_dbsnapshot_writer_t *writer, unsigned char type, unsigned char object,
+		zbx_uint64_t rowid, char **values, int values_num, char **error);
+int	zbx_dbsnapshot_writer_flush(zbx_dbsnapshot_writer_t *writer, char **error);
+int	zbx_dbsnapshot_writer_close(zbx_dbsnapshot_writer_t *writer, zbx_uint64_t revision, char **error);
+void	zbx_dbsnapshot_writer_discard(zbx_dbsnapshot_writer_t *writer);
+
+#endif
@@ -45,8 +45,30 @@
 #define ZBX_DBSYNC_OBJ_HTTPSTEP		14
 #define ZBX_DBSYNC_OBJ_HTTPSTEP_FIELD	15
 #define ZBX_DBSYNC_OBJ_HTTPSTEP_ITEM	16
+/* the following objects are synchronized by comparing whole tables with cached data, */
+/* their changelog is used only to detect if the comparison must be done               */
+#define ZBX_DBSYNC_OBJ_GLOBALMACRO		17
+#define ZBX_DBSYNC_OBJ_HOSTMACRO		18
+#define ZBX_DBSYNC_OBJ_ACTION			19
+#define ZBX_DBSYNC_OBJ_OPERATION		20
+#define ZBX_DBSYNC_OBJ_CONDITION		21
+#define ZBX_DBSYNC_OBJ_CORRELATION		22
+#define ZBX_DBSYNC_OBJ_CORR_CONDITION		23
+#define ZBX_DBSYNC_OBJ_CORR_CONDITION_TAG	24
+#define ZBX_DBSYNC_OBJ_CORR_CONDITION_GROUP	25
+#define ZBX_DBSYNC_OBJ_CORR_CONDITION_TAGPAIR	26
+#define ZBX_DBSYNC_OBJ_CORR_CONDITION_TAGVALUE	27
+#define ZBX_DBSYNC_OBJ_CORR_OPERATION		28
+#define ZBX_DBSYNC_OBJ_HSTGRP			29
+#define ZBX_DBSYNC_OBJ_HOSTS_GROUPS		30
+#define ZBX_DBSYNC_OBJ_MAINTENANCE		31
+#define ZBX_DBSYNC_OBJ_MAINTENANCE_TAG		32
+#define ZBX_DBSYNC_OBJ_MAINTENANCE_WINDOW	33
+#define ZBX_DBSYNC_OBJ_TIMEPERIOD		34
+#define ZBX_DBSYNC_OBJ_MAINTENANCE_GROUP	35
+#define ZBX_DBSYNC_OBJ_MAINTENANCE_HOST		36
 /* number of dbsync objects - keep in sync with above defines */
-#define ZBX_DBSYNC_OBJ_COUNT		16
+#define ZBX_DBSYNC_OBJ_COUNT		36
 
 #define ZBX_DBSYNC_JOURNAL(X)		(X - 1)
 
@@ -55,6 +77,15 @@
 
 #define ZBX_DBSYNC_BATCH_SIZE			1000
 
+/* the snapshot can be used only while all changelog records made after it are kept in database */
+#define ZBX_DBSYNC_SNAPSHOT_MAX_AGE		(ZBX_DBSYNC_CHANGELOG_MAX_AGE - ZBX_DBSYNC_CHANGELOG_PRUNE_INTERVAL)
+
+/* item_rtdata columns of items changeset - state, lastlogsize, mtime, error */
+static const int	dbsync_item_rtdata_columns[] = {12, 20, 21, 27};
+
+/* host_rtdata columns of hosts changeset - lastaccess */
+static const int	dbsync_host_rtdata_columns[] = {12};
+
 typedef struct
 {
 	zbx_uint64_t	changelogid;
@@ -97,6 +128,22 @@ typedef struct
 	zbx_hashset_t			changelog;
 
 	zbx_dbsync_journal_t		journals[ZBX_DBSYNC_OBJ_COUNT];
+
+	/* ZBX_DBSYNC_UPDATE if changelog journals can be used to detect changes */
+	unsigned char			changelog_mode;
+
+	/* the configuration cache snapshot file, NULL if snapshot is not used */
+	char				*snapshot_file;
+	char				*snapshot_source;
+
+	/* the snapshot loaded at startup, used by initial synchronization */
+	zbx_dbsnapshot_t		*snapshot;
+
+	/* the snapshot written during synchronization */
+	zbx_dbsnapshot_writer_t		*snapshot_writer;
+
+	/* 1 if the written snapshot contains fully synchronized configuration */
+	unsigned char			snapshot_synced;
 }
 zbx_dbsync_env_t;
 
@@ -299,6 +346,188 @@ static char	**dbsync_preproc_row(zbx_dbsync_t *sync, char **row)
 	return sync->row;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stops writing configuration cache snapshot after failure          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_discard(const char *error)
+{
+	zabbix_log(LOG_LEVEL_WARNING, "configuration cache snapshot is disabled: %s", error);
+
+	zbx_dbsnapshot_writer_discard(dbsync_env.snapshot_writer);
+	dbsync_env.snapshot_writer = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes record to configuration cache snapshot                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_write(unsigned char type, unsigned char object, zbx_uint64_t rowid, char **values,
+		int values_num)
+{
+	char	*error = NULL;
+
+	if (NULL == dbsync_env.snapshot_writer)
+		return;
+
+	if (SUCCEED != zbx_dbsnapshot_writer_add(dbsync_env.snapshot_writer, type, object, rowid, values, values_num,
+			&error))
+	{
+		dbsync_snapshot_discard(error);
+		zbx_free(error);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes changeset row to configuration cache snapshot              *
+ *                                                                            *
+ * Parameter: sync  - [IN] the changeset                                      *
+ *            rowid - [IN] the row identifier                                 *
+ *            tag   - [IN] the row tag (see ZBX_DBSYNC_ROW_ defines)          *
+ *            dbrow - [IN] the row contents before preprocessing, NULL for    *
+ *                         removed rows                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_add_row(const zbx_dbsync_t *sync, zbx_uint64_t rowid, unsigned char tag, char **dbrow)
+{
+	if (0 == sync->snapshot_object)
+		return;
+
+	dbsync_snapshot_write(tag, sync->snapshot_object, rowid, dbrow, sync->columns_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares changeset to be written to configuration cache snapshot  *
+ *                                                                            *
+ * Parameter: sync   - [IN] the changeset                                     *
+ *            object - [IN] the snapshot object (see ZBX_DBSYNC_OBJ_*)        *
+ *                                                                            *
+ * Return value: SUCCEED - the changeset rows are restored from snapshot      *
+ *               FAIL    - the changeset rows must be read from database      *
+ *                                                                            *
+ * Comments: Must be called after dbsync_prepare().                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_open(zbx_dbsync_t *sync, unsigned char object)
+{
+	sync->snapshot_object = object;
+
+	if (ZBX_DBSYNC_INIT != sync->mode || NULL == dbsync_env.snapshot)
+		return FAIL;
+
+	sync->snapshot_rows = &dbsync_env.snapshot->rows[object];
+	sync->snapshot_row = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)sync->columns_num);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces runtime data columns of restored host row with the       *
+ *          values the configuration cache had when snapshot was written      *
+ *                                                                            *
+ * Comments: The runtime data tables are not tracked by changelog, so the     *
+ *           columns are as old as the last change of the row.                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_apply_rtdata(zbx_dbsync_t *sync, const zbx_dbsnapshot_row_t *rtdata)
+{
+	int	i;
+	char	*values[ARRSIZE(dbsync_host_rtdata_columns)];
+
+	if (SUCCEED != zbx_dbsnapshot_get_row(rtdata, values, (int)ARRSIZE(values)))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	for (i = 0; i < (int)ARRSIZE(values); i++)
+		sync->snapshot_row[dbsync_host_rtdata_columns[i]] = values[i];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces runtime data columns of restored item row with the       *
+ *          values read from database                                         *
+ *                                                                            *
+ * Parameter: sync   - [IN] the changeset                                     *
+ *            itemid - [IN] the restored item identifier                      *
+ *                                                                            *
+ * Comments: Item runtime data is flushed to database by history syncers      *
+ *           after the snapshot is written, so it is always taken from        *
+ *           database. Both snapshot rows and database rows are sorted by     *
+ *           itemid, so they are merged in single pass.                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_apply_item_rtdata(zbx_dbsync_t *sync, zbx_uint64_t itemid)
+{
+	zbx_uint64_t	rtdata_itemid;
+	int		i;
+
+	while (NULL != sync->snapshot_dbrow)
+	{
+		ZBX_STR2UINT64(rtdata_itemid, sync->snapshot_dbrow[0]);
+
+		if (rtdata_itemid > itemid)
+			return;
+
+		if (rtdata_itemid == itemid)
+		{
+			for (i = 0; i < (int)ARRSIZE(dbsync_item_rtdata_columns); i++)
+				sync->snapshot_row[dbsync_item_rtdata_columns[i]] = sync->snapshot_dbrow[i + 1];
+
+			return;
+		}
+
+		sync->snapshot_dbrow = zbx_db_fetch(sync->dbresult);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets the next row restored from configuration cache snapshot     *
+ *                                                                            *
+ * Return value: the row or NULL if there are no more rows                    *
+ *                                                                            *
+ ******************************************************************************/
+static char	**dbsync_snapshot_fetch(zbx_dbsync_t *sync)
+{
+	const zbx_dbsnapshot_row_t	*row, *rtdata;
+
+	while (sync->snapshot_index < sync->snapshot_rows->values_num)
+	{
+		row = &sync->snapshot_rows->values[sync->snapshot_index++];
+
+		if (SUCCEED != zbx_dbsnapshot_get_row(row, sync->snapshot_row, sync->columns_num))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
+
+		switch (sync->snapshot_object)
+		{
+			case ZBX_DBSYNC_OBJ_ITEM:
+				dbsync_snapshot_apply_item_rtdata(sync, row->rowid);
+				break;
+			case ZBX_DBSYNC_OBJ_HOST:
+				if (NULL != (rtdata = zbx_dbsnapshot_get_rtdata(dbsync_env.snapshot,
+						ZBX_DBSYNC_OBJ_HOST, row->rowid)))
+				{
+					dbsync_snapshot_apply_rtdata(sync, rtdata);
+				}
+				break;
+		}
+
+		return sync->snapshot_row;
+	}
+
+	return NULL;
+}
+
 static void	dbsync_journal_init(zbx_dbsync_journal_t *journal)
 {
 	zbx_vector_uint64_create(&journal->inserts);
@@ -429,13 +658,72 @@ static void	dbsync_remove_duplicate_ids(zbx_vector_uint64_t *dst, const zbx_vect
 	dst->values_num = k;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts writing new configuration cache snapshot                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_create(void)
+{
+	char	*error = NULL;
+
+	if (NULL != dbsync_env.snapshot_writer)
+		zbx_dbsnapshot_writer_discard(dbsync_env.snapshot_writer);
+
+	dbsync_env.snapshot_synced = 0;
+
+	if (NULL == (dbsync_env.snapshot_writer = zbx_dbsnapshot_writer_open(dbsync_env.snapshot_file,
+			dbsync_env.snapshot_source, &error)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "configuration cache snapshot is disabled: %s", error);
+		zbx_free(error);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: marks changelog records processed when snapshot was written as    *
+ *          processed                                                         *
+ *                                                                            *
+ * Return value: the number of restored changelog records                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_restore_changelog(void)
+{
+	const zbx_vector_dbsnapshot_row_t	*rows = &dbsync_env.snapshot->changelog;
+	zbx_dbsync_changelog_t			changelog_local;
+	char					*clock;
+	int					i;
+
+	for (i = 0; i < rows->values_num; i++)
+	{
+		if (SUCCEED != zbx_dbsnapshot_get_row(&rows->values[i], &clock, 1) || NULL == clock)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
+
+		changelog_local.changelogid = rows->values[i].rowid;
+		changelog_local.clock = atoi(clock);
+		zbx_hashset_insert(&dbsync_env.changelog, &changelog_local, sizeof(changelog_local));
+	}
+
+	return rows->values_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: read changelog and prepare lists of modified objects since last   *
  *          sync                                                              *
  *                                                                            *
+ * Parameter: mode           - [IN] the synchronization mode                  *
+ *            changelog_mode - [IN] ZBX_DBSYNC_UPDATE if the changelog was    *
+ *                                  already processed by previous syncs and   *
+ *                                  can be used to detect changed tables,     *
+ *                                  ZBX_DBSYNC_INIT otherwise                 *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_dbsync_env_prepare(unsigned char mode)
+int	zbx_dbsync_env_prepare(unsigned char mode, unsigned char changelog_mode)
 {
 	DB_RESULT		result;
 	DB_ROW			row;
@@ -448,7 +736,18 @@ int	zbx_dbsync_env_prepare(unsigned char mode)
 	for (i = 0; i < ARRSIZE(dbsync_env.journals); i++)
 		dbsync_journal_init(&dbsync_env.journals[i]);
 
-	if (ZBX_DBSYNC_INIT == mode)
+	dbsync_env.changelog_mode = changelog_mode;
+
+	if (ZBX_DBSYNC_INIT == changelog_mode && NULL != dbsync_env.snapshot_file)
+		dbsync_snapshot_create();
+
+	if (ZBX_DBSYNC_INIT == mode && NULL != dbsync_env.snapshot)
+	{
+		/* changes made after the snapshot are applied by the next synchronization */
+		changelog_num = dbsync_snapshot_restore_changelog();
+		result = NULL;
+	}
+	else if (ZBX_DBSYNC_INIT == mode)
 	{
 		result = zbx_db_select("select changelogid,clock from changelog");
 
@@ -563,24 +862,57 @@ static void	dbsync_env_flush_journal(zbx_dbsync_journal_t *journal)
 	zbx_hashset_destroy(&objectids);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: mark all journal changelog records as processed                   *
+ *                                                                            *
+ * Comments: Used for objects synchronized by comparing whole tables - when   *
+ *           journal has records the comparison is always done, so all the    *
+ *           changes are applied.                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_env_flush_journal_all(zbx_dbsync_journal_t *journal)
+{
+	int	i;
+
+	for (i = 0; i < journal->changelog.values_num; i++)
+	{
+		zbx_hashset_insert(&dbsync_env.changelog, &journal->changelog.values[i].changelog,
+				sizeof(zbx_dbsync_changelog_t));
+	}
+}
+
 void	zbx_dbsync_env_flush_changelog(void)
 {
 	size_t	i;
 
-	for (i = 0; i < (int)ARRSIZE(dbsync_env.journals); i++)
+	for (i = 0; i < (size_t)ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_GLOBALMACRO); i++)
 		dbsync_env_flush_journal(&dbsync_env.journals[i]);
 
+	for (; i < ARRSIZE(dbsync_env.journals); i++)
+		dbsync_env_flush_journal_all(&dbsync_env.journals[i]);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() changelog  : %d (%d slots)", __func__,
 			dbsync_env.changelog.num_data, dbsync_env.changelog.num_slots);
 
 }
 
+static void	dbsync_snapshot_free(void)
+{
+	zbx_dbsnapshot_free(dbsync_env.snapshot);
+	zbx_free(dbsync_env.snapshot);
+}
+
 void	zbx_dbsync_env_clear(void)
 {
 	size_t	i;
 
 	dbsync_prune_changelog();
 
+	/* the loaded snapshot is used only by the initial synchronization */
+	if (NULL != dbsync_env.snapshot)
+		dbsync_snapshot_free();
+
 	zbx_hashset_destroy(&dbsync_env.strpool);
 
 	for (i = 0; i < ARRSIZE(dbsync_env.journals); i++)
@@ -593,6 +925,157 @@ int	zbx_dbsync_env_changelog_num(void)
 	return dbsync_env.changelog.num_data;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads configuration cache snapshot to be used by the initial      *
+ *          synchronization and enables snapshot writing                      *
+ *                                                                            *
+ * Parameters: filename - [IN] the snapshot file                              *
+ *             source   - [IN] the configuration database identity            *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded                            *
+ *               FAIL    - the snapshot does not exist or cannot be used,     *
+ *                         configuration will be loaded from database         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_env_load_snapshot(const char *filename, const char *source)
+{
+	char	*error = NULL;
+	int	i, rows_num = 0;
+
+	dbsync_env.snapshot_file = zbx_strdup(dbsync_env.snapshot_file, filename);
+	dbsync_env.snapshot_source = zbx_strdup(dbsync_env.snapshot_source, source);
+
+	dbsync_env.snapshot = (zbx_dbsnapshot_t *)zbx_malloc(NULL, sizeof(zbx_dbsnapshot_t));
+
+	if (SUCCEED != zbx_dbsnapshot_load(dbsync_env.snapshot, filename, source, ZBX_DBSYNC_SNAPSHOT_MAX_AGE,
+			&error))
+	{
+		if (NULL != error)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot use configuration cache snapshot \"%s\": %s", filename,
+					error);
+			zbx_free(error);
+		}
+
+		dbsync_snapshot_free();
+
+		return FAIL;
+	}
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_OBJ_MAX; i++)
+		rows_num += dbsync_env.snapshot->rows[i].values_num;
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded configuration cache snapshot of revision " ZBX_FS_UI64
+			" with %d rows, written %d seconds ago", dbsync_env.snapshot->revision, rows_num,
+			(int)time(NULL) - dbsync_env.snapshot->clock);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: flushes configuration cache snapshot after successful             *
+ *          synchronization                                                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_flush_snapshot(void)
+{
+	char	*error = NULL;
+
+	if (NULL == dbsync_env.snapshot_writer)
+		return;
+
+	if (SUCCEED != zbx_dbsnapshot_writer_flush(dbsync_env.snapshot_writer, &error))
+	{
+		dbsync_snapshot_discard(error);
+		zbx_free(error);
+		return;
+	}
+
+	dbsync_env.snapshot_synced = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if configuration cache snapshot can be closed              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_env_snapshot_writable(void)
+{
+	return NULL != dbsync_env.snapshot_writer && 0 != dbsync_env.snapshot_synced ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes cached proxy runtime data to configuration cache snapshot  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_add_proxy_rtdata(zbx_uint64_t proxyid, int lastaccess)
+{
+	char	lastaccess_str[MAX_ID_LEN], *values[ARRSIZE(dbsync_host_rtdata_columns)];
+
+	zbx_snprintf(lastaccess_str, sizeof(lastaccess_str), "%d", lastaccess);
+	values[0] = lastaccess_str;
+
+	dbsync_snapshot_write(ZBX_DBSNAPSHOT_REC_RTDATA, ZBX_DBSYNC_OBJ_HOST, proxyid, values, (int)ARRSIZE(values));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: closes configuration cache snapshot on shutdown so it can be      *
+ *          loaded by the next start                                          *
+ *                                                                            *
+ * Parameters: revision - [IN] the configuration revision                     *
+ *                                                                            *
+ * Comments: The processed changelog records are written to snapshot, so     *
+ *           only changes made after the snapshot are synchronized from       *
+ *           database on the next start.                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_close_snapshot(zbx_uint64_t revision)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_dbsync_changelog_t	*changelog;
+	char			clock_str[MAX_ID_LEN], *values[1], *error = NULL;
+
+	if (NULL == dbsync_env.snapshot_writer)
+		return;
+
+	if (0 == dbsync_env.snapshot_synced)
+	{
+		zbx_dbsnapshot_writer_discard(dbsync_env.snapshot_writer);
+		dbsync_env.snapshot_writer = NULL;
+		return;
+	}
+
+	values[0] = clock_str;
+
+	zbx_hashset_iter_reset(&dbsync_env.changelog, &iter);
+	while (NULL != (changelog = (zbx_dbsync_changelog_t *)zbx_hashset_iter_next(&iter)) &&
+			NULL != dbsync_env.snapshot_writer)
+	{
+		zbx_snprintf(clock_str, sizeof(clock_str), "%d", changelog->clock);
+		dbsync_snapshot_write(ZBX_DBSNAPSHOT_REC_CHANGELOG, 0, changelog->changelogid, values, 1);
+	}
+
+	if (NULL == dbsync_env.snapshot_writer)
+		return;
+
+	if (SUCCEED != zbx_dbsnapshot_writer_close(dbsync_env.snapshot_writer, revision, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write configuration cache snapshot: %s", error);
+		zbx_free(error);
+	}
+	else
+	{
+		zabbix_log(LOG_LEVEL_INFORMATION, "written configuration cache snapshot of revision " ZBX_FS_UI64,
+				revision);
+	}
+
+	dbsync_env.snapshot_writer = NULL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get rows changed since last sync                                  *
@@ -627,6 +1110,8 @@ static int	dbsync_get_rows(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, si
 		while (NULL != (dbrow = zbx_db_fetch(result)))
 		{
 			ZBX_STR2UINT64(rowid, dbrow[0]);
+			dbsync_snapshot_add_row(sync, rowid, tag, dbrow);
+
 			if (NULL != (row = dbsync_preproc_row(sync, dbrow)))
 				dbsync_add_row(sync, rowid, tag, row);
 
@@ -683,7 +1168,10 @@ static int	dbsync_read_journal(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc
 	}
 
 	for (i = 0; i < journal->deletes.values_num; i++)
+	{
+		dbsync_snapshot_add_row(sync, journal->deletes.values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
 		dbsync_add_row(sync, journal->deletes.values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+	}
 
 	/* the obtained object identifiers are removed from journal */
 	sync->add_num = (zbx_uint64_t)(inserts_num - journal->inserts.values_num);
@@ -694,6 +1182,41 @@ static int	dbsync_read_journal(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if tables synchronized by full comparison must be compared *
+ *                                                                            *
+ * Parameter: sync        - [IN] the changeset                                *
+ *            objects     - [IN] the objects (ZBX_DBSYNC_OBJ_*) the compared  *
+ *                               data depends on                              *
+ *            objects_num - [IN] the number of objects                        *
+ *                                                                            *
+ * Return value: SUCCEED - the objects were changed since last sync or the    *
+ *                         changes cannot be detected                         *
+ *               FAIL    - the objects were not changed, the comparison can   *
+ *                         be skipped                                         *
+ *                                                                            *
+ * Comments: Tables with cascading foreign keys do not record deletes made    *
+ *           by cascade on all databases, so the referenced tables must be    *
+ *           listed together with the compared tables.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_check_changelog(const zbx_dbsync_t *sync, const int *objects, int objects_num)
+{
+	int	i;
+
+	if (ZBX_DBSYNC_UPDATE != sync->mode || ZBX_DBSYNC_UPDATE != dbsync_env.changelog_mode)
+		return SUCCEED;
+
+	for (i = 0; i < objects_num; i++)
+	{
+		if (0 != dbsync_env.journals[ZBX_DBSYNC_JOURNAL(objects[i])].changelog.values_num)
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initializes changeset                                             *
@@ -712,6 +1235,12 @@ void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode)
 	sync->preproc_row_func = NULL;
 	zbx_vector_ptr_create(&sync->columns);
 
+	sync->snapshot_object = 0;
+	sync->snapshot_rows = NULL;
+	sync->snapshot_index = 0;
+	sync->snapshot_row = NULL;
+	sync->snapshot_dbrow = NULL;
+
 	if (ZBX_DBSYNC_UPDATE == sync->mode)
 	{
 		zbx_vector_ptr_create(&sync->rows);
@@ -733,6 +1262,7 @@ void	zbx_dbsync_clear(zbx_dbsync_t *sync)
 	zbx_vector_ptr_destroy(&sync->columns);
 
 	zbx_free(sync->row);
+	zbx_free(sync->snapshot_row);
 
 	if (ZBX_DBSYNC_UPDATE == sync->mode)
 	{
@@ -796,12 +1326,25 @@ int	zbx_dbsync_next(zbx_dbsync_t *sync, zbx_uint64_t *rowid, char ***row, unsign
 	{
 		char	**dbrow;
 
-		if (NULL == (dbrow = zbx_db_fetch(sync->dbresult)))
+		if (NULL != sync->snapshot_rows)
+			dbrow = dbsync_snapshot_fetch(sync);
+		else
+			dbrow = zbx_db_fetch(sync->dbresult);
+
+		if (NULL == dbrow)
 		{
 			*row = NULL;
 			return FAIL;
 		}
 
+		if (0 != sync->snapshot_object)
+		{
+			zbx_uint64_t	dbrowid;
+
+			ZBX_STR2UINT64(dbrowid, dbrow[0]);
+			dbsync_snapshot_add_row(sync, dbrowid, ZBX_DBSYNC_ROW_ADD, dbrow);
+		}
+
 		*row = dbsync_preproc_row(sync, dbrow);
 
 		*rowid = 0;
@@ -1033,6 +1576,9 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 	dbsync_prepare(sync, 18, NULL);
 #endif
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_HOST))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -1311,6 +1857,13 @@ int	zbx_dbsync_compare_global_macros(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid, *prowid = &rowid;
 	zbx_um_macro_t		**pmacro;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_GLOBALMACRO};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 4, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select globalmacroid,macro,value,type"
@@ -1437,6 +1990,13 @@ int	zbx_dbsync_compare_host_macros(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid, *prowid = &rowid;
 	zbx_um_macro_t		**pmacro;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_HOSTMACRO, ZBX_DBSYNC_OBJ_HOST};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 5, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select m.hostmacroid,m.hostid,m.macro,m.value,m.type"
@@ -1732,6 +2292,20 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 50, dbsync_item_preproc_row);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_ITEM))
+	{
+		/* item runtime data is not written to snapshot and must be read from database */
+		if (NULL == (sync->dbresult = zbx_db_select("select itemid,state,lastlogsize,mtime,error"
+				" from item_rtdata order by itemid")))
+		{
+			ret = FAIL;
+			goto out;
+		}
+
+		sync->snapshot_dbrow = zbx_db_fetch(sync->dbresult);
+		goto out;
+	}
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -2032,6 +2606,9 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 20, dbsync_trigger_preproc_row);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_TRIGGER))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -2171,6 +2748,9 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 5, dbsync_function_preproc_row);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_FUNCTION))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -2332,6 +2912,13 @@ int	zbx_dbsync_compare_actions(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_action_t		*action;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_ACTION};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 4, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select actionid,eventsource,evaltype,formula"
@@ -2429,6 +3016,13 @@ int	zbx_dbsync_compare_action_ops(zbx_dbsync_t *sync)
 	DB_RESULT		result;
 	zbx_uint64_t		rowid, actionid = 0;
 	unsigned char		opflags = ZBX_ACTION_OPCLASS_NONE;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_ACTION, ZBX_DBSYNC_OBJ_OPERATION};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 2, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select a.actionid,o.recovery"
@@ -2526,6 +3120,13 @@ int	zbx_dbsync_compare_action_conditions(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t		iter;
 	zbx_uint64_t			rowid;
 	zbx_dc_action_condition_t	*condition;
+	static const int		objects[] = {ZBX_DBSYNC_OBJ_ACTION, ZBX_DBSYNC_OBJ_CONDITION};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 6, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select c.conditionid,c.actionid,c.conditiontype,c.operator,c.value,c.value2"
@@ -2600,6 +3201,9 @@ int	zbx_dbsync_compare_trigger_tags(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_TRIGGER_TAG))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -2635,6 +3239,9 @@ int	zbx_dbsync_compare_item_tags(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_ITEM_TAG))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -2670,6 +3277,9 @@ int	zbx_dbsync_compare_host_tags(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_HOST_TAG))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -2728,6 +3338,13 @@ int	zbx_dbsync_compare_correlations(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_correlation_t	*correlation;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_CORRELATION};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 4, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select correlationid,name,evaltype,formula"
@@ -2854,6 +3471,15 @@ int	zbx_dbsync_compare_corr_conditions(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_corr_condition_t	*corr_condition;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_CORRELATION, ZBX_DBSYNC_OBJ_CORR_CONDITION,
+			ZBX_DBSYNC_OBJ_CORR_CONDITION_TAG, ZBX_DBSYNC_OBJ_CORR_CONDITION_GROUP,
+			ZBX_DBSYNC_OBJ_CORR_CONDITION_TAGPAIR, ZBX_DBSYNC_OBJ_CORR_CONDITION_TAGVALUE};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 11, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select cc.corr_conditionid,cc.correlationid,cc.type,cct.tag,cctv.tag,cctv.value,cctv.operator,"
@@ -2959,6 +3585,13 @@ int	zbx_dbsync_compare_corr_operations(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_corr_operation_t	*corr_operation;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_CORRELATION, ZBX_DBSYNC_OBJ_CORR_OPERATION};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 3, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select co.corr_operationid,co.correlationid,co.type"
@@ -3050,6 +3683,13 @@ int	zbx_dbsync_compare_host_groups(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_hostgroup_t	*group;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_HSTGRP};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 2, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select("select groupid,name from hstgrp")))
 		return FAIL;
@@ -3116,6 +3756,9 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 7, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_ITEM_PREPROC))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -3285,6 +3928,13 @@ int	zbx_dbsync_compare_maintenances(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_maintenance_t	*maintenance;
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_MAINTENANCE};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 5, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select("select maintenanceid,maintenance_type,active_since,active_till,tags_evaltype"
 						" from maintenances")))
@@ -3377,6 +4027,13 @@ int	zbx_dbsync_compare_maintenance_tags(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t		iter;
 	zbx_uint64_t			rowid;
 	zbx_dc_maintenance_tag_t	*maintenance_tag;
+	static const int		objects[] = {ZBX_DBSYNC_OBJ_MAINTENANCE, ZBX_DBSYNC_OBJ_MAINTENANCE_TAG};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 5, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select("select maintenancetagid,maintenanceid,operator,tag,value"
 						" from maintenance_tag")))
@@ -3486,6 +4143,14 @@ int	zbx_dbsync_compare_maintenance_periods(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t		iter;
 	zbx_uint64_t			rowid;
 	zbx_dc_maintenance_period_t	*period;
+	static const int		objects[] = {ZBX_DBSYNC_OBJ_MAINTENANCE, ZBX_DBSYNC_OBJ_MAINTENANCE_WINDOW,
+			ZBX_DBSYNC_OBJ_TIMEPERIOD};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 10, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select("select t.timeperiodid,t.timeperiod_type,t.every,t.month,t.dayofweek,t.day,"
 						"t.start_time,t.period,t.start_date,m.maintenanceid"
@@ -3559,6 +4224,14 @@ int	zbx_dbsync_compare_maintenance_groups(zbx_dbsync_t *sync)
 	zbx_uint64_pair_t	mg_local, *mg;
 	char			maintenanceid_s[MAX_ID_LEN + 1], groupid_s[MAX_ID_LEN + 1];
 	char			*del_row[2] = {maintenanceid_s, groupid_s};
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_MAINTENANCE, ZBX_DBSYNC_OBJ_MAINTENANCE_GROUP,
+			ZBX_DBSYNC_OBJ_HSTGRP};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 2, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select("select maintenanceid,groupid from maintenances_groups order by maintenanceid")))
 		return FAIL;
@@ -3634,6 +4307,14 @@ int	zbx_dbsync_compare_maintenance_hosts(zbx_dbsync_t *sync)
 	zbx_uint64_pair_t	mh_local, *mh;
 	char			maintenanceid_s[MAX_ID_LEN + 1], hostid_s[MAX_ID_LEN + 1];
 	char			*del_row[2] = {maintenanceid_s, hostid_s};
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_MAINTENANCE, ZBX_DBSYNC_OBJ_MAINTENANCE_HOST,
+			ZBX_DBSYNC_OBJ_HOST};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 2, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select("select maintenanceid,hostid from maintenances_hosts order by maintenanceid")))
 		return FAIL;
@@ -3709,6 +4390,13 @@ int	zbx_dbsync_compare_host_group_hosts(zbx_dbsync_t *sync)
 	zbx_uint64_pair_t	gh_local, *gh;
 	char			groupid_s[MAX_ID_LEN + 1], hostid_s[MAX_ID_LEN + 1];
 	char			*del_row[2] = {groupid_s, hostid_s};
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_HSTGRP, ZBX_DBSYNC_OBJ_HOSTS_GROUPS, ZBX_DBSYNC_OBJ_HOST};
+
+	if (FAIL == dbsync_check_changelog(sync, objects, (int)ARRSIZE(objects)))
+	{
+		dbsync_prepare(sync, 2, NULL);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = zbx_db_select(
 			"select hg.groupid,hg.hostid"
@@ -3793,6 +4481,9 @@ int	zbx_dbsync_prepare_drules(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_DRULE))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -3828,6 +4519,9 @@ int	zbx_dbsync_prepare_dchecks(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 2, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_DCHECK))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -3863,6 +4557,9 @@ int	zbx_dbsync_prepare_httptests(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_HTTPTEST))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -3898,6 +4595,9 @@ int	zbx_dbsync_prepare_httptest_fields(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 2, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_HTTPTEST_FIELD))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -3932,6 +4632,9 @@ int	zbx_dbsync_prepare_httpsteps(zbx_dbsync_t *sync)
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select httpstepid,httptestid from httpstep");
 	dbsync_prepare(sync, 2, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_HTTPSTEP))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -3966,6 +4669,9 @@ int	zbx_dbsync_prepare_httpstep_fields(zbx_dbsync_t *sync)
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select httpstep_fieldid,httpstepid from httpstep_field");
 	dbsync_prepare(sync, 2, NULL);
 
+	if (SUCCEED == dbsync_snapshot_open(sync, ZBX_DBSYNC_OBJ_HTTPSTEP_FIELD))
+		goto out;
+
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
 		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
@@ -21,6 +21,7 @@
 #define ZABBIX_DBSYNC_H
 
 #include "dbconfig.h"
+#include "dbsnapshot.h"
 
 /* no changes */
 #define ZBX_DBSYNC_ROW_NONE	0
@@ -101,6 +102,18 @@ struct zbx_dbsync
 	/* the preprocessed columns  */
 	zbx_vector_ptr_t		columns;
 
+	/* the object (see ZBX_DBSYNC_OBJ_* defines) the rows are written to configuration cache */
+	/* snapshot as, 0 if the changeset is not written to snapshot                             */
+	unsigned char			snapshot_object;
+
+	/* the snapshot rows for ZBX_DBSYNC_INIT mode restored from snapshot, NULL otherwise */
+	const zbx_vector_dbsnapshot_row_t	*snapshot_rows;
+	int				snapshot_index;
+	char				**snapshot_row;
+
+	/* the next database row of runtime data merged into restored rows, NULL if there are no more rows */
+	char				**snapshot_dbrow;
+
 	/* statistics */
 	zbx_uint64_t	add_num;
 	zbx_uint64_t	update_num;
@@ -108,10 +121,15 @@ struct zbx_dbsync
 };
 
 void	zbx_dbsync_env_init(ZBX_DC_CONFIG *cache);
-int	zbx_dbsync_env_prepare(unsigned char mode);
+int	zbx_dbsync_env_prepare(unsigned char mode, unsigned char changelog_mode);
 void	zbx_dbsync_env_flush_changelog(void);
 void	zbx_dbsync_env_clear(void);
 int	zbx_dbsync_env_changelog_num(void);
+int	zbx_dbsync_env_load_snapshot(const char *filename, const char *source);
+void	zbx_dbsync_env_flush_snapshot(void);
+int	zbx_dbsync_env_snapshot_writable(void);
+void	zbx_dbsync_env_add_proxy_rtdata(zbx_uint64_t proxyid, int lastaccess);
+void	zbx_dbsync_env_close_snapshot(zbx_uint64_t revision);
 
 void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode);
 void	zbx_dbsync_clear(zbx_dbsync_t *sync);
@@ -1050,6 +1050,177 @@ static void	um_cache_get_macro(const zbx_um_cache_t *cache, const zbx_uint64_t *
 	zbx_free(context);
 }
 
+/* Resolved macros are memorized per process for the last used user macro cache, */
+/* so that resolving the same host macros (for example item update intervals on  */
+/* every nextcheck calculation) does not walk host/template/global macro chain   */
+/* again. User macro cache is not changed without changing its revision (except  */
+/* for removal of deleted hosts), so the memo is reset when different cache or   */
+/* cache revision is used. Resolved values are copied, which keeps memo safe     */
+/* even if the cache it was built from is released.                              */
+
+#define ZBX_UM_MEMO_MAX		65536
+
+typedef struct
+{
+	zbx_uint64_t	hostid;
+	char		*macro;
+	char		*value;
+	size_t		macro_len;
+	unsigned char	env;
+	unsigned char	type;
+}
+zbx_um_memo_macro_t;
+
+typedef struct
+{
+	zbx_hashset_t		macros;
+	const zbx_um_cache_t	*cache;
+	zbx_uint64_t		revision;
+}
+zbx_um_memo_t;
+
+static ZBX_THREAD_LOCAL zbx_um_memo_t	*um_memo = NULL;
+
+static zbx_hash_t	um_memo_macro_hash(const void *d)
+{
+	const zbx_um_memo_macro_t	*macro = (const zbx_um_memo_macro_t *)d;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&macro->hostid);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(macro->macro, macro->macro_len, hash);
+
+	return ZBX_DEFAULT_HASH_ALGO(&macro->env, sizeof(macro->env), hash);
+}
+
+static int	um_memo_macro_compare(const void *d1, const void *d2)
+{
+	const zbx_um_memo_macro_t	*m1 = (const zbx_um_memo_macro_t *)d1;
+	const zbx_um_memo_macro_t	*m2 = (const zbx_um_memo_macro_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(m1->hostid, m2->hostid);
+	ZBX_RETURN_IF_NOT_EQUAL(m1->env, m2->env);
+	ZBX_RETURN_IF_NOT_EQUAL(m1->macro_len, m2->macro_len);
+
+	return memcmp(m1->macro, m2->macro, m1->macro_len);
+}
+
+static void	um_memo_macro_clean(void *d)
+{
+	zbx_um_memo_macro_t	*macro = (zbx_um_memo_macro_t *)d;
+
+	zbx_free(macro->macro);
+	zbx_free(macro->value);
+}
+
+/*********************************************************************************
+ *                                                                               *
+ * Purpose: get resolved macro memo for the specified user macro cache           *
+ *                                                                               *
+ * Return value: The memo, reset if it was built from other cache or revision.   *
+ *                                                                               *
+ *********************************************************************************/
+static zbx_um_memo_t	*um_memo_get(const zbx_um_cache_t *cache)
+{
+	if (NULL == um_memo)
+	{
+		um_memo = (zbx_um_memo_t *)zbx_malloc(NULL, sizeof(zbx_um_memo_t));
+		zbx_hashset_create_ext(&um_memo->macros, 100, um_memo_macro_hash, um_memo_macro_compare,
+				um_memo_macro_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+	else if (um_memo->cache == cache && um_memo->revision == cache->revision &&
+			ZBX_UM_MEMO_MAX > um_memo->macros.num_data)
+	{
+		return um_memo;
+	}
+	else
+		zbx_hashset_clear(&um_memo->macros);
+
+	um_memo->cache = cache;
+	um_memo->revision = cache->revision;
+
+	return um_memo;
+}
+
+/*********************************************************************************
+ *                                                                               *
+ * Purpose: get user macro value (host/global)                                   *
+ *                                                                               *
+ * Parameters: cache       - [IN] the user macro cache                           *
+ *             hostids     - [IN] the host identifiers                           *
+ *             hostids_num - [IN] the number of host identifiers                 *
+ *             macro       - [IN] the macro with optional context, might be      *
+ *                                followed by other text                         *
+ *             env         - [IN] the environment flag                           *
+ *             type        - [OUT] the macro type                                *
+ *                                                                               *
+ * Return value: The macro value or NULL if macro was not found.                 *
+ *                                                                               *
+ * Comments: Macros resolved in single host scope are memorized by the macro     *
+ *           token itself, the returned value is valid until the next macro is   *
+ *           resolved.                                                           *
+ *                                                                               *
+ *********************************************************************************/
+static const char	*um_cache_get_value(const zbx_um_cache_t *cache, const zbx_uint64_t *hostids, int hostids_num,
+		const char *macro, int env, unsigned char *type)
+{
+	const zbx_um_macro_t	*um_macro = NULL;
+	zbx_um_memo_t		*memo;
+	zbx_um_memo_macro_t	memo_local, *memo_macro;
+	const char		*value;
+	int			macro_r, context_l, context_r;
+
+	if (1 < hostids_num || SUCCEED != zbx_user_macro_parse(macro, &macro_r, &context_l, &context_r, NULL))
+	{
+		um_cache_get_macro(cache, hostids, hostids_num, macro, &um_macro);
+		memo = NULL;
+	}
+	else
+	{
+		memo = um_memo_get(cache);
+
+		memo_local.hostid = (0 != hostids_num ? hostids[0] : ZBX_UM_CACHE_GLOBAL_MACRO_HOSTID);
+		memo_local.macro = (char *)macro;
+		memo_local.macro_len = (size_t)macro_r + 1;
+		memo_local.env = (unsigned char)env;
+
+		if (NULL != (memo_macro = (zbx_um_memo_macro_t *)zbx_hashset_search(&memo->macros, &memo_local)))
+		{
+			*type = memo_macro->type;
+			return memo_macro->value;
+		}
+
+		um_cache_get_macro(cache, hostids, hostids_num, macro, &um_macro);
+	}
+
+	if (NULL != um_macro)
+	{
+		*type = um_macro->type;
+
+		if (ZBX_MACRO_ENV_NONSECURE == env && ZBX_MACRO_VALUE_TEXT != um_macro->type)
+			value = ZBX_MACRO_SECRET_MASK;
+		else
+			value = (NULL != um_macro->value ? um_macro->value : ZBX_MACRO_NO_KVS_VALUE);
+	}
+	else
+		value = NULL;
+
+	if (NULL != memo)
+	{
+		memo_local.macro = zbx_malloc(NULL, memo_local.macro_len + 1);
+		memcpy(memo_local.macro, macro, memo_local.macro_len);
+		memo_local.macro[memo_local.macro_len] = '\0';
+		memo_local.value = (NULL != value ? zbx_strdup(NULL, value) : NULL);
+		memo_local.type = (NULL != um_macro ? um_macro->type : ZBX_MACRO_VALUE_TEXT);
+
+		memo_macro = (zbx_um_memo_macro_t *)zbx_hashset_insert(&memo->macros, &memo_local,
+				sizeof(memo_local));
+		value = memo_macro->value;
+	}
+
+	return value;
+}
+
 /*********************************************************************************
  *                                                                               *
  * Purpose: resolve user macro (host/global)                                     *
@@ -1062,23 +1233,18 @@ static void	um_cache_get_macro(const zbx_um_cache_t *cache, const zbx_uint64_t *
  *                                  0 - secure                                   *
  *                                  1 - non-secure (secure macros are resolved   *
  *                                                  to ***** )                   *
- *             value       - [OUT] macro value, must be freed by the caller      *
+ *             value       - [OUT] macro value, valid until the next macro is    *
+ *                                 resolved                                      *
  *                                                                               *
  *********************************************************************************/
 void	um_cache_resolve_const(const zbx_um_cache_t *cache, const zbx_uint64_t *hostids, int hostids_num,
 		const char *macro, int env, const char **value)
 {
-	const zbx_um_macro_t	*um_macro = NULL;
-
-	um_cache_get_macro(cache, hostids, hostids_num, macro, &um_macro);
+	const char	*um_value;
+	unsigned char	type;
 
-	if (NULL != um_macro)
-	{
-		if (ZBX_MACRO_ENV_NONSECURE == env && ZBX_MACRO_VALUE_TEXT != um_macro->type)
-			*value = ZBX_MACRO_SECRET_MASK;
-		else
-			*value = (NULL != um_macro->value ? um_macro->value : ZBX_MACRO_NO_KVS_VALUE);
-	}
+	if (NULL != (um_value = um_cache_get_value(cache, hostids, hostids_num, macro, env, &type)))
+		*value = um_value;
 }
 
 /*********************************************************************************
@@ -1099,31 +1265,20 @@ void	um_cache_resolve_const(const zbx_um_cache_t *cache, const zbx_uint64_t *hos
 void	um_cache_resolve(const zbx_um_cache_t *cache, const zbx_uint64_t *hostids, int hostids_num, const char *macro,
 		int env, char **value)
 {
-	const zbx_um_macro_t	*um_macro = NULL;
+	const char	*um_value;
+	unsigned char	type;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() macro:'%s'", __func__, macro);
 
-	um_cache_get_macro(cache, hostids, hostids_num, macro, &um_macro);
-
-	if (NULL != um_macro)
-	{
-		if (ZBX_MACRO_ENV_NONSECURE == env && ZBX_MACRO_VALUE_TEXT != um_macro->type)
-			*value = zbx_strdup(*value, ZBX_MACRO_SECRET_MASK);
-		else
-			*value = zbx_strdup(NULL, (NULL != um_macro->value ? um_macro->value : ZBX_MACRO_NO_KVS_VALUE));
-	}
+	if (NULL != (um_value = um_cache_get_value(cache, hostids, hostids_num, macro, env, &type)))
+		*value = zbx_strdup(*value, um_value);
 
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
 		const char	*out = NULL;
 
-		if (NULL != um_macro)
-		{
-			if (ZBX_MACRO_VALUE_TEXT == um_macro->type)
-				out = um_macro->value;
-			else
-				out = (NULL == um_macro->value ? ZBX_MACRO_SECRET_MASK : ZBX_MACRO_NO_KVS_VALUE);
-		}
+		if (NULL != um_value)
+			out = (ZBX_MACRO_VALUE_TEXT == type ? um_value : ZBX_MACRO_SECRET_MASK);
 
 		zabbix_log(LOG_LEVEL_DEBUG, "End of %s(): %s", __func__, ZBX_NULL2EMPTY_STR(out));
 	}
@@ -36,6 +36,7 @@
 #include "zbx_trigger_constants.h"
 #include "zbx_item_constants.h"
 
+/* the history cache and index memory of the currently locked history cache shard */
 static zbx_shmem_info_t	*hc_index_mem = NULL;
 static zbx_shmem_info_t	*hc_mem = NULL;
 static zbx_shmem_info_t	*trend_mem = NULL;
@@ -66,11 +67,18 @@ extern int		CONFIG_DOUBLE_PRECISION;
 /* the maximum time spent synchronizing history */
 #define ZBX_HC_SYNC_TIME_MAX	10
 
-/* the maximum number of items in one synchronization batch */
+/* the default number of items in one synchronization batch */
 #define ZBX_HC_SYNC_MAX		1000
 #define ZBX_HC_TIMER_MAX	(ZBX_HC_SYNC_MAX / 2)
 #define ZBX_HC_TIMER_SOFT_MAX	(ZBX_HC_TIMER_MAX - 10)
 
+/* the limits of server synchronization batch size, adapted to batch processing time */
+#define ZBX_HC_SYNC_BATCH_MIN	100
+#define ZBX_HC_SYNC_BATCH_MAX	(ZBX_HC_SYNC_MAX * 4)
+
+/* the batch processing time in seconds the synchronization batch size is adapted to */
+#define ZBX_HC_SYNC_BATCH_TIME	1.0
+
 /* the minimum processed item percentage of item candidates to continue synchronizing */
 #define ZBX_HC_SYNC_MIN_PCNT	10
 
@@ -82,6 +90,12 @@ extern int		CONFIG_DOUBLE_PRECISION;
 #define ZBX_DC_FLAGS_NOT_FOR_MODULES	(ZBX_DC_FLAGS_NOT_FOR_HISTORY | ZBX_DC_FLAG_LLD)
 #define ZBX_DC_FLAGS_NOT_FOR_EXPORT	(ZBX_DC_FLAG_NOVALUE | ZBX_DC_FLAG_UNDEF)
 
+/* numeric values with these flags are stored as separate history cache data instead of being packed */
+#define ZBX_HC_FLAGS_NOT_FOR_PACKING	(ZBX_DC_FLAG_META | ZBX_DC_FLAG_NOVALUE | ZBX_DC_FLAG_LLD | ZBX_DC_FLAG_UNDEF)
+
+/* the initial number of values in history cache packed value array */
+#define ZBX_HC_PACKED_ALLOC_MIN		8
+
 #define ZBX_HC_PROXYQUEUE_STATE_NORMAL 0
 #define ZBX_HC_PROXYQUEUE_STATE_WAIT 1
 
@@ -108,15 +122,42 @@ typedef struct
 }
 zbx_hc_proxyqueue_t;
 
+/* History cache is partitioned by itemid into shards, each with its own item index, */
+/* queue, shared memory and lock, so that processes adding values and syncing        */
+/* history contend only when working with the same shard.                            */
+#define ZBX_HC_SHARDS_MAX	ZBX_MUTEX_CACHE_SHARDS
+
+/* the minimum history cache and history index cache size per shard */
+#define ZBX_HC_SHARD_SIZE_MIN	ZBX_MEBIBYTE
+
 typedef struct
 {
-	zbx_hashset_t		trends;
+	zbx_flatset_t		history_items;
+	zbx_binary_heap_t	history_queue;
 	ZBX_DC_STATS		stats;
+	int			history_num;
 
-	zbx_hashset_t		history_items;
-	zbx_binary_heap_t	history_queue;
+	zbx_shmem_info_t	*mem;
+	zbx_shmem_info_t	*index_mem;
+
+	/* the number of shard values in history cache spill file */
+	int			spill_num;
+}
+zbx_hc_shard_t;
+
+static zbx_hc_shard_t	*hc_shards[ZBX_HC_SHARDS_MAX];
+static zbx_mutex_t	hc_shard_locks[ZBX_HC_SHARDS_MAX];
+static int		hc_shards_num = 0;
+
+/* the global history cache data, allocated in the first shard index memory */
+typedef struct
+{
+	zbx_hashset_t		trends;
+
+	/* the previous hour trends waiting for their flush time when trend flushing is spread */
+	zbx_hashset_t		trends_pending;
+	int			trends_pending_check;
 
-	int			history_num;
 	int			trends_num;
 	int			trends_last_cleanup_hour;
 	int			history_num_total;
@@ -126,6 +167,16 @@ typedef struct
 
 	zbx_hc_proxyqueue_t	proxyqueue;
 	int			proxy_history_count;
+
+	/* history cache spill file state, protected by spill lock */
+	zbx_uint64_t		spill_read_offset;
+	zbx_uint64_t		spill_write_offset;
+	int			spill_values_num;
+	unsigned char		spill_replaying;
+
+	/* the time spent in history synchronization stages and the number of synchronized batches */
+	double			sync_stage_time[ZBX_HC_SYNC_STAGE_COUNT];
+	zbx_uint64_t		sync_batches_num;
 }
 ZBX_DC_CACHE;
 
@@ -175,13 +226,18 @@ static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
 
 static void	hc_add_item_values(dc_item_value_t *values, int values_num);
-static void	hc_pop_items(zbx_vector_ptr_t *history_items);
+static int	hc_spill_replay(void);
+static void	hc_get_spill_stats(int *values_num, zbx_uint64_t *used);
+static void	hc_pop_items(zbx_vector_ptr_t *history_items, int items_max);
 static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *history_items);
 static void	hc_push_items(zbx_vector_ptr_t *history_items);
 static void	hc_free_item_values(ZBX_DC_HISTORY *history, int history_num);
-static void	hc_queue_item(zbx_hc_item_t *item);
+static void	hc_queue_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 static int	hc_queue_get_size(void);
+static int	hc_get_history_num(void);
+static void	hc_get_stats(ZBX_DC_STATS *stats, zbx_uint64_t *history_free, zbx_uint64_t *history_total,
+		zbx_uint64_t *index_free, zbx_uint64_t *index_total);
 static int	hc_get_history_compression_age(void);
 
 ZBX_PTR_VECTOR_DECL(item_tag, zbx_tag_t)
@@ -198,13 +254,10 @@ ZBX_PTR_VECTOR_IMPL(tags, zbx_tag_t*)
  ******************************************************************************/
 void	DCget_stats_all(zbx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
+	hc_get_stats(&wcache_info->stats, &wcache_info->history_free, &wcache_info->history_total,
+			&wcache_info->index_free, &wcache_info->index_total);
 
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+	LOCK_CACHE;
 
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 	{
@@ -215,6 +268,25 @@ void	DCget_stats_all(zbx_wcache_info_t *wcache_info)
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history synchronization statistics                            *
+ *                                                                            *
+ * Parameters: stage_time  - [OUT] the time spent in each synchronization     *
+ *                                 stage, ZBX_HC_SYNC_STAGE_COUNT elements    *
+ *             batches_num - [OUT] the number of synchronized batches         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_get_sync_stats(double *stage_time, zbx_uint64_t *batches_num)
+{
+	LOCK_CACHE;
+
+	memcpy(stage_time, cache->sync_stage_time, sizeof(cache->sync_stage_time));
+	*batches_num = cache->sync_batches_num;
+
+	UNLOCK_CACHE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get statistics of the database cache                              *
@@ -225,57 +297,64 @@ void	*DCget_stats(int request)
 	static zbx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	ZBX_DC_STATS		stats;
+	zbx_uint64_t		history_free, history_total, index_free, index_total, spill_used, spill_total;
+	int			spill_values_num;
+
+	hc_get_stats(&stats, &history_free, &history_total, &index_free, &index_total);
+	hc_get_spill_stats(&spill_values_num, &spill_used);
+	spill_total = (NULL != CONFIG_HISTORY_SPILL_FILE ? CONFIG_HISTORY_SPILL_SIZE : 0);
 
 	LOCK_CACHE;
 
 	switch (request)
 	{
 		case ZBX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = history_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = history_total - history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(history_total - history_free) / history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)history_free / history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_TOTAL:
@@ -300,26 +379,58 @@ void	*DCget_stats(int request)
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = index_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = index_total - index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(index_total - index_free) / index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)index_free / index_total;
+			ret = (void *)&value_double;
+			break;
+		case ZBX_STATS_SPILL_VALUES:
+			value_uint = (zbx_uint64_t)spill_values_num;
+			ret = (void *)&value_uint;
+			break;
+		case ZBX_STATS_SPILL_TOTAL:
+			value_uint = spill_total;
+			ret = (void *)&value_uint;
+			break;
+		case ZBX_STATS_SPILL_USED:
+			value_uint = spill_used;
+			ret = (void *)&value_uint;
+			break;
+		case ZBX_STATS_SPILL_FREE:
+			value_uint = spill_total - spill_used;
+			ret = (void *)&value_uint;
+			break;
+		case ZBX_STATS_SPILL_PUSED:
+			value_double = (0 != spill_total ? 100 * (double)spill_used / spill_total : 0);
+			ret = (void *)&value_double;
+			break;
+		case ZBX_STATS_SYNC_ITEMS:
+		case ZBX_STATS_SYNC_HISTORY:
+		case ZBX_STATS_SYNC_TRENDS:
+		case ZBX_STATS_SYNC_TRIGGERS:
+		case ZBX_STATS_SYNC_EVENTS:
+		case ZBX_STATS_SYNC_COMMIT:
+			value_double = cache->sync_stage_time[request - ZBX_STATS_SYNC_ITEMS];
 			ret = (void *)&value_double;
 			break;
+		case ZBX_STATS_SYNC_BATCHES:
+			value_uint = cache->sync_batches_num;
+			ret = (void *)&value_uint;
+			break;
 		default:
 			ret = NULL;
 	}
@@ -389,6 +500,7 @@ static void	dc_insert_trends_in_db(ZBX_DC_TREND *trends, int trends_num, unsigne
 
 	zbx_db_insert_prepare(&db_insert, table_name, "itemid", "clock", "num", "value_min", "value_avg",
 			"value_max", NULL);
+	zbx_db_insert_enable_copy(&db_insert);
 
 	for (i = 0; i < trends_num; i++)
 	{
@@ -494,6 +606,116 @@ static void	dc_remove_updated_trends(ZBX_DC_TREND *trends, int trends_num, const
 	}
 }
 
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: merges trends into the existing database trends with a single     *
+ *          insert statement                                                  *
+ *                                                                            *
+ * Comments: A helper function for DCflush trends. The number of values,      *
+ *           minimum, maximum and average are merged by the database when the *
+ *           trend already exists, instead of selecting existing trends and   *
+ *           updating them one by one.                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trends_upsert(ZBX_DC_TREND *trends, int trends_num, int *inserts_num, unsigned char value_type,
+		const char *table_name, int clock)
+{
+	int		i, rows_num = 0;
+	ZBX_DC_TREND	*trend;
+	size_t		sql_offset = 0;
+
+#if defined(HAVE_POSTGRESQL)
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "insert into %s as t", table_name);
+#else
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "insert into %s", table_name);
+#endif
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " (itemid,clock,num,value_min,value_avg,value_max) values ");
+
+	for (i = 0; i < trends_num; i++)
+	{
+		trend = &trends[i];
+
+		if (0 == trend->itemid)
+			continue;
+
+		if (clock != trend->clock || value_type != trend->value_type)
+			continue;
+
+		if (0 != trend->disable_from && clock >= trend->disable_from)
+			continue;
+
+		if (0 != rows_num)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "(" ZBX_FS_UI64 ",%d,%d," ZBX_FS_DBL64_SQL ","
+					ZBX_FS_DBL64_SQL "," ZBX_FS_DBL64_SQL ")", trend->itemid, trend->clock,
+					trend->num, trend->value_min.dbl, trend->value_avg.dbl, trend->value_max.dbl);
+		}
+		else
+		{
+			zbx_uint128_t	avg;
+
+			/* calculate the trend average value */
+			zbx_udiv128_64(&avg, &trend->value_avg.ui64, trend->num);
+
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "(" ZBX_FS_UI64 ",%d,%d," ZBX_FS_UI64 ","
+					ZBX_FS_UI64 "," ZBX_FS_UI64 ")", trend->itemid, trend->clock, trend->num,
+					trend->value_min.ui64, avg.lo, trend->value_max.ui64);
+		}
+
+		trend->itemid = 0;
+		rows_num++;
+
+		--*inserts_num;
+	}
+
+	if (0 == rows_num)
+		return;
+
+#if defined(HAVE_POSTGRESQL)
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " on conflict (itemid,clock) do update set"
+			" num=t.num+excluded.num,"
+			"value_min=least(t.value_min,excluded.value_min),"
+			"value_max=greatest(t.value_max,excluded.value_max),");
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+				"value_avg=(t.value_avg*t.num+excluded.value_avg*excluded.num)/(t.num+excluded.num)");
+	}
+	else
+	{
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+				"value_avg=div(t.value_avg*t.num+excluded.value_avg*excluded.num,t.num+excluded.num)");
+	}
+#else
+	/* MySQL assigns the columns from left to right, so the number of values is updated last */
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " on duplicate key update");
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+				" value_avg=(value_avg*num+values(value_avg)*values(num))/(num+values(num)),");
+	}
+	else
+	{
+		/* unsigned multiplication would overflow BIGINT UNSIGNED, so the sum is calculated in DECIMAL */
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+				" value_avg=truncate((cast(value_avg as decimal(20,0))*num+"
+				"cast(values(value_avg) as decimal(20,0))*values(num))/(num+values(num)),0),");
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+			"value_min=least(value_min,values(value_min)),"
+			"value_max=greatest(value_max,values(value_max)),"
+			"num=num+values(num)");
+#endif
+	zbx_db_execute("%s", sql);
+}
+#else
 /******************************************************************************
  *                                                                            *
  * Purpose: helper function for DCflush trends                                *
@@ -638,6 +860,7 @@ static void	dc_trends_fetch_and_update(ZBX_DC_TREND *trends, int trends_num, zbx
 	if (sql_offset > 16)	/* In ORACLE always present begin..end; */
 		zbx_db_execute("%s", sql);
 }
+#endif
 
 /******************************************************************************
  *                                                                            *
@@ -714,8 +937,12 @@ static void	DBflush_trends(ZBX_DC_TREND *trends, int *trends_num, zbx_vector_uin
 
 	if (0 != itemids_num)
 	{
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+		dc_trends_upsert(trends, trends_to, &inserts_num, value_type, table_name, clock);
+#else
 		dc_trends_fetch_and_update(trends, trends_to, itemids, itemids_num,
 				&inserts_num, value_type, table_name, clock);
+#endif
 	}
 
 	zbx_free(itemids);
@@ -759,6 +986,20 @@ static void	DBflush_trends(ZBX_DC_TREND *trends, int *trends_num, zbx_vector_uin
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reset trend values                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCclear_trend(ZBX_DC_TREND *trend)
+{
+	trend->clock = 0;
+	trend->num = 0;
+	memset(&trend->value_min, 0, sizeof(zbx_history_value_t));
+	memset(&trend->value_avg, 0, sizeof(zbx_value_avg_t));
+	memset(&trend->value_max, 0, sizeof(zbx_history_value_t));
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: move trend to the array of trends for flushing to DB              *
@@ -775,11 +1016,75 @@ static void	DCflush_trend(ZBX_DC_TREND *trend, ZBX_DC_TREND **trends, int *trend
 	memcpy(&(*trends)[*trends_num], trend, sizeof(ZBX_DC_TREND));
 	(*trends_num)++;
 
-	trend->clock = 0;
-	trend->num = 0;
-	memset(&trend->value_min, 0, sizeof(zbx_history_value_t));
-	memset(&trend->value_avg, 0, sizeof(zbx_value_avg_t));
-	memset(&trend->value_max, 0, sizeof(zbx_history_value_t));
+	DCclear_trend(trend);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the time offset within hour when item trend of the        *
+ *          previous hour is flushed                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	DCget_trend_flush_offset(zbx_uint64_t itemid)
+{
+	return (int)(ZBX_DEFAULT_UINT64_HASH_FUNC(&itemid) % (zbx_hash_t)CONFIG_TRENDS_FLUSH_SPREAD);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: move trend to the pending trends to be flushed at the item flush  *
+ *          offset                                                            *
+ *                                                                            *
+ * Comments: An older pending trend of the same item is flushed right away.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCdefer_trend(ZBX_DC_TREND *trend, ZBX_DC_TREND **trends, int *trends_alloc, int *trends_num)
+{
+	ZBX_DC_TREND	*pending;
+
+	if (NULL != (pending = (ZBX_DC_TREND *)zbx_hashset_search(&cache->trends_pending, &trend->itemid)))
+	{
+		DCflush_trend(pending, trends, trends_alloc, trends_num);
+		memcpy(pending, trend, sizeof(ZBX_DC_TREND));
+	}
+	else
+		zbx_hashset_insert(&cache->trends_pending, trend, sizeof(ZBX_DC_TREND));
+
+	DCclear_trend(trend);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: move pending trends that reached their flush offset to the array  *
+ *          of trends for flushing to DB                                      *
+ *                                                                            *
+ * Parameters: now             - [IN] the current time                        *
+ *             trends          - [OUT] list of trends to flush into database  *
+ *             trends_alloc    - [IN/OUT]                                     *
+ *             trends_num      - [IN/OUT] number of trends                    *
+ *             compression_age - [IN] history compression age                *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCflush_pending_trends(int now, ZBX_DC_TREND **trends, int *trends_alloc, int *trends_num,
+		int compression_age)
+{
+	zbx_hashset_iter_t	iter;
+	ZBX_DC_TREND		*trend;
+	int			seconds = now % SEC_PER_HOUR, hour = now - seconds;
+
+	zbx_hashset_iter_reset(&cache->trends_pending, &iter);
+
+	while (NULL != (trend = (ZBX_DC_TREND *)zbx_hashset_iter_next(&iter)))
+	{
+		if (trend->clock >= hour - SEC_PER_HOUR && seconds < DCget_trend_flush_offset(trend->itemid))
+			continue;
+
+		/* discard trends that are pointing to compressed history period */
+		if (0 == compression_age || trend->clock >= compression_age)
+			DCflush_trend(trend, trends, trends_alloc, trends_num);
+
+		zbx_hashset_iter_remove(&iter);
+	}
 }
 
 /******************************************************************************
@@ -796,10 +1101,30 @@ static void	DCadd_trend(const ZBX_DC_HISTORY *history, ZBX_DC_TREND **trends, in
 
 	trend = DCget_trend(history->itemid);
 
+	if (0 != CONFIG_TRENDS_FLUSH_SPREAD && trend->clock != hour)
+	{
+		ZBX_DC_TREND	*pending;
+
+		/* late values of the previous hour are added to the pending trend */
+		if (NULL != (pending = (ZBX_DC_TREND *)zbx_hashset_search(&cache->trends_pending,
+				&history->itemid)) && pending->clock == hour &&
+				pending->value_type == history->value_type)
+		{
+			trend = pending;
+		}
+	}
+
 	if (trend->num > 0 && (trend->clock != hour || trend->value_type != history->value_type) &&
 			SUCCEED == zbx_history_requires_trends(trend->value_type))
 	{
-		DCflush_trend(trend, trends, trends_alloc, trends_num);
+		/* the previous hour trend is kept until its flush offset when trend flushing is spread */
+		if (0 != CONFIG_TRENDS_FLUSH_SPREAD && trend->clock + SEC_PER_HOUR == hour &&
+				trend->value_type == history->value_type)
+		{
+			DCdefer_trend(trend, trends, trends_alloc, trends_num);
+		}
+		else
+			DCflush_trend(trend, trends, trends_alloc, trends_num);
 	}
 
 	trend->value_type = history->value_type;
@@ -865,6 +1190,12 @@ static void	DCmass_update_trends(const ZBX_DC_HISTORY *history, int history_num,
 		DCadd_trend(h, trends, &trends_alloc, trends_num);
 	}
 
+	if (0 != cache->trends_pending.num_data && cache->trends_pending_check != ts.sec)
+	{
+		DCflush_pending_trends(ts.sec, trends, &trends_alloc, trends_num, compression_age);
+		cache->trends_pending_check = ts.sec;
+	}
+
 	if (cache->trends_last_cleanup_hour < hour && ZBX_TRENDS_CLEANUP_TIME < seconds)
 	{
 		zbx_hashset_iter_t	iter;
@@ -1552,6 +1883,16 @@ static void	DCsync_trends(void)
 		}
 	}
 
+	zbx_hashset_iter_reset(&cache->trends_pending, &iter);
+
+	while (NULL != (trend = (ZBX_DC_TREND *)zbx_hashset_iter_next(&iter)))
+	{
+		if (trend->clock >= compression_age)
+			DCflush_trend(trend, &trends, &trends_alloc, &trends_num);
+
+		zbx_hashset_iter_remove(&iter);
+	}
+
 	UNLOCK_TRENDS;
 
 	if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_TRENDS) && 0 != trends_num)
@@ -3172,6 +3513,89 @@ static void	proxy_prepare_history(ZBX_DC_HISTORY *history, int history_num)
 	zbx_vector_uint64_destroy(&itemids);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add time spent in history synchronization stage                   *
+ *                                                                            *
+ * Parameters: stage_time - [IN/OUT] the time spent in each stage             *
+ *             stage      - [IN] the stage, ZBX_HC_SYNC_STAGE_*               *
+ *             time_start - [IN] the stage start time                         *
+ *                                                                            *
+ * Return value: the current time, the start time of the next stage           *
+ *                                                                            *
+ ******************************************************************************/
+static double	hc_sync_stage_add(double *stage_time, int stage, double time_start)
+{
+	double	now;
+
+	now = zbx_time();
+	stage_time[stage] += now - time_start;
+
+	return now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add synchronized batch to history synchronization statistics      *
+ *                                                                            *
+ * Parameters: stage_time - [IN] the time spent in each stage                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_sync_stats_add(const double *stage_time)
+{
+	int	i;
+
+	LOCK_CACHE;
+
+	for (i = 0; i < ZBX_HC_SYNC_STAGE_COUNT; i++)
+		cache->sync_stage_time[i] += stage_time[i];
+
+	cache->sync_batches_num++;
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adapt synchronization batch size to the measured processing speed *
+ *                                                                            *
+ * Parameters: batch_size - [IN/OUT] the batch size                           *
+ *             items_num  - [IN] the number of items taken in the last batch  *
+ *             values_num - [IN] the number of values synchronized            *
+ *             batch_time - [IN] the last batch processing time               *
+ *             queue_size - [IN] the number of items left in queue            *
+ *                                                                            *
+ * Comments: The batch size is adapted so that one batch is processed in      *
+ *           about ZBX_HC_SYNC_BATCH_TIME. Small batches keep trigger locks   *
+ *           short and let other syncers work on the queue, large batches     *
+ *           spread database round trips over more values. The batch is grown *
+ *           only if it was full and the queue has enough items for the next  *
+ *           one.                                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_sync_batch_adapt(int *batch_size, int items_num, int values_num, double batch_time,
+		int queue_size)
+{
+	double	size;
+
+	if (0 == values_num)
+		return;
+
+	if (ZBX_HC_SYNC_BATCH_TIME >= batch_time && (items_num < *batch_size || queue_size < *batch_size))
+		return;
+
+	/* the number of values that would be processed in target time at the measured speed */
+	if (0 < batch_time)
+		size = values_num * ZBX_HC_SYNC_BATCH_TIME / batch_time;
+	else
+		size = ZBX_HC_SYNC_BATCH_MAX;
+
+	/* move half way to the estimated size to smooth out fluctuations of batch processing time */
+	size = (*batch_size + size) / 2;
+
+	*batch_size = (int)MAX(ZBX_HC_SYNC_BATCH_MIN, MIN(ZBX_HC_SYNC_BATCH_MAX, size));
+}
+
 static void	sync_proxy_history(int *total_num, int *more)
 {
 	int			history_num, txn_rc;
@@ -3188,15 +3612,15 @@ static void	sync_proxy_history(int *total_num, int *more)
 
 	do
 	{
+		double	stage_time[ZBX_HC_SYNC_STAGE_COUNT] = {0}, time_stage;
+
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
+		time_stage = zbx_time();
 
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
+		hc_pop_items(&history_items, ZBX_HC_SYNC_MAX);	/* select and take items out of history cache */
 		history_num = history_items.values_num;
 
-		UNLOCK_CACHE;
-
 		if (0 == history_num)
 			break;
 
@@ -3205,40 +3629,41 @@ static void	sync_proxy_history(int *total_num, int *more)
 
 		DCmass_proxy_prepare_itemdiff(history, history_num, &item_diff);
 
+		time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_ITEMS, time_stage);
+
 		do
 		{
 			zbx_db_begin();
 
 			DBmass_proxy_add_history(history, history_num);
 			DBmass_proxy_update_items(&item_diff);
+
+			time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_HISTORY, time_stage);
+			txn_rc = zbx_db_commit();
+			time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_COMMIT, time_stage);
 		}
-		while (ZBX_DB_DOWN == (txn_rc = zbx_db_commit()));
+		while (ZBX_DB_DOWN == txn_rc);
 
-		LOCK_CACHE;
+		hc_sync_stats_add(stage_time);
+
+		/* apply item changes before returning items to history cache, so that the */
+		/* next item values are not processed by other syncers before it            */
+		if (ZBX_DB_FAIL != txn_rc && 0 != item_diff.values_num)
+			DCconfig_items_apply_changes(&item_diff);
 
 		hc_push_items(&history_items);	/* return items to history cache */
 
 		if (ZBX_DB_FAIL != txn_rc)
 		{
-			if (0 != item_diff.values_num)
-				DCconfig_items_apply_changes(&item_diff);
-
-			cache->history_num -= history_num;
-
 			if (0 != hc_queue_get_size())
 				*more = ZBX_SYNC_MORE;
 
-			UNLOCK_CACHE;
-
 			*total_num += history_num;
 
 			hc_free_item_values(history, history_num);
 		}
 		else
-		{
 			*more = ZBX_SYNC_MORE;
-			UNLOCK_CACHE;
-		}
 
 		zbx_vector_ptr_clear(&history_items);
 		zbx_vector_ptr_clear_ext(&item_diff, zbx_default_mem_free_func);
@@ -3282,7 +3707,10 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	static ZBX_HISTORY_STRING	*history_string;
 	static ZBX_HISTORY_TEXT		*history_text;
 	static ZBX_HISTORY_LOG		*history_log;
-	static int			module_enabled = FAIL;
+	static ZBX_DC_HISTORY		*history;
+	static zbx_uint64_t		*trigger_itemids;
+	static zbx_timespec_t		*trigger_timespecs;
+	static int			module_enabled = FAIL, batch_size = ZBX_HC_SYNC_MAX;
 	int				i, history_num, history_float_num, history_integer_num, history_string_num,
 					history_text_num, history_log_num, txn_error, compression_age;
 	unsigned int			item_retrieve_mode;
@@ -3291,9 +3719,6 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	zbx_vector_ptr_t		history_items, trigger_diff, item_diff, inventory_values, trigger_timers,
 					trigger_order;
 	zbx_vector_uint64_pair_t	trends_diff, proxy_subscribtions;
-	ZBX_DC_HISTORY			history[ZBX_HC_SYNC_MAX];
-	zbx_uint64_t			trigger_itemids[ZBX_HC_SYNC_MAX];
-	zbx_timespec_t			trigger_timespecs[ZBX_HC_SYNC_MAX];
 	zbx_history_sync_item_t		*items = NULL;
 	int				*errcodes = NULL;
 	zbx_vector_uint64_t		itemids;
@@ -3305,35 +3730,42 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	{
 		module_enabled = SUCCEED;
 		history_float = (ZBX_HISTORY_FLOAT *)zbx_malloc(history_float,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_FLOAT));
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_FLOAT));
 	}
 
 	if (NULL == history_integer && NULL != history_integer_cbs)
 	{
 		module_enabled = SUCCEED;
 		history_integer = (ZBX_HISTORY_INTEGER *)zbx_malloc(history_integer,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_INTEGER));
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_INTEGER));
 	}
 
 	if (NULL == history_string && NULL != history_string_cbs)
 	{
 		module_enabled = SUCCEED;
 		history_string = (ZBX_HISTORY_STRING *)zbx_malloc(history_string,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_STRING));
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_STRING));
 	}
 
 	if (NULL == history_text && NULL != history_text_cbs)
 	{
 		module_enabled = SUCCEED;
 		history_text = (ZBX_HISTORY_TEXT *)zbx_malloc(history_text,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_TEXT));
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_TEXT));
 	}
 
 	if (NULL == history_log && NULL != history_log_cbs)
 	{
 		module_enabled = SUCCEED;
 		history_log = (ZBX_HISTORY_LOG *)zbx_malloc(history_log,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_LOG));
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_LOG));
+	}
+
+	if (NULL == history)
+	{
+		history = (ZBX_DC_HISTORY *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_DC_HISTORY));
+		trigger_itemids = (zbx_uint64_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(zbx_uint64_t));
+		trigger_timespecs = (zbx_timespec_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(zbx_timespec_t));
 	}
 
 	compression_age = hc_get_history_compression_age();
@@ -3362,22 +3794,21 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 	do
 	{
-		int			trends_num = 0, timers_num = 0, ret = SUCCEED;
+		int			trends_num = 0, timers_num = 0, ret = SUCCEED, queue_size = 0;
 		ZBX_DC_TREND		*trends = NULL;
+		double			stage_time[ZBX_HC_SYNC_STAGE_COUNT] = {0}, time_start, time_stage;
 
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
-		UNLOCK_CACHE;
+		time_start = time_stage = zbx_time();
+
+		hc_pop_items(&history_items, batch_size);	/* select and take items out of history cache */
 
 		if (0 != history_items.values_num)
 		{
 			if (0 == (history_num = DCconfig_lock_triggers_by_history_items(&history_items, &triggerids)))
 			{
-				LOCK_CACHE;
 				hc_push_items(&history_items);
-				UNLOCK_CACHE;
 				zbx_vector_ptr_clear(&history_items);
 			}
 		}
@@ -3394,11 +3825,11 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 			if (NULL == items)
 			{
 				items = (zbx_history_sync_item_t *)zbx_malloc(NULL, sizeof(zbx_history_sync_item_t) *
-						(size_t)ZBX_HC_SYNC_MAX);
+						(size_t)ZBX_HC_SYNC_BATCH_MAX);
 			}
 
 			if (NULL == errcodes)
-				errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)ZBX_HC_SYNC_MAX);
+				errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)ZBX_HC_SYNC_BATCH_MAX);
 
 			zbx_vector_uint64_reserve(&itemids, history_num);
 
@@ -3413,7 +3844,11 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 			DCmass_prepare_history(history, items, errcodes, history_num, &item_diff,
 					&inventory_values, compression_age, &proxy_subscribtions);
 
-			if (FAIL != (ret = DBmass_add_history(history, history_num)))
+			time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_ITEMS, time_stage);
+			ret = DBmass_add_history(history, history_num);
+			time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_HISTORY, time_stage);
+
+			if (FAIL != ret)
 			{
 				DCconfig_items_apply_changes(&item_diff);
 				DCmass_update_trends(history, history_num, &trends, &trends_num, compression_age);
@@ -3428,14 +3863,20 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 					DBmass_update_items(&item_diff, &inventory_values);
 					DBmass_update_trends(trends, trends_num, &trends_diff);
 
+					time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_TRENDS, time_stage);
+
 					/* process internal events generated by DCmass_prepare_history() */
 					zbx_process_events(NULL, NULL);
 
+					time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_EVENTS, time_stage);
+
 					if (ZBX_DB_OK == (txn_error = zbx_db_commit()))
 						DCupdate_trends(&trends_diff);
 					else
 						zbx_reset_event_recovery();
 
+					time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_COMMIT, time_stage);
+
 					zbx_vector_uint64_pair_clear(&trends_diff);
 				}
 				while (ZBX_DB_DOWN == txn_error);
@@ -3477,20 +3918,28 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 				{
 					zbx_db_begin();
 
+					time_stage = zbx_time();
+
 					recalculate_triggers(history, history_num, &itemids, items, errcodes,
 							&trigger_timers, &trigger_diff, trigger_itemids,
 							trigger_timespecs, &trigger_info, &trigger_order);
 
+					time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_TRIGGERS, time_stage);
+
 					/* process trigger events generated by recalculate_triggers() */
 					zbx_process_events(&trigger_diff, &triggerids);
 					if (0 != trigger_diff.values_num)
 						zbx_db_save_trigger_changes(&trigger_diff);
 
+					time_stage = hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_EVENTS, time_stage);
+
 					if (ZBX_DB_OK == (txn_error = zbx_db_commit()))
 						DCconfig_triggers_apply_changes(&trigger_diff);
 					else
 						zbx_clean_events();
 
+					hc_sync_stage_add(stage_time, ZBX_HC_SYNC_STAGE_COMMIT, time_stage);
+
 					zbx_vector_ptr_clear_ext(&trigger_diff, (zbx_clean_func_t)zbx_trigger_diff_free);
 				}
 				while (ZBX_DB_DOWN == txn_error);
@@ -3522,11 +3971,9 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		if (0 != history_num)
 		{
-			LOCK_CACHE;
 			hc_push_items(&history_items);	/* return items to history cache */
-			cache->history_num -= history_num;
 
-			if (0 != hc_queue_get_size())
+			if (0 != (queue_size = hc_queue_get_size()))
 			{
 				/* Continue sync if enough of sync candidates were processed       */
 				/* (meaning most of sync candidates are not locked by triggers).   */
@@ -3537,8 +3984,6 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 					*more = ZBX_SYNC_MORE;
 			}
 
-			UNLOCK_CACHE;
-
 			*values_num += history_num;
 		}
 
@@ -3588,8 +4033,14 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 		if (0 != history_num || 0 != timers_num)
 			zbx_clean_events();
 
+		if (0 != history_num || 0 != timers_num)
+			hc_sync_stats_add(stage_time);
+
 		if (0 != history_num)
 		{
+			hc_sync_batch_adapt(&batch_size, history_items.values_num, history_num, zbx_time() - time_start,
+					queue_size);
+
 			zbx_free(trends);
 			zbx_dc_config_clean_history_sync_items(items, errcodes, (size_t)history_num);
 
@@ -3634,12 +4085,12 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
  ******************************************************************************/
 static void	sync_history_cache_full(void)
 {
-	int			values_num = 0, triggers_num = 0, more;
-	zbx_hashset_iter_t	iter;
+	int			values_num = 0, triggers_num = 0, more, i;
+	zbx_flatset_iter_t	iter;
 	zbx_hc_item_t		*item;
-	zbx_binary_heap_t	tmp_history_queue;
+	zbx_binary_heap_t	tmp_history_queues[ZBX_HC_SHARDS_MAX];
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	/* History index cache might be full without any space left for queueing items from history index to  */
 	/* history queue. The solution: replace the shared-memory history queue with heap-allocated one. Add  */
@@ -3658,21 +4109,29 @@ static void	sync_history_cache_full(void)
 		DCconfig_unlock_all_triggers();
 	}
 
-	tmp_history_queue = cache->history_queue;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard = hc_shards[i];
 
-	zbx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
+		tmp_history_queues[i] = shard->history_queue;
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL != item->tail)
+		zbx_binary_heap_create(&shard->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY);
+		zbx_flatset_iter_reset(&shard->history_items, &iter);
+
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (zbx_hc_item_t *)zbx_flatset_iter_next(&iter)))
 		{
-			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(shard, item);
+			}
 		}
 	}
 
+	(void)hc_spill_replay();
+
 	if (0 != hc_queue_get_size())
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data...");
@@ -3684,16 +4143,22 @@ static void	sync_history_cache_full(void)
 			else
 				sync_proxy_history(&values_num, &more);
 
+			/* move values left in spill file into the synced history cache */
+			(void)hc_spill_replay();
+
 			zabbix_log(LOG_LEVEL_WARNING, "syncing history data... " ZBX_FS_DBL "%%",
-					(double)values_num / (cache->history_num + values_num) * 100);
+					(double)values_num / (hc_get_history_num() + values_num) * 100);
 		}
 		while (0 != hc_queue_get_size());
 
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	zbx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_binary_heap_destroy(&hc_shards[i]->history_queue);
+		hc_shards[i]->history_queue = tmp_history_queues[i];
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -3706,7 +4171,9 @@ static void	sync_history_cache_full(void)
 void	zbx_log_sync_history_cache_progress(void)
 {
 	double		pcnt = -1.0;
-	int		ts_last, ts_next, sec;
+	int		ts_last, ts_next, sec, history_num;
+
+	history_num = hc_get_history_num();
 
 	LOCK_CACHE;
 
@@ -3721,16 +4188,16 @@ void	zbx_log_sync_history_cache_progress(void)
 
 	if (0 == cache->history_progress_ts)
 	{
-		cache->history_num_total = cache->history_num;
+		cache->history_num_total = history_num;
 		cache->history_progress_ts = sec;
 	}
 
-	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == cache->history_num)
+	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == history_num)
 	{
 		if (0 != cache->history_num_total)
-			pcnt = 100 * (double)(cache->history_num_total - cache->history_num) / cache->history_num_total;
+			pcnt = 100 * (double)(cache->history_num_total - history_num) / cache->history_num_total;
 
-		cache->history_progress_ts = (0 == cache->history_num ? INT_MAX : sec);
+		cache->history_progress_ts = (0 == history_num ? INT_MAX : sec);
 	}
 
 	ts_next = cache->history_progress_ts;
@@ -3759,15 +4226,23 @@ void	zbx_log_sync_history_cache_progress(void)
  ******************************************************************************/
 void	zbx_sync_history_cache(int *values_num, int *triggers_num, int *more)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	int	spill_values_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	*values_num = 0;
 	*triggers_num = 0;
 
+	spill_values_num = hc_spill_replay();
+
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 		sync_server_history(values_num, triggers_num, more);
 	else
 		sync_proxy_history(values_num, more);
+
+	/* values waiting in spill file must be moved to history cache without delay */
+	if (0 != spill_values_num)
+		*more = ZBX_SYNC_MORE;
 }
 
 /******************************************************************************
@@ -4123,14 +4598,8 @@ void	dc_flush_history(void)
 	if (0 == item_values_num)
 		return;
 
-	LOCK_CACHE;
-
 	hc_add_item_values(item_values, item_values_num);
 
-	cache->history_num += item_values_num;
-
-	UNLOCK_CACHE;
-
 	item_values_num = 0;
 	string_values_offset = 0;
 }
@@ -4143,6 +4612,98 @@ void	dc_flush_history(void)
 ZBX_SHMEM_FUNC_IMPL(__hc_index, hc_index_mem)
 ZBX_SHMEM_FUNC_IMPL(__hc, hc_mem)
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history cache shard index of the specified item               *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_shard_index(zbx_uint64_t itemid)
+{
+	return (int)(itemid % (zbx_uint64_t)hc_shards_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: lock history cache shard                                          *
+ *                                                                            *
+ * Parameters: index - [IN] the shard index                                   *
+ *                                                                            *
+ * Return value: the locked shard                                             *
+ *                                                                            *
+ * Comments: The history cache and index memory allocators are switched to    *
+ *           the shard memory, so the shard data must be changed only while   *
+ *           the shard is locked.                                             *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_hc_shard_t	*hc_lock_shard(int index)
+{
+	zbx_mutex_lock(hc_shard_locks[index]);
+
+	hc_mem = hc_shards[index]->mem;
+	hc_index_mem = hc_shards[index]->index_mem;
+
+	return hc_shards[index];
+}
+
+static void	hc_unlock_shard(int index)
+{
+	zbx_mutex_unlock(hc_shard_locks[index]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the number of values in history cache                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_history_num(void)
+{
+	int	i, history_num = 0;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		history_num += hc_lock_shard(i)->history_num;
+		hc_unlock_shard(i);
+	}
+
+	return history_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history cache statistics summed over all shards               *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_stats(ZBX_DC_STATS *stats, zbx_uint64_t *history_free, zbx_uint64_t *history_total,
+		zbx_uint64_t *index_free, zbx_uint64_t *index_total)
+{
+	int	i;
+
+	memset(stats, 0, sizeof(ZBX_DC_STATS));
+	*history_free = *history_total = *index_free = *index_total = 0;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard;
+
+		shard = hc_lock_shard(i);
+
+		stats->history_counter += shard->stats.history_counter;
+		stats->history_float_counter += shard->stats.history_float_counter;
+		stats->history_uint_counter += shard->stats.history_uint_counter;
+		stats->history_str_counter += shard->stats.history_str_counter;
+		stats->history_log_counter += shard->stats.history_log_counter;
+		stats->history_text_counter += shard->stats.history_text_counter;
+		stats->notsupported_counter += shard->stats.notsupported_counter;
+
+		*history_free += shard->mem->free_size;
+		*history_total += shard->mem->total_size;
+		*index_free += shard->index_mem->free_size;
+		*index_total += shard->index_mem->total_size;
+
+		hc_unlock_shard(i);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: compares history queue elements                                   *
@@ -4162,12 +4723,12 @@ static int	hc_queue_elem_compare_func(const void *d1, const void *d2)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: free history item data allocated in history cache                 *
+ * Purpose: free history item data value allocated in history cache           *
  *                                                                            *
  * Parameters: data - [IN] history item data                                  *
  *                                                                            *
  ******************************************************************************/
-static void	hc_free_data(zbx_hc_data_t *data)
+static void	hc_free_data_value(zbx_hc_data_t *data)
 {
 	if (ITEM_STATE_NOTSUPPORTED == data->state)
 	{
@@ -4195,6 +4756,25 @@ static void	hc_free_data(zbx_hc_data_t *data)
 		}
 	}
 
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free history item data allocated in history cache                 *
+ *                                                                            *
+ * Parameters: data - [IN] history item data                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_free_data(zbx_hc_data_t *data)
+{
+	hc_free_data_value(data);
+
+	if (NULL != data->packed)
+	{
+		__hc_shmem_free_func(data->packed->values);
+		__hc_shmem_free_func(data->packed);
+	}
+
 	__hc_shmem_free_func(data);
 }
 
@@ -4202,46 +4782,49 @@ static void	hc_free_data(zbx_hc_data_t *data)
  *                                                                            *
  * Purpose: put back item into history queue                                  *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: shard - [IN] the history cache shard                           *
+ *             item  - [IN] history item                                      *
  *                                                                            *
  ******************************************************************************/
-static void	hc_queue_item(zbx_hc_item_t *item)
+static void	hc_queue_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item)
 {
 	zbx_binary_heap_elem_t	elem = {item->itemid, (const void *)item};
 
-	zbx_binary_heap_insert(&cache->history_queue, &elem);
+	zbx_binary_heap_insert(&shard->history_queue, &elem);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: returns history item by itemid                                    *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             itemid - [IN] the item id                                      *
  *                                                                            *
  * Return value: the history item or NULL if the requested item is not in     *
  *               history cache                                                *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
+static zbx_hc_item_t	*hc_get_item(zbx_hc_shard_t *shard, zbx_uint64_t itemid)
 {
-	return (zbx_hc_item_t *)zbx_hashset_search(&cache->history_items, &itemid);
+	return (zbx_hc_item_t *)zbx_flatset_search(&shard->history_items, &itemid);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: adds a new item to history cache                                  *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
- *                      [IN] the item data                                    *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             itemid - [IN] the item id                                      *
+ *             data   - [IN] the item data                                    *
  *                                                                            *
  * Return value: the added history item                                       *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
+static zbx_hc_item_t	*hc_add_item(zbx_hc_shard_t *shard, zbx_uint64_t itemid, zbx_hc_data_t *data)
 {
 	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, 0, data, data};
 
-	return (zbx_hc_item_t *)zbx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (zbx_hc_item_t *)zbx_flatset_insert(&shard->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
@@ -4334,11 +4917,44 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates history cache statistics with added value                 *
+ *                                                                            *
+ * Parameters: shard           - [IN] the history cache shard                 *
+ *             item_value_type - [IN] the item value type                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_stats_add_value(zbx_hc_shard_t *shard, unsigned char item_value_type)
+{
+	switch (item_value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			shard->stats.history_float_counter++;
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			shard->stats.history_uint_counter++;
+			break;
+		case ITEM_VALUE_TYPE_STR:
+			shard->stats.history_str_counter++;
+			break;
+		case ITEM_VALUE_TYPE_TEXT:
+			shard->stats.history_text_counter++;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			shard->stats.history_log_counter++;
+			break;
+	}
+
+	shard->stats.history_counter++;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: clones item value from local cache into history cache             *
  *                                                                            *
- * Parameters: data       - [IN/OUT] a reference to the cloned value          *
+ * Parameters: shard      - [IN] the history cache shard                      *
+ *             data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
@@ -4348,7 +4964,7 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(zbx_hc_shard_t *shard, zbx_hc_data_t **data, const dc_item_value_t *item_value)
 {
 	if (NULL == *data)
 	{
@@ -4374,7 +4990,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		shard->stats.notsupported_counter++;
 
 		return SUCCEED;
 	}
@@ -4386,8 +5002,8 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		shard->stats.history_text_counter++;
+		shard->stats.history_counter++;
 
 		return SUCCEED;
 	}
@@ -4422,26 +5038,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 				break;
 		}
 
-		switch (item_value->item_value_type)
-		{
-			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
-				break;
-			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
-				break;
-			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
-				break;
-			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
-				break;
-			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
-				break;
-		}
-
-		cache->stats.history_counter++;
+		hc_stats_add_value(shard, item_value->item_value_type);
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -4451,189 +5048,1224 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item values to the history cache                             *
- *                                                                            *
- * Parameters: values     - [IN] the item values to add                       *
- *             values_num - [IN] the number of item values to add             *
- *                                                                            *
- * Comments: If the history cache is full this function will wait until       *
- *           history syncers processes values freeing enough space to store   *
- *           the new value.                                                   *
- *                                                                            *
- ******************************************************************************/
-static void	hc_add_item_values(dc_item_value_t *values, int values_num)
-{
-	dc_item_value_t	*item_value;
-	int		i;
-	zbx_hc_item_t	*item;
-
-	for (i = 0; i < values_num; i++)
-	{
-		zbx_hc_data_t	*data = NULL;
-
-		item_value = &values[i];
-
-		/* a record with metadata and no value can be dropped if  */
-		/* the metadata update is copied to the last queued value */
-		if (NULL != (item = hc_get_item(item_value->itemid)) &&
-				0 != (item_value->flags & ZBX_DC_FLAG_NOVALUE) &&
-				0 != (item_value->flags & ZBX_DC_FLAG_META))
-		{
-			/* skip metadata updates when only one value is queued, */
-			/* because the item might be already being processed    */
-			if (item->head != item->tail)
-			{
-				item->head->lastlogsize = item_value->lastlogsize;
-				item->head->mtime = item_value->mtime;
-				item->head->flags |= ZBX_DC_FLAG_META;
-				continue;
-			}
-		}
-
-		if (SUCCEED != hc_clone_history_data(&data, item_value))
-		{
-			do
-			{
-				UNLOCK_CACHE;
-
-				zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
-				sleep(1);
-
-				LOCK_CACHE;
-			}
-			while (SUCCEED != hc_clone_history_data(&data, item_value));
-
-			item = hc_get_item(item_value->itemid);
-		}
-
-		if (NULL == item)
-		{
-			item = hc_add_item(item_value->itemid, data);
-			hc_queue_item(item);
-		}
-		else
-		{
-			item->head->next = data;
-			item->head = data;
-		}
-		item->values_num++;
-	}
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: copies item value from history cache into the specified history   *
- *          value                                                             *
- *                                                                            *
- * Parameters: history - [OUT] the history value                              *
- *             itemid  - [IN] the item identifier                             *
- *             data    - [IN] the history data to copy                        *
+ * Purpose: releases partially cloned item value                              *
  *                                                                            *
- * Comments: handling of uninitialized fields in dc_add_proxy_history_log()   *
+ * Parameters: data       - [IN/OUT] the partially cloned value               *
+ *             item_value - [IN] the item value being cloned                  *
  *                                                                            *
  ******************************************************************************/
-static void	hc_copy_history_data(ZBX_DC_HISTORY *history, zbx_uint64_t itemid, zbx_hc_data_t *data)
+static void	hc_free_partial_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
 {
-	history->itemid = itemid;
-	history->ts = data->ts;
-	history->state = data->state;
-	history->flags = data->flags;
-	history->lastlogsize = data->lastlogsize;
-	history->mtime = data->mtime;
+	if (NULL == *data)
+		return;
 
-	if (ITEM_STATE_NOTSUPPORTED == data->state)
+	if (ITEM_STATE_NOTSUPPORTED == item_value->state || 0 != (ZBX_DC_FLAG_LLD & item_value->flags))
 	{
-		history->value.err = zbx_strdup(NULL, data->value.str);
-		history->flags |= ZBX_DC_FLAG_UNDEF;
-		return;
+		if (NULL != (*data)->value.str)
+			__hc_shmem_free_func((*data)->value.str);
 	}
-
-	history->value_type = data->value_type;
-
-	if (0 == (ZBX_DC_FLAG_NOVALUE & data->flags))
+	else if (0 == (ZBX_DC_FLAG_NOVALUE & item_value->flags))
 	{
-		switch (data->value_type)
+		switch (item_value->value_type)
 		{
-			case ITEM_VALUE_TYPE_FLOAT:
-				history->value.dbl = data->value.dbl;
-				break;
-			case ITEM_VALUE_TYPE_UINT64:
-				history->value.ui64 = data->value.ui64;
-				break;
 			case ITEM_VALUE_TYPE_STR:
 			case ITEM_VALUE_TYPE_TEXT:
-				history->value.str = zbx_strdup(NULL, data->value.str);
+				if (NULL != (*data)->value.str)
+					__hc_shmem_free_func((*data)->value.str);
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				history->value.log = (zbx_log_value_t *)zbx_malloc(NULL, sizeof(zbx_log_value_t));
-				history->value.log->value = zbx_strdup(NULL, data->value.log->value);
-
-				if (NULL != data->value.log->source)
-					history->value.log->source = zbx_strdup(NULL, data->value.log->source);
-				else
-					history->value.log->source = NULL;
+				if (NULL != (*data)->value.log)
+				{
+					if (NULL != (*data)->value.log->value)
+						__hc_shmem_free_func((*data)->value.log->value);
 
-				history->value.log->timestamp = data->value.log->timestamp;
-				history->value.log->severity = data->value.log->severity;
-				history->value.log->logeventid = data->value.log->logeventid;
+					if (NULL != (*data)->value.log->source)
+						__hc_shmem_free_func((*data)->value.log->source);
 
+					__hc_shmem_free_func((*data)->value.log);
+				}
 				break;
 		}
 	}
+
+	__hc_shmem_free_func(*data);
+	*data = NULL;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: pops the next batch of history items from cache for processing    *
- *                                                                            *
- * Parameters: history_items - [OUT] the locked history items                 *
+ * Purpose: appends cloned value to the history cache item                    *
  *                                                                            *
- * Comments: The history_items must be returned back to history cache with    *
- *           hc_push_items() function after they have been processed.         *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             item   - [IN] the history item, NULL if the item is not cached *
+ *             itemid - [IN] the item identifier                              *
+ *             data   - [IN] the cloned value                                 *
  *                                                                            *
  ******************************************************************************/
-static void	hc_pop_items(zbx_vector_ptr_t *history_items)
+static void	hc_append_item_data(zbx_hc_shard_t *shard, zbx_hc_item_t *item, zbx_uint64_t itemid,
+		zbx_hc_data_t *data)
 {
-	zbx_binary_heap_elem_t	*elem;
-	zbx_hc_item_t		*item;
-
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	if (NULL == item)
 	{
-		elem = zbx_binary_heap_find_min(&cache->history_queue);
-		item = (zbx_hc_item_t *)elem->data;
-		zbx_vector_ptr_append(history_items, item);
-
-		zbx_binary_heap_remove_min(&cache->history_queue);
+		item = hc_add_item(shard, itemid, data);
+		hc_queue_item(shard, item);
+	}
+	else
+	{
+		item->head->next = data;
+		item->head = data;
 	}
+	item->values_num++;
+	shard->history_num++;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets item history values                                          *
+ * Purpose: packs numeric value after the last history cache item data        *
  *                                                                            *
- * Parameters: history       - [OUT] the history values                       *
- *             history_items - [IN] the history items                         *
+ * Parameters: shard      - [IN] the history cache shard                      *
+ *             item       - [IN] the history item                             *
+ *             item_value - [IN] the item value                               *
+ *                                                                            *
+ * Return value: SUCCEED - the value was packed                               *
+ *               FAIL    - the value cannot be packed or not enough memory,   *
+ *                         it must be cloned as separate data                 *
+ *                                                                            *
+ * Comments: Numeric values without metadata are stored as timestamp and      *
+ *           value pairs in array instead of separate data to fit more values *
+ *           into history cache. Values are packed while they have the same   *
+ *           type and flags.                                                  *
  *                                                                            *
  ******************************************************************************/
-static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *history_items)
+static int	hc_pack_item_value(zbx_hc_shard_t *shard, zbx_hc_item_t *item, const dc_item_value_t *item_value)
 {
-	int		i, history_num = 0;
-	zbx_hc_item_t	*item;
+	zbx_hc_packed_t		*packed = item->head->packed;
+	zbx_hc_packed_value_t	*value;
 
-	/* we don't need to lock history cache because no other processes can  */
-	/* change item's history data until it is pushed back to history queue */
-	for (i = 0; i < history_items->values_num; i++)
-	{
-		item = (zbx_hc_item_t *)history_items->values[i];
+	if (ITEM_STATE_NORMAL != item_value->state || 0 != (item_value->flags & ZBX_HC_FLAGS_NOT_FOR_PACKING))
+		return FAIL;
 
-		if (ZBX_HC_ITEM_STATUS_BUSY == item->status)
-			continue;
+	if (ITEM_VALUE_TYPE_FLOAT != item_value->value_type && ITEM_VALUE_TYPE_UINT64 != item_value->value_type)
+		return FAIL;
 
-		hc_copy_history_data(&history[history_num++], item->itemid, item->tail);
-	}
-}
+	if (NULL == packed)
+	{
+		if (NULL == (packed = (zbx_hc_packed_t *)__hc_shmem_malloc_func(NULL, sizeof(zbx_hc_packed_t))))
+			return FAIL;
 
-/******************************************************************************
+		if (NULL == (packed->values = (zbx_hc_packed_value_t *)__hc_shmem_malloc_func(NULL,
+				sizeof(zbx_hc_packed_value_t) * ZBX_HC_PACKED_ALLOC_MIN)))
+		{
+			__hc_shmem_free_func(packed);
+			return FAIL;
+		}
+
+		packed->first = 0;
+		packed->num = 0;
+		packed->alloc = ZBX_HC_PACKED_ALLOC_MIN;
+		packed->value_type = item_value->value_type;
+		packed->flags = item_value->flags;
+
+		item->head->packed = packed;
+	}
+	else if (packed->value_type != item_value->value_type || packed->flags != item_value->flags)
+	{
+		return FAIL;
+	}
+	else if (packed->num == packed->alloc)
+	{
+		if (packed->first >= packed->alloc / 2)
+		{
+			/* reuse space of the processed values */
+			memmove(packed->values, packed->values + packed->first,
+					sizeof(zbx_hc_packed_value_t) * (size_t)(packed->num - packed->first));
+		}
+		else
+		{
+			zbx_hc_packed_value_t	*values;
+
+			if (NULL == (values = (zbx_hc_packed_value_t *)__hc_shmem_malloc_func(NULL,
+					sizeof(zbx_hc_packed_value_t) * (size_t)packed->alloc * 2)))
+			{
+				return FAIL;
+			}
+
+			memcpy(values, packed->values + packed->first,
+					sizeof(zbx_hc_packed_value_t) * (size_t)(packed->num - packed->first));
+			__hc_shmem_free_func(packed->values);
+			packed->values = values;
+			packed->alloc *= 2;
+		}
+
+		packed->num -= packed->first;
+		packed->first = 0;
+	}
+
+	value = &packed->values[packed->num++];
+	value->ts = item_value->ts;
+
+	if (ITEM_VALUE_TYPE_FLOAT == item_value->value_type)
+		value->value.dbl = item_value->value.value_dbl;
+	else
+		value->value.ui64 = item_value->value.value_uint;
+
+	hc_stats_add_value(shard, item_value->item_value_type);
+
+	item->values_num++;
+	shard->history_num++;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces processed history item data value with the next packed   *
+ *          value                                                             *
+ *                                                                            *
+ * Parameters: data - [IN/OUT] the history item data                          *
+ *                                                                            *
+ * Return value: SUCCEED - the data contains the next value                   *
+ *               FAIL    - there are no packed values                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_unpack_item_value(zbx_hc_data_t *data)
+{
+	zbx_hc_packed_t		*packed;
+	zbx_hc_packed_value_t	*value;
+
+	if (NULL == (packed = data->packed))
+		return FAIL;
+
+	hc_free_data_value(data);
+
+	value = &packed->values[packed->first++];
+
+	data->ts = value->ts;
+	data->value = value->value;
+	data->value_type = packed->value_type;
+	data->flags = packed->flags;
+	data->state = ITEM_STATE_NORMAL;
+	data->lastlogsize = 0;
+	data->mtime = 0;
+
+	if (packed->first == packed->num)
+	{
+		__hc_shmem_free_func(packed->values);
+		__hc_shmem_free_func(packed);
+		data->packed = NULL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * history cache spill file                                                   *
+ *                                                                            *
+ * Values that do not fit into a full history cache are appended to a local   *
+ * spill file instead of blocking the processes adding values. History        *
+ * syncers move the values back into history cache in the same order once     *
+ * there is free space. While a shard has values in the spill file, the new    *
+ * values of that shard are appended to the file as well to keep the order of  *
+ * item values.                                                               *
+ *                                                                            *
+ * The file starts with zbx_hc_spill_header_t followed by records - the item  *
+ * value from local history cache with its value and source strings appended. *
+ * The header keeps the offset of the first record not moved to history cache *
+ * yet, so the moved records are not restored again after restart. Records of *
+ * shards without free space are skipped, the records moved after them are    *
+ * marked as moved. The file is truncated when all records are moved to       *
+ * history cache.                                                             *
+ *                                                                            *
+ * The file is written without holding shard locks. Lock order: shard lock,   *
+ * spill lock.                                                                *
+ *                                                                            *
+ ******************************************************************************/
+
+#define ZBX_HC_SPILL_SIGNATURE		"ZBXHCSPL"
+
+/* the maximum number of values moved from spill file to history cache at once */
+#define ZBX_HC_SPILL_REPLAY_MAX		(ZBX_HC_SYNC_MAX * 10)
+
+/* the spill file read buffer size */
+#define ZBX_HC_SPILL_READ_SIZE		(64 * ZBX_KIBIBYTE)
+
+#define	LOCK_SPILL	zbx_mutex_lock(hc_spill_lock)
+#define	UNLOCK_SPILL	zbx_mutex_unlock(hc_spill_lock)
+
+typedef struct
+{
+	char		signature[8];
+	zbx_uint32_t	record_size;
+	zbx_uint32_t	reserved;
+	zbx_uint64_t	read_offset;	/* the offset of the first record not moved to history cache */
+}
+zbx_hc_spill_header_t;
+
+typedef struct
+{
+	zbx_uint32_t	size;		/* the record size including strings */
+	zbx_uint32_t	moved;		/* 1 if the value was moved to history cache before older records */
+	dc_item_value_t	value;		/* the string offsets are relative to the end of record header */
+}
+zbx_hc_spill_record_t;
+
+typedef struct
+{
+	unsigned char	*data;
+	size_t		data_alloc;
+	size_t		data_size;
+	zbx_uint64_t	offset;		/* the file offset of the buffered data */
+}
+zbx_hc_spill_buffer_t;
+
+static int		hc_spill_fd = -1;
+static zbx_mutex_t	hc_spill_lock = ZBX_MUTEX_NULL;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets lengths of the item value strings stored in spill file       *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_spill_get_str_lens(const dc_item_value_t *item_value, size_t *value_len, size_t *source_len)
+{
+	*value_len = 0;
+	*source_len = 0;
+
+	if (ITEM_STATE_NOTSUPPORTED == item_value->state || 0 != (ZBX_DC_FLAG_LLD & item_value->flags))
+	{
+		*value_len = item_value->value.value_str.len;
+		return;
+	}
+
+	if (0 != (ZBX_DC_FLAG_NOVALUE & item_value->flags))
+		return;
+
+	switch (item_value->value_type)
+	{
+		case ITEM_VALUE_TYPE_LOG:
+			*source_len = item_value->source.len;
+			ZBX_FALLTHROUGH;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			*value_len = item_value->value.value_str.len;
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes data to spill file at the specified offset                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_spill_write(const unsigned char *data, size_t size, zbx_uint64_t offset)
+{
+	ssize_t	n;
+
+	while (0 != size)
+	{
+		if (-1 == (n = pwrite(hc_spill_fd, data, size, (off_t)offset)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot write to history cache spill file \"%s\": %s",
+					CONFIG_HISTORY_SPILL_FILE, zbx_strerror(errno));
+			return FAIL;
+		}
+
+		data += n;
+		size -= (size_t)n;
+		offset += (zbx_uint64_t)n;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads spill file data into buffer                                 *
+ *                                                                            *
+ * Parameters: buffer     - [IN/OUT] the read buffer                          *
+ *             offset     - [IN] the file offset of data to read              *
+ *             size       - [IN] the size of data to read                     *
+ *             offset_end - [IN] the end of data in file                      *
+ *                                                                            *
+ * Return value: the requested data or NULL on error                          *
+ *                                                                            *
+ ******************************************************************************/
+static const unsigned char	*hc_spill_read(zbx_hc_spill_buffer_t *buffer, zbx_uint64_t offset, size_t size,
+		zbx_uint64_t offset_end)
+{
+	size_t	read_size, read_offset = 0;
+	ssize_t	n;
+
+	if (offset + size > offset_end)
+		return NULL;
+
+	if (offset >= buffer->offset && offset + size <= buffer->offset + buffer->data_size)
+		return buffer->data + (offset - buffer->offset);
+
+	read_size = MAX(size, ZBX_HC_SPILL_READ_SIZE);
+
+	if (read_size > offset_end - offset)
+		read_size = (size_t)(offset_end - offset);
+
+	if (buffer->data_alloc < read_size)
+	{
+		buffer->data_alloc = read_size;
+		buffer->data = (unsigned char *)zbx_realloc(buffer->data, buffer->data_alloc);
+	}
+
+	buffer->offset = offset;
+	buffer->data_size = 0;
+
+	while (read_offset < read_size)
+	{
+		if (-1 == (n = pread(hc_spill_fd, buffer->data + read_offset, read_size - read_offset,
+				(off_t)(offset + read_offset))))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot read history cache spill file \"%s\": %s",
+					CONFIG_HISTORY_SPILL_FILE, zbx_strerror(errno));
+			return NULL;
+		}
+
+		if (0 == n)
+			return NULL;
+
+		read_offset += (size_t)n;
+	}
+
+	buffer->data_size = read_size;
+
+	return buffer->data;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads and validates spill file record                             *
+ *                                                                            *
+ * Parameters: buffer     - [IN/OUT] the read buffer                          *
+ *             offset     - [IN] the record offset                            *
+ *             offset_end - [IN] the end of data in file                      *
+ *             record     - [OUT] the record header                           *
+ *                                                                            *
+ * Return value: the record strings or NULL if the record cannot be read      *
+ *                                                                            *
+ ******************************************************************************/
+static const unsigned char	*hc_spill_read_record(zbx_hc_spill_buffer_t *buffer, zbx_uint64_t offset,
+		zbx_uint64_t offset_end, zbx_hc_spill_record_t *record)
+{
+	const unsigned char	*data;
+
+	if (NULL == (data = hc_spill_read(buffer, offset, sizeof(zbx_hc_spill_record_t), offset_end)))
+		return NULL;
+
+	memcpy(record, data, sizeof(zbx_hc_spill_record_t));
+
+	if (record->size != sizeof(zbx_hc_spill_record_t) + record->value.value.value_str.len +
+			record->value.source.len || record->value.source.pvalue != record->value.value.value_str.len)
+	{
+		return NULL;
+	}
+
+	if (NULL == (data = hc_spill_read(buffer, offset, record->size, offset_end)))
+		return NULL;
+
+	return data + sizeof(zbx_hc_spill_record_t);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes item value into spill file record                      *
+ *                                                                            *
+ * Parameters: buf        - [IN/OUT] the records buffer                       *
+ *             buf_alloc  - [IN/OUT] the records buffer size                  *
+ *             buf_offset - [IN/OUT] the end of records in buffer             *
+ *             item_value - [IN] the item value                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_spill_serialize_value(unsigned char **buf, size_t *buf_alloc, size_t *buf_offset,
+		const dc_item_value_t *item_value)
+{
+	zbx_hc_spill_record_t	record;
+	size_t			value_len, source_len, size;
+	unsigned char		*ptr;
+
+	hc_spill_get_str_lens(item_value, &value_len, &source_len);
+	size = sizeof(record) + value_len + source_len;
+
+	if (*buf_alloc < *buf_offset + size)
+	{
+		while (*buf_alloc < *buf_offset + size)
+			*buf_alloc = MAX(*buf_alloc * 2, ZBX_KIBIBYTE);
+
+		*buf = (unsigned char *)zbx_realloc(*buf, *buf_alloc);
+	}
+
+	memset(&record, 0, sizeof(record));
+	record.size = (zbx_uint32_t)size;
+	record.value = *item_value;
+	record.value.value.value_str.pvalue = 0;
+	record.value.value.value_str.len = value_len;
+	record.value.source.pvalue = value_len;
+	record.value.source.len = source_len;
+
+	ptr = *buf + *buf_offset;
+	memcpy(ptr, &record, sizeof(record));
+
+	if (0 != value_len)
+		memcpy(ptr + sizeof(record), &string_values[item_value->value.value_str.pvalue], value_len);
+
+	if (0 != source_len)
+		memcpy(ptr + sizeof(record) + value_len, &string_values[item_value->source.pvalue], source_len);
+
+	*buf_offset += size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends serialized item values to spill file                      *
+ *                                                                            *
+ * Parameters: buf        - [IN] the serialized records                       *
+ *             size       - [IN] the size of serialized records               *
+ *             values_num - [IN] the number of records                        *
+ *                                                                            *
+ * Return value: SUCCEED - the values were appended to spill file             *
+ *               FAIL    - spill file is full or cannot be written            *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_spill_write_values(const unsigned char *buf, size_t size, int values_num)
+{
+	int	ret = FAIL;
+
+	LOCK_SPILL;
+
+	if (cache->spill_write_offset + size <= CONFIG_HISTORY_SPILL_SIZE &&
+			SUCCEED == hc_spill_write(buf, size, cache->spill_write_offset))
+	{
+		if (0 == cache->spill_values_num)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "history cache is full, writing values to spill file \"%s\"",
+					CONFIG_HISTORY_SPILL_FILE);
+		}
+
+		cache->spill_write_offset += size;
+		cache->spill_values_num += values_num;
+		ret = SUCCEED;
+	}
+
+	UNLOCK_SPILL;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item value to the history cache shard, waiting for free      *
+ *          space if necessary                                                *
+ *                                                                            *
+ * Parameters: shard      - [IN/OUT] the locked history cache shard           *
+ *             index      - [IN] the shard index                              *
+ *             item_value - [IN] the item value                               *
+ *                                                                            *
+ * Comments: The shard lock is released while waiting.                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_add_item_value_wait(zbx_hc_shard_t **shard, int index, const dc_item_value_t *item_value)
+{
+	zbx_hc_data_t	*data = NULL;
+
+	/* values are not added while there are older shard values in spill file */
+	while (0 != (*shard)->spill_num || SUCCEED != hc_clone_history_data(*shard, &data, item_value))
+	{
+		hc_unlock_shard(index);
+
+		zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
+		sleep(1);
+
+		*shard = hc_lock_shard(index);
+	}
+
+	hc_append_item_data(*shard, hc_get_item(*shard, item_value->itemid), item_value->itemid, data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item values to the history cache                             *
+ *                                                                            *
+ * Parameters: values     - [IN] the item values to add                       *
+ *             values_num - [IN] the number of item values to add             *
+ *                                                                            *
+ * Comments: If the history cache shard is full the values are written to     *
+ *           spill file, if spill file is not configured or is full this      *
+ *           function will wait until history syncers processes values        *
+ *           freeing enough space to store the new value.                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+{
+	static unsigned char	*spill_buf = NULL;
+	static size_t		spill_buf_alloc = 0;
+	size_t			spill_buf_offset;
+	dc_item_value_t		*item_value;
+	int			i, index, shards[ZBX_MAX_VALUES_LOCAL], spilled[ZBX_MAX_VALUES_LOCAL],
+				values_left = values_num, spilled_num;
+	zbx_hc_item_t		*item;
+
+	for (i = 0; i < values_num; i++)
+		shards[i] = hc_get_shard_index(values[i].itemid);
+
+	/* add values shard by shard, keeping the order of each item values */
+	for (index = 0; index < hc_shards_num && 0 < values_left; index++)
+	{
+		zbx_hc_shard_t	*shard = NULL;
+
+		spilled_num = 0;
+		spill_buf_offset = 0;
+
+		for (i = 0; i < values_num; i++)
+		{
+			zbx_hc_data_t	*data = NULL;
+
+			if (index != shards[i])
+				continue;
+
+			values_left--;
+
+			if (NULL == shard)
+				shard = hc_lock_shard(index);
+
+			item_value = &values[i];
+
+			/* a record with metadata and no value can be dropped if  */
+			/* the metadata update is copied to the last queued value */
+			if (NULL != (item = hc_get_item(shard, item_value->itemid)) && 0 == shard->spill_num &&
+					0 != (item_value->flags & ZBX_DC_FLAG_NOVALUE) &&
+					0 != (item_value->flags & ZBX_DC_FLAG_META))
+			{
+				/* skip metadata updates when only one value is queued, */
+				/* because the item might be already being processed,   */
+				/* or when the last queued value is packed              */
+				if (item->head != item->tail && NULL == item->head->packed)
+				{
+					item->head->lastlogsize = item_value->lastlogsize;
+					item->head->mtime = item_value->mtime;
+					item->head->flags |= ZBX_DC_FLAG_META;
+					continue;
+				}
+			}
+
+			if (NULL != item && 0 == shard->spill_num && SUCCEED == hc_pack_item_value(shard, item, item_value))
+				continue;
+
+			/* values are added to spill file while there are older shard values in it */
+			if (0 == shard->spill_num && SUCCEED == hc_clone_history_data(shard, &data, item_value))
+			{
+				hc_append_item_data(shard, item, item_value->itemid, data);
+				continue;
+			}
+
+			hc_free_partial_data(&data, item_value);
+
+			if (-1 == hc_spill_fd)
+			{
+				hc_add_item_value_wait(&shard, index, item_value);
+				continue;
+			}
+
+			/* the shard spill counter keeps the value order, spill file is written after unlocking shard */
+			hc_spill_serialize_value(&spill_buf, &spill_buf_alloc, &spill_buf_offset, item_value);
+			spilled[spilled_num++] = i;
+			shard->spill_num++;
+		}
+
+		if (NULL != shard)
+			hc_unlock_shard(index);
+
+		if (0 == spilled_num || SUCCEED == hc_spill_write_values(spill_buf, spill_buf_offset, spilled_num))
+			continue;
+
+		/* spill file is full, wait for free space in history cache */
+		shard = hc_lock_shard(index);
+
+		/* the counter is reset if spill file was discarded meanwhile */
+		shard->spill_num = MAX(shard->spill_num - spilled_num, 0);
+
+		for (i = 0; i < spilled_num; i++)
+			hc_add_item_value_wait(&shard, index, &values[spilled[i]]);
+
+		hc_unlock_shard(index);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stores the offset of the first record not moved to history cache  *
+ *          in spill file header                                              *
+ *                                                                            *
+ * Parameters: read_offset - [IN] the record offset                           *
+ *                                                                            *
+ * Return value: SUCCEED - the offset was written to disk                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_spill_store_read_offset(zbx_uint64_t read_offset)
+{
+	if (SUCCEED != hc_spill_write((const unsigned char *)&read_offset, sizeof(read_offset),
+			offsetof(zbx_hc_spill_header_t, read_offset)))
+	{
+		return FAIL;
+	}
+
+	if (0 != fsync(hc_spill_fd))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot synchronize history cache spill file \"%s\": %s",
+				CONFIG_HISTORY_SPILL_FILE, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: marks spill file record as moved to history cache                 *
+ *                                                                            *
+ * Parameters: offset - [IN] the record offset                                *
+ *                                                                            *
+ * Return value: SUCCEED - the record was marked                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_spill_mark_moved(zbx_uint64_t offset)
+{
+	zbx_uint32_t	moved = 1;
+
+	return hc_spill_write((const unsigned char *)&moved, sizeof(moved),
+			offset + offsetof(zbx_hc_spill_record_t, moved));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: truncates spill file to empty state                               *
+ *                                                                            *
+ * Comments: Must be called with spill lock held.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_spill_truncate(void)
+{
+	if (0 != ftruncate(hc_spill_fd, sizeof(zbx_hc_spill_header_t)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot truncate history cache spill file \"%s\": %s",
+				CONFIG_HISTORY_SPILL_FILE, zbx_strerror(errno));
+	}
+
+	/* the stale read offset beyond end of file is ignored on startup if this fails */
+	(void)hc_spill_store_read_offset(sizeof(zbx_hc_spill_header_t));
+
+	cache->spill_read_offset = sizeof(zbx_hc_spill_header_t);
+	cache->spill_write_offset = sizeof(zbx_hc_spill_header_t);
+	cache->spill_values_num = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: discards all values in spill file                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_spill_discard(void)
+{
+	int	i;
+
+	for (i = 0; i < hc_shards_num; i++)
+		hc_lock_shard(i)->spill_num = 0;
+
+	LOCK_SPILL;
+	hc_spill_truncate();
+	UNLOCK_SPILL;
+
+	for (i = hc_shards_num - 1; i >= 0; i--)
+		hc_unlock_shard(i);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds value read from spill file to history cache                  *
+ *                                                                            *
+ * Parameters: record - [IN/OUT] the spill file record                        *
+ *             str    - [IN] the record strings                               *
+ *                                                                            *
+ * Return value: SUCCEED - the value was added to history cache               *
+ *               FAIL    - not enough space in history cache                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_spill_add_record(zbx_hc_spill_record_t *record, const unsigned char *str)
+{
+	dc_item_value_t	*item_value = &record->value;
+	zbx_hc_shard_t	*shard;
+	zbx_hc_item_t	*item;
+	zbx_hc_data_t	*data = NULL;
+	size_t		string_values_offset_orig = string_values_offset, str_len;
+	int		index, ret;
+
+	/* copy strings to the local history cache string buffer after the pending local values */
+	if (0 != (str_len = record->size - sizeof(zbx_hc_spill_record_t)))
+	{
+		dc_string_buffer_realloc(str_len);
+		memcpy(&string_values[string_values_offset], str, str_len);
+	}
+
+	item_value->value.value_str.pvalue += string_values_offset;
+	item_value->source.pvalue += string_values_offset;
+	string_values_offset += str_len;
+
+	index = hc_get_shard_index(item_value->itemid);
+	shard = hc_lock_shard(index);
+
+	item = hc_get_item(shard, item_value->itemid);
+
+	if (NULL != item && SUCCEED == hc_pack_item_value(shard, item, item_value))
+	{
+		ret = SUCCEED;
+	}
+	else if (SUCCEED == (ret = hc_clone_history_data(shard, &data, item_value)))
+		hc_append_item_data(shard, item, item_value->itemid, data);
+	else
+		hc_free_partial_data(&data, item_value);
+
+	/* the counter is reset if spill file was discarded while values were being written */
+	if (SUCCEED == ret && 0 < shard->spill_num)
+		shard->spill_num--;
+
+	hc_unlock_shard(index);
+
+	string_values_offset = string_values_offset_orig;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves values from spill file to history cache while there is      *
+ *          free space                                                        *
+ *                                                                            *
+ * Return value: the number of values left in spill file                      *
+ *                                                                            *
+ * Comments: Only one process moves values at a time, others return at once.  *
+ *           The values of shards without free space are left in file and     *
+ *           the following values of other shards are moved.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_spill_replay(void)
+{
+	static zbx_hc_spill_buffer_t	buffer;
+	static unsigned char		*shards_full = NULL;
+	zbx_hc_spill_record_t		record;
+	const unsigned char		*str;
+	zbx_uint64_t			offset, offset_end, read_offset, read_offset_orig;
+	int				values_num = 0, values_left, corrupted = 0, failed = 0, shards_full_num = 0,
+					index, moved;
+
+	if (-1 == hc_spill_fd)
+		return 0;
+
+	LOCK_SPILL;
+
+	if (0 != cache->spill_replaying || 0 == cache->spill_values_num)
+	{
+		values_left = cache->spill_values_num;
+		UNLOCK_SPILL;
+
+		return values_left;
+	}
+
+	cache->spill_replaying = 1;
+	offset = cache->spill_read_offset;
+	offset_end = cache->spill_write_offset;
+
+	UNLOCK_SPILL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() offset:" ZBX_FS_UI64 " end:" ZBX_FS_UI64, __func__, offset, offset_end);
+
+	if (NULL == shards_full)
+		shards_full = (unsigned char *)zbx_malloc(NULL, (size_t)hc_shards_num);
+
+	memset(shards_full, 0, (size_t)hc_shards_num);
+
+	/* the file is truncated between calls, drop the data buffered during previous call */
+	buffer.data_size = 0;
+
+	read_offset = read_offset_orig = offset;
+
+	while (offset < offset_end && ZBX_HC_SPILL_REPLAY_MAX > values_num && hc_shards_num > shards_full_num)
+	{
+		if (NULL == (str = hc_spill_read_record(&buffer, offset, offset_end, &record)))
+		{
+			corrupted = 1;
+			break;
+		}
+
+		moved = record.moved;
+		index = hc_get_shard_index(record.value.itemid);
+
+		if (0 == moved && 0 == shards_full[index])
+		{
+			if (SUCCEED == hc_spill_add_record(&record, str))
+			{
+				values_num++;
+				moved = 1;
+
+				/* values moved after skipped ones must not be moved again by the next call or restart */
+				if (read_offset != offset && SUCCEED != hc_spill_mark_moved(offset))
+				{
+					failed = 1;
+					break;
+				}
+			}
+			else
+			{
+				shards_full[index] = 1;
+				shards_full_num++;
+			}
+		}
+
+		offset += record.size;
+
+		if (0 != moved && read_offset + record.size == offset)
+			read_offset = offset;
+	}
+
+	if (0 != corrupted)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot read history cache spill file \"%s\" record at offset " ZBX_FS_UI64
+				", discarding the remaining values", CONFIG_HISTORY_SPILL_FILE, offset);
+	}
+
+	/* persist the replay position, so the moved values are not restored again after restart */
+	if (0 == corrupted && 0 == failed && read_offset != read_offset_orig &&
+			SUCCEED != hc_spill_store_read_offset(read_offset))
+	{
+		failed = 1;
+	}
+
+	if (0 != failed)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot update history cache spill file \"%s\", discarding the remaining"
+				" values", CONFIG_HISTORY_SPILL_FILE);
+	}
+
+	if (0 != corrupted || 0 != failed)
+		hc_spill_discard();
+
+	LOCK_SPILL;
+
+	if (0 == corrupted && 0 == failed)
+	{
+		cache->spill_read_offset = read_offset;
+		cache->spill_values_num -= values_num;
+
+		if (0 == cache->spill_values_num)
+		{
+			hc_spill_truncate();
+
+			zabbix_log(LOG_LEVEL_WARNING, "all values from history cache spill file were moved to history"
+					" cache");
+		}
+	}
+
+	cache->spill_replaying = 0;
+	values_left = cache->spill_values_num;
+
+	UNLOCK_SPILL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() moved:%d left:%d", __func__, values_num, values_left);
+
+	return values_left;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets spill file statistics                                        *
+ *                                                                            *
+ * Parameters: values_num - [OUT] the number of values in spill file          *
+ *             used       - [OUT] the spill file size                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_spill_stats(int *values_num, zbx_uint64_t *used)
+{
+	if (-1 == hc_spill_fd)
+	{
+		*values_num = 0;
+		*used = 0;
+		return;
+	}
+
+	LOCK_SPILL;
+
+	*values_num = cache->spill_values_num;
+	*used = (0 != cache->spill_values_num ? cache->spill_write_offset : 0);
+
+	UNLOCK_SPILL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: opens history cache spill file and restores values left in it by  *
+ *          the previous run                                                  *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the spill file was opened or is not configured     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	init_history_cache_spill(char **error)
+{
+	zbx_hc_spill_header_t	header;
+	zbx_hc_spill_record_t	record;
+	zbx_hc_spill_buffer_t	buffer = {0};
+	zbx_stat_t		st;
+	zbx_uint64_t		offset = sizeof(header), read_offset = sizeof(header);
+	int			ret = FAIL;
+
+	if (NULL == CONFIG_HISTORY_SPILL_FILE)
+		return SUCCEED;
+
+	if (SUCCEED != zbx_mutex_create(&hc_spill_lock, ZBX_MUTEX_CACHE_SPILL, error))
+		return FAIL;
+
+	if (-1 == (hc_spill_fd = open(CONFIG_HISTORY_SPILL_FILE, O_RDWR | O_CREAT, 0600)))
+	{
+		*error = zbx_dsprintf(*error, "cannot open history cache spill file \"%s\": %s",
+				CONFIG_HISTORY_SPILL_FILE, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 != zbx_fstat(hc_spill_fd, &st))
+	{
+		*error = zbx_dsprintf(*error, "cannot obtain history cache spill file \"%s\" information: %s",
+				CONFIG_HISTORY_SPILL_FILE, zbx_strerror(errno));
+		goto out;
+	}
+
+	cache->spill_values_num = 0;
+
+	if (0 != st.st_size)
+	{
+		const unsigned char	*data;
+
+		if (NULL != (data = hc_spill_read(&buffer, 0, sizeof(header), (zbx_uint64_t)st.st_size)))
+			memcpy(&header, data, sizeof(header));
+
+		if (NULL == data || 0 != memcmp(header.signature, ZBX_HC_SPILL_SIGNATURE, sizeof(header.signature)) ||
+				sizeof(zbx_hc_spill_record_t) != header.record_size)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "discarding incompatible history cache spill file \"%s\"",
+					CONFIG_HISTORY_SPILL_FILE);
+		}
+		else if (sizeof(header) <= header.read_offset && (zbx_uint64_t)st.st_size >= header.read_offset)
+		{
+			/* count values left by the previous run, the last record might be partially written */
+			for (read_offset = offset = header.read_offset; NULL != hc_spill_read_record(&buffer, offset,
+					(zbx_uint64_t)st.st_size, &record); offset += record.size)
+			{
+				if (0 != record.moved)
+					continue;
+
+				hc_shards[hc_get_shard_index(record.value.itemid)]->spill_num++;
+				cache->spill_values_num++;
+			}
+
+			if (0 != cache->spill_values_num)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "restoring %d values from history cache spill file \"%s\"",
+						cache->spill_values_num, CONFIG_HISTORY_SPILL_FILE);
+			}
+		}
+	}
+
+	if (0 == cache->spill_values_num)
+	{
+		offset = read_offset = sizeof(header);
+
+		memset(&header, 0, sizeof(header));
+		memcpy(header.signature, ZBX_HC_SPILL_SIGNATURE, sizeof(header.signature));
+		header.record_size = sizeof(zbx_hc_spill_record_t);
+		header.read_offset = read_offset;
+
+		if (SUCCEED != hc_spill_write((const unsigned char *)&header, sizeof(header), 0))
+		{
+			*error = zbx_dsprintf(*error, "cannot write history cache spill file \"%s\"",
+					CONFIG_HISTORY_SPILL_FILE);
+			goto out;
+		}
+	}
+
+	if (0 != ftruncate(hc_spill_fd, (off_t)offset))
+	{
+		*error = zbx_dsprintf(*error, "cannot truncate history cache spill file \"%s\": %s",
+				CONFIG_HISTORY_SPILL_FILE, zbx_strerror(errno));
+		goto out;
+	}
+
+	cache->spill_read_offset = read_offset;
+	cache->spill_write_offset = offset;
+	cache->spill_replaying = 0;
+
+	ret = SUCCEED;
+out:
+	zbx_free(buffer.data);
+
+	if (SUCCEED != ret)
+	{
+		close(hc_spill_fd);
+		hc_spill_fd = -1;
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies item value from history cache into the specified history   *
+ *          value                                                             *
+ *                                                                            *
+ * Parameters: history - [OUT] the history value                              *
+ *             itemid  - [IN] the item identifier                             *
+ *             data    - [IN] the history data to copy                        *
+ *                                                                            *
+ * Comments: handling of uninitialized fields in dc_add_proxy_history_log()   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_copy_history_data(ZBX_DC_HISTORY *history, zbx_uint64_t itemid, zbx_hc_data_t *data)
+{
+	history->itemid = itemid;
+	history->ts = data->ts;
+	history->state = data->state;
+	history->flags = data->flags;
+	history->lastlogsize = data->lastlogsize;
+	history->mtime = data->mtime;
+
+	if (ITEM_STATE_NOTSUPPORTED == data->state)
+	{
+		history->value.err = zbx_strdup(NULL, data->value.str);
+		history->flags |= ZBX_DC_FLAG_UNDEF;
+		return;
+	}
+
+	history->value_type = data->value_type;
+
+	if (0 == (ZBX_DC_FLAG_NOVALUE & data->flags))
+	{
+		switch (data->value_type)
+		{
+			case ITEM_VALUE_TYPE_FLOAT:
+				history->value.dbl = data->value.dbl;
+				break;
+			case ITEM_VALUE_TYPE_UINT64:
+				history->value.ui64 = data->value.ui64;
+				break;
+			case ITEM_VALUE_TYPE_STR:
+			case ITEM_VALUE_TYPE_TEXT:
+				history->value.str = zbx_strdup(NULL, data->value.str);
+				break;
+			case ITEM_VALUE_TYPE_LOG:
+				history->value.log = (zbx_log_value_t *)zbx_malloc(NULL, sizeof(zbx_log_value_t));
+				history->value.log->value = zbx_strdup(NULL, data->value.log->value);
+
+				if (NULL != data->value.log->source)
+					history->value.log->source = zbx_strdup(NULL, data->value.log->source);
+				else
+					history->value.log->source = NULL;
+
+				history->value.log->timestamp = data->value.log->timestamp;
+				history->value.log->severity = data->value.log->severity;
+				history->value.log->logeventid = data->value.log->logeventid;
+
+				break;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pops the next batch of history items from cache for processing    *
+ *                                                                            *
+ * Parameters: history_items - [OUT] the locked history items                 *
+ *             items_max     - [IN] the maximum number of items to take       *
+ *                                                                            *
+ * Comments: The history_items must be returned back to history cache with    *
+ *           hc_push_items() function after they have been processed.         *
+ *           Items are taken from the oldest values of each shard, starting   *
+ *           with a different shard on every call.                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_pop_items(zbx_vector_ptr_t *history_items, int items_max)
+{
+	static int		shard_next = -1;
+	zbx_binary_heap_elem_t	*elem;
+	zbx_hc_item_t		*item;
+	int			i;
+
+	/* start with different shards in different processes and rotate the first shard, */
+	/* so syncers do not compete for the same shard lock                               */
+	if (-1 == shard_next)
+		shard_next = (int)(getpid() % hc_shards_num);
+
+	for (i = 0; i < hc_shards_num && items_max > history_items->values_num; i++)
+	{
+		int		index = (shard_next + i) % hc_shards_num;
+		zbx_hc_shard_t	*shard;
+
+		shard = hc_lock_shard(index);
+
+		while (items_max > history_items->values_num &&
+				FAIL == zbx_binary_heap_empty(&shard->history_queue))
+		{
+			elem = zbx_binary_heap_find_min(&shard->history_queue);
+			item = (zbx_hc_item_t *)elem->data;
+			zbx_vector_ptr_append(history_items, item);
+
+			zbx_binary_heap_remove_min(&shard->history_queue);
+		}
+
+		hc_unlock_shard(index);
+	}
+
+	shard_next = (shard_next + 1) % hc_shards_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets item history values                                          *
+ *                                                                            *
+ * Parameters: history       - [OUT] the history values                       *
+ *             history_items - [IN] the history items                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *history_items)
+{
+	int		i, history_num = 0;
+	zbx_hc_item_t	*item;
+
+	/* we don't need to lock history cache because no other processes can  */
+	/* change item's history data until it is pushed back to history queue */
+	for (i = 0; i < history_items->values_num; i++)
+	{
+		item = (zbx_hc_item_t *)history_items->values[i];
+
+		if (ZBX_HC_ITEM_STATUS_BUSY == item->status)
+			continue;
+
+		hc_copy_history_data(&history[history_num++], item->itemid, item->tail);
+	}
+}
+
+/******************************************************************************
  *                                                                            *
  * Purpose: push back the processed history items into history cache          *
  *                                                                            *
@@ -4647,32 +6279,56 @@ static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *histor
  ******************************************************************************/
 void	hc_push_items(zbx_vector_ptr_t *history_items)
 {
-	int		i;
+	int		i, index, items_left = history_items->values_num;
 	zbx_hc_item_t	*item;
 	zbx_hc_data_t	*data_free;
 
-	for (i = 0; i < history_items->values_num; i++)
+	for (index = 0; index < hc_shards_num && 0 < items_left; index++)
 	{
-		item = (zbx_hc_item_t *)history_items->values[i];
+		zbx_hc_shard_t	*shard = NULL;
 
-		switch (item->status)
+		for (i = 0; i < history_items->values_num; i++)
 		{
-			case ZBX_HC_ITEM_STATUS_BUSY:
-				/* reset item status before returning it to queue */
-				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-				hc_queue_item(item);
-				break;
-			case ZBX_HC_ITEM_STATUS_NORMAL:
-				item->values_num--;
-				data_free = item->tail;
-				item->tail = item->tail->next;
-				hc_free_data(data_free);
-				if (NULL == item->tail)
-					zbx_hashset_remove(&cache->history_items, item);
-				else
-					hc_queue_item(item);
-				break;
+			item = (zbx_hc_item_t *)history_items->values[i];
+
+			if (index != hc_get_shard_index(item->itemid))
+				continue;
+
+			items_left--;
+
+			if (NULL == shard)
+				shard = hc_lock_shard(index);
+
+			switch (item->status)
+			{
+				case ZBX_HC_ITEM_STATUS_BUSY:
+					/* reset item status before returning it to queue */
+					item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+					hc_queue_item(shard, item);
+					break;
+				case ZBX_HC_ITEM_STATUS_NORMAL:
+					item->values_num--;
+					shard->history_num--;
+
+					if (SUCCEED == hc_unpack_item_value(item->tail))
+					{
+						hc_queue_item(shard, item);
+						break;
+					}
+
+					data_free = item->tail;
+					item->tail = item->tail->next;
+					hc_free_data(data_free);
+					if (NULL == item->tail)
+						zbx_flatset_remove(&shard->history_items, item);
+					else
+						hc_queue_item(shard, item);
+					break;
+			}
 		}
+
+		if (NULL != shard)
+			hc_unlock_shard(index);
 	}
 }
 
@@ -4683,7 +6339,15 @@ void	hc_push_items(zbx_vector_ptr_t *history_items)
  ******************************************************************************/
 int	hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	int	i, size = 0;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		size += hc_lock_shard(i)->history_queue.elems_num;
+		hc_unlock_shard(i);
+	}
+
+	return size;
 }
 
 int	hc_get_history_compression_age(void)
@@ -4729,7 +6393,7 @@ static int	init_trend_cache(char **error)
 
 	sz = zbx_shmem_required_size(1, "trend cache", "TrendCacheSize");
 	if (SUCCEED != (ret = zbx_shmem_create(&trend_mem, CONFIG_TRENDS_CACHE_SIZE, "trend cache", "TrendCacheSize", 0,
-			error)))
+			0, error)))
 	{
 		goto out;
 	}
@@ -4747,6 +6411,11 @@ static int	init_trend_cache(char **error)
 			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
 			__trend_shmem_malloc_func, __trend_shmem_realloc_func, __trend_shmem_free_func);
 
+	zbx_hashset_create_ext(&cache->trends_pending, 0,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__trend_shmem_malloc_func, __trend_shmem_realloc_func, __trend_shmem_free_func);
+	cache->trends_pending_check = 0;
+
 #undef INIT_HASHSET_SIZE
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -4754,6 +6423,82 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: Allocate shared memory and locks for history cache shards         *
+ *                                                                            *
+ * Comments: Is called from init_database_cache(). The first shard allocators *
+ *           are left active for allocating global history cache data.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	init_history_cache_shards(char **error)
+{
+	int	i, ret = SUCCEED;
+
+	/* use less shards with small caches, so each shard has enough memory */
+	for (hc_shards_num = ZBX_HC_SHARDS_MAX; 1 < hc_shards_num; hc_shards_num /= 2)
+	{
+		if (ZBX_HC_SHARD_SIZE_MIN <= CONFIG_HISTORY_CACHE_SIZE / (zbx_uint64_t)hc_shards_num &&
+				ZBX_HC_SHARD_SIZE_MIN <= CONFIG_HISTORY_INDEX_CACHE_SIZE / (zbx_uint64_t)hc_shards_num)
+		{
+			break;
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() shards:%d", __func__, hc_shards_num);
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hc_shard_t		*shard;
+		zbx_shmem_info_t	*mem, *index_mem;
+
+		if (SUCCEED != (ret = zbx_mutex_create(&hc_shard_locks[i], (zbx_mutex_name_t)(ZBX_MUTEX_CACHE_SHARD + i),
+				error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_shmem_create(&mem, CONFIG_HISTORY_CACHE_SIZE / (zbx_uint64_t)hc_shards_num,
+				"history cache", "HistoryCacheSize", 1, ZBX_SHMEM_FLAG_SLABS, error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_shmem_create(&index_mem,
+				CONFIG_HISTORY_INDEX_CACHE_SIZE / (zbx_uint64_t)hc_shards_num, "history index cache",
+				"HistoryIndexCacheSize", 0, ZBX_SHMEM_FLAG_SLABS, error)))
+		{
+			goto out;
+		}
+
+		hc_mem = mem;
+		hc_index_mem = index_mem;
+
+		shard = (zbx_hc_shard_t *)__hc_index_shmem_malloc_func(NULL, sizeof(zbx_hc_shard_t));
+		memset(shard, 0, sizeof(zbx_hc_shard_t));
+
+		shard->mem = mem;
+		shard->index_mem = index_mem;
+
+		zbx_flatset_create_ext(&shard->history_items, ZBX_HC_ITEMS_INIT_SIZE / hc_shards_num, NULL,
+				__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func,
+				__hc_index_shmem_free_func);
+
+		zbx_binary_heap_create_ext(&shard->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY, __hc_index_shmem_malloc_func,
+				__hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+
+		hc_shards[i] = shard;
+	}
+
+	hc_mem = hc_shards[0]->mem;
+	hc_index_mem = hc_shards[0]->index_mem;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Allocate shared memory for database cache                         *
@@ -4777,17 +6522,8 @@ int	init_database_cache(char **error)
 	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
 		goto out;
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_mem, CONFIG_HISTORY_CACHE_SIZE, "history cache",
-			"HistoryCacheSize", 1, error)))
-	{
-		goto out;
-	}
-
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_index_mem, CONFIG_HISTORY_INDEX_CACHE_SIZE, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
-	{
+	if (SUCCEED != (ret = init_history_cache_shards(error)))
 		goto out;
-	}
 
 	cache = (ZBX_DC_CACHE *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_CACHE));
 	memset(cache, 0, sizeof(ZBX_DC_CACHE));
@@ -4795,13 +6531,6 @@ int	init_database_cache(char **error)
 	ids = (ZBX_DC_IDS *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
 	memset(ids, 0, sizeof(ZBX_DC_IDS));
 
-	zbx_hashset_create_ext(&cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
-
-	zbx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
-
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 	{
 		zbx_hashset_create_ext(&(cache->proxyqueue.index), ZBX_HC_SYNC_MAX,
@@ -4824,6 +6553,9 @@ int	init_database_cache(char **error)
 
 	cache->proxy_history_count = 0;
 
+	if (SUCCEED != (ret = init_history_cache_spill(error)))
+		goto out;
+
 	if (NULL == sql)
 		sql = (char *)zbx_malloc(sql, sql_alloc);
 out:
@@ -4898,6 +6630,8 @@ static void	DCsync_all(void)
  ******************************************************************************/
 void	free_database_cache(int sync)
 {
+	int	i;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	if (ZBX_SYNC_ALL == sync)
@@ -4905,11 +6639,27 @@ void	free_database_cache(int sync)
 
 	cache = NULL;
 
-	zbx_shmem_destroy(hc_mem);
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_shmem_info_t	*mem = hc_shards[i]->mem, *index_mem = hc_shards[i]->index_mem;
+
+		hc_shards[i] = NULL;
+		zbx_shmem_destroy(mem);
+		zbx_shmem_destroy(index_mem);
+		zbx_mutex_destroy(&hc_shard_locks[i]);
+	}
+
+	hc_shards_num = 0;
 	hc_mem = NULL;
-	zbx_shmem_destroy(hc_index_mem);
 	hc_index_mem = NULL;
 
+	if (-1 != hc_spill_fd)
+	{
+		close(hc_spill_fd);
+		hc_spill_fd = -1;
+		zbx_mutex_destroy(&hc_spill_lock);
+	}
+
 	zbx_mutex_destroy(&cache_lock);
 	zbx_mutex_destroy(&cache_ids_lock);
 
@@ -5031,12 +6781,22 @@ out:
  ******************************************************************************/
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
 {
-	LOCK_CACHE;
+	int	i;
 
-	*values_num = cache->history_num;
-	*items_num = cache->history_items.num_data;
+	*values_num = 0;
+	*items_num = 0;
 
-	UNLOCK_CACHE;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard;
+
+		shard = hc_lock_shard(i);
+
+		*values_num += (zbx_uint64_t)shard->history_num;
+		*items_num += (zbx_uint64_t)shard->history_items.num_data;
+
+		hc_unlock_shard(i);
+	}
 }
 
 /******************************************************************************
@@ -5046,15 +6806,33 @@ void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
  ******************************************************************************/
 void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index)
 {
-	LOCK_CACHE;
+	int	i;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hc_shard_t		*shard;
+		zbx_shmem_stats_t	stats;
 
-	if (NULL != data)
-		zbx_shmem_get_stats(hc_mem, data);
+		shard = hc_lock_shard(i);
 
-	if (NULL != index)
-		zbx_shmem_get_stats(hc_index_mem, index);
+		if (NULL != data)
+		{
+			zbx_shmem_get_stats(shard->mem, 0 == i ? data : &stats);
 
-	UNLOCK_CACHE;
+			if (0 != i)
+				zbx_shmem_add_stats(data, &stats);
+		}
+
+		if (NULL != index)
+		{
+			zbx_shmem_get_stats(shard->index_mem, 0 == i ? index : &stats);
+
+			if (0 != i)
+				zbx_shmem_add_stats(index, &stats);
+		}
+
+		hc_unlock_shard(i);
+	}
 }
 
 /******************************************************************************
@@ -5064,21 +6842,27 @@ void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index)
  ******************************************************************************/
 void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items)
 {
-	zbx_hashset_iter_t	iter;
+	zbx_flatset_iter_t	iter;
 	zbx_hc_item_t		*item;
+	int			i;
 
-	LOCK_CACHE;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard;
 
-	zbx_vector_uint64_pair_reserve(items, cache->history_items.num_data);
+		shard = hc_lock_shard(i);
 
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
-		zbx_vector_uint64_pair_append_ptr(items, &pair);
-	}
+		zbx_vector_uint64_pair_reserve(items, (size_t)(items->values_num + shard->history_items.num_data));
 
-	UNLOCK_CACHE;
+		zbx_flatset_iter_reset(&shard->history_items, &iter);
+		while (NULL != (item = (zbx_hc_item_t *)zbx_flatset_iter_next(&iter)))
+		{
+			zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
+			zbx_vector_uint64_pair_append_ptr(items, &pair);
+		}
+
+		hc_unlock_shard(i);
+	}
 }
 
 /******************************************************************************
@@ -5191,14 +6975,18 @@ static void	zbx_hc_proxyqueue_clear(void)
  ******************************************************************************/
 int	zbx_hc_check_proxy(zbx_uint64_t proxyid)
 {
-	double	hc_pused;
-	int	ret;
+	double		hc_pused;
+	int		ret;
+	ZBX_DC_STATS	stats;
+	zbx_uint64_t	history_free, history_total, index_free, index_total;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxyid:"ZBX_FS_UI64, __func__, proxyid);
 
-	LOCK_CACHE;
+	hc_get_stats(&stats, &history_free, &history_total, &index_free, &index_total);
+	hc_pused = 100 * (double)(history_total - history_free) / history_total;
 
-	hc_pused = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+	/* proxy queue is allocated in the first shard index memory */
+	(void)hc_lock_shard(0);
 
 	if (20 >= hc_pused)
 	{
@@ -5243,7 +7031,7 @@ int	zbx_hc_check_proxy(zbx_uint64_t proxyid)
 	ret = zbx_hc_proxyqueue_dequeue(proxyid);
 
 out:
-	UNLOCK_CACHE;
+	hc_unlock_shard(0);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -21,6 +21,7 @@
 
 #include "log.h"
 #include "zbxmutexs.h"
+#include "zbxstr.h"
 #include "zbxtime.h"
 #include "zbxvariant.h"
 
@@ -43,11 +44,26 @@
  * When cache runs out of memory to store new items it enters in low memory mode.
  * In low memory mode cache continues to function as before with few restrictions:
  *   1) items that weren't accessed during the last day are removed from cache.
- *   2) items with worst hits/values ratio might be removed from cache to free the space.
- *   3) no new items are added to the cache.
+ *   2) items chosen by the eviction policy might be removed from cache to free the space.
+ *   3) only new items requested often enough are added to the cache.
+ *
+ * The admission and eviction policy is an adaptation of W-TinyLFU. The item access frequency
+ * is estimated with a count-min sketch, which also counts accesses to items that are not
+ * cached and is periodically aged by halving its counters. Items are split into probation
+ * and protected segments - new items start in probation and are promoted to protected
+ * segment when accessed again. When space must be freed probation items are removed first,
+ * starting with the least frequently used ones. An item in probation segment is not allowed
+ * to remove items accessed more frequently than itself, so an occasional request for a large
+ * period of rarely used item is served from database instead of flushing frequently used
+ * items from cache. The protected segment is limited to 80% of items, the least recently
+ * accessed protected items are demoted back to probation segment when it grows larger.
  *
  * The low memory mode can't be turned off - it will persist until server is rebooted.
  * In low memory mode a warning message is written into log every 5 minutes.
+ *
+ * With larger cache sizes the cache is split into shards by itemid. Each shard has its own
+ * memory, items, statistics and operating mode, so one shard might be working in low memory
+ * mode while others are not.
  */
 
 /* the period of low memory warning messages */
@@ -58,10 +74,9 @@
 
 #define ZBX_VC_LOW_MEMORY_ITEM_PRINT_LIMIT	25
 
+/* the shared memory of the currently locked value cache shard */
 static zbx_shmem_info_t	*vc_mem = NULL;
 
-zbx_rwlock_t	vc_lock = ZBX_RWLOCK_NULL;
-
 /* value cache enable/disable flags */
 #define ZBX_VC_DISABLED		0
 #define ZBX_VC_ENABLED		1
@@ -86,6 +101,32 @@ ZBX_SHMEM_FUNC_IMPL(__vc, vc_mem)
 
 #define ZBX_VC_ITEM_EXPIRE_PERIOD	SEC_PER_DAY
 
+/* the item segments of admission/eviction policy */
+#define ZBX_VC_SEGMENT_PROBATION	0
+#define ZBX_VC_SEGMENT_PROTECTED	1
+
+/* the maximum percentage of items in protected segment */
+#define ZBX_VC_PROTECTED_PERCENT	80
+
+/* the number of frequency sketch rows (hash functions) */
+#define ZBX_VC_SKETCH_DEPTH		4
+
+/* the maximum value of frequency sketch counter */
+#define ZBX_VC_SKETCH_COUNTER_MAX	15
+
+/* the minimum/maximum number of frequency sketch counters in row */
+#define ZBX_VC_SKETCH_WIDTH_MIN		256
+#define ZBX_VC_SKETCH_WIDTH_MAX		65536
+
+/* the expected average item size, used to calculate frequency sketch width */
+#define ZBX_VC_SKETCH_ITEM_SIZE		ZBX_KIBIBYTE
+
+/* the number of recorded accesses per sketch counter after which the sketch is aged */
+#define ZBX_VC_SKETCH_SAMPLE_FACTOR	10
+
+/* the minimum estimated access frequency to add new items in low memory mode */
+#define ZBX_VC_ADMISSION_FREQUENCY_MIN	2
+
 /* the data chunk used to store data fragment */
 typedef struct zbx_vc_chunk
 {
@@ -104,6 +145,11 @@ typedef struct zbx_vc_chunk
 	/* the number of item value slots in chunk */
 	int			slots_num;
 
+	/* the size of encoded item value data or 0 for plain chunks, */
+	/* encoded chunks keep the first value in slots[0], the last  */
+	/* value in slots[1] and the encoded values after them        */
+	int			encoded_size;
+
 	/* the item value data */
 	zbx_history_record_t	slots[1];
 }
@@ -117,6 +163,97 @@ zbx_vc_chunk_t;
 #define ZBX_VC_MAX_CHUNK_RECORDS	((64 * ZBX_KIBIBYTE - sizeof(zbx_vc_chunk_t)) / \
 		sizeof(zbx_history_record_t) + 1)
 
+/* the minimum number of numeric values in chunk to encode it */
+#define ZBX_VC_MIN_ENCODE_RECORDS	8
+
+/* the period after which unused sliding windows are removed */
+#define ZBX_VC_WINDOW_EXPIRE_PERIOD	SEC_PER_HOUR
+
+/* the window percentile sketch flag, tracked for zbx_vc_get_percentile() besides ZBX_VC_AGGREGATE_* flags */
+#define ZBX_VC_AGGREGATE_PERCENTILE	0x80
+
+/* the relative accuracy of window percentile sketch */
+#define ZBX_VC_PERCENTILE_ACCURACY	0.01
+
+/* values with smaller absolute value are counted as zeros by percentile sketch */
+#define ZBX_VC_PERCENTILE_MIN_VALUE	1e-9
+
+/* the maximum number of percentile sketch buckets for positive (negative) values */
+#define ZBX_VC_PERCENTILE_BUCKETS_MAX	4096
+
+/* the double ended queue of values, used to track window minimum/maximum */
+typedef struct
+{
+	zbx_history_record_t	*values;
+	int			first;
+	int			num;
+	int			alloc;
+}
+zbx_vc_deque_t;
+
+/* the percentile sketch buckets of positive or negative values */
+typedef struct
+{
+	/* the number of values in buckets */
+	int	*counts;
+
+	/* the index of the first bucket */
+	int	offset;
+
+	/* the number of buckets */
+	int	num;
+}
+zbx_vc_buckets_t;
+
+/* the relative error percentile sketch (DDSketch) - values are counted in buckets with */
+/* logarithmically growing bounds, so any percentile is estimated with relative error   */
+/* not exceeding ZBX_VC_PERCENTILE_ACCURACY and values can be removed as well as added  */
+typedef struct
+{
+	zbx_vc_buckets_t	positive;
+	zbx_vc_buckets_t	negative;
+
+	/* the number of values close to zero */
+	int			zero;
+}
+zbx_vc_percentiles_t;
+
+/* the sliding window aggregates of item values */
+typedef struct zbx_vc_window
+{
+	struct zbx_vc_window	*next;
+
+	/* the window size in seconds */
+	int			seconds;
+
+	/* the tracked aggregates (ZBX_VC_AGGREGATE_* flags) besides sum and count */
+	unsigned char		flags;
+
+	/* the last time window aggregates were requested */
+	int			lastaccess;
+
+	/* the window covers values with timestamps in (start, end] range, */
+	/* where end is the timestamp of the last value added to cache     */
+	zbx_timespec_t		start;
+	zbx_timespec_t		end;
+
+	int			count;
+	zbx_uint64_t		sum_ui64;
+	double			sum_dbl;
+
+	/* the number of values removed from window since sums were */
+	/* recalculated, used to limit floating point error         */
+	int			removed;
+
+	/* the ascending (minimum) and descending (maximum) value queues */
+	zbx_vc_deque_t		min;
+	zbx_vc_deque_t		max;
+
+	/* the percentile sketch of window values */
+	zbx_vc_percentiles_t	percentiles;
+}
+zbx_vc_window_t;
+
 /* the value cache item data */
 typedef struct
 {
@@ -129,6 +266,9 @@ typedef struct
 	/* the item status flags (ZBX_ITEM_STATUS_*)                  */
 	unsigned char	status;
 
+	/* the admission/eviction policy segment (ZBX_VC_SEGMENT_*)   */
+	unsigned char	segment;
+
 	/* the hour when the current/global range sync was done       */
 	unsigned char	range_sync_hour;
 
@@ -179,6 +319,9 @@ typedef struct
 
 	/* the first (oldest) chunk of item history data              */
 	zbx_vc_chunk_t	*tail;
+
+	/* the sliding window aggregates of numeric items             */
+	zbx_vc_window_t	*windows;
 }
 zbx_vc_item_t;
 
@@ -203,6 +346,25 @@ typedef struct
 	/* the minimum number of bytes to be freed when cache runs out of space */
 	size_t		min_free_request;
 
+	/* the item access frequency sketch - ZBX_VC_SKETCH_DEPTH rows of counters */
+	unsigned char	*sketch;
+
+	/* the number of counters in sketch row, a power of 2 */
+	int		sketch_width;
+
+	/* the number of accesses recorded in sketch since it was aged */
+	int		sketch_additions;
+
+	/* the number of cache hits of items in probation and protected segments */
+	zbx_uint64_t	hits_probation;
+	zbx_uint64_t	hits_protected;
+
+	/* the number of items removed to free space for other items */
+	zbx_uint64_t	evictions;
+
+	/* the number of space requests refused by admission policy */
+	zbx_uint64_t	admissions_rejected;
+
 	/* the cached items */
 	zbx_hashset_t	items;
 
@@ -219,16 +381,36 @@ typedef struct
 
 	/* the item 'weight' - <number of hits> / <number of cache records> */
 	double		weight;
+
+	/* the estimated item access frequency */
+	int		frequency;
 }
 zbx_vc_item_weight_t;
 
 ZBX_VECTOR_DECL(vc_itemweight, zbx_vc_item_weight_t)
 ZBX_VECTOR_IMPL(vc_itemweight, zbx_vc_item_weight_t)
 
+ZBX_VECTOR_DECL(history_range, zbx_history_range_t)
+ZBX_VECTOR_IMPL(history_range, zbx_history_range_t)
+
+ZBX_VECTOR_IMPL(vc_request, zbx_vc_request_t)
+
+/* the bit stream used to encode chunk values */
+typedef struct
+{
+	unsigned char	*data;
+	size_t		data_alloc;
+
+	/* the number of written bits */
+	size_t		bits;
+}
+zbx_vc_bitstream_t;
+
 typedef enum
 {
 	ZBX_VC_UPDATE_STATS,
-	ZBX_VC_UPDATE_RANGE
+	ZBX_VC_UPDATE_RANGE,
+	ZBX_VC_UPDATE_WINDOW
 }
 zbx_vc_item_update_type_t;
 
@@ -244,6 +426,12 @@ enum
 	ZBX_VC_UPDATE_RANGE_NOW
 };
 
+enum
+{
+	ZBX_VC_UPDATE_WINDOW_SECONDS,
+	ZBX_VC_UPDATE_WINDOW_FLAGS
+};
+
 typedef struct
 {
 	zbx_uint64_t			itemid;
@@ -271,12 +459,66 @@ static void	vc_cache_item_update(zbx_uint64_t itemid, zbx_vc_item_update_type_t
 	update->data[1] = arg2;
 }
 
-/* the value cache */
+/* Value cache is partitioned by itemid into shards, each with its own item index, string */
+/* pool, statistics, shared memory and read-write lock, so that processes working with    */
+/* different items do not contend for the same lock.                                      */
+#define ZBX_VC_SHARDS_MAX	ZBX_RWLOCK_VALUECACHE_SHARDS
+
+/* the minimum value cache size per shard */
+#define ZBX_VC_SHARD_SIZE_MIN	(4 * ZBX_MEBIBYTE)
+
+static zbx_vc_cache_t	*vc_shards[ZBX_VC_SHARDS_MAX];
+static zbx_shmem_info_t	*vc_shards_mem[ZBX_VC_SHARDS_MAX];
+static zbx_rwlock_t	vc_shards_lock[ZBX_VC_SHARDS_MAX];
+static int		vc_shards_num = 0;
+
+/* the currently locked value cache shard, after initialization points to the first shard */
 static zbx_vc_cache_t	*vc_cache = NULL;
+static zbx_rwlock_t	vc_lock = ZBX_RWLOCK_NULL;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get value cache shard index of the specified item                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_get_shard_index(zbx_uint64_t itemid)
+{
+	if (1 >= vc_shards_num)
+		return 0;
+
+	return (int)(itemid % (zbx_uint64_t)vc_shards_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: select value cache shard for locking                              *
+ *                                                                            *
+ * Parameters: index - [IN] the shard index                                   *
+ *                                                                            *
+ * Return value: the shard lock                                               *
+ *                                                                            *
+ * Comments: The cache data and memory allocator functions work with the      *
+ *           selected shard, so the shard data must be accessed only while    *
+ *           the shard is locked. Only one shard can be locked at a time,     *
+ *           except when locking all shards in ascending order.               *
+ *           If cache is not initialized the locking is skipped.              *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_rwlock_t	vc_select_shard(int index)
+{
+	if (0 != vc_shards_num)
+	{
+		vc_cache = vc_shards[index];
+		vc_mem = vc_shards_mem[index];
+		vc_lock = vc_shards_lock[index];
+	}
+
+	return vc_lock;
+}
 
-#define	RDLOCK_CACHE	zbx_rwlock_rdlock(vc_lock);
-#define	WRLOCK_CACHE	zbx_rwlock_wrlock(vc_lock);
-#define	UNLOCK_CACHE	zbx_rwlock_unlock(vc_lock);
+#define	RDLOCK_CACHE(index)	zbx_rwlock_rdlock(vc_select_shard(index))
+#define	WRLOCK_CACHE(index)	zbx_rwlock_wrlock(vc_select_shard(index))
+#define	UNLOCK_CACHE		zbx_rwlock_unlock(vc_lock)
 
 /* function prototypes */
 static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_record_t *src, int value_type);
@@ -564,6 +806,40 @@ static int	vc_item_weight_compare_func(const zbx_vc_item_weight_t *d1, const zbx
 	return 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares two item weight data structures by eviction order -     *
+ *          probation items first, then by access frequency and 'weight'      *
+ *                                                                            *
+ * Parameters: d1   - [IN] the first item weight data structure               *
+ *             d2   - [IN] the second item weight data structure              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_item_eviction_compare_func(const zbx_vc_item_weight_t *d1, const zbx_vc_item_weight_t *d2)
+{
+	ZBX_RETURN_IF_NOT_EQUAL(d1->item->segment, d2->item->segment);
+	ZBX_RETURN_IF_NOT_EQUAL(d1->frequency, d2->frequency);
+	ZBX_RETURN_IF_NOT_EQUAL(d1->weight, d2->weight);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares two item weight data structures by item last access     *
+ *          time                                                              *
+ *                                                                            *
+ * Parameters: d1   - [IN] the first item weight data structure               *
+ *             d2   - [IN] the second item weight data structure              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_item_recency_compare_func(const zbx_vc_item_weight_t *d1, const zbx_vc_item_weight_t *d2)
+{
+	ZBX_RETURN_IF_NOT_EQUAL(d1->item->last_accessed, d2->item->last_accessed);
+
+	return 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: frees history log and all resources allocated for it              *
@@ -641,6 +917,8 @@ static void	vc_history_record_vector_clean(zbx_vector_history_record_t *vector,
  *                                                                            *
  * Comments: The misses are added only to cache statistics, while hits are    *
  *           added to both - item and cache statistics.                       *
+ *           Probation items accessed again are promoted to protected         *
+ *           segment.                                                         *
  *                                                                            *
  ******************************************************************************/
 static void	vc_update_statistics(zbx_vc_item_t *item, int hits, int misses, int now)
@@ -649,6 +927,18 @@ static void	vc_update_statistics(zbx_vc_item_t *item, int hits, int misses, int
 	{
 		int	hour;
 
+		if (ZBX_VC_SEGMENT_PROTECTED == item->segment)
+		{
+			vc_cache->hits_protected += (zbx_uint64_t)hits;
+		}
+		else
+		{
+			vc_cache->hits_probation += (zbx_uint64_t)hits;
+
+			if (0 != item->last_accessed)
+				item->segment = ZBX_VC_SEGMENT_PROTECTED;
+		}
+
 		item->hits += (zbx_uint64_t)hits;
 		item->last_accessed = now;
 
@@ -671,6 +961,135 @@ static void	vc_update_statistics(zbx_vc_item_t *item, int hits, int misses, int
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes item access frequency sketch of the current shard     *
+ *                                                                            *
+ * Parameters: shard_size - [IN] the shard memory size                        *
+ *                                                                            *
+ * Return value: SUCCEED - the sketch was initialized                         *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_sketch_init(zbx_uint64_t shard_size)
+{
+	zbx_uint64_t	items_num = shard_size / ZBX_VC_SKETCH_ITEM_SIZE;
+	size_t		size;
+
+	for (vc_cache->sketch_width = ZBX_VC_SKETCH_WIDTH_MIN; ZBX_VC_SKETCH_WIDTH_MAX > vc_cache->sketch_width &&
+			(zbx_uint64_t)vc_cache->sketch_width < items_num; vc_cache->sketch_width *= 2)
+		;
+
+	size = (size_t)vc_cache->sketch_width * ZBX_VC_SKETCH_DEPTH;
+
+	if (NULL == (vc_cache->sketch = (unsigned char *)__vc_shmem_malloc_func(NULL, size)))
+		return FAIL;
+
+	memset(vc_cache->sketch, 0, size);
+	vc_cache->sketch_additions = 0;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns frequency sketch counter of the item in the specified row *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	*vc_sketch_counter(zbx_uint64_t itemid, int row)
+{
+	zbx_hash_t	hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_ALGO(&itemid, sizeof(itemid), (zbx_hash_t)row);
+
+	return vc_cache->sketch + row * vc_cache->sketch_width + (hash & (zbx_hash_t)(vc_cache->sketch_width - 1));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: records item access in frequency sketch                           *
+ *                                                                            *
+ * Parameters: itemid - [IN] the accessed item                                *
+ *                                                                            *
+ * Comments: After recording ZBX_VC_SKETCH_SAMPLE_FACTOR accesses per counter *
+ *           all counters are halved, so the estimated frequency reflects     *
+ *           recent accesses.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_sketch_add(zbx_uint64_t itemid)
+{
+	int	i;
+
+	if (NULL == vc_cache->sketch)
+		return;
+
+	for (i = 0; i < ZBX_VC_SKETCH_DEPTH; i++)
+	{
+		unsigned char	*counter = vc_sketch_counter(itemid, i);
+
+		if (ZBX_VC_SKETCH_COUNTER_MAX > *counter)
+			(*counter)++;
+	}
+
+	if (++vc_cache->sketch_additions >= vc_cache->sketch_width * ZBX_VC_SKETCH_SAMPLE_FACTOR)
+	{
+		for (i = 0; i < vc_cache->sketch_width * ZBX_VC_SKETCH_DEPTH; i++)
+			vc_cache->sketch[i] >>= 1;
+
+		vc_cache->sketch_additions /= 2;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: estimates item access frequency                                   *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item                                         *
+ *                                                                            *
+ * Return value: The estimated number of recent item accesses.                *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_sketch_estimate(zbx_uint64_t itemid)
+{
+	int	i, frequency = ZBX_VC_SKETCH_COUNTER_MAX;
+
+	if (NULL == vc_cache->sketch)
+		return 0;
+
+	for (i = 0; i < ZBX_VC_SKETCH_DEPTH; i++)
+	{
+		unsigned char	*counter = vc_sketch_counter(itemid, i);
+
+		if (*counter < frequency)
+			frequency = *counter;
+	}
+
+	return frequency;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if new item can be added to cache                          *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item                                         *
+ *                                                                            *
+ * Return value: SUCCEED - the item can be added to cache                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: In low memory mode only items requested often enough are added.  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_admit_item(zbx_uint64_t itemid)
+{
+	if (ZBX_VC_MODE_NORMAL == vc_cache->mode)
+		return SUCCEED;
+
+	if (ZBX_VC_ADMISSION_FREQUENCY_MIN <= vc_sketch_estimate(itemid))
+		return SUCCEED;
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: is used to sort items by value count in descending order          *
@@ -814,7 +1233,7 @@ static void	vc_release_space(zbx_vc_item_t *source_item, size_t space)
 {
 	zbx_hashset_iter_t		iter;
 	zbx_vc_item_t			*item;
-	int				i;
+	int				i, protected_num = 0, protected_max, source_frequency = 0;
 	size_t				freed;
 	zbx_vector_vc_itemweight_t	items;
 
@@ -832,13 +1251,16 @@ static void	vc_release_space(zbx_vc_item_t *source_item, size_t space)
 
 	vc_warn_low_memory();
 
-	/* remove items with least hits/size ratio */
+	/* remove probation items first, with least access frequency and hits/size ratio */
 	zbx_vector_vc_itemweight_create(&items);
 
 	zbx_hashset_iter_reset(&vc_cache->items, &iter);
 
 	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
 	{
+		if (ZBX_VC_SEGMENT_PROTECTED == item->segment)
+			protected_num++;
+
 		/* don't remove the item that requested the space and also keep */
 		/* items currently being accessed                               */
 		if (item != source_item)
@@ -848,18 +1270,52 @@ static void	vc_release_space(zbx_vc_item_t *source_item, size_t space)
 			if (0 < item->values_total)
 				weight.weight = (double)item->hits / item->values_total;
 
+			weight.frequency = vc_sketch_estimate(item->itemid);
+
 			zbx_vector_vc_itemweight_append_ptr(&items, &weight);
 		}
 	}
 
-	zbx_vector_vc_itemweight_sort(&items, (zbx_compare_func_t)vc_item_weight_compare_func);
+	/* demote the least recently accessed items when protected segment grows too large */
+	protected_max = vc_cache->items.num_data * ZBX_VC_PROTECTED_PERCENT / 100;
+
+	if (protected_num > protected_max)
+	{
+		zbx_vector_vc_itemweight_sort(&items, (zbx_compare_func_t)vc_item_recency_compare_func);
+
+		for (i = 0; i < items.values_num && protected_num > protected_max; i++)
+		{
+			item = items.values[i].item;
+
+			if (ZBX_VC_SEGMENT_PROTECTED == item->segment)
+			{
+				item->segment = ZBX_VC_SEGMENT_PROBATION;
+				protected_num--;
+			}
+		}
+	}
+
+	zbx_vector_vc_itemweight_sort(&items, (zbx_compare_func_t)vc_item_eviction_compare_func);
+
+	/* accesses are recorded in sketch when statistics are flushed, so count the current request too */
+	if (NULL != source_item)
+		source_frequency = vc_sketch_estimate(source_item->itemid) + 1;
 
 	for (i = 0; i < items.values_num && freed < space; i++)
 	{
+		/* probation item is not allowed to remove more frequently accessed items */
+		if (NULL != source_item && ZBX_VC_SEGMENT_PROBATION == source_item->segment &&
+				items.values[i].frequency > source_frequency)
+		{
+			vc_cache->admissions_rejected++;
+			break;
+		}
+
 		item = items.values[i].item;
 
 		freed += vch_item_free_cache(item) + sizeof(zbx_vc_item_t);
 		zbx_hashset_remove_direct(&vc_cache->items, item);
+		vc_cache->evictions++;
 	}
 	zbx_vector_vc_itemweight_destroy(&items);
 }
@@ -907,7 +1363,7 @@ static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_
  *                                                                            *
  ******************************************************************************/
 static void	vc_history_record_vector_append(zbx_vector_history_record_t *vector, int value_type,
-		zbx_history_record_t *value)
+		const zbx_history_record_t *value)
 {
 	zbx_history_record_t	record;
 
@@ -917,57 +1373,310 @@ static void	vc_history_record_vector_append(zbx_vector_history_record_t *vector,
 
 /******************************************************************************
  *                                                                            *
- * Purpose: allocate cache memory to store item's resources                   *
- *                                                                            *
- * Parameters: item   - [IN] the item                                         *
- *             size   - [IN] the number of bytes to allocate                  *
- *                                                                            *
- * Return value:  The pointer to allocated memory or NULL if there is not     *
- *                enough shared memory.                                       *
+ * Purpose: writes bits to bit stream                                         *
  *                                                                            *
- * Comments: If allocation fails this function attempts to free the required  *
- *           space in cache by calling vc_free_space() and tries again. If it *
- *           still fails a NULL value is returned.                            *
+ * Parameters: bs    - [IN/OUT] the bit stream                                *
+ *             value - [IN] the value to write                                *
+ *             bits  - [IN] the number of low value bits to write (1-64)      *
  *                                                                            *
  ******************************************************************************/
-static void	*vc_item_malloc(zbx_vc_item_t *item, size_t size)
+static void	vc_bitstream_write(zbx_vc_bitstream_t *bs, zbx_uint64_t value, int bits)
 {
-	char	*ptr;
-
-	if (NULL == (ptr = (char *)__vc_shmem_malloc_func(NULL, size)))
+	while (0 < bits)
 	{
-		/* If failed to allocate required memory, try to free space in      */
-		/* cache and allocate again. If there still is not enough space -   */
-		/* return NULL as failure.                                          */
-		vc_release_space(item, size);
-		ptr = (char *)__vc_shmem_malloc_func(NULL, size);
-	}
+		size_t	offset = bs->bits >> 3;
+		int	free_bits = 8 - (int)(bs->bits & 7), n = MIN(free_bits, bits);
 
-	return ptr;
+		if (offset == bs->data_alloc)
+		{
+			bs->data_alloc = (0 == bs->data_alloc ? 256 : bs->data_alloc * 2);
+			bs->data = (unsigned char *)zbx_realloc(bs->data, bs->data_alloc);
+		}
+
+		if (8 == free_bits)
+			bs->data[offset] = 0;
+
+		bs->data[offset] |= (unsigned char)(((value >> (bits - n)) & ((1u << n) - 1)) << (free_bits - n));
+
+		bits -= n;
+		bs->bits += (size_t)n;
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: copies string to the cache memory                                 *
- *                                                                            *
- * Parameters: item  - [IN] the item                                          *
- *             str   - [IN] the string to copy                                *
- *                                                                            *
- * Return value:  The pointer to the copied string or NULL if there was not   *
- *                enough space in cache.                                      *
+ * Purpose: reads bits from bit stream                                        *
  *                                                                            *
- * Comments: If the string pool already contains matching string, then its    *
- *           reference counter is incremented and the string returned.        *
+ * Parameters: data - [IN] the bit stream data                                *
+ *             pos  - [IN/OUT] the bit position in data                       *
+ *             bits - [IN] the number of bits to read (1-64)                  *
  *                                                                            *
- *           Otherwise cache memory is allocated to store the specified       *
- *           string. If the allocation fails this function attempts to free   *
- *           the required space in cache by calling vc_release_space() and    *
- *           tries again. If it still fails then a NULL value is returned.    *
+ * Return value: the read bits                                                *
  *                                                                            *
  ******************************************************************************/
-static char	*vc_item_strdup(zbx_vc_item_t *item, const char *str)
+static zbx_uint64_t	vc_bitstream_read(const unsigned char *data, size_t *pos, int bits)
 {
-	void	*ptr;
+	zbx_uint64_t	value = 0;
+
+	while (0 < bits)
+	{
+		int	avail = 8 - (int)(*pos & 7), n = MIN(avail, bits);
+
+		value = (value << n) | (zbx_uint64_t)((data[*pos >> 3] >> (avail - n)) & ((1u << n) - 1));
+
+		bits -= n;
+		*pos += (size_t)n;
+	}
+
+	return value;
+}
+
+static int	vc_leading_zeros(zbx_uint64_t value)
+{
+	int	n = 0;
+
+	while (0 == (value & __UINT64_C(0x8000000000000000)))
+	{
+		value <<= 1;
+		n++;
+	}
+
+	return n;
+}
+
+static int	vc_trailing_zeros(zbx_uint64_t value)
+{
+	int	n = 0;
+
+	while (0 == (value & 1))
+	{
+		value >>= 1;
+		n++;
+	}
+
+	return n;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: encodes numeric history values                                    *
+ *                                                                            *
+ * Parameters: bs         - [OUT] the encoded values                          *
+ *             values     - [IN] the values in ascending order                *
+ *             values_num - [IN] the number of values                         *
+ *                                                                            *
+ * Comments: The values are encoded as described in Facebook Gorilla paper.   *
+ *           Timestamp seconds are stored as delta of deltas, nanoseconds are *
+ *           stored only when changed and values are stored as XOR with the   *
+ *           previous value, omitting the leading and trailing zero bits.     *
+ *           Float and unsigned values are encoded by their bit patterns.     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_encode_values(zbx_vc_bitstream_t *bs, const zbx_history_record_t *values, int values_num)
+{
+	int	i, delta = 0, leading = -1, trailing = 0;
+
+	vc_bitstream_write(bs, (zbx_uint32_t)values[0].timestamp.sec, 32);
+	vc_bitstream_write(bs, (zbx_uint32_t)values[0].timestamp.ns, 30);
+	vc_bitstream_write(bs, values[0].value.ui64, 64);
+
+	for (i = 1; i < values_num; i++)
+	{
+		const zbx_history_record_t	*prev = &values[i - 1], *value = &values[i];
+		int				dod, sec_delta;
+		zbx_uint64_t			xor;
+
+		sec_delta = value->timestamp.sec - prev->timestamp.sec;
+		dod = sec_delta - delta;
+		delta = sec_delta;
+
+		if (0 == dod)
+		{
+			vc_bitstream_write(bs, 0, 1);
+		}
+		else if (-63 <= dod && 64 >= dod)
+		{
+			vc_bitstream_write(bs, 0x2, 2);
+			vc_bitstream_write(bs, (zbx_uint64_t)(dod + 63), 7);
+		}
+		else if (-255 <= dod && 256 >= dod)
+		{
+			vc_bitstream_write(bs, 0x6, 3);
+			vc_bitstream_write(bs, (zbx_uint64_t)(dod + 255), 9);
+		}
+		else if (-2047 <= dod && 2048 >= dod)
+		{
+			vc_bitstream_write(bs, 0xe, 4);
+			vc_bitstream_write(bs, (zbx_uint64_t)(dod + 2047), 12);
+		}
+		else
+		{
+			vc_bitstream_write(bs, 0xf, 4);
+			vc_bitstream_write(bs, (zbx_uint32_t)sec_delta, 32);
+		}
+
+		if (value->timestamp.ns == prev->timestamp.ns)
+		{
+			vc_bitstream_write(bs, 0, 1);
+		}
+		else
+		{
+			vc_bitstream_write(bs, 1, 1);
+			vc_bitstream_write(bs, (zbx_uint32_t)value->timestamp.ns, 30);
+		}
+
+		if (0 == (xor = value->value.ui64 ^ prev->value.ui64))
+		{
+			vc_bitstream_write(bs, 0, 1);
+		}
+		else
+		{
+			int	lz, tz;
+
+			/* the number of leading zeros is stored in 5 bits */
+			if (31 < (lz = vc_leading_zeros(xor)))
+				lz = 31;
+
+			tz = vc_trailing_zeros(xor);
+
+			if (-1 != leading && lz >= leading && tz >= trailing)
+			{
+				vc_bitstream_write(bs, 0x2, 2);
+				vc_bitstream_write(bs, xor >> trailing, 64 - leading - trailing);
+			}
+			else
+			{
+				/* the number of meaningful bits (1-64) is stored in 6 bits, 64 as 0 */
+				vc_bitstream_write(bs, 0x3, 2);
+				vc_bitstream_write(bs, (zbx_uint64_t)lz, 5);
+				vc_bitstream_write(bs, (zbx_uint64_t)((64 - lz - tz) & 0x3f), 6);
+				vc_bitstream_write(bs, xor >> tz, 64 - lz - tz);
+
+				leading = lz;
+				trailing = tz;
+			}
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decodes numeric history values encoded by vc_encode_values()      *
+ *                                                                            *
+ * Parameters: data       - [IN] the encoded values                           *
+ *             values     - [OUT] the decoded values                          *
+ *             values_num - [IN] the number of values                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_decode_values(const unsigned char *data, zbx_history_record_t *values, int values_num)
+{
+	int	i, delta = 0, leading = 0, trailing = 0;
+	size_t	pos = 0;
+
+	values[0].timestamp.sec = (int)vc_bitstream_read(data, &pos, 32);
+	values[0].timestamp.ns = (int)vc_bitstream_read(data, &pos, 30);
+	values[0].value.ui64 = vc_bitstream_read(data, &pos, 64);
+
+	for (i = 1; i < values_num; i++)
+	{
+		const zbx_history_record_t	*prev = &values[i - 1];
+		zbx_history_record_t		*value = &values[i];
+
+		if (0 == vc_bitstream_read(data, &pos, 1))
+			;
+		else if (0 == vc_bitstream_read(data, &pos, 1))
+			delta += (int)vc_bitstream_read(data, &pos, 7) - 63;
+		else if (0 == vc_bitstream_read(data, &pos, 1))
+			delta += (int)vc_bitstream_read(data, &pos, 9) - 255;
+		else if (0 == vc_bitstream_read(data, &pos, 1))
+			delta += (int)vc_bitstream_read(data, &pos, 12) - 2047;
+		else
+			delta = (int)vc_bitstream_read(data, &pos, 32);
+
+		value->timestamp.sec = prev->timestamp.sec + delta;
+
+		if (0 == vc_bitstream_read(data, &pos, 1))
+			value->timestamp.ns = prev->timestamp.ns;
+		else
+			value->timestamp.ns = (int)vc_bitstream_read(data, &pos, 30);
+
+		if (0 == vc_bitstream_read(data, &pos, 1))
+		{
+			value->value.ui64 = prev->value.ui64;
+		}
+		else
+		{
+			if (0 != vc_bitstream_read(data, &pos, 1))
+			{
+				int	meaningful;
+
+				leading = (int)vc_bitstream_read(data, &pos, 5);
+
+				if (0 == (meaningful = (int)vc_bitstream_read(data, &pos, 6)))
+					meaningful = 64;
+
+				trailing = 64 - leading - meaningful;
+			}
+
+			value->value.ui64 = prev->value.ui64 ^
+					(vc_bitstream_read(data, &pos, 64 - leading - trailing) << trailing);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocate cache memory to store item's resources                   *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             size   - [IN] the number of bytes to allocate                  *
+ *                                                                            *
+ * Return value:  The pointer to allocated memory or NULL if there is not     *
+ *                enough shared memory.                                       *
+ *                                                                            *
+ * Comments: If allocation fails this function attempts to free the required  *
+ *           space in cache by calling vc_free_space() and tries again. If it *
+ *           still fails a NULL value is returned.                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	*vc_item_malloc(zbx_vc_item_t *item, size_t size)
+{
+	char	*ptr;
+
+	if (NULL == (ptr = (char *)__vc_shmem_malloc_func(NULL, size)))
+	{
+		/* If failed to allocate required memory, try to free space in      */
+		/* cache and allocate again. If there still is not enough space -   */
+		/* return NULL as failure.                                          */
+		vc_release_space(item, size);
+		ptr = (char *)__vc_shmem_malloc_func(NULL, size);
+	}
+
+	return ptr;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies string to the cache memory                                 *
+ *                                                                            *
+ * Parameters: item  - [IN] the item                                          *
+ *             str   - [IN] the string to copy                                *
+ *                                                                            *
+ * Return value:  The pointer to the copied string or NULL if there was not   *
+ *                enough space in cache.                                      *
+ *                                                                            *
+ * Comments: If the string pool already contains matching string, then its    *
+ *           reference counter is incremented and the string returned.        *
+ *                                                                            *
+ *           Otherwise cache memory is allocated to store the specified       *
+ *           string. If the allocation fails this function attempts to free   *
+ *           the required space in cache by calling vc_release_space() and    *
+ *           tries again. If it still fails then a NULL value is returned.    *
+ *                                                                            *
+ ******************************************************************************/
+static char	*vc_item_strdup(zbx_vc_item_t *item, const char *str)
+{
+	void	*ptr;
 
 	ptr = zbx_hashset_search(&vc_cache->strpool, str - REFCOUNT_FIELD_SIZE);
 
@@ -1184,7 +1893,7 @@ static void	vc_remove_item_by_id(zbx_uint64_t itemid)
  ******************************************************************************/
 void	zbx_vc_remove_items_by_ids(zbx_vector_uint64_t *itemids)
 {
-	int	i;
+	int	i, j;
 
 	if (ZBX_VC_DISABLED == vc_state)
 		return;
@@ -1192,12 +1901,18 @@ void	zbx_vc_remove_items_by_ids(zbx_vector_uint64_t *itemids)
 	if (0 == itemids->values_num)
 		return;
 
-	WRLOCK_CACHE;
+	for (j = 0; j < vc_shards_num; j++)
+	{
+		WRLOCK_CACHE(j);
 
-	for (i = 0; i < itemids->values_num; i++)
-		vc_remove_item_by_id(itemids->values[i]);
+		for (i = 0; i < itemids->values_num; i++)
+		{
+			if (j == vc_get_shard_index(itemids->values[i]))
+				vc_remove_item_by_id(itemids->values[i]);
+		}
 
-	UNLOCK_CACHE;
+		UNLOCK_CACHE;
+	}
 }
 
 /******************************************************************************
@@ -1254,8 +1969,71 @@ static void	vc_item_update_db_cached_from(zbx_vc_item_t *item, int timestamp)
  *
  * After adding a new chunk, the older chunks (outside the largest request
  * range) are automatically removed from cache.
+ *
+ * Chunks of numeric (float, unsigned) items are encoded once no more values
+ * are appended to them - timestamps are stored as delta of deltas and values
+ * as XOR with the previous value. Encoded chunks are decoded when read and
+ * converted back to plain chunks if values must be inserted into them.
  */
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the first (oldest) value in chunk                         *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_history_record_t	*vch_chunk_first(const zbx_vc_chunk_t *chunk)
+{
+	if (0 != chunk->encoded_size)
+		return &chunk->slots[0];
+
+	return &chunk->slots[chunk->first_value];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the last (newest) value in chunk                          *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_history_record_t	*vch_chunk_last(const zbx_vc_chunk_t *chunk)
+{
+	if (0 != chunk->encoded_size)
+		return &chunk->slots[1];
+
+	return &chunk->slots[chunk->last_value];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns chunk values                                              *
+ *                                                                            *
+ * Parameters: chunk - [IN] the chunk                                         *
+ *                                                                            *
+ * Return value: the chunk value slots, indexed same as plain chunk slots     *
+ *                                                                            *
+ * Comments: Encoded chunk values are decoded into a process local buffer,    *
+ *           which is valid until the next call of this function.             *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_history_record_t	*vch_chunk_values(const zbx_vc_chunk_t *chunk)
+{
+	static zbx_history_record_t	*values = NULL;
+	static int			values_alloc = 0;
+
+	if (0 == chunk->encoded_size)
+		return chunk->slots;
+
+	if (values_alloc < chunk->slots_num)
+	{
+		values_alloc = chunk->slots_num;
+		values = (zbx_history_record_t *)zbx_realloc(values, sizeof(zbx_history_record_t) *
+				(size_t)values_alloc);
+	}
+
+	vc_decode_values((const unsigned char *)&chunk->slots[2], values, chunk->slots_num);
+
+	return values;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: updates item range with current request range                     *
@@ -1282,7 +2060,7 @@ static void	vch_item_update_range(zbx_vc_item_t *item, int range, int now)
 		diff += 0xff;
 
 	if (NULL != item->head)
-		last_value_timestamp = item->head->slots[item->head->last_value].timestamp.sec;
+		last_value_timestamp = vch_chunk_last(item->head)->timestamp.sec;
 	else
 		last_value_timestamp = now;
 
@@ -1387,70 +2165,234 @@ static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *i
 
 /******************************************************************************
  *                                                                            *
- * Purpose: find the index of the last value in chunk with timestamp less or  *
- *          equal to the specified timestamp.                                 *
+ * Purpose: replaces chunk with another chunk in item's chunk list            *
  *                                                                            *
- * Parameters:  chunk - [IN] the chunk                                        *
- *              ts    - [IN] the target timestamp                             *
+ ******************************************************************************/
+static void	vch_item_replace_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, zbx_vc_chunk_t *new_chunk)
+{
+	new_chunk->prev = chunk->prev;
+	new_chunk->next = chunk->next;
+
+	if (NULL != chunk->prev)
+		chunk->prev->next = new_chunk;
+	else
+		item->tail = new_chunk;
+
+	if (NULL != chunk->next)
+		chunk->next->prev = new_chunk;
+	else
+		item->head = new_chunk;
+
+	__vc_shmem_free_func(chunk);
+}
+
+/******************************************************************************
  *                                                                            *
- * Return value: The index of the last value in chunk with timestamp less or  *
- *               equal to the specified timestamp.                            *
- *               -1 is returned in the case of failure (meaning that all      *
- *               values have timestamps greater than the target timestamp).   *
+ * Purpose: encodes numeric item chunk values to save cache memory            *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to encode                               *
+ *                                                                            *
+ * Comments: Chunks are encoded once no more values are added to them, the    *
+ *           head chunk is never encoded. The chunk is left unchanged if      *
+ *           encoding does not reduce its size or there is not enough memory. *
  *                                                                            *
  ******************************************************************************/
-static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+static void	vch_item_encode_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
-	int	start = chunk->first_value, end = chunk->last_value, middle;
+	static zbx_vc_bitstream_t	bs;
+	zbx_vc_chunk_t			*encoded;
+	int				values_num;
+	size_t				size;
 
-	/* check if the last value timestamp is already greater or equal to the specified timestamp */
-	if (0 >= zbx_timespec_compare(&chunk->slots[end].timestamp, ts))
-		return end;
+	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
+		return;
 
-	/* chunk contains only one value, which did not pass the above check, return failure */
-	if (start == end)
-		return -1;
+	if (0 != chunk->encoded_size || chunk == item->head)
+		return;
 
-	/* perform value lookup using binary search */
-	while (start != end)
-	{
-		middle = start + (end - start) / 2;
+	if (ZBX_VC_MIN_ENCODE_RECORDS > (values_num = chunk->last_value - chunk->first_value + 1))
+		return;
 
-		if (0 < zbx_timespec_compare(&chunk->slots[middle].timestamp, ts))
-		{
-			end = middle;
-			continue;
-		}
+	bs.bits = 0;
+	vc_encode_values(&bs, &chunk->slots[chunk->first_value], values_num);
+	size = (bs.bits + 7) >> 3;
 
-		if (0 >= zbx_timespec_compare(&chunk->slots[middle + 1].timestamp, ts))
-		{
-			start = middle;
-			continue;
-		}
+	/* the encoded chunk keeps the first and last values decoded */
+	if (sizeof(zbx_history_record_t) + size >= (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t))
+		return;
 
-		return middle;
+	if (NULL == (encoded = (zbx_vc_chunk_t *)__vc_shmem_malloc_func(NULL, sizeof(zbx_vc_chunk_t) +
+			sizeof(zbx_history_record_t) + size)))
+	{
+		return;
 	}
 
-	return -1;
+	encoded->first_value = 0;
+	encoded->last_value = values_num - 1;
+	encoded->slots_num = values_num;
+	encoded->encoded_size = (int)size;
+	encoded->slots[0] = chunk->slots[chunk->first_value];
+	encoded->slots[1] = chunk->slots[chunk->last_value];
+	memcpy(&encoded->slots[2], bs.data, size);
+
+	vch_item_replace_chunk(item, chunk, encoded);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets the chunk and index of the last value with a timestamp less  *
- *          or equal to the specified timestamp                               *
- *                                                                            *
- * Parameters:  item          - [IN] the item                                 *
- *              ts            - [IN] the target timestamp                     *
- *                                   (NULL - current time)                    *
- *              pchunk        - [OUT] the chunk containing the target value   *
- *              pindex        - [OUT] the index of the target value           *
- *                                                                            *
- * Return value: SUCCEED - the last value was found successfully              *
- *               FAIL - all values in cache have timestamps greater than the  *
- *                      target (timeshift) timestamp.                         *
- *                                                                            *
- * Comments: If end_timestamp value is 0, then simply the last item value in  *
- *           cache is returned.                                               *
+ * Purpose: encodes item chunks starting with the tail chunk until an         *
+ *          encoded chunk or the head chunk is reached                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_encode_tail_chunks(zbx_vc_item_t *item)
+{
+	zbx_vc_chunk_t	*chunk = item->tail, *next;
+
+	for (; NULL != chunk && item->head != chunk && 0 == chunk->encoded_size; chunk = next)
+	{
+		next = chunk->next;
+		vch_item_encode_chunk(item, chunk);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decodes encoded chunk back into plain chunk                       *
+ *                                                                            *
+ * Parameters: item   - [IN/OUT] the chunk owner item                         *
+ *             pchunk - [IN/OUT] the chunk to decode, replaced with the       *
+ *                               decoded chunk                                *
+ *                                                                            *
+ * Return value: SUCCEED - the chunk was decoded or was not encoded           *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_decode_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t **pchunk)
+{
+	zbx_vc_chunk_t	*chunk = *pchunk, *decoded;
+
+	if (0 == chunk->encoded_size)
+		return SUCCEED;
+
+	if (NULL == (decoded = (zbx_vc_chunk_t *)vc_item_malloc(item, sizeof(zbx_vc_chunk_t) +
+			sizeof(zbx_history_record_t) * (size_t)(chunk->slots_num - 1))))
+	{
+		return FAIL;
+	}
+
+	vc_decode_values((const unsigned char *)&chunk->slots[2], decoded->slots, chunk->slots_num);
+	decoded->first_value = chunk->first_value;
+	decoded->last_value = chunk->last_value;
+	decoded->slots_num = chunk->slots_num;
+	decoded->encoded_size = 0;
+
+	vch_item_replace_chunk(item, chunk, decoded);
+	*pchunk = decoded;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes values older than the specified timestamp from the        *
+ *          beginning of chunk                                                *
+ *                                                                            *
+ * Parameters: item      - [IN/OUT] the chunk owner item                      *
+ *             chunk     - [IN/OUT] the chunk                                 *
+ *             timestamp - [IN] the timestamp (seconds)                       *
+ *                                                                            *
+ * Comments: The chunk must have values with the timestamp greater or equal   *
+ *           to the specified timestamp.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_chunk_values(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int timestamp)
+{
+	const zbx_history_record_t	*values = vch_chunk_values(chunk);
+	int				index = chunk->first_value;
+
+	while (values[index].timestamp.sec < timestamp)
+		index++;
+
+	if (index == chunk->first_value)
+		return;
+
+	vc_item_free_values(item, chunk->slots, chunk->first_value, index - 1);
+	chunk->first_value = index;
+
+	if (0 != chunk->encoded_size)
+		chunk->slots[0] = values[index];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find the index of the last value in chunk with timestamp less or  *
+ *          equal to the specified timestamp.                                 *
+ *                                                                            *
+ * Parameters:  chunk - [IN] the chunk                                        *
+ *              ts    - [IN] the target timestamp                             *
+ *                                                                            *
+ * Return value: The index of the last value in chunk with timestamp less or  *
+ *               equal to the specified timestamp.                            *
+ *               -1 is returned in the case of failure (meaning that all      *
+ *               values have timestamps greater than the target timestamp).   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+{
+	int				start = chunk->first_value, end = chunk->last_value, middle;
+	const zbx_history_record_t	*values;
+
+	/* check if the last value timestamp is already greater or equal to the specified timestamp */
+	if (0 >= zbx_timespec_compare(&vch_chunk_last(chunk)->timestamp, ts))
+		return end;
+
+	/* chunk contains only one value, which did not pass the above check, return failure */
+	if (start == end)
+		return -1;
+
+	values = vch_chunk_values(chunk);
+
+	/* perform value lookup using binary search */
+	while (start != end)
+	{
+		middle = start + (end - start) / 2;
+
+		if (0 < zbx_timespec_compare(&values[middle].timestamp, ts))
+		{
+			end = middle;
+			continue;
+		}
+
+		if (0 >= zbx_timespec_compare(&values[middle + 1].timestamp, ts))
+		{
+			start = middle;
+			continue;
+		}
+
+		return middle;
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets the chunk and index of the last value with a timestamp less  *
+ *          or equal to the specified timestamp                               *
+ *                                                                            *
+ * Parameters:  item          - [IN] the item                                 *
+ *              ts            - [IN] the target timestamp                     *
+ *                                   (NULL - current time)                    *
+ *              pchunk        - [OUT] the chunk containing the target value   *
+ *              pindex        - [OUT] the index of the target value           *
+ *                                                                            *
+ * Return value: SUCCEED - the last value was found successfully              *
+ *               FAIL - all values in cache have timestamps greater than the  *
+ *                      target (timeshift) timestamp.                         *
+ *                                                                            *
+ * Comments: If end_timestamp value is 0, then simply the last item value in  *
+ *           cache is returned.                                               *
  *                                                                            *
  ******************************************************************************/
 static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
@@ -1464,9 +2406,9 @@ static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec
 
 	index = chunk->last_value;
 
-	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
+	if (0 < zbx_timespec_compare(&vch_chunk_last(chunk)->timestamp, ts))
 	{
-		while (0 < zbx_timespec_compare(&chunk->slots[chunk->first_value].timestamp, ts))
+		while (0 < zbx_timespec_compare(&vch_chunk_first(chunk)->timestamp, ts))
 		{
 			chunk = chunk->prev;
 			/* there are no values for requested range, return failure */
@@ -1604,7 +2546,11 @@ static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
 	size_t	freed;
 
-	freed = sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+	if (0 != chunk->encoded_size)
+		freed = sizeof(zbx_vc_chunk_t) + sizeof(zbx_history_record_t) + (size_t)chunk->encoded_size;
+	else
+		freed = sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+
 	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
 
 	__vc_shmem_free_func(chunk);
@@ -1660,9 +2606,8 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
 		/* Try to remove chunks with all history values older than maximum request range, maximum */
 		/* request range should be calculated from last received value with which active range    */
 		/* was calculated to avoid dropping of chunks that might be still used in count request.  */
-		while (NULL != chunk && chunk->slots[chunk->last_value].timestamp.sec < timestamp &&
-				chunk->slots[chunk->last_value].timestamp.sec !=
-						item->head->slots[item->head->last_value].timestamp.sec)
+		while (NULL != chunk && vch_chunk_last(chunk)->timestamp.sec < timestamp &&
+				vch_chunk_last(chunk)->timestamp.sec != vch_chunk_last(item->head)->timestamp.sec)
 		{
 			/* don't remove the head chunk */
 			if (NULL == (next = chunk->next))
@@ -1676,18 +2621,11 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
 			/* In this case increase the first value index of the next chunk until the first  */
 			/* value timestamp is greater.                                                    */
 
-			if (next->slots[next->first_value].timestamp.sec != next->slots[next->last_value].timestamp.sec)
-			{
-				while (next->slots[next->first_value].timestamp.sec ==
-						chunk->slots[chunk->last_value].timestamp.sec)
-				{
-					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
-					next->first_value++;
-				}
-			}
+			if (vch_chunk_first(next)->timestamp.sec != vch_chunk_last(next)->timestamp.sec)
+				vch_item_remove_chunk_values(item, next, vch_chunk_last(chunk)->timestamp.sec + 1);
 
 			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
-			item->db_cached_from = chunk->slots[chunk->last_value].timestamp.sec + 1;
+			item->db_cached_from = vch_chunk_last(chunk)->timestamp.sec + 1;
 
 			vch_item_remove_chunk(item, chunk);
 
@@ -1718,21 +2656,16 @@ static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
 		item->status = 0;
 
 	/* try to remove chunks with all history values older than the timestamp */
-	while (NULL != chunk && chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+	while (NULL != chunk && vch_chunk_first(chunk)->timestamp.sec < timestamp)
 	{
 		zbx_vc_chunk_t	*next;
 
 		/* If chunk contains values with timestamp greater or equal - remove */
 		/* only the values with less timestamp. Otherwise remove the while   */
 		/* chunk and check next one.                                         */
-		if (chunk->slots[chunk->last_value].timestamp.sec >= timestamp)
+		if (vch_chunk_last(chunk)->timestamp.sec >= timestamp)
 		{
-			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
-			{
-				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
-				chunk->first_value++;
-			}
-
+			vch_item_remove_chunk_values(item, chunk, timestamp);
 			break;
 		}
 
@@ -1762,10 +2695,9 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 	int		ret = FAIL, index, sindex, nslots = 0;
 	zbx_vc_chunk_t	*chunk, *schunk;
 
-	if (NULL != item->head &&
-			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+	if (NULL != item->head && 0 < zbx_history_record_compare_asc_func(vch_chunk_last(item->head), value))
 	{
-		if (0 < zbx_history_record_compare_asc_func(&item->tail->slots[item->tail->first_value], value))
+		if (0 < zbx_history_record_compare_asc_func(vch_chunk_first(item->tail), value))
 		{
 			/* If the added value has the same or older timestamp as the first value in cache */
 			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
@@ -1786,6 +2718,17 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 			goto out;
 		}
 
+		/* values are moved to the right within plain chunks, so decode */
+		/* the chunks up to the one where the value will be inserted    */
+		for (chunk = item->head; NULL != chunk; chunk = chunk->prev)
+		{
+			if (FAIL == vch_item_decode_chunk(item, &chunk))
+				goto out;
+
+			if (0 >= zbx_history_record_compare_asc_func(&chunk->slots[chunk->first_value], value))
+				break;
+		}
+
 		sindex = item->head->last_value;
 		schunk = item->head;
 
@@ -1827,7 +2770,7 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 	else
 	{
 		/* find the number of free slots on the right side in last (head) chunk */
-		if (NULL != item->head)
+		if (NULL != item->head && 0 == item->head->encoded_size)
 			nslots = item->head->slots_num - item->head->last_value - 1;
 
 		if (0 == nslots)
@@ -1875,7 +2818,7 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 	/* skip values already added to the item cache by another process */
 	if (NULL != item->tail)
 	{
-		int	sec = item->tail->slots[item->tail->first_value].timestamp.sec;
+		int	sec = vch_chunk_first(item->tail)->timestamp.sec;
 
 		while (--count >= 0 && values[count].timestamp.sec >= sec)
 			;
@@ -1887,7 +2830,7 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 		int	copy_slots, nslots = 0;
 
 		/* find the number of free slots on the left side in first (tail) chunk */
-		if (NULL != item->tail)
+		if (NULL != item->tail && 0 == item->tail->encoded_size)
 			nslots = item->tail->first_value;
 
 		if (0 == nslots)
@@ -1909,6 +2852,8 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 			goto out;
 	}
 
+	vch_item_encode_tail_chunks(item);
+
 	ret = SUCCEED;
 out:
 	return ret;
@@ -1946,7 +2891,7 @@ static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
 	if (NULL != (*item)->tail)
 	{
 		/* we need to get item values before the first cached value, but not including it */
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+		range_end = vch_chunk_first((*item)->tail)->timestamp.sec - 1;
 	}
 	else
 		range_end = ZBX_JAN_2038;
@@ -1967,7 +2912,7 @@ static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
 				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
 	}
 
-	WRLOCK_CACHE;
+	WRLOCK_CACHE(vc_get_shard_index(itemid));
 
 	if (SUCCEED != ret)
 		goto out;
@@ -2055,7 +3000,7 @@ static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int ran
 
 	/* get the end timestamp to which (including) the values should be cached */
 	if (NULL != (*item)->head)
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+		range_end = vch_chunk_first((*item)->tail)->timestamp.sec - 1;
 	else
 		range_end = ZBX_JAN_2038;
 
@@ -2080,7 +3025,7 @@ static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int ran
 				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
 	}
 
-	WRLOCK_CACHE;
+	WRLOCK_CACHE(vc_get_shard_index(itemid));
 
 	if (SUCCEED != ret)
 		goto out;
@@ -2113,8 +3058,7 @@ static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int ran
 
 	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
 	{
-		vc_item_update_db_cached_from(*item,
-				(*item)->tail->slots[(*item)->tail->first_value].timestamp.sec);
+		vc_item_update_db_cached_from(*item, vch_chunk_first((*item)->tail)->timestamp.sec);
 	}
 	else if (0 != range_start)
 		vc_item_update_db_cached_from(*item, range_start);
@@ -2125,6 +3069,46 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves cached item history data with timestamps in the         *
+ *          (start, end] range                                                *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             values - [OUT] the item history data stored time/value pairs   *
+ *                      in descending order                                   *
+ *             start  - [IN] the range start timestamp (exclusive)            *
+ *             end    - [IN] the range end timestamp (inclusive)              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_get_values_by_range(const zbx_vc_item_t *item, zbx_vector_history_record_t *values,
+		const zbx_timespec_t *start, const zbx_timespec_t *end)
+{
+	int		index;
+	zbx_vc_chunk_t	*chunk;
+
+	if (FAIL == vch_item_get_last_value(item, end, &chunk, &index))
+	{
+		/* Cache does not contain records for the specified timeshift & seconds range. */
+		/* Return empty vector with success.                                           */
+		return;
+	}
+
+	/* fill the values vector with item history values until the start timestamp is reached */
+	while (0 < zbx_timespec_compare(&vch_chunk_last(chunk)->timestamp, start))
+	{
+		const zbx_history_record_t	*slots = vch_chunk_values(chunk);
+
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, start))
+			vc_history_record_vector_append(values, item->value_type, &slots[index--]);
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieves item history data from cache                            *
@@ -2139,9 +3123,8 @@ out:
 static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
 		const zbx_timespec_t *ts)
 {
-	int		index, now;
+	int		now;
 	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
-	zbx_vc_chunk_t	*chunk;
 
 	/* Check if maximum request range is not set and all data are cached.  */
 	/* Because that indicates there was a count based request with unknown */
@@ -2153,24 +3136,7 @@ static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_hi
 		vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
 	}
 
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
-	{
-		/* Cache does not contain records for the specified timeshift & seconds range. */
-		/* Return empty vector with success.                                           */
-		return;
-	}
-
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
-	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
-
-		if (NULL == (chunk = chunk->prev))
-			break;
-
-		index = chunk->last_value;
-	}
+	vch_item_get_values_by_range(item, values, &start, ts);
 }
 
 /******************************************************************************
@@ -2216,11 +3182,13 @@ static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vecto
 	/* fill the values vector with item history values until the <count> values are read    */
 	/* or no more values within specified time period                                       */
 	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	while (0 < zbx_timespec_compare(&vch_chunk_last(chunk)->timestamp, &start))
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
+		const zbx_history_record_t	*slots = vch_chunk_values(chunk);
+
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
 		{
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+			vc_history_record_vector_append(values, item->value_type, &slots[index--]);
 
 			if (values->values_num == count)
 				goto out;
@@ -2326,356 +3294,2291 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: frees resources allocated for item history data                   *
- *                                                                            *
- * Parameters: item    - [IN] the item                                        *
- *                                                                            *
- * Return value: the size of freed memory (bytes)                             *
+ * Purpose: compares two numeric history values                               *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+static int	vc_history_value_compare(int value_type, const zbx_history_value_t *v1,
+		const zbx_history_value_t *v2)
 {
-	size_t	freed = 0;
-
-	zbx_vc_chunk_t	*chunk = item->tail;
-
-	while (NULL != chunk)
+	if (ITEM_VALUE_TYPE_UINT64 == value_type)
 	{
-		zbx_vc_chunk_t	*next = chunk->next;
-
-		freed += vch_item_free_chunk(item, chunk);
-		chunk = next;
+		ZBX_RETURN_IF_NOT_EQUAL(v1->ui64, v2->ui64);
+	}
+	else
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(v1->dbl, v2->dbl);
 	}
-	item->values_total = 0;
-	item->head = NULL;
-	item->tail = NULL;
 
-	return freed;
+	return 0;
 }
 
-/******************************************************************************************************************
- *                                                                                                                *
- * Public API                                                                                                     *
- *                                                                                                                *
- ******************************************************************************************************************/
-
 /******************************************************************************
  *                                                                            *
- * Purpose: initializes value cache                                           *
+ * Purpose: appends value to the window minimum/maximum queue                 *
+ *                                                                            *
+ * Parameters: deque      - [IN/OUT] the queue                                *
+ *             value      - [IN] the value to append                          *
+ *             value_type - [IN] the value type                               *
+ *             flag       - [IN] ZBX_VC_AGGREGATE_MIN - ascending queue       *
+ *                               ZBX_VC_AGGREGATE_MAX - descending queue      *
+ *                                                                            *
+ * Return value: SUCCEED - the value was appended                             *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ * Comments: Values that can no longer be the window minimum (maximum) are    *
+ *           removed from the end of queue, so the first queue value is       *
+ *           always the minimum (maximum) of window.                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_init(char **error)
+static int	vc_deque_push(zbx_vc_deque_t *deque, const zbx_history_record_t *value, int value_type,
+		unsigned char flag)
 {
-	zbx_uint64_t	size_reserved;
-	int		ret = FAIL;
-
-	if (0 == CONFIG_VALUE_CACHE_SIZE)
-		return SUCCEED;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (SUCCEED != (ret = zbx_rwlock_create(&vc_lock, ZBX_RWLOCK_VALUECACHE, error)))
-		goto out;
-
-	size_reserved = zbx_shmem_required_size(1, "value cache size", "ValueCacheSize");
-
-	if (SUCCEED != zbx_shmem_create(&vc_mem, CONFIG_VALUE_CACHE_SIZE, "value cache size", "ValueCacheSize", 1,
-			error))
+	while (0 < deque->num)
 	{
-		goto out;
-	}
+		const zbx_history_record_t	*last;
+		int				rc;
 
-	CONFIG_VALUE_CACHE_SIZE -= size_reserved;
+		last = &deque->values[(deque->first + deque->num - 1) % deque->alloc];
+		rc = vc_history_value_compare(value_type, &last->value, &value->value);
 
-	vc_cache = (zbx_vc_cache_t *)__vc_shmem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
+		if ((ZBX_VC_AGGREGATE_MIN == flag && 0 > rc) || (ZBX_VC_AGGREGATE_MAX == flag && 0 < rc))
+			break;
 
-	if (NULL == vc_cache)
-	{
-		*error = zbx_strdup(*error, "cannot allocate value cache header");
-		goto out;
+		deque->num--;
 	}
-	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
-
-	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
 
-	if (NULL == vc_cache->items.slots)
+	if (deque->num == deque->alloc)
 	{
-		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
-		goto out;
-	}
+		zbx_history_record_t	*values;
+		int			i, alloc = (0 == deque->alloc ? 16 : deque->alloc * 2);
 
-	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
-			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
-			__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
-
-	if (NULL == vc_cache->strpool.slots)
-	{
-		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
-		goto out;
-	}
+		if (NULL == (values = (zbx_history_record_t *)__vc_shmem_malloc_func(NULL,
+				sizeof(zbx_history_record_t) * (size_t)alloc)))
+		{
+			return FAIL;
+		}
 
-	/* the free space request should be 5% of cache size, but no more than 128KB */
-	vc_cache->min_free_request = (CONFIG_VALUE_CACHE_SIZE / 100) * 5;
-	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
-		vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
+		for (i = 0; i < deque->num; i++)
+			values[i] = deque->values[(deque->first + i) % deque->alloc];
 
-	zbx_vector_vc_itemupdate_create(&vc_itemupdates);
-	zbx_vector_vc_itemupdate_reserve(&vc_itemupdates, 256);
+		if (NULL != deque->values)
+			__vc_shmem_free_func(deque->values);
 
-	ret = SUCCEED;
-out:
-	zbx_vc_disable();
+		deque->values = values;
+		deque->alloc = alloc;
+		deque->first = 0;
+	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	deque->values[(deque->first + deque->num) % deque->alloc] = *value;
+	deque->num++;
 
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: destroys value cache                                              *
+ * Purpose: returns the first queue value with timestamp after the specified  *
+ *          timestamp                                                         *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_destroy(void)
+static const zbx_history_record_t	*vc_deque_first(const zbx_vc_deque_t *deque, const zbx_timespec_t *start)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	int	i;
 
-	if (NULL != vc_cache)
+	for (i = 0; i < deque->num; i++)
 	{
-		zbx_vector_vc_itemupdate_destroy(&vc_itemupdates);
-
-		zbx_hashset_destroy(&vc_cache->items);
-		zbx_hashset_destroy(&vc_cache->strpool);
+		const zbx_history_record_t	*value = &deque->values[(deque->first + i) % deque->alloc];
 
-		__vc_shmem_free_func(vc_cache);
-		vc_cache = NULL;
-
-		zbx_shmem_destroy(vc_mem);
-		vc_mem = NULL;
-		zbx_rwlock_destroy(&vc_lock);
+		if (0 < zbx_timespec_compare(&value->timestamp, start))
+			return value;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return NULL;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: resets value cache                                                *
- *                                                                            *
- * Comments: All items and their historical data are removed,                 *
- *           cache working mode, statistics reset.                            *
+ * Purpose: removes queue values with timestamp less or equal to the          *
+ *          specified timestamp                                               *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_reset(void)
+static void	vc_deque_remove(zbx_vc_deque_t *deque, const zbx_timespec_t *start)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
+	while (0 < deque->num && 0 >= zbx_timespec_compare(&deque->values[deque->first].timestamp, start))
+	{
+		deque->first = (deque->first + 1) % deque->alloc;
+		deque->num--;
+	}
+}
+
+static size_t	vc_deque_free(zbx_vc_deque_t *deque)
+{
+	size_t	freed = sizeof(zbx_history_record_t) * (size_t)deque->alloc;
+
+	if (NULL != deque->values)
+		__vc_shmem_free_func(deque->values);
+
+	memset(deque, 0, sizeof(zbx_vc_deque_t));
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the logarithm of percentile sketch bucket bound ratio     *
+ *                                                                            *
+ ******************************************************************************/
+static double	vc_percentile_log_gamma(void)
+{
+	return log((1 + ZBX_VC_PERCENTILE_ACCURACY) / (1 - ZBX_VC_PERCENTILE_ACCURACY));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds or removes value count in percentile sketch bucket           *
+ *                                                                            *
+ * Parameters: buckets - [IN/OUT] the buckets                                 *
+ *             index   - [IN] the bucket index                                *
+ *             count   - [IN] the number of values to add (negative - remove) *
+ *                                                                            *
+ * Return value: SUCCEED - the bucket was updated                             *
+ *               FAIL    - not enough memory or too many buckets              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_buckets_update(zbx_vc_buckets_t *buckets, int index, int count)
+{
+	if (0 == buckets->num || index < buckets->offset || index >= buckets->offset + buckets->num)
+	{
+		int	*counts, offset, num;
+
+		if (0 > count)
+			return FAIL;
+
+		if (0 == buckets->num)
+		{
+			offset = index;
+			num = 1;
+		}
+		else
+		{
+			offset = MIN(buckets->offset, index);
+			num = MAX(buckets->offset + buckets->num, index + 1) - offset;
+		}
+
+		if (ZBX_VC_PERCENTILE_BUCKETS_MAX < num)
+			return FAIL;
+
+		if (NULL == (counts = (int *)__vc_shmem_malloc_func(NULL, sizeof(int) * (size_t)num)))
+			return FAIL;
+
+		memset(counts, 0, sizeof(int) * (size_t)num);
+
+		if (0 != buckets->num)
+		{
+			memcpy(counts + buckets->offset - offset, buckets->counts, sizeof(int) * (size_t)buckets->num);
+			__vc_shmem_free_func(buckets->counts);
+		}
+
+		buckets->counts = counts;
+		buckets->offset = offset;
+		buckets->num = num;
+	}
+
+	buckets->counts[index - buckets->offset] += count;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets percentile sketch bucket of the value                        *
+ *                                                                            *
+ * Parameters: value - [IN] the value                                         *
+ *             index - [OUT] the bucket index                                 *
+ *                                                                            *
+ * Return value: 1 - positive value bucket                                    *
+ *               0 - zero value                                               *
+ *              -1 - negative value bucket                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_percentiles_bucket(double value, int *index)
+{
+	if (ZBX_VC_PERCENTILE_MIN_VALUE > fabs(value))
+	{
+		*index = 0;
+		return 0;
+	}
+
+	*index = (int)ceil(log(fabs(value)) / vc_percentile_log_gamma());
+
+	return 0 < value ? 1 : -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds or removes value in percentile sketch                        *
+ *                                                                            *
+ * Parameters: percentiles - [IN/OUT] the percentile sketch                   *
+ *             value       - [IN] the value                                   *
+ *             value_type  - [IN] the value type                              *
+ *             count       - [IN] 1 - add value, -1 - remove value            *
+ *                                                                            *
+ * Return value: SUCCEED - the sketch was updated                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_percentiles_update(zbx_vc_percentiles_t *percentiles, const zbx_history_value_t *value,
+		int value_type, int count)
+{
+	int	index;
+
+	switch (vc_percentiles_bucket(ITEM_VALUE_TYPE_UINT64 == value_type ? (double)value->ui64 : value->dbl,
+			&index))
+	{
+		case 1:
+			return vc_buckets_update(&percentiles->positive, index, count);
+		case -1:
+			return vc_buckets_update(&percentiles->negative, index, count);
+		default:
+			percentiles->zero += count;
+			return SUCCEED;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees percentile sketch                                           *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vc_percentiles_free(zbx_vc_percentiles_t *percentiles)
+{
+	size_t	freed = sizeof(int) * (size_t)(percentiles->positive.num + percentiles->negative.num);
+
+	if (NULL != percentiles->positive.counts)
+		__vc_shmem_free_func(percentiles->positive.counts);
+
+	if (NULL != percentiles->negative.counts)
+		__vc_shmem_free_func(percentiles->negative.counts);
+
+	memset(percentiles, 0, sizeof(zbx_vc_percentiles_t));
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: counts values in percentile sketch bucket, excluding the          *
+ *          specified values                                                  *
+ *                                                                            *
+ * Parameters: count    - [IN] the number of values in bucket                 *
+ *             sign     - [IN] the bucket sign (see vc_percentiles_bucket())  *
+ *             index    - [IN] the bucket index                               *
+ *             excluded - [IN] the values to exclude in ascending order       *
+ *             next     - [IN/OUT] the next value to exclude                  *
+ *                                                                            *
+ * Return value: the number of values in bucket                               *
+ *                                                                            *
+ * Comments: The buckets must be visited in ascending value order.            *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_percentiles_bucket_count(int count, int sign, int index, const zbx_vector_dbl_t *excluded,
+		int *next)
+{
+	int	excluded_index;
+
+	while (*next < excluded->values_num &&
+			sign == vc_percentiles_bucket(excluded->values[*next], &excluded_index) &&
+			index == excluded_index)
+	{
+		count--;
+		(*next)++;
+	}
+
+	return count;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: estimates percentile of values counted in percentile sketch       *
+ *                                                                            *
+ * Parameters: percentiles - [IN] the percentile sketch                       *
+ *             excluded    - [IN] the values to exclude in ascending order    *
+ *             percentage  - [IN] the percentage                              *
+ *             result      - [OUT] the estimated percentile                   *
+ *                                                                            *
+ * Return value: SUCCEED - the percentile was estimated                       *
+ *               FAIL    - the sketch has no values                           *
+ *                                                                            *
+ * Comments: The percentile is the value at ceil(count * percentage / 100)    *
+ *           position (first for 0%) in sorted values, as calculated by       *
+ *           percentile() function.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_percentiles_get(const zbx_vc_percentiles_t *percentiles, const zbx_vector_dbl_t *excluded,
+		double percentage, double *result)
+{
+	const zbx_vc_buckets_t	*buckets;
+	int			i, num, rank, next = 0;
+	double			gamma;
+
+	num = percentiles->zero - excluded->values_num;
+
+	for (i = 0; i < percentiles->positive.num; i++)
+		num += percentiles->positive.counts[i];
+
+	for (i = 0; i < percentiles->negative.num; i++)
+		num += percentiles->negative.counts[i];
+
+	if (0 >= num)
+		return FAIL;
+
+	if (0 == (rank = (int)ceil(num * (percentage / 100))))
+		rank = 1;
+
+	gamma = (1 + ZBX_VC_PERCENTILE_ACCURACY) / (1 - ZBX_VC_PERCENTILE_ACCURACY);
+
+	/* negative values in ascending order are in descending bucket order */
+	buckets = &percentiles->negative;
+
+	for (i = buckets->num - 1; 0 <= i; i--)
+	{
+		if (0 >= (rank -= vc_percentiles_bucket_count(buckets->counts[i], -1, buckets->offset + i, excluded,
+				&next)))
+		{
+			*result = -2 * pow(gamma, buckets->offset + i) / (gamma + 1);
+			return SUCCEED;
+		}
+	}
+
+	if (0 >= (rank -= vc_percentiles_bucket_count(percentiles->zero, 0, 0, excluded, &next)))
+	{
+		*result = 0;
+		return SUCCEED;
+	}
+
+	buckets = &percentiles->positive;
+
+	for (i = 0; i < buckets->num; i++)
+	{
+		if (0 >= (rank -= vc_percentiles_bucket_count(buckets->counts[i], 1, buckets->offset + i, excluded,
+				&next)))
+		{
+			*result = 2 * pow(gamma, buckets->offset + i) / (gamma + 1);
+			return SUCCEED;
+		}
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates sum of cached item values with timestamps in the       *
+ *          (start, end] range                                                *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             start    - [IN] the range start timestamp (exclusive)          *
+ *             end      - [IN] the range end timestamp (inclusive)            *
+ *             sum_ui64 - [OUT] the sum of unsigned values                    *
+ *             sum_dbl  - [OUT] the sum of values as floating point numbers   *
+ *                                                                            *
+ * Return value: the number of values in range                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_sum_values(const zbx_vc_item_t *item, const zbx_timespec_t *start, const zbx_timespec_t *end,
+		zbx_uint64_t *sum_ui64, double *sum_dbl)
+{
+	int		index, count = 0;
+	zbx_vc_chunk_t	*chunk;
+
+	*sum_ui64 = 0;
+	*sum_dbl = 0;
+
+	if (FAIL == vch_item_get_last_value(item, end, &chunk, &index))
+		return 0;
+
+	while (0 < zbx_timespec_compare(&vch_chunk_last(chunk)->timestamp, start))
+	{
+		const zbx_history_record_t	*slots = vch_chunk_values(chunk);
+
+		for (; index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, start);
+				index--)
+		{
+			if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
+			{
+				*sum_ui64 += slots[index].value.ui64;
+				*sum_dbl += (double)slots[index].value.ui64;
+			}
+			else
+				*sum_dbl += slots[index].value.dbl;
+
+			count++;
+		}
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+
+	return count;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if all item values in window are cached                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_window_is_cached(const zbx_vc_item_t *item, const zbx_vc_window_t *window)
+{
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		return SUCCEED;
+
+	if (0 != item->db_cached_from && item->db_cached_from <= window->start.sec)
+		return SUCCEED;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: fills window minimum or maximum queue with cached window values   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_fill_window_deque(const zbx_vc_item_t *item, zbx_vc_window_t *window, zbx_vc_deque_t *deque,
+		unsigned char flag)
+{
+	zbx_vector_history_record_t	values;
+	int				i, ret = SUCCEED;
+
+	zbx_history_record_vector_create(&values);
+	vch_item_get_values_by_range(item, &values, &window->start, &window->end);
+
+	for (i = values.values_num - 1; 0 <= i; i--)
+	{
+		if (SUCCEED != (ret = vc_deque_push(deque, &values.values[i], item->value_type, flag)))
+			break;
+	}
+
+	zbx_history_record_vector_destroy(&values, item->value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds or removes cached item values with timestamps in the        *
+ *          (start, end] range in window percentile sketch                    *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             window - [IN/OUT] the window                                   *
+ *             start  - [IN] the range start timestamp (exclusive)            *
+ *             end    - [IN] the range end timestamp (inclusive)              *
+ *             count  - [IN] 1 - add values, -1 - remove values               *
+ *                                                                            *
+ * Return value: SUCCEED - the sketch was updated                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_update_window_percentiles(const zbx_vc_item_t *item, zbx_vc_window_t *window,
+		const zbx_timespec_t *start, const zbx_timespec_t *end, int count)
+{
+	zbx_vector_history_record_t	values;
+	int				i, ret = SUCCEED;
+
+	zbx_history_record_vector_create(&values);
+	vch_item_get_values_by_range(item, &values, start, end);
+
+	for (i = 0; i < values.values_num; i++)
+	{
+		if (SUCCEED != (ret = vc_percentiles_update(&window->percentiles, &values.values[i].value,
+				item->value_type, count)))
+		{
+			break;
+		}
+	}
+
+	zbx_history_record_vector_destroy(&values, item->value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees sliding window                                              *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vc_window_free(zbx_vc_window_t *window)
+{
+	size_t	freed = sizeof(zbx_vc_window_t);
+
+	freed += vc_deque_free(&window->min);
+	freed += vc_deque_free(&window->max);
+	freed += vc_percentiles_free(&window->percentiles);
+	__vc_shmem_free_func(window);
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes sliding window from item                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_window(zbx_vc_item_t *item, zbx_vc_window_t *window)
+{
+	zbx_vc_window_t	**pnext;
+
+	for (pnext = &item->windows; *pnext != window; pnext = &(*pnext)->next)
+		;
+
+	*pnext = window->next;
+	vc_window_free(window);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees item sliding windows                                        *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_windows(zbx_vc_item_t *item)
+{
+	size_t	freed = 0;
+
+	while (NULL != item->windows)
+	{
+		zbx_vc_window_t	*window = item->windows;
+
+		item->windows = window->next;
+		freed += vc_window_free(window);
+	}
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds sliding window to item or updates the tracked aggregates of  *
+ *          existing window                                                   *
+ *                                                                            *
+ * Parameters: item    - [IN/OUT] the item                                    *
+ *             seconds - [IN] the window size in seconds                      *
+ *             flags   - [IN] the requested aggregates (ZBX_VC_AGGREGATE_*)   *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ * Comments: The window is created only if all values in it are cached,       *
+ *           otherwise it will be created by the next request after values    *
+ *           are cached by zbx_vc_get_values().                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_add_window(zbx_vc_item_t *item, int seconds, unsigned char flags, int now)
+{
+	zbx_vc_window_t	*window;
+
+	for (window = item->windows; NULL != window; window = window->next)
+	{
+		if (window->seconds == seconds)
+			break;
+	}
+
+	if (NULL == window)
+	{
+		zbx_vc_window_t	window_local = {.seconds = seconds};
+
+		if (NULL == item->head)
+			return;
+
+		window_local.end = vch_chunk_last(item->head)->timestamp;
+		window_local.start.sec = window_local.end.sec - seconds;
+		window_local.start.ns = window_local.end.ns;
+
+		if (SUCCEED != vch_item_window_is_cached(item, &window_local))
+			return;
+
+		if (NULL == (window = (zbx_vc_window_t *)__vc_shmem_malloc_func(NULL, sizeof(zbx_vc_window_t))))
+			return;
+
+		window_local.count = vch_item_sum_values(item, &window_local.start, &window_local.end,
+				&window_local.sum_ui64, &window_local.sum_dbl);
+
+		*window = window_local;
+		window->next = item->windows;
+		item->windows = window;
+	}
+
+	window->lastaccess = now;
+
+	if (0 != (flags & ZBX_VC_AGGREGATE_MIN) && 0 == (window->flags & ZBX_VC_AGGREGATE_MIN))
+	{
+		if (SUCCEED == vch_item_fill_window_deque(item, window, &window->min, ZBX_VC_AGGREGATE_MIN))
+			window->flags |= ZBX_VC_AGGREGATE_MIN;
+		else
+			vc_deque_free(&window->min);
+	}
+
+	if (0 != (flags & ZBX_VC_AGGREGATE_MAX) && 0 == (window->flags & ZBX_VC_AGGREGATE_MAX))
+	{
+		if (SUCCEED == vch_item_fill_window_deque(item, window, &window->max, ZBX_VC_AGGREGATE_MAX))
+			window->flags |= ZBX_VC_AGGREGATE_MAX;
+		else
+			vc_deque_free(&window->max);
+	}
+
+	if (0 != (flags & ZBX_VC_AGGREGATE_PERCENTILE) && 0 == (window->flags & ZBX_VC_AGGREGATE_PERCENTILE))
+	{
+		if (SUCCEED == vch_item_update_window_percentiles(item, window, &window->start, &window->end, 1))
+			window->flags |= ZBX_VC_AGGREGATE_PERCENTILE;
+		else
+			vc_percentiles_free(&window->percentiles);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds new item value to sliding window and removes the values      *
+ *          falling out of it                                                 *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             window - [IN/OUT] the window                                   *
+ *             value  - [IN] the value added to cache                         *
+ *                                                                            *
+ * Return value: SUCCEED - the window was updated                             *
+ *               FAIL    - the window cannot be updated and must be removed   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_update_window(const zbx_vc_item_t *item, zbx_vc_window_t *window,
+		const zbx_history_record_t *value)
+{
+	zbx_timespec_t	start = {value->timestamp.sec - window->seconds, value->timestamp.ns};
+
+	/* values added before the window end are either inserted in the middle of window */
+	/* or dropped, windows are rebuilt in such cases                                  */
+	if (0 > zbx_timespec_compare(&value->timestamp, &window->end))
+		return FAIL;
+
+	if (0 != (window->flags & ZBX_VC_AGGREGATE_MIN) &&
+			SUCCEED != vc_deque_push(&window->min, value, item->value_type, ZBX_VC_AGGREGATE_MIN))
+	{
+		return FAIL;
+	}
+
+	if (0 != (window->flags & ZBX_VC_AGGREGATE_MAX) &&
+			SUCCEED != vc_deque_push(&window->max, value, item->value_type, ZBX_VC_AGGREGATE_MAX))
+	{
+		return FAIL;
+	}
+
+	if (0 != (window->flags & ZBX_VC_AGGREGATE_PERCENTILE) &&
+			SUCCEED != vc_percentiles_update(&window->percentiles, &value->value, item->value_type, 1))
+	{
+		return FAIL;
+	}
+
+	if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
+	{
+		window->sum_ui64 += value->value.ui64;
+		window->sum_dbl += (double)value->value.ui64;
+	}
+	else
+		window->sum_dbl += value->value.dbl;
+
+	window->count++;
+	window->end = value->timestamp;
+
+	if (0 < zbx_timespec_compare(&start, &window->start))
+	{
+		zbx_uint64_t	sum_ui64;
+		double		sum_dbl;
+		int		removed;
+
+		if (SUCCEED != vch_item_window_is_cached(item, window))
+			return FAIL;
+
+		removed = vch_item_sum_values(item, &window->start, &start, &sum_ui64, &sum_dbl);
+
+		if (0 != (window->flags & ZBX_VC_AGGREGATE_PERCENTILE) &&
+				SUCCEED != vch_item_update_window_percentiles(item, window, &window->start, &start, -1))
+		{
+			return FAIL;
+		}
+
+		window->count -= removed;
+		window->sum_ui64 -= sum_ui64;
+		window->sum_dbl -= sum_dbl;
+		window->removed += removed;
+		window->start = start;
+
+		vc_deque_remove(&window->min, &start);
+		vc_deque_remove(&window->max, &start);
+
+		/* recalculate floating point sum when all values it was calculated from have been replaced */
+		if (window->removed > window->count)
+		{
+			window->count = vch_item_sum_values(item, &window->start, &window->end, &window->sum_ui64,
+					&window->sum_dbl);
+			window->removed = 0;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates item sliding windows with the value added to cache        *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the item                                      *
+ *             value - [IN] the value added to cache                          *
+ *                                                                            *
+ * Comments: Windows that were not requested during the last hour or cannot   *
+ *           be updated are removed.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_update_windows(zbx_vc_item_t *item, const zbx_history_record_t *value)
+{
+	zbx_vc_window_t	*window, *next;
+
+	for (window = item->windows; NULL != window; window = next)
+	{
+		next = window->next;
+
+		if (window->lastaccess + ZBX_VC_WINDOW_EXPIRE_PERIOD < value->timestamp.sec ||
+				SUCCEED != vch_item_update_window(item, window, value))
+		{
+			vch_item_remove_window(item, window);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets item value aggregates over time period from sliding window   *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             window    - [IN] the window                                    *
+ *             ts        - [IN] the period end timestamp                      *
+ *             flags     - [IN] the requested aggregates (ZBX_VC_AGGREGATE_*) *
+ *             aggregate - [OUT] the aggregates                               *
+ *                                                                            *
+ * Return value: SUCCEED - the aggregates were retrieved                      *
+ *               FAIL    - the window does not cover the requested period     *
+ *                                                                            *
+ * Comments: The period may end after the window end as long as there are no *
+ *           newer values. In this case the values between window start and   *
+ *           period start are excluded from the returned aggregates.          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_window_aggregate(const zbx_vc_item_t *item, const zbx_vc_window_t *window,
+		const zbx_timespec_t *ts, unsigned char flags, zbx_vc_aggregate_t *aggregate)
+{
+	zbx_timespec_t			start = {ts->sec - window->seconds, ts->ns};
+	const zbx_history_record_t	*value;
+
+	if (NULL == item->head || 0 != zbx_timespec_compare(&window->end, &vch_chunk_last(item->head)->timestamp))
+		return FAIL;
+
+	if (0 > zbx_timespec_compare(ts, &window->end) || SUCCEED != vch_item_window_is_cached(item, window))
+		return FAIL;
+
+	aggregate->count = window->count;
+	aggregate->sum_ui64 = window->sum_ui64;
+	aggregate->sum_dbl = window->sum_dbl;
+
+	if (0 < zbx_timespec_compare(&start, &window->start))
+	{
+		zbx_uint64_t	sum_ui64;
+		double		sum_dbl;
+
+		aggregate->count -= vch_item_sum_values(item, &window->start, &start, &sum_ui64, &sum_dbl);
+		aggregate->sum_ui64 -= sum_ui64;
+		aggregate->sum_dbl -= sum_dbl;
+	}
+
+	if (0 == aggregate->count)
+	{
+		aggregate->sum_ui64 = 0;
+		aggregate->sum_dbl = 0;
+
+		return SUCCEED;
+	}
+
+	if (0 != (flags & ZBX_VC_AGGREGATE_MIN))
+	{
+		if (NULL == (value = vc_deque_first(&window->min, &start)))
+			return FAIL;
+
+		aggregate->min = value->value;
+	}
+
+	if (0 != (flags & ZBX_VC_AGGREGATE_MAX))
+	{
+		if (NULL == (value = vc_deque_first(&window->max, &start)))
+			return FAIL;
+
+		aggregate->max = value->value;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: estimates item value percentile over time period from sliding     *
+ *          window                                                            *
+ *                                                                            *
+ * Parameters: item       - [IN] the item                                     *
+ *             window     - [IN] the window                                   *
+ *             ts         - [IN] the period end timestamp                     *
+ *             percentage - [IN] the percentage                               *
+ *             result     - [OUT] the estimated percentile                    *
+ *                                                                            *
+ * Return value: SUCCEED - the percentile was estimated                       *
+ *               FAIL    - the window does not cover the requested period or  *
+ *                         there are no values in period                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_window_percentile(const zbx_vc_item_t *item, const zbx_vc_window_t *window,
+		const zbx_timespec_t *ts, double percentage, double *result)
+{
+	zbx_timespec_t			start = {ts->sec - window->seconds, ts->ns};
+	zbx_vector_history_record_t	values;
+	zbx_vector_dbl_t		excluded;
+	int				i, ret;
+
+	if (NULL == item->head || 0 != zbx_timespec_compare(&window->end, &vch_chunk_last(item->head)->timestamp))
+		return FAIL;
+
+	if (0 > zbx_timespec_compare(ts, &window->end) || SUCCEED != vch_item_window_is_cached(item, window))
+		return FAIL;
+
+	zbx_vector_dbl_create(&excluded);
+
+	/* exclude values between window start and period start */
+	if (0 < zbx_timespec_compare(&start, &window->start))
+	{
+		zbx_history_record_vector_create(&values);
+		vch_item_get_values_by_range(item, &values, &window->start, &start);
+
+		for (i = 0; i < values.values_num; i++)
+		{
+			zbx_vector_dbl_append(&excluded, ITEM_VALUE_TYPE_UINT64 == item->value_type ?
+					(double)values.values[i].value.ui64 : values.values[i].value.dbl);
+		}
+
+		zbx_history_record_vector_destroy(&values, item->value_type);
+		zbx_vector_dbl_sort(&excluded, ZBX_DEFAULT_DBL_COMPARE_FUNC);
+	}
+
+	ret = vc_percentiles_get(&window->percentiles, &excluded, percentage, result);
+
+	zbx_vector_dbl_destroy(&excluded);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees resources allocated for item history data                   *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+{
+	size_t	freed = 0;
+
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	freed += vch_item_free_windows(item);
+
+	while (NULL != chunk)
+	{
+		zbx_vc_chunk_t	*next = chunk->next;
+
+		freed += vch_item_free_chunk(item, chunk);
+		chunk = next;
+	}
+	item->values_total = 0;
+	item->head = NULL;
+	item->tail = NULL;
+
+	return freed;
+}
+
+/*
+ * Value cache snapshot file layout:
+ *
+ *   header | item | item | ... | footer
+ *
+ * Each item starts with zbx_vc_snapshot_item_t followed by values_num item values in
+ * ascending order. A value is stored as zbx_timespec_t timestamp followed by the value -
+ * numeric values as is, strings as 32 bit length and the string without terminating zero.
+ * Log values are stored as timestamp, severity and logeventid followed by source
+ * (ZBX_VC_SNAPSHOT_NULL length for NULL source) and value strings.
+ *
+ * The snapshot is written on clean shutdown and the footer is written last, so a partially
+ * written snapshot is never loaded.
+ */
+
+#define ZBX_VC_SNAPSHOT_MAGIC		"ZBXVSNAP"
+#define ZBX_VC_SNAPSHOT_FOOTER_MAGIC	"ZBXVSEND"
+#define ZBX_VC_SNAPSHOT_VERSION		1
+
+#define ZBX_VC_SNAPSHOT_NULL		0xffffffff
+
+/* the maximum length of snapshot string, used to detect corrupted snapshots */
+#define ZBX_VC_SNAPSHOT_STRING_MAX	(16 * ZBX_MEBIBYTE)
+
+typedef struct
+{
+	char		magic[8];
+	zbx_uint32_t	version;
+	zbx_uint32_t	header_size;
+	char		build[64];
+	char		source[128];
+}
+zbx_vc_snapshot_header_t;
+
+typedef struct
+{
+	zbx_uint64_t	items_num;
+	zbx_uint32_t	clock;
+	zbx_uint32_t	reserved;
+	char		magic[8];
+}
+zbx_vc_snapshot_footer_t;
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	hits;
+	int		last_accessed;
+	int		active_range;
+	int		daily_range;
+	int		db_cached_from;
+	int		values_num;
+	unsigned char	value_type;
+	unsigned char	status;
+	unsigned char	range_sync_hour;
+	unsigned char	reserved;
+}
+zbx_vc_snapshot_item_t;
+
+static void	vc_snapshot_header_init(zbx_vc_snapshot_header_t *header, const char *source)
+{
+	memset(header, 0, sizeof(zbx_vc_snapshot_header_t));
+	memcpy(header->magic, ZBX_VC_SNAPSHOT_MAGIC, sizeof(header->magic));
+	header->version = ZBX_VC_SNAPSHOT_VERSION;
+	header->header_size = sizeof(zbx_vc_snapshot_header_t);
+	zbx_strscpy(header->build, ZABBIX_VERSION " (revision " ZABBIX_REVISION ")");
+	zbx_strscpy(header->source, source);
+}
+
+static int	vc_snapshot_write(FILE *file, const void *data, size_t size)
+{
+	if (0 == size)
+		return SUCCEED;
+
+	return 1 == fwrite(data, size, 1, file) ? SUCCEED : FAIL;
+}
+
+static int	vc_snapshot_write_str(FILE *file, const char *str)
+{
+	zbx_uint32_t	len;
+
+	len = (NULL == str ? ZBX_VC_SNAPSHOT_NULL : (zbx_uint32_t)strlen(str));
+
+	if (SUCCEED != vc_snapshot_write(file, &len, sizeof(len)))
+		return FAIL;
+
+	if (NULL == str)
+		return SUCCEED;
+
+	return vc_snapshot_write(file, str, len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes history value to snapshot file                             *
+ *                                                                            *
+ * Parameters: file       - [IN] the snapshot file                            *
+ *             value_type - [IN] the value type                               *
+ *             record     - [IN] the history value                            *
+ *                                                                            *
+ * Return value: SUCCEED - the value was written                              *
+ *               FAIL    - file write error                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_write_value(FILE *file, int value_type, const zbx_history_record_t *record)
+{
+	const zbx_log_value_t	*log;
+
+	if (SUCCEED != vc_snapshot_write(file, &record->timestamp, sizeof(record->timestamp)))
+		return FAIL;
+
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			return vc_snapshot_write(file, &record->value.dbl, sizeof(record->value.dbl));
+		case ITEM_VALUE_TYPE_UINT64:
+			return vc_snapshot_write(file, &record->value.ui64, sizeof(record->value.ui64));
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			return vc_snapshot_write_str(file, record->value.str);
+		case ITEM_VALUE_TYPE_LOG:
+			log = record->value.log;
+
+			if (SUCCEED != vc_snapshot_write(file, &log->timestamp, sizeof(log->timestamp)) ||
+					SUCCEED != vc_snapshot_write(file, &log->severity, sizeof(log->severity)) ||
+					SUCCEED != vc_snapshot_write(file, &log->logeventid, sizeof(log->logeventid)) ||
+					SUCCEED != vc_snapshot_write_str(file, log->source))
+			{
+				return FAIL;
+			}
+
+			return vc_snapshot_write_str(file, log->value);
+	}
+
+	THIS_SHOULD_NEVER_HAPPEN;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes item with its cached values to snapshot file               *
+ *                                                                            *
+ * Parameters: file - [IN] the snapshot file                                  *
+ *             item - [IN] the item                                           *
+ *                                                                            *
+ * Return value: SUCCEED - the item was written                               *
+ *               FAIL    - file write error                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_write_item(FILE *file, const zbx_vc_item_t *item)
+{
+	zbx_vc_snapshot_item_t	rec;
+	const zbx_vc_chunk_t	*chunk;
+	int			i;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.itemid = item->itemid;
+	rec.hits = item->hits;
+	rec.last_accessed = item->last_accessed;
+	rec.active_range = item->active_range;
+	rec.daily_range = item->daily_range;
+	rec.db_cached_from = item->db_cached_from;
+	rec.value_type = item->value_type;
+	rec.status = item->status;
+	rec.range_sync_hour = item->range_sync_hour;
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+		rec.values_num += chunk->last_value - chunk->first_value + 1;
+
+	if (SUCCEED != vc_snapshot_write(file, &rec, sizeof(rec)))
+		return FAIL;
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+	{
+		const zbx_history_record_t	*slots = vch_chunk_values(chunk);
+
+		for (i = chunk->first_value; i <= chunk->last_value; i++)
+		{
+			if (SUCCEED != vc_snapshot_write_value(file, item->value_type, &slots[i]))
+				return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+static int	vc_snapshot_read(FILE *file, void *data, size_t size)
+{
+	if (0 == size)
+		return SUCCEED;
+
+	return 1 == fread(data, size, 1, file) ? SUCCEED : FAIL;
+}
+
+static int	vc_snapshot_read_str(FILE *file, char **str)
+{
+	zbx_uint32_t	len;
+
+	if (SUCCEED != vc_snapshot_read(file, &len, sizeof(len)))
+		return FAIL;
+
+	if (ZBX_VC_SNAPSHOT_NULL == len)
+		return SUCCEED;
+
+	if (ZBX_VC_SNAPSHOT_STRING_MAX < len)
+		return FAIL;
+
+	*str = (char *)zbx_malloc(NULL, (size_t)len + 1);
+	(*str)[len] = '\0';
+
+	return vc_snapshot_read(file, *str, len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads history value from snapshot file                            *
+ *                                                                            *
+ * Parameters: file       - [IN] the snapshot file                            *
+ *             value_type - [IN] the value type                               *
+ *             record     - [OUT] the history value                           *
+ *                                                                            *
+ * Return value: SUCCEED - the value was read                                 *
+ *               FAIL    - file read error or corrupted snapshot              *
+ *                                                                            *
+ * Comments: The value must be freed with zbx_history_record_clear() also     *
+ *           when reading fails.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read_value(FILE *file, int value_type, zbx_history_record_t *record)
+{
+	zbx_log_value_t	*log;
+
+	memset(record, 0, sizeof(zbx_history_record_t));
+
+	if (SUCCEED != vc_snapshot_read(file, &record->timestamp, sizeof(record->timestamp)))
+		return FAIL;
+
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			return vc_snapshot_read(file, &record->value.dbl, sizeof(record->value.dbl));
+		case ITEM_VALUE_TYPE_UINT64:
+			return vc_snapshot_read(file, &record->value.ui64, sizeof(record->value.ui64));
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			if (SUCCEED != vc_snapshot_read_str(file, &record->value.str))
+				return FAIL;
+
+			return NULL != record->value.str ? SUCCEED : FAIL;
+		case ITEM_VALUE_TYPE_LOG:
+			log = record->value.log = (zbx_log_value_t *)zbx_malloc(NULL, sizeof(zbx_log_value_t));
+			memset(log, 0, sizeof(zbx_log_value_t));
+
+			if (SUCCEED != vc_snapshot_read(file, &log->timestamp, sizeof(log->timestamp)) ||
+					SUCCEED != vc_snapshot_read(file, &log->severity, sizeof(log->severity)) ||
+					SUCCEED != vc_snapshot_read(file, &log->logeventid, sizeof(log->logeventid)) ||
+					SUCCEED != vc_snapshot_read_str(file, &log->source) ||
+					SUCCEED != vc_snapshot_read_str(file, &log->value))
+			{
+				return FAIL;
+			}
+
+			return NULL != log->value ? SUCCEED : FAIL;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: restores item from snapshot                                       *
+ *                                                                            *
+ * Parameters: rec    - [IN] the snapshot item                                *
+ *             values - [IN] the item values in ascending order               *
+ *             now    - [IN] the current time                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the item was added to cache                        *
+ *               FAIL    - the item was discarded                             *
+ *                                                                            *
+ * Comments: Items not accessed during the last day are discarded as they     *
+ *           would be dropped from cache anyway. Values older than the item   *
+ *           active range counted from the current time (rather than from the *
+ *           shutdown time) are discarded, as no request will use them.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_restore_item(const zbx_vc_snapshot_item_t *rec, const zbx_vector_history_record_t *values,
+		int now)
+{
+	zbx_vc_item_t	new_item = {.itemid = rec->itemid, .value_type = rec->value_type}, *item;
+	int		first = 0, db_cached_from = rec->db_cached_from;
+	unsigned char	status = rec->status;
+	size_t		size;
+
+	if (0 == rec->last_accessed || now - rec->last_accessed > ZBX_VC_ITEM_EXPIRE_PERIOD)
+		return FAIL;
+
+	if (0 != rec->active_range && 0 != db_cached_from && now - rec->active_range > db_cached_from)
+	{
+		db_cached_from = now - rec->active_range;
+
+		while (first < values->values_num && values->values[first].timestamp.sec < db_cached_from)
+			first++;
+
+		if (0 != first)
+			status = 0;
+	}
+
+	if (first == values->values_num)
+		return FAIL;
+
+	/* leave space for requests after start, the snapshot might come from a larger cache */
+	size = sizeof(zbx_vc_item_t) + (size_t)(values->values_num - first) * sizeof(zbx_history_record_t);
+
+	if (vc_mem->free_size < size + vc_cache->min_free_request)
+		return FAIL;
+
+	if (NULL != zbx_hashset_search(&vc_cache->items, &rec->itemid))
+		return FAIL;
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
+		return FAIL;
+
+	if (SUCCEED != vch_item_add_values_at_tail(item, values->values + first, values->values_num - first))
+	{
+		vc_remove_item(item);
+		return FAIL;
+	}
+
+	item->status = status;
+	item->db_cached_from = db_cached_from;
+	item->active_range = rec->active_range;
+	item->daily_range = rec->daily_range;
+	item->range_sync_hour = rec->range_sync_hour;
+	item->last_accessed = rec->last_accessed;
+	item->hits = rec->hits;
+
+	return SUCCEED;
+}
+
+/******************************************************************************************************************
+ *                                                                                                                *
+ * Public API                                                                                                     *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes value cache                                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_init(char **error)
+{
+	zbx_uint64_t	size_reserved, shard_size;
+	int		i, ret = FAIL;
+
+	if (0 == CONFIG_VALUE_CACHE_SIZE)
+		return SUCCEED;
+
+	/* use less shards with small caches, so each shard has enough memory */
+	for (vc_shards_num = ZBX_VC_SHARDS_MAX; 1 < vc_shards_num; vc_shards_num /= 2)
+	{
+		if (ZBX_VC_SHARD_SIZE_MIN <= CONFIG_VALUE_CACHE_SIZE / (zbx_uint64_t)vc_shards_num)
+			break;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() shards:%d", __func__, vc_shards_num);
+
+	size_reserved = zbx_shmem_required_size(1, "value cache size", "ValueCacheSize");
+	shard_size = CONFIG_VALUE_CACHE_SIZE / (zbx_uint64_t)vc_shards_num;
+
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		if (SUCCEED != zbx_rwlock_create(&vc_shards_lock[i], (zbx_rwlock_name_t)(ZBX_RWLOCK_VALUECACHE + i),
+				error))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != zbx_shmem_create(&vc_shards_mem[i], shard_size, "value cache size", "ValueCacheSize",
+				1, ZBX_SHMEM_FLAG_SLABS, error))
+		{
+			goto out;
+		}
+
+		vc_mem = vc_shards_mem[i];
+
+		if (NULL == (vc_cache = (zbx_vc_cache_t *)__vc_shmem_malloc_func(NULL, sizeof(zbx_vc_cache_t))))
+		{
+			*error = zbx_strdup(*error, "cannot allocate value cache header");
+			goto out;
+		}
+		memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
+
+		zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE / vc_shards_num,
+				ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+				__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
+
+		if (NULL == vc_cache->items.slots)
+		{
+			*error = zbx_strdup(*error, "cannot allocate value cache data storage");
+			goto out;
+		}
+
+		zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE / vc_shards_num,
+				vc_strpool_hash_func, vc_strpool_compare_func, NULL,
+				__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
+
+		if (NULL == vc_cache->strpool.slots)
+		{
+			*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
+			goto out;
+		}
+
+		if (SUCCEED != vc_sketch_init(shard_size - size_reserved))
+		{
+			*error = zbx_strdup(*error, "cannot allocate value cache frequency sketch");
+			goto out;
+		}
+
+		/* the free space request should be 5% of shard size, but no more than 128KB */
+		vc_cache->min_free_request = ((shard_size - size_reserved) / 100) * 5;
+		if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
+			vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
+
+		vc_shards[i] = vc_cache;
+	}
+
+	CONFIG_VALUE_CACHE_SIZE -= size_reserved * (zbx_uint64_t)vc_shards_num;
+
+	vc_select_shard(0);
+
+	zbx_vector_vc_itemupdate_create(&vc_itemupdates);
+	zbx_vector_vc_itemupdate_reserve(&vc_itemupdates, 256);
+
+	ret = SUCCEED;
+out:
+	zbx_vc_disable();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroys value cache                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_destroy(void)
+{
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != vc_cache)
+	{
+		zbx_vector_vc_itemupdate_destroy(&vc_itemupdates);
+
+		for (i = 0; i < vc_shards_num; i++)
+		{
+			vc_select_shard(i);
+
+			zbx_hashset_destroy(&vc_cache->items);
+			zbx_hashset_destroy(&vc_cache->strpool);
+
+			__vc_shmem_free_func(vc_cache->sketch);
+			__vc_shmem_free_func(vc_cache);
+			vc_shards[i] = NULL;
+
+			zbx_shmem_destroy(vc_mem);
+			vc_shards_mem[i] = NULL;
+			zbx_rwlock_destroy(&vc_shards_lock[i]);
+		}
+
+		vc_cache = NULL;
+		vc_mem = NULL;
+		vc_lock = ZBX_RWLOCK_NULL;
+		vc_shards_num = 0;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads value cache snapshot written on previous shutdown           *
+ *                                                                            *
+ * Parameters: filename - [IN] the snapshot file                              *
+ *             source   - [IN] the history database identity                  *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded                            *
+ *               FAIL    - the snapshot does not exist or cannot be used      *
+ *                                                                            *
+ * Comments: Must be called after cache initialization, before starting       *
+ *           processes using it. The snapshot is removed after loading, so a  *
+ *           stale snapshot is not loaded after an unclean shutdown.          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_load_snapshot(const char *filename, const char *source)
+{
+	FILE				*file;
+	zbx_vc_snapshot_header_t	header, header_local;
+	zbx_vc_snapshot_footer_t	footer;
+	zbx_vc_snapshot_item_t		rec;
+	zbx_vector_history_record_t	values;
+	zbx_uint64_t			i;
+	int				j, now, ret = FAIL, items_num = 0;
+	const char			*error = NULL;
+
+	if (NULL == vc_cache)
+		return FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() filename:%s", __func__, filename);
+
+	if (NULL == (file = fopen(filename, "rb")))
+	{
+		if (ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open value cache snapshot \"%s\": %s", filename,
+					zbx_strerror(errno));
+		}
+
+		goto out;
+	}
+
+	vc_snapshot_header_init(&header_local, source);
+	now = (int)time(NULL);
+
+	if (SUCCEED != vc_snapshot_read(file, &header, sizeof(header)) ||
+			0 != memcmp(header.magic, header_local.magic, sizeof(header.magic)) ||
+			0 != fseek(file, -(long)sizeof(footer), SEEK_END) ||
+			SUCCEED != vc_snapshot_read(file, &footer, sizeof(footer)) ||
+			0 != memcmp(footer.magic, ZBX_VC_SNAPSHOT_FOOTER_MAGIC, sizeof(footer.magic)))
+	{
+		error = "snapshot was not closed properly";
+	}
+	else if (0 != memcmp(&header, &header_local, sizeof(header)))
+		error = "snapshot was written by different version or from different database";
+	else if (now - (int)footer.clock > ZBX_VC_ITEM_EXPIRE_PERIOD)
+		error = "snapshot is too old";
+	else if (0 != fseek(file, (long)sizeof(header), SEEK_SET))
+		error = zbx_strerror(errno);
+
+	if (NULL != error)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot use value cache snapshot \"%s\": %s", filename, error);
+		goto close;
+	}
+
+	zbx_vector_history_record_create(&values);
+
+	for (i = 0; i < footer.items_num; i++)
+	{
+		if (SUCCEED != vc_snapshot_read(file, &rec, sizeof(rec)) || ITEM_VALUE_TYPE_MAX <= rec.value_type ||
+				0 > rec.values_num)
+		{
+			break;
+		}
+
+		for (j = 0; j < rec.values_num; j++)
+		{
+			zbx_history_record_t	record;
+
+			if (SUCCEED != vc_snapshot_read_value(file, rec.value_type, &record))
+			{
+				zbx_history_record_clear(&record, rec.value_type);
+				break;
+			}
+
+			zbx_vector_history_record_append_ptr(&values, &record);
+		}
+
+		if (j != rec.values_num)
+		{
+			vc_history_record_vector_clean(&values, rec.value_type);
+			break;
+		}
+
+		WRLOCK_CACHE(vc_get_shard_index(rec.itemid));
+
+		if (SUCCEED == vc_snapshot_restore_item(&rec, &values, now))
+			items_num++;
+
+		UNLOCK_CACHE;
+
+		vc_history_record_vector_clean(&values, rec.value_type);
+	}
+
+	zbx_vector_history_record_destroy(&values);
+
+	if (i != footer.items_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "value cache snapshot \"%s\" is corrupted, loaded " ZBX_FS_UI64
+				" of " ZBX_FS_UI64 " items", filename, i, footer.items_num);
+	}
+	else
+	{
+		zabbix_log(LOG_LEVEL_INFORMATION, "loaded %d of " ZBX_FS_UI64 " items from value cache snapshot,"
+				" server was stopped for %d seconds", items_num, footer.items_num,
+				now - (int)footer.clock);
+		ret = SUCCEED;
+	}
+close:
+	fclose(file);
+
+	if (0 != unlink(filename))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove value cache snapshot \"%s\": %s", filename,
+				zbx_strerror(errno));
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes value cache snapshot on clean shutdown                     *
+ *                                                                            *
+ * Parameters: filename - [IN] the snapshot file                              *
+ *             source   - [IN] the history database identity                  *
+ *                                                                            *
+ * Comments: Must be called after the history cache has been flushed and      *
+ *           before the value cache is destroyed. The items are written in    *
+ *           the order of decreasing hits/values ratio, so the most useful    *
+ *           items are loaded first if the cache was made smaller.            *
+ *           The snapshot is not written if value caching is disabled in the  *
+ *           current process, as the flushed values might not be cached.      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_save_snapshot(const char *filename, const char *source)
+{
+	FILE				*file;
+	char				*filename_tmp;
+	zbx_vc_snapshot_header_t	header;
+	zbx_vc_snapshot_footer_t	footer;
+	zbx_vector_vc_itemweight_t	items;
+	zbx_hashset_iter_t		iter;
+	zbx_vc_item_t			*item;
+	int				i, fd, ret = FAIL;
+
+	if (NULL == vc_cache || ZBX_VC_DISABLED == vc_state)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() filename:%s", __func__, filename);
+
+	/* write to temporary file and rename it, so the old snapshot is never left half written */
+	filename_tmp = zbx_dsprintf(NULL, "%s.tmp", filename);
+
+	if (0 != unlink(filename_tmp) && ENOENT != errno)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove file \"%s\": %s", filename_tmp, zbx_strerror(errno));
+		goto out;
+	}
+
+	/* the snapshot contains history values, it must be readable only by owner */
+	if (-1 == (fd = open(filename_tmp, O_WRONLY | O_CREAT | O_EXCL, 0600)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create value cache snapshot \"%s\": %s", filename_tmp,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (NULL == (file = fdopen(fd, "wb")))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open value cache snapshot \"%s\": %s", filename_tmp,
+				zbx_strerror(errno));
+		close(fd);
+		unlink(filename_tmp);
+		goto out;
+	}
+
+	vc_snapshot_header_init(&header, source);
+
+	memset(&footer, 0, sizeof(footer));
+	memcpy(footer.magic, ZBX_VC_SNAPSHOT_FOOTER_MAGIC, sizeof(footer.magic));
+
+	zbx_vector_vc_itemweight_create(&items);
+
+	/* lock all shards to write items of all shards ordered by weight */
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		RDLOCK_CACHE(i);
+
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_vc_item_weight_t	weight = {.item = item};
+
+			if (NULL == item->head)
+				continue;
+
+			weight.weight = (double)item->hits / item->values_total;
+			zbx_vector_vc_itemweight_append_ptr(&items, &weight);
+		}
+	}
+
+	zbx_vector_vc_itemweight_sort(&items, (zbx_compare_func_t)vc_item_weight_compare_func);
+
+	if (SUCCEED == (ret = vc_snapshot_write(file, &header, sizeof(header))))
+	{
+		for (i = items.values_num - 1; i >= 0; i--)
+		{
+			if (SUCCEED != (ret = vc_snapshot_write_item(file, items.values[i].item)))
+				break;
+
+			footer.items_num++;
+		}
+	}
+
+	for (i = 0; i < vc_shards_num; i++)
+		zbx_rwlock_unlock(vc_shards_lock[i]);
+
+	zbx_vector_vc_itemweight_destroy(&items);
+
+	footer.clock = (zbx_uint32_t)time(NULL);
+
+	if (SUCCEED == ret)
+		ret = vc_snapshot_write(file, &footer, sizeof(footer));
+
+	if (0 != fclose(file))
+		ret = FAIL;
+
+	if (SUCCEED != ret)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write value cache snapshot \"%s\": %s", filename_tmp,
+				zbx_strerror(errno));
+		unlink(filename_tmp);
+	}
+	else if (0 != rename(filename_tmp, filename))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot rename value cache snapshot \"%s\" to \"%s\": %s",
+				filename_tmp, filename, zbx_strerror(errno));
+		unlink(filename_tmp);
+	}
+	else
+	{
+		zabbix_log(LOG_LEVEL_INFORMATION, "value cache snapshot of " ZBX_FS_UI64 " items written to \"%s\"",
+				footer.items_num, filename);
+	}
+out:
+	zbx_free(filename_tmp);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resets value cache                                                *
+ *                                                                            *
+ * Comments: All items and their historical data are removed,                 *
+ *           cache working mode, statistics reset.                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_reset(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
 	if (NULL != vc_cache)
 	{
 		zbx_vc_item_t		*item;
 		zbx_hashset_iter_t	iter;
+		int			i;
 
-		WRLOCK_CACHE;
+		for (i = 0; i < vc_shards_num; i++)
+		{
+			WRLOCK_CACHE(i);
 
-		zbx_hashset_iter_reset(&vc_cache->items, &iter);
-		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+			zbx_hashset_iter_reset(&vc_cache->items, &iter);
+			while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+			{
+				vch_item_free_cache(item);
+				zbx_hashset_iter_remove(&iter);
+			}
+
+			vc_cache->hits = 0;
+			vc_cache->misses = 0;
+			vc_cache->hits_probation = 0;
+			vc_cache->hits_protected = 0;
+			vc_cache->evictions = 0;
+			vc_cache->admissions_rejected = 0;
+			vc_cache->min_free_request = 0;
+
+			if (NULL != vc_cache->sketch)
+			{
+				memset(vc_cache->sketch, 0, (size_t)vc_cache->sketch_width * ZBX_VC_SKETCH_DEPTH);
+				vc_cache->sketch_additions = 0;
+			}
+			vc_cache->mode = ZBX_VC_MODE_NORMAL;
+			vc_cache->mode_time = 0;
+			vc_cache->last_warning_time = 0;
+
+			UNLOCK_CACHE;
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item values to the history and value cache                   *
+ *                                                                            *
+ * Parameters: history - [IN] item history values                             *
+ *                                                                            *
+ * Return value: SUCCEED - the values were added successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
+{
+	zbx_vc_item_t		*item;
+	int			i, j;
+	ZBX_DC_HISTORY		*h;
+
+	if (SUCCEED != zbx_history_add_values(history, ret_flush))
+		return FAIL;
+
+	if (ZBX_VC_DISABLED == vc_state)
+		return SUCCEED;
+
+	for (j = 0; j < vc_shards_num; j++)
+	{
+		int	locked = 0;
+
+		for (i = 0; i < history->values_num; i++)
 		{
-			vch_item_free_cache(item);
-			zbx_hashset_iter_remove(&iter);
+			zbx_history_record_t	record;
+			zbx_vc_chunk_t		*head;
+			int			last_value_timestamp;
+
+			h = (ZBX_DC_HISTORY *)history->values[i];
+
+			if (j != vc_get_shard_index(h->itemid))
+				continue;
+
+			if (0 == locked)
+			{
+				WRLOCK_CACHE(j);
+				locked = 1;
+			}
+
+			if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
+				continue;
+
+			record.timestamp = h->ts;
+			record.value = h->value;
+			head = item->head;
+
+			if (NULL != head)
+				last_value_timestamp = vch_chunk_last(head)->timestamp.sec;
+			else
+				last_value_timestamp = (int)time(NULL);
+
+			/* If the new value type does not match the item's type in cache remove it, */
+			/* so it's cached with the correct type from correct tables when accessed   */
+			/* next time.                                                               */
+			/* Also remove item if the value adding failed. In this case we             */
+			/* won't have the latest data in cache - so the requests must go directly   */
+			/* to the database.                                                         */
+			if (item->value_type != h->value_type || FAIL == vch_item_add_value_at_head(item, &record))
+			{
+				vc_remove_item(item);
+				continue;
+			}
+
+			if (NULL != item->windows)
+				vch_item_update_windows(item, &record);
+
+			/* try to remove old (unused) chunks and encode the previous head chunk if a new chunk */
+			/* was added                                                                             */
+			if (head != item->head)
+			{
+				vch_item_clean_cache(item, last_value_timestamp);
+
+				if (NULL != item->head->prev)
+					vch_item_encode_chunk(item, item->head->prev);
+			}
 		}
 
-		vc_cache->hits = 0;
-		vc_cache->misses = 0;
-		vc_cache->min_free_request = 0;
-		vc_cache->mode = ZBX_VC_MODE_NORMAL;
-		vc_cache->mode_time = 0;
-		vc_cache->last_warning_time = 0;
+		if (0 != locked)
+			UNLOCK_CACHE;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item history data for the specified time period               *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             values     - [OUT] the item history data stored time/value     *
+ *                          pairs in descending order                         *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: If the data is not in cache, it's read from DB, so this function *
+ *           will always return the requested data, unless some error occurs. *
+ *                                                                            *
+ *           If <count> is set then value range is defined as <count> values  *
+ *           before <timestamp>. Otherwise the range is defined as <seconds>  *
+ *           seconds before <timestamp>.                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
+		int seconds, int count, const zbx_timespec_t *ts)
+{
+	zbx_vc_item_t	*item, new_item;
+	int 		ret = FAIL, cache_used = 1;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
+			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
+
+	RDLOCK_CACHE(vc_get_shard_index(itemid));
+
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
+
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		vc_warn_low_memory();
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		if (SUCCEED != vc_admit_item(itemid))
+			goto out;
+
+		memset(&new_item, 0, sizeof(new_item));
+		new_item.itemid = itemid;
+		new_item.value_type = value_type;
+		item = &new_item;
+	}
+	else if (item->value_type != value_type)
+		goto out;
+
+	ret = vch_item_get_values(item, values, seconds, count, ts);
+out:
+	if (FAIL == ret)
+	{
+		cache_used = 0;
+
+		UNLOCK_CACHE;
+		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
+		WRLOCK_CACHE(vc_get_shard_index(itemid));
+
+		if (ZBX_VC_DISABLED != vc_state)
+		{
+			vc_remove_item_by_id(itemid);
+			vc_sketch_add(itemid);
+		}
+
+		if (SUCCEED == ret)
+			vc_update_statistics(NULL, 0, values->values_num, (int)time(NULL));
+	}
+
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
+			__func__, zbx_result_string(ret), values->values_num, cache_used);
+
+	return ret;
+}
+
+static int	vc_history_range_compare(const void *d1, const void *d2)
+{
+	const zbx_history_range_t	*r1 = (const zbx_history_range_t *)d1;
+	const zbx_history_range_t	*r2 = (const zbx_history_range_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r1->itemid, r2->itemid);
+	ZBX_RETURN_IF_NOT_EQUAL(r1->start, r2->start);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: caches item values for multiple time based requests at once       *
+ *                                                                            *
+ * Parameters: requests - [IN] the item requests                              *
+ *                                                                            *
+ * Comments: This function is used before a batch of zbx_vc_get_values()      *
+ *           calls with the same parameters. Instead of reading the periods    *
+ *           not cached yet item by item, they are read from history storage  *
+ *           with few multiple item queries and added to cache.               *
+ *           New items are not added in low memory mode. Failures are ignored *
+ *           as the values are read again by zbx_vc_get_values().             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_prefetch_values(const zbx_vector_vc_request_t *requests)
+{
+	zbx_vector_history_range_t	ranges[ITEM_VALUE_TYPE_MAX];
+	zbx_history_range_t		*range;
+	zbx_vc_item_t			*item;
+	int				i, j, k, shard, range_start, range_end, values_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() requests_num:%d", __func__, requests->values_num);
+
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
+
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+		zbx_vector_history_range_create(&ranges[i]);
+
+	/* find the periods not cached yet, same as vch_item_cache_values_by_time() would */
+	for (shard = 0; shard < vc_shards_num; shard++)
+	{
+		RDLOCK_CACHE(shard);
+
+		for (i = 0; i < requests->values_num; i++)
+		{
+			const zbx_vc_request_t	*request = &requests->values[i];
+			zbx_history_range_t	range_local = {0};
+
+			if (ITEM_VALUE_TYPE_MAX <= request->value_type || shard != vc_get_shard_index(request->itemid))
+				continue;
+
+			if (0 > (range_start = request->ts.sec - request->seconds))
+				range_start = 0;
+
+			if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &request->itemid)))
+			{
+				if (SUCCEED != vc_admit_item(request->itemid))
+					continue;
+
+				range_end = ZBX_JAN_2038;
+			}
+			else
+			{
+				if (item->value_type != request->value_type ||
+						ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+				{
+					continue;
+				}
+
+				if (0 != item->db_cached_from && range_start >= item->db_cached_from)
+					continue;
+
+				if (NULL != item->tail)
+					range_end = vch_chunk_first(item->tail)->timestamp.sec - 1;
+				else
+					range_end = ZBX_JAN_2038;
+			}
+
+			if (range_start >= range_end)
+				continue;
+
+			range_local.itemid = request->itemid;
+			range_local.start = range_start;
+			range_local.end = range_end;
+			zbx_vector_history_range_append(&ranges[request->value_type], range_local);
+		}
+
+		UNLOCK_CACHE;
+	}
+
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+	{
+		if (0 == ranges[i].values_num)
+			continue;
+
+		/* keep the longest period of each item */
+		zbx_vector_history_range_sort(&ranges[i], vc_history_range_compare);
+
+		for (j = 0, k = 1; k < ranges[i].values_num; k++)
+		{
+			if (ranges[i].values[k].itemid != ranges[i].values[j].itemid)
+				ranges[i].values[++j] = ranges[i].values[k];
+		}
+
+		ranges[i].values_num = j + 1;
+
+		/* decrement interval start point because interval starting point is excluded by history backend, */
+		/* same as vc_db_read_values_by_time() does                                                      */
+		for (j = 0; j < ranges[i].values_num; j++)
+		{
+			if (0 != ranges[i].values[j].start)
+				ranges[i].values[j].start--;
+
+			zbx_history_record_vector_create(&ranges[i].values[j].values);
+		}
+
+		if (SUCCEED != zbx_history_get_values_multi(i, ranges[i].values, ranges[i].values_num))
+		{
+			for (j = 0; j < ranges[i].values_num; j++)
+				zbx_history_record_vector_destroy(&ranges[i].values[j].values, i);
+
+			ranges[i].values_num = 0;
+			continue;
+		}
+
+		for (j = 0; j < ranges[i].values_num; j++)
+		{
+			zbx_vector_history_record_sort(&ranges[i].values[j].values,
+					(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+		}
+	}
+
+	for (shard = 0; shard < vc_shards_num; shard++)
+	{
+		int	shard_values_num = 0;
+
+		WRLOCK_CACHE(shard);
+
+		for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+		{
+			for (j = 0; j < ranges[i].values_num; j++)
+			{
+				range = &ranges[i].values[j];
+
+				if (shard != vc_get_shard_index(range->itemid))
+					continue;
+
+				if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items,
+						&range->itemid)))
+				{
+					zbx_vc_item_t	new_item = {.itemid = range->itemid,
+							.value_type = (unsigned char)i};
+
+					if (SUCCEED != vc_admit_item(range->itemid))
+						continue;
+
+					if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items,
+							&new_item, sizeof(new_item))))
+					{
+						continue;
+					}
+				}
+				else if (item->value_type != i || ZBX_ITEM_STATUS_CACHED_ALL == item->status ||
+						(0 != item->db_cached_from && range->start + 1 >= item->db_cached_from))
+				{
+					/* item type changed or values were cached by another process meanwhile */
+					continue;
+				}
+
+				item->status = 0;
+
+				if (0 < range->values.values_num && SUCCEED != vch_item_add_values_at_tail(item,
+						range->values.values, range->values.values_num))
+				{
+					vc_remove_item(item);
+					continue;
+				}
+
+				vc_item_update_db_cached_from(item, 0 != range->start ? range->start + 1 : 0);
+				shard_values_num += range->values.values_num;
+			}
+		}
+
+		/* the prefetched values were read from database, account them as cache misses */
+		if (0 != shard_values_num)
+			vc_update_statistics(NULL, 0, shard_values_num, (int)time(NULL));
 
 		UNLOCK_CACHE;
+
+		values_num += shard_values_num;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+	{
+		for (j = 0; j < ranges[i].values_num; j++)
+			zbx_history_record_vector_destroy(&ranges[i].values[j].values, i);
+
+		zbx_vector_history_range_destroy(&ranges[i]);
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() values_num:%d", __func__, values_num);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item values to the history and value cache                   *
+ * Purpose: get the last history value with a timestamp less or equal to the  *
+ *          target timestamp                                                  *
  *                                                                            *
- * Parameters: history - [IN] item history values                             *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             ts         - [IN] the target timestamp                         *
+ *             value      - [OUT] the value found                             *
  *                                                                            *
- * Return value: SUCCEED - the values were added successfully                 *
+ * Return Value: SUCCEED - the item was retrieved                             *
  *               FAIL    - otherwise                                          *
  *                                                                            *
+ * Comments: Depending on the value type this function might allocate memory  *
+ *           to store value data. To free it use zbx_vc_history_value_clear() *
+ *           function.                                                        *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
+int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
+		zbx_history_record_t *value)
 {
-	zbx_vc_item_t		*item;
-	int			i;
-	ZBX_DC_HISTORY		*h;
-
-	if (SUCCEED != zbx_history_add_values(history, ret_flush))
-		return FAIL;
-
-	if (ZBX_VC_DISABLED == vc_state)
-		return SUCCEED;
-
-	WRLOCK_CACHE;
-
-	for (i = 0; i < history->values_num; i++)
-	{
-		h = (ZBX_DC_HISTORY *)history->values[i];
+	zbx_vector_history_record_t	values;
+	int				ret = FAIL;
 
-		if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
-		{
-			zbx_history_record_t	record = {h->ts, h->value};
-			zbx_vc_chunk_t		*head = item->head;
-			int			last_value_timestamp;
+	zbx_history_record_vector_create(&values);
 
-			if (NULL != head)
-				last_value_timestamp = head->slots[head->last_value].timestamp.sec;
-			else
-				last_value_timestamp = (int)time(NULL);
+	if (SUCCEED != zbx_vc_get_values(itemid, value_type, &values, ts->sec, 1, ts) || 0 == values.values_num)
+		goto out;
 
-			/* If the new value type does not match the item's type in cache remove it, */
-			/* so it's cached with the correct type from correct tables when accessed   */
-			/* next time.                                                               */
-			/* Also remove item if the value adding failed. In this case we             */
-			/* won't have the latest data in cache - so the requests must go directly   */
-			/* to the database.                                                         */
-			if (item->value_type != h->value_type || FAIL == vch_item_add_value_at_head(item, &record))
-			{
-				vc_remove_item(item);
-				continue;
-			}
+	*value = values.values[0];
 
-			/* try to remove old (unused) chunks if a new chunk was added */
-			if (head != item->head)
-				vch_item_clean_cache(item, last_value_timestamp);
-		}
-	}
+	/* reset values vector size so the returned value is not cleared when destroying the vector */
+	values.values_num = 0;
 
-	UNLOCK_CACHE;
+	ret = SUCCEED;
+out:
+	zbx_history_record_vector_destroy(&values, value_type);
 
-	return SUCCEED;
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item history data for the specified time period               *
+ * Purpose: get item value aggregates over the specified time period          *
  *                                                                            *
  * Parameters: itemid     - [IN] the item id                                  *
  *             value_type - [IN] the item value type                          *
- *             values     - [OUT] the item history data stored time/value     *
- *                          pairs in descending order                         *
- *             seconds    - [IN] the time period to retrieve data for         *
- *             count      - [IN] the number of history values to retrieve     *
+ *             seconds    - [IN] the time period                              *
  *             ts         - [IN] the period end timestamp                     *
+ *             flags      - [IN] the requested aggregates besides sum and     *
+ *                               count (ZBX_VC_AGGREGATE_*)                   *
+ *             aggregate  - [OUT] the aggregates                              *
  *                                                                            *
- * Return value:  SUCCEED - the item history data was retrieved successfully  *
- *                FAIL    - the item history data was not retrieved           *
- *                                                                            *
- * Comments: If the data is not in cache, it's read from DB, so this function *
- *           will always return the requested data, unless some error occurs. *
+ * Return value:  SUCCEED - the aggregates were retrieved successfully        *
+ *                FAIL    - the aggregates are not available, the values must *
+ *                          be retrieved with zbx_vc_get_values()             *
  *                                                                            *
- *           If <count> is set then value range is defined as <count> values  *
- *           before <timestamp>. Otherwise the range is defined as <seconds>  *
- *           seconds before <timestamp>.                                      *
+ * Comments: The aggregates are maintained in sliding windows, updated when   *
+ *           values are added to cache. Windows are created for the requested *
+ *           periods when locally cached statistics are flushed, so the first *
+ *           request for period always fails.                                 *
+ *           Only float and unsigned items without time shift (period ending  *
+ *           at or after the last item value) are supported.                  *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, unsigned char value_type, int seconds, const zbx_timespec_t *ts,
+		unsigned char flags, zbx_vc_aggregate_t *aggregate)
 {
-	zbx_vc_item_t	*item, new_item;
-	int 		ret = FAIL, cache_used = 1;
+	zbx_vc_item_t	*item;
+	zbx_vc_window_t	*window;
+	int		ret = FAIL, now;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
-			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
+	if (ITEM_VALUE_TYPE_FLOAT != value_type && ITEM_VALUE_TYPE_UINT64 != value_type)
+		return FAIL;
+
+	if (0 >= seconds)
+		return FAIL;
 
-	RDLOCK_CACHE;
+	RDLOCK_CACHE(vc_get_shard_index(itemid));
 
 	if (ZBX_VC_DISABLED == vc_state)
 		goto out;
 
-	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
-		vc_warn_low_memory();
-
-	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)) ||
+			item->value_type != value_type)
 	{
-		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
-			goto out;
-
-		memset(&new_item, 0, sizeof(new_item));
-		new_item.itemid = itemid;
-		new_item.value_type = value_type;
-		item = &new_item;
-	}
-	else if (item->value_type != value_type)
 		goto out;
+	}
 
-	ret = vch_item_get_values(item, values, seconds, count, ts);
-out:
-	if (FAIL == ret)
-	{
-		cache_used = 0;
+	vc_cache_item_update(itemid, ZBX_VC_UPDATE_WINDOW, seconds, flags);
 
-		UNLOCK_CACHE;
-		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
-		WRLOCK_CACHE;
+	for (window = item->windows; NULL != window; window = window->next)
+	{
+		if (window->seconds == seconds)
+			break;
+	}
 
-		if (ZBX_VC_DISABLED != vc_state)
-			vc_remove_item_by_id(itemid);
+	if (NULL == window || flags != (window->flags & flags))
+		goto out;
 
-		if (SUCCEED == ret)
-			vc_update_statistics(NULL, 0, values->values_num, (int)time(NULL));
-	}
+	if (SUCCEED != (ret = vch_item_get_window_aggregate(item, window, ts, flags, aggregate)))
+		goto out;
 
+	/* keep the window values in cache */
+	now = (int)time(NULL);
+	vc_cache_item_update(itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
+	vc_cache_item_update(itemid, ZBX_VC_UPDATE_STATS, aggregate->count, 0);
+out:
 	UNLOCK_CACHE;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
-			__func__, zbx_result_string(ret), values->values_num, cache_used);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() itemid:" ZBX_FS_UI64 " period:%d end_timestamp '%s' flags:0x%x:%s",
+			__func__, itemid, seconds, zbx_timespec_str(ts), flags, zbx_result_string(ret));
 
 	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get the last history value with a timestamp less or equal to the  *
- *          target timestamp                                                  *
+ * Purpose: estimates item value percentile over the specified time period    *
  *                                                                            *
  * Parameters: itemid     - [IN] the item id                                  *
  *             value_type - [IN] the item value type                          *
- *             ts         - [IN] the target timestamp                         *
- *             value      - [OUT] the value found                             *
+ *             seconds    - [IN] the time period                              *
+ *             ts         - [IN] the period end timestamp                     *
+ *             percentage - [IN] the percentage                               *
+ *             value      - [OUT] the estimated percentile                    *
  *                                                                            *
- * Return Value: SUCCEED - the item was retrieved                             *
- *               FAIL    - otherwise                                          *
+ * Return value:  SUCCEED - the percentile was estimated successfully         *
+ *                FAIL    - the percentile is not available, the values must  *
+ *                          be retrieved with zbx_vc_get_values()             *
  *                                                                            *
- * Comments: Depending on the value type this function might allocate memory  *
- *           to store value data. To free it use zbx_vc_history_value_clear() *
- *           function.                                                        *
+ * Comments: The percentile is estimated from sketch maintained in sliding    *
+ *           window with relative error not exceeding 1%. As with             *
+ *           zbx_vc_get_aggregate() the window is created when locally cached *
+ *           statistics are flushed, so the first request for period always   *
+ *           fails.                                                           *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
-		zbx_history_record_t *value)
+int	zbx_vc_get_percentile(zbx_uint64_t itemid, unsigned char value_type, int seconds, const zbx_timespec_t *ts,
+		double percentage, zbx_history_value_t *value)
 {
-	zbx_vector_history_record_t	values;
-	int				ret = FAIL;
+	zbx_vc_item_t	*item;
+	zbx_vc_window_t	*window;
+	int		ret = FAIL, now;
+	double		result;
 
-	zbx_history_record_vector_create(&values);
+	if (ITEM_VALUE_TYPE_FLOAT != value_type && ITEM_VALUE_TYPE_UINT64 != value_type)
+		return FAIL;
 
-	if (SUCCEED != zbx_vc_get_values(itemid, value_type, &values, ts->sec, 1, ts) || 0 == values.values_num)
+	if (0 >= seconds)
+		return FAIL;
+
+	RDLOCK_CACHE(vc_get_shard_index(itemid));
+
+	if (ZBX_VC_DISABLED == vc_state)
 		goto out;
 
-	*value = values.values[0];
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)) ||
+			item->value_type != value_type)
+	{
+		goto out;
+	}
 
-	/* reset values vector size so the returned value is not cleared when destroying the vector */
-	values.values_num = 0;
+	vc_cache_item_update(itemid, ZBX_VC_UPDATE_WINDOW, seconds, ZBX_VC_AGGREGATE_PERCENTILE);
 
-	ret = SUCCEED;
+	for (window = item->windows; NULL != window; window = window->next)
+	{
+		if (window->seconds == seconds)
+			break;
+	}
+
+	if (NULL == window || 0 == (window->flags & ZBX_VC_AGGREGATE_PERCENTILE))
+		goto out;
+
+	if (SUCCEED != (ret = vch_item_get_window_percentile(item, window, ts, percentage, &result)))
+		goto out;
+
+	if (ITEM_VALUE_TYPE_UINT64 == value_type)
+		value->ui64 = (zbx_uint64_t)(result + 0.5);
+	else
+		value->dbl = result;
+
+	/* keep the window values in cache */
+	now = (int)time(NULL);
+	vc_cache_item_update(itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
+	vc_cache_item_update(itemid, ZBX_VC_UPDATE_STATS, window->count, 0);
 out:
-	zbx_history_record_vector_destroy(&values, value_type);
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() itemid:" ZBX_FS_UI64 " period:%d end_timestamp '%s' percentage:" ZBX_FS_DBL
+			":%s", __func__, itemid, seconds, zbx_timespec_str(ts), percentage, zbx_result_string(ret));
 
 	return ret;
 }
@@ -2693,19 +5596,30 @@ out:
  ******************************************************************************/
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats)
 {
+	int	i;
+
 	if (ZBX_VC_DISABLED == vc_state)
 		return FAIL;
 
-	RDLOCK_CACHE;
+	memset(stats, 0, sizeof(zbx_vc_stats_t));
+	stats->mode = ZBX_VC_MODE_NORMAL;
 
-	stats->hits = vc_cache->hits;
-	stats->misses = vc_cache->misses;
-	stats->mode = vc_cache->mode;
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		RDLOCK_CACHE(i);
 
-	stats->total_size = vc_mem->total_size;
-	stats->free_size = vc_mem->free_size;
+		stats->hits += vc_cache->hits;
+		stats->misses += vc_cache->misses;
 
-	UNLOCK_CACHE;
+		/* report low memory mode if any of shards is running out of memory */
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+			stats->mode = vc_cache->mode;
+
+		stats->total_size += vc_mem->total_size;
+		stats->free_size += vc_mem->free_size;
+
+		UNLOCK_CACHE;
+	}
 
 	return SUCCEED;
 }
@@ -2740,6 +5654,7 @@ void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, in
 {
 	zbx_hashset_iter_t	iter;
 	zbx_vc_item_t		*item;
+	int			i;
 
 	*values_num = 0;
 
@@ -2750,16 +5665,63 @@ void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, in
 		return;
 	}
 
-	RDLOCK_CACHE;
+	*items_num = 0;
+	*mode = ZBX_VC_MODE_NORMAL;
 
-	*items_num = (zbx_uint64_t)vc_cache->items.num_data;
-	*mode = vc_cache->mode;
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		RDLOCK_CACHE(i);
 
-	zbx_hashset_iter_reset(&vc_cache->items, &iter);
-	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
-		*values_num += (zbx_uint64_t)item->values_total;
+		*items_num += (zbx_uint64_t)vc_cache->items.num_data;
 
-	UNLOCK_CACHE;
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+			*mode = vc_cache->mode;
+
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+			*values_num += (zbx_uint64_t)item->values_total;
+
+		UNLOCK_CACHE;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get value cache admission/eviction policy statistics              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_get_policy_stats(zbx_vc_policy_stats_t *stats)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vc_item_t		*item;
+	int			i;
+
+	memset(stats, 0, sizeof(zbx_vc_policy_stats_t));
+
+	if (ZBX_VC_DISABLED == vc_state)
+		return;
+
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		RDLOCK_CACHE(i);
+
+		stats->hits_probation += vc_cache->hits_probation;
+		stats->hits_protected += vc_cache->hits_protected;
+		stats->misses += vc_cache->misses;
+		stats->evictions += vc_cache->evictions;
+		stats->admissions_rejected += vc_cache->admissions_rejected;
+
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (ZBX_VC_SEGMENT_PROTECTED == item->segment)
+				stats->items_protected++;
+			else
+				stats->items_probation++;
+		}
+
+		UNLOCK_CACHE;
+	}
 }
 
 /******************************************************************************
@@ -2769,15 +5731,24 @@ void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, in
  ******************************************************************************/
 void	zbx_vc_get_mem_stats(zbx_shmem_stats_t *mem)
 {
+	zbx_shmem_stats_t	stats;
+	int			i;
+
 	if (ZBX_VC_DISABLED == vc_state)
 	{
 		memset(mem, 0, sizeof(zbx_shmem_stats_t));
 		return;
 	}
 
-	RDLOCK_CACHE;
-	zbx_shmem_get_stats(vc_mem, mem);
-	UNLOCK_CACHE;
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		RDLOCK_CACHE(i);
+		zbx_shmem_get_stats(vc_mem, 0 == i ? mem : &stats);
+		UNLOCK_CACHE;
+
+		if (0 != i)
+			zbx_shmem_add_stats(mem, &stats);
+	}
 }
 
 /******************************************************************************
@@ -2790,25 +5761,29 @@ void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats)
 	zbx_hashset_iter_t	iter;
 	zbx_vc_item_t		*item;
 	zbx_vc_item_stats_t	*item_stats;
+	int			i;
 
 	if (ZBX_VC_DISABLED == vc_state)
 		return;
 
-	RDLOCK_CACHE;
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		RDLOCK_CACHE(i);
 
-	zbx_vector_ptr_reserve(stats, (size_t)vc_cache->items.num_data);
+		zbx_vector_ptr_reserve(stats, (size_t)(stats->values_num + vc_cache->items.num_data));
 
-	zbx_hashset_iter_reset(&vc_cache->items, &iter);
-	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		item_stats = (zbx_vc_item_stats_t *)zbx_malloc(NULL, sizeof(zbx_vc_item_stats_t));
-		item_stats->itemid = item->itemid;
-		item_stats->values_num = item->values_total;
-		item_stats->hourly_num = item->last_hourly_num;
-		zbx_vector_ptr_append(stats, item_stats);
-	}
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			item_stats = (zbx_vc_item_stats_t *)zbx_malloc(NULL, sizeof(zbx_vc_item_stats_t));
+			item_stats->itemid = item->itemid;
+			item_stats->values_num = item->values_total;
+			item_stats->hourly_num = item->last_hourly_num;
+			zbx_vector_ptr_append(stats, item_stats);
+		}
 
-	UNLOCK_CACHE;
+		UNLOCK_CACHE;
+	}
 }
 
 /******************************************************************************
@@ -2818,7 +5793,7 @@ void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats)
  ******************************************************************************/
 void	zbx_vc_flush_stats(void)
 {
-	int		i, now;
+	int		i, j, now;
 	zbx_vc_item_t	*item = NULL;
 	zbx_uint64_t	itemid = 0;
 
@@ -2829,35 +5804,48 @@ void	zbx_vc_flush_stats(void)
 
 	now = (int)time(NULL);
 
-	WRLOCK_CACHE;
-
-	for (i = 0; i < vc_itemupdates.values_num; i++)
+	for (j = 0; j < vc_shards_num; j++)
 	{
-		zbx_vc_item_update_t	*update = &vc_itemupdates.values[i];
+		WRLOCK_CACHE(j);
 
-		if (itemid != update->itemid)
+		for (i = 0; i < vc_itemupdates.values_num; i++)
 		{
-			itemid = update->itemid;
-			item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid);
-		}
+			zbx_vc_item_update_t	*update = &vc_itemupdates.values[i];
 
-		if (NULL == item)
-			continue;
+			if (j != vc_get_shard_index(update->itemid))
+				continue;
 
-		switch (update->type)
-		{
-			case ZBX_VC_UPDATE_RANGE:
-				vch_item_update_range(item, update->data[ZBX_VC_UPDATE_RANGE_SECONDS],
-						update->data[ZBX_VC_UPDATE_RANGE_NOW]);
-				break;
-			case ZBX_VC_UPDATE_STATS:
-				vc_update_statistics(item, update->data[ZBX_VC_UPDATE_STATS_HITS],
-						update->data[ZBX_VC_UPDATE_STATS_MISSES], now);
-				break;
+			if (itemid != update->itemid)
+			{
+				itemid = update->itemid;
+				item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid);
+			}
+
+			if (ZBX_VC_UPDATE_STATS == update->type)
+				vc_sketch_add(update->itemid);
+
+			if (NULL == item)
+				continue;
+
+			switch (update->type)
+			{
+				case ZBX_VC_UPDATE_RANGE:
+					vch_item_update_range(item, update->data[ZBX_VC_UPDATE_RANGE_SECONDS],
+							update->data[ZBX_VC_UPDATE_RANGE_NOW]);
+					break;
+				case ZBX_VC_UPDATE_STATS:
+					vc_update_statistics(item, update->data[ZBX_VC_UPDATE_STATS_HITS],
+							update->data[ZBX_VC_UPDATE_STATS_MISSES], now);
+					break;
+				case ZBX_VC_UPDATE_WINDOW:
+					vch_item_add_window(item, update->data[ZBX_VC_UPDATE_WINDOW_SECONDS],
+							(unsigned char)update->data[ZBX_VC_UPDATE_WINDOW_FLAGS], now);
+					break;
+			}
 		}
-	}
 
-	UNLOCK_CACHE;
+		UNLOCK_CACHE;
+	}
 
 	zbx_vector_vc_itemupdate_clear(&vc_itemupdates);
 }
@@ -141,6 +141,16 @@ static sqlite3			*conn = NULL;
 static zbx_mutex_t		sqlite_access = ZBX_MUTEX_NULL;
 #endif
 
+#if defined(HAVE_POSTGRESQL) && defined(LIBPQ_HAS_PIPELINING)
+#	define ZBX_PG_PIPELINE
+/* the maximum number of statements sent without waiting for their results */
+#	define ZBX_PG_PIPELINE_MAX	64
+
+static int	pipeline_enabled = 0;	/* non-select statements of transaction are pipelined */
+static char	*pipeline_queries[ZBX_PG_PIPELINE_MAX];	/* statements waiting for results */
+static int	pipeline_queries_num = 0;
+#endif
+
 #if defined(HAVE_ORACLE)
 static void	OCI_DBclean_result_handle(DB_RESULT result);
 static void	OCI_DBclean_result(DB_RESULT result);
@@ -389,6 +399,123 @@ static int	is_recoverable_postgresql_error(const PGconn *pg_conn, const PGresult
 }
 #endif
 
+#if defined(ZBX_PG_PIPELINE)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for results of the pipelined statements and leave pipeline   *
+ *          mode                                                              *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - all pipelined statements succeeded               *
+ *               ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *                                                                            *
+ * Comments: The failed statement aborts the rest of pipeline, so the         *
+ *           transaction is marked as failed.                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_pipeline_sync(void)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		i, ret = ZBX_DB_OK;
+
+	if (0 == pipeline_queries_num && PQ_PIPELINE_OFF == PQpipelineStatus(conn))
+		return ZBX_DB_OK;
+
+	if (1 != PQpipelineSync(conn))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), "pipeline sync");
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+		goto out;
+	}
+
+	for (i = 0; i < pipeline_queries_num; i++)
+	{
+		while (NULL != (result = PQgetResult(conn)))
+		{
+			if (PGRES_FATAL_ERROR == PQresultStatus(result) && ZBX_DB_OK == ret)
+			{
+				zbx_err_codes_t	errcode;
+
+				zbx_postgresql_error(&error, result);
+
+				if (0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), "23505"))
+					errcode = ERR_Z3008;
+				else
+					errcode = ERR_Z3005;
+
+				zbx_db_errlog(errcode, 0, error, pipeline_queries[i]);
+				zbx_free(error);
+
+				ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+			}
+
+			PQclear(result);
+		}
+	}
+
+	/* consume the pipeline synchronization point result */
+	if (NULL != (result = PQgetResult(conn)))
+		PQclear(result);
+out:
+	/* connection left in pipeline mode cannot execute other statements, force reconnect */
+	if (PQ_PIPELINE_OFF != PQpipelineStatus(conn) && 1 != PQexitPipelineMode(conn))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), "pipeline exit");
+		ret = ZBX_DB_DOWN;
+	}
+
+	for (i = 0; i < pipeline_queries_num; i++)
+		zbx_free(pipeline_queries[i]);
+
+	pipeline_queries_num = 0;
+
+	if (ZBX_DB_OK != ret && 0 < txn_level)
+		txn_error = ret;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send statement in pipeline mode without waiting for its result    *
+ *                                                                            *
+ * Parameters: sql - [IN] the statement                                       *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the statement was sent                           *
+ *               ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_pipeline_send(const char *sql)
+{
+	int	ret;
+
+	if (ZBX_PG_PIPELINE_MAX == pipeline_queries_num && ZBX_DB_OK != (ret = db_pipeline_sync()))
+		return ret;
+
+	if (PQ_PIPELINE_OFF == PQpipelineStatus(conn) && 1 != PQenterPipelineMode(conn))
+		goto error;
+
+	if (1 != PQsendQueryParams(conn, sql, 0, NULL, NULL, NULL, NULL, 0))
+		goto error;
+
+	pipeline_queries[pipeline_queries_num++] = zbx_strdup(NULL, sql);
+
+	/* send the statement right away, so database executes it while the next one is being prepared */
+	if (0 != PQflush(conn))
+		goto error;
+
+	return ZBX_DB_OK;
+error:
+	zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), sql);
+	ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+
+	if (ZBX_DB_FAIL == ret)
+		txn_error = ZBX_DB_FAIL;
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: specify the autoincrement options during db connect               *
@@ -1045,6 +1172,10 @@ void	zbx_db_close_basic(void)
 		PQfinish(conn);
 		conn = NULL;
 	}
+#	if defined(ZBX_PG_PIPELINE)
+	while (0 < pipeline_queries_num)
+		zbx_free(pipeline_queries[--pipeline_queries_num]);
+#	endif
 #elif defined(HAVE_SQLITE3)
 	if (NULL != conn)
 	{
@@ -1107,6 +1238,10 @@ int	zbx_db_commit_basic(void)
 		assert(0);
 	}
 
+#if defined(ZBX_PG_PIPELINE)
+	pipeline_enabled = 0;
+	db_pipeline_sync();
+#endif
 	if (ZBX_DB_OK != txn_error)
 		return ZBX_DB_FAIL; /* commit called on failed transaction */
 
@@ -1153,6 +1288,10 @@ int	zbx_db_rollback_basic(void)
 		assert(0);
 	}
 
+#if defined(ZBX_PG_PIPELINE)
+	pipeline_enabled = 0;
+	db_pipeline_sync();
+#endif
 	last_txn_error = txn_error;
 
 	/* allow rollback of failed transaction */
@@ -1195,6 +1334,27 @@ int	zbx_db_txn_end_error(void)
 	return txn_end_error;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start sending non-select statements of the current transaction    *
+ *          without waiting for their results                                 *
+ *                                                                            *
+ * Comments: The results are checked before the next select statement and     *
+ *           when transaction ends, so the pipelined statements must consist  *
+ *           of single SQL command and their callers must not depend on the   *
+ *           number of affected rows.                                         *
+ *           Pipelining ends with transaction. Does nothing if database       *
+ *           client library does not support pipelining.                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_pipeline_begin_basic(void)
+{
+#if defined(ZBX_PG_PIPELINE)
+	if (0 < txn_level)
+		pipeline_enabled = 1;
+#endif
+}
+
 #ifdef HAVE_ORACLE
 static sword	zbx_oracle_statement_prepare(const char *sql)
 {
@@ -1554,6 +1714,13 @@ int	zbx_db_vexecute(const char *fmt, va_list args)
 		ret = OCI_handle_sql_error((err == ORA_ERR_UNIQ_CONSTRAINT ? ERR_Z3008 : ERR_Z3005), err, sql);
 
 #elif defined(HAVE_POSTGRESQL)
+#	if defined(ZBX_PG_PIPELINE)
+	if (0 != pipeline_enabled && 0 < txn_level)
+	{
+		ret = db_pipeline_send(sql);
+		goto clean;
+	}
+#	endif
 	result = PQexec(conn,sql);
 
 	if (NULL == result)
@@ -1636,6 +1803,138 @@ clean:
 	return ret;
 }
 
+#if defined(HAVE_POSTGRESQL)
+/* the maximum size of data sent with one PQputCopyData() call */
+#define ZBX_DB_COPY_CHUNK_SIZE	(ZBX_MEBIBYTE)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies data into table with COPY ... FROM STDIN statement         *
+ *                                                                            *
+ * Parameters: sql  - [IN] the COPY statement                                 *
+ *             data - [IN] the data in the format specified by COPY statement *
+ *             size - [IN] the data size                                      *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows copied (on success)                        *
+ *                                                                            *
+ * Comments: Within transaction the COPY statement is protected by savepoint, *
+ *           so a failed COPY does not fail the transaction and the data can  *
+ *           be inserted by other means.                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_basic(const char *sql, const char *data, size_t size)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = ZBX_DB_OK, savepoint = 0;
+	size_t		offset, chunk;
+	double		sec = 0;
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level,
+				sql);
+		return ZBX_DB_FAIL;
+	}
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+		sec = zbx_time();
+
+	if (0 < txn_level)
+	{
+		if (ZBX_DB_OK > (ret = zbx_db_execute_basic("savepoint zbx_copy")))
+			return ret;
+
+		savepoint = 1;
+	}
+
+#if defined(ZBX_PG_PIPELINE)
+	if (ZBX_DB_OK != (ret = db_pipeline_sync()))
+		return ret;
+#endif
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s] size:" ZBX_FS_SIZE_T, txn_level, sql,
+			(zbx_fs_size_t)size);
+
+	result = PQexec(conn, sql);
+
+	if (NULL == result || PGRES_COPY_IN != PQresultStatus(result))
+	{
+		if (NULL == result)
+			zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		else
+		{
+			zbx_postgresql_error(&error, result);
+			zbx_db_errlog(ERR_Z3005, 0, error, sql);
+			zbx_free(error);
+		}
+
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+		PQclear(result);
+		goto out;
+	}
+
+	PQclear(result);
+
+	for (offset = 0; offset < size; offset += chunk)
+	{
+		chunk = MIN(size - offset, ZBX_DB_COPY_CHUNK_SIZE);
+
+		if (1 != PQputCopyData(conn, data + offset, (int)chunk))
+			break;
+	}
+
+	if (offset < size)
+		PQputCopyEnd(conn, "cannot send data");
+	else
+		PQputCopyEnd(conn, NULL);
+
+	while (NULL != (result = PQgetResult(conn)))
+	{
+		if (PGRES_COMMAND_OK == PQresultStatus(result))
+		{
+			ret = atoi(PQcmdTuples(result));
+		}
+		else if (ZBX_DB_OK <= ret)
+		{
+			zbx_err_codes_t	errcode;
+
+			zbx_postgresql_error(&error, result);
+
+			if (0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), "23505"))
+				errcode = ERR_Z3008;
+			else
+				errcode = ERR_Z3005;
+
+			zbx_db_errlog(errcode, 0, error, sql);
+			zbx_free(error);
+
+			ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+		}
+
+		PQclear(result);
+	}
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)CONFIG_LOG_SLOW_QUERIES / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+out:
+	if (0 != savepoint)
+	{
+		if (ZBX_DB_OK <= ret)
+			zbx_db_execute_basic("release savepoint zbx_copy");
+		else if (ZBX_DB_FAIL == ret)
+			zbx_db_execute_basic("rollback to savepoint zbx_copy");
+	}
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: execute a select statement                                        *
@@ -1665,6 +1964,11 @@ DB_RESULT	zbx_db_vselect(const char *fmt, va_list args)
 
 	sql = zbx_dvsprintf(sql, fmt, args);
 
+#if defined(ZBX_PG_PIPELINE)
+	/* the select may depend on the pipelined statements, wait for their results */
+	db_pipeline_sync();
+#endif
+
 	if (ZBX_DB_OK != txn_error)
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level, sql);
@@ -326,6 +326,20 @@ int	zbx_db_end(int ret)
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send the following non-select statements of transaction without  *
+ *          waiting for their results                                         *
+ *                                                                            *
+ * Comments: errors are reported when transaction ends, see                   *
+ *           zbx_db_pipeline_begin_basic() for restrictions                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_pipeline_begin(void)
+{
+	zbx_db_pipeline_begin_basic();
+}
+
 #ifdef HAVE_ORACLE
 /******************************************************************************
  *                                                                            *
@@ -2810,6 +2824,7 @@ void	zbx_db_insert_prepare_dyn(zbx_db_insert_t *self, const ZBX_TABLE *table, co
 	}
 
 	self->autoincrement = -1;
+	self->copy = 0;
 
 	zbx_vector_ptr_create(&self->fields);
 	zbx_vector_ptr_create(&self->rows);
@@ -2908,7 +2923,8 @@ void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *self, const zbx_db_value_t **
 			case ZBX_TYPE_TEXT:
 			case ZBX_TYPE_SHORTTEXT:
 			case ZBX_TYPE_CUID:
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_POSTGRESQL)
+				/* Oracle binds values and COPY sends them as is, SQL statements are escaped when built */
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_OFF);
 #else
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
@@ -2989,6 +3005,201 @@ void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...)
 	zbx_vector_ptr_destroy(&values);
 }
 
+#ifdef HAVE_POSTGRESQL
+/* the period COPY is not used after it has failed */
+#define ZBX_DB_COPY_RETRY_PERIOD	SEC_PER_HOUR
+
+static time_t	db_copy_disabled_until = 0;
+
+static void	db_copy_append(char **data, size_t *data_alloc, size_t *data_offset, const void *src, size_t size)
+{
+	if (*data_alloc < *data_offset + size)
+	{
+		while (*data_alloc < *data_offset + size)
+			*data_alloc *= 2;
+
+		*data = (char *)zbx_realloc(*data, *data_alloc);
+	}
+
+	memcpy(*data + *data_offset, src, size);
+	*data_offset += size;
+}
+
+static void	db_copy_append_uint16(char **data, size_t *data_alloc, size_t *data_offset, unsigned short value)
+{
+	value = htons(value);
+	db_copy_append(data, data_alloc, data_offset, &value, sizeof(value));
+}
+
+static void	db_copy_append_uint32(char **data, size_t *data_alloc, size_t *data_offset, zbx_uint32_t value)
+{
+	value = htonl(value);
+	db_copy_append(data, data_alloc, data_offset, &value, sizeof(value));
+}
+
+static void	db_copy_append_uint64(char **data, size_t *data_alloc, size_t *data_offset, zbx_uint64_t value)
+{
+	db_copy_append_uint32(data, data_alloc, data_offset, (zbx_uint32_t)(value >> 32));
+	db_copy_append_uint32(data, data_alloc, data_offset, (zbx_uint32_t)value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends unsigned integer as PostgreSQL binary numeric value       *
+ *                                                                            *
+ * Comments: numeric value is sent as number of base 10000 digits, weight of  *
+ *           the first digit, sign, display scale and the digits starting     *
+ *           with the most significant one, trailing zero digits omitted      *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_append_numeric(char **data, size_t *data_alloc, size_t *data_offset, zbx_uint64_t value)
+{
+	unsigned short	digits[5];
+	int		digits_num = 0, first = 0, i;
+
+	for (; 0 != value; value /= 10000)
+		digits[digits_num++] = (unsigned short)(value % 10000);
+
+	while (first < digits_num && 0 == digits[first])
+		first++;
+
+	db_copy_append_uint32(data, data_alloc, data_offset, (zbx_uint32_t)(8 + 2 * (digits_num - first)));
+	db_copy_append_uint16(data, data_alloc, data_offset, (unsigned short)(digits_num - first));
+	db_copy_append_uint16(data, data_alloc, data_offset, (unsigned short)(0 != digits_num ? digits_num - 1 : 0));
+	db_copy_append_uint16(data, data_alloc, data_offset, 0);
+	db_copy_append_uint16(data, data_alloc, data_offset, 0);
+
+	for (i = digits_num - 1; i >= first; i--)
+		db_copy_append_uint16(data, data_alloc, data_offset, digits[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: inserts the bulk insert rows with COPY statement in binary format *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: SUCCEED - the rows were copied                               *
+ *               FAIL    - the rows must be inserted with INSERT statements   *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_copy(zbx_db_insert_t *self)
+{
+	static const char	signature[] = "PGCOPY\n\377\r\n";
+	char			*sql = NULL, *data;
+	size_t			sql_alloc = 0, sql_offset = 0, data_alloc = 16 * ZBX_KIBIBYTE, data_offset = 0;
+	int			i, j, ret = FAIL, rc;
+	const ZBX_FIELD		*field;
+	time_t			now;
+
+	if (db_copy_disabled_until > (now = time(NULL)))
+		return FAIL;
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (const ZBX_FIELD *)self->fields.values[i];
+
+		if (ZBX_TYPE_BLOB == field->type || ZBX_TYPE_SERIAL == field->type)
+			return FAIL;
+	}
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "copy %s (", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (const ZBX_FIELD *)self->fields.values[i];
+
+		if (0 != i)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") from stdin (format binary)");
+
+	data = (char *)zbx_malloc(NULL, data_alloc);
+
+	/* header - signature including terminating zero, flags and header extension length */
+	db_copy_append(&data, &data_alloc, &data_offset, signature, sizeof(signature));
+	db_copy_append_uint32(&data, &data_alloc, &data_offset, 0);
+	db_copy_append_uint32(&data, &data_alloc, &data_offset, 0);
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		const zbx_db_value_t	*values = (const zbx_db_value_t *)self->rows.values[i];
+
+		db_copy_append_uint16(&data, &data_alloc, &data_offset, (unsigned short)self->fields.values_num);
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			const zbx_db_value_t	*value = &values[j];
+			zbx_uint64_t		dbl;
+			size_t			len;
+
+			field = (const ZBX_FIELD *)self->fields.values[j];
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+				case ZBX_TYPE_CUID:
+					len = strlen(value->str);
+					db_copy_append_uint32(&data, &data_alloc, &data_offset, (zbx_uint32_t)len);
+					db_copy_append(&data, &data_alloc, &data_offset, value->str, len);
+					break;
+				case ZBX_TYPE_INT:
+					db_copy_append_uint32(&data, &data_alloc, &data_offset, sizeof(zbx_uint32_t));
+					db_copy_append_uint32(&data, &data_alloc, &data_offset, (zbx_uint32_t)value->i32);
+					break;
+				case ZBX_TYPE_FLOAT:
+					memcpy(&dbl, &value->dbl, sizeof(dbl));
+					db_copy_append_uint32(&data, &data_alloc, &data_offset, sizeof(zbx_uint64_t));
+					db_copy_append_uint64(&data, &data_alloc, &data_offset, dbl);
+					break;
+				case ZBX_TYPE_UINT:
+					db_copy_append_numeric(&data, &data_alloc, &data_offset, value->ui64);
+					break;
+				case ZBX_TYPE_ID:
+					/* zero identifier is inserted as null, see zbx_db_sql_id_ins() */
+					if (0 == value->ui64)
+					{
+						db_copy_append_uint32(&data, &data_alloc, &data_offset, (zbx_uint32_t)-1);
+						break;
+					}
+
+					db_copy_append_uint32(&data, &data_alloc, &data_offset, sizeof(zbx_uint64_t));
+					db_copy_append_uint64(&data, &data_alloc, &data_offset, value->ui64);
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	/* trailer */
+	db_copy_append_uint16(&data, &data_alloc, &data_offset, (unsigned short)-1);
+
+	if (ZBX_DB_OK <= (rc = zbx_db_copy_basic(sql, data, data_offset)))
+	{
+		ret = SUCCEED;
+	}
+	else if (ZBX_DB_FAIL == rc && ERR_Z3008 != zbx_db_last_errcode())
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot copy data into table \"%s\", using INSERT statements for the"
+				" next %d seconds", self->table->table, ZBX_DB_COPY_RETRY_PERIOD);
+		db_copy_disabled_until = now + ZBX_DB_COPY_RETRY_PERIOD;
+	}
+
+	zbx_free(data);
+	zbx_free(sql);
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: executes the prepared database bulk insert operation              *
@@ -3014,6 +3225,9 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 	char		*sql_values = NULL;
 	size_t		sql_values_alloc = 0, sql_values_offset = 0;
 #	endif
+#	ifdef HAVE_POSTGRESQL
+	char		*str_esc;
+#	endif
 #else
 	zbx_db_bind_context_t	*contexts;
 	int			rc, tries = 0;
@@ -3037,6 +3251,11 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 		}
 	}
 
+#ifdef HAVE_POSTGRESQL
+	if (0 != self->copy && SUCCEED == db_insert_copy(self))
+		return SUCCEED;
+#endif
+
 #ifndef HAVE_ORACLE
 	sql = (char *)zbx_malloc(NULL, sql_alloc);
 #endif
@@ -3172,7 +3391,13 @@ retry_oracle:
 				case ZBX_TYPE_LONGTEXT:
 				case ZBX_TYPE_CUID:
 					zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
+#	ifdef HAVE_POSTGRESQL
+					str_esc = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
+					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, str_esc);
+					zbx_free(str_esc);
+#	else
 					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, value->str);
+#	endif
 					zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
 					break;
 				case ZBX_TYPE_INT:
@@ -3262,6 +3487,25 @@ void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name)
 	exit(EXIT_FAILURE);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes database bulk insert operation to use COPY statement when   *
+ *          supported by database                                             *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Comments: If COPY fails the rows are inserted with INSERT statements.      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_insert_enable_copy(zbx_db_insert_t *self)
+{
+#ifdef HAVE_POSTGRESQL
+	self->copy = 1;
+#else
+	ZBX_UNUSED(self);
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: determine is it a server or a proxy database                      *
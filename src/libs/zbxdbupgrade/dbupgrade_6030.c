@@ -1496,6 +1496,306 @@ static int	DBpatch_6030159(void)
 
 	return SUCCEED;
 }
+
+static int	DBpatch_6030160(void)
+{
+	return DBcreate_changelog_insert_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_6030161(void)
+{
+	return DBcreate_changelog_update_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_6030162(void)
+{
+	return DBcreate_changelog_delete_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_6030163(void)
+{
+	return DBcreate_changelog_insert_trigger("hostmacro", "hostmacroid");
+}
+
+static int	DBpatch_6030164(void)
+{
+	return DBcreate_changelog_update_trigger("hostmacro", "hostmacroid");
+}
+
+static int	DBpatch_6030165(void)
+{
+	return DBcreate_changelog_delete_trigger("hostmacro", "hostmacroid");
+}
+
+static int	DBpatch_6030166(void)
+{
+	return DBcreate_changelog_insert_trigger("actions", "actionid");
+}
+
+static int	DBpatch_6030167(void)
+{
+	return DBcreate_changelog_update_trigger("actions", "actionid");
+}
+
+static int	DBpatch_6030168(void)
+{
+	return DBcreate_changelog_delete_trigger("actions", "actionid");
+}
+
+static int	DBpatch_6030169(void)
+{
+	return DBcreate_changelog_insert_trigger("operations", "operationid");
+}
+
+static int	DBpatch_6030170(void)
+{
+	return DBcreate_changelog_update_trigger("operations", "operationid");
+}
+
+static int	DBpatch_6030171(void)
+{
+	return DBcreate_changelog_delete_trigger("operations", "operationid");
+}
+
+static int	DBpatch_6030172(void)
+{
+	return DBcreate_changelog_insert_trigger("conditions", "conditionid");
+}
+
+static int	DBpatch_6030173(void)
+{
+	return DBcreate_changelog_update_trigger("conditions", "conditionid");
+}
+
+static int	DBpatch_6030174(void)
+{
+	return DBcreate_changelog_delete_trigger("conditions", "conditionid");
+}
+
+static int	DBpatch_6030175(void)
+{
+	return DBcreate_changelog_insert_trigger("correlation", "correlationid");
+}
+
+static int	DBpatch_6030176(void)
+{
+	return DBcreate_changelog_update_trigger("correlation", "correlationid");
+}
+
+static int	DBpatch_6030177(void)
+{
+	return DBcreate_changelog_delete_trigger("correlation", "correlationid");
+}
+
+static int	DBpatch_6030178(void)
+{
+	return DBcreate_changelog_insert_trigger("corr_condition", "corr_conditionid");
+}
+
+static int	DBpatch_6030179(void)
+{
+	return DBcreate_changelog_update_trigger("corr_condition", "corr_conditionid");
+}
+
+static int	DBpatch_6030180(void)
+{
+	return DBcreate_changelog_delete_trigger("corr_condition", "corr_conditionid");
+}
+
+static int	DBpatch_6030181(void)
+{
+	return DBcreate_changelog_insert_trigger("corr_condition_tag", "corr_conditionid");
+}
+
+static int	DBpatch_6030182(void)
+{
+	return DBcreate_changelog_update_trigger("corr_condition_tag", "corr_conditionid");
+}
+
+static int	DBpatch_6030183(void)
+{
+	return DBcreate_changelog_delete_trigger("corr_condition_tag", "corr_conditionid");
+}
+
+static int	DBpatch_6030184(void)
+{
+	return DBcreate_changelog_insert_trigger("corr_condition_group", "corr_conditionid");
+}
+
+static int	DBpatch_6030185(void)
+{
+	return DBcreate_changelog_update_trigger("corr_condition_group", "corr_conditionid");
+}
+
+static int	DBpatch_6030186(void)
+{
+	return DBcreate_changelog_delete_trigger("corr_condition_group", "corr_conditionid");
+}
+
+static int	DBpatch_6030187(void)
+{
+	return DBcreate_changelog_insert_trigger("corr_condition_tagpair", "corr_conditionid");
+}
+
+static int	DBpatch_6030188(void)
+{
+	return DBcreate_changelog_update_trigger("corr_condition_tagpair", "corr_conditionid");
+}
+
+static int	DBpatch_6030189(void)
+{
+	return DBcreate_changelog_delete_trigger("corr_condition_tagpair", "corr_conditionid");
+}
+
+static int	DBpatch_6030190(void)
+{
+	return DBcreate_changelog_insert_trigger("corr_condition_tagvalue", "corr_conditionid");
+}
+
+static int	DBpatch_6030191(void)
+{
+	return DBcreate_changelog_update_trigger("corr_condition_tagvalue", "corr_conditionid");
+}
+
+static int	DBpatch_6030192(void)
+{
+	return DBcreate_changelog_delete_trigger("corr_condition_tagvalue", "corr_conditionid");
+}
+
+static int	DBpatch_6030193(void)
+{
+	return DBcreate_changelog_insert_trigger("corr_operation", "corr_operationid");
+}
+
+static int	DBpatch_6030194(void)
+{
+	return DBcreate_changelog_update_trigger("corr_operation", "corr_operationid");
+}
+
+static int	DBpatch_6030195(void)
+{
+	return DBcreate_changelog_delete_trigger("corr_operation", "corr_operationid");
+}
+
+static int	DBpatch_6030196(void)
+{
+	return DBcreate_changelog_insert_trigger("hstgrp", "groupid");
+}
+
+static int	DBpatch_6030197(void)
+{
+	return DBcreate_changelog_update_trigger("hstgrp", "groupid");
+}
+
+static int	DBpatch_6030198(void)
+{
+	return DBcreate_changelog_delete_trigger("hstgrp", "groupid");
+}
+
+static int	DBpatch_6030199(void)
+{
+	return DBcreate_changelog_insert_trigger("hosts_groups", "hostgroupid");
+}
+
+static int	DBpatch_6030200(void)
+{
+	return DBcreate_changelog_update_trigger("hosts_groups", "hostgroupid");
+}
+
+static int	DBpatch_6030201(void)
+{
+	return DBcreate_changelog_delete_trigger("hosts_groups", "hostgroupid");
+}
+
+static int	DBpatch_6030202(void)
+{
+	return DBcreate_changelog_insert_trigger("maintenances", "maintenanceid");
+}
+
+static int	DBpatch_6030203(void)
+{
+	return DBcreate_changelog_update_trigger("maintenances", "maintenanceid");
+}
+
+static int	DBpatch_6030204(void)
+{
+	return DBcreate_changelog_delete_trigger("maintenances", "maintenanceid");
+}
+
+static int	DBpatch_6030205(void)
+{
+	return DBcreate_changelog_insert_trigger("maintenance_tag", "maintenancetagid");
+}
+
+static int	DBpatch_6030206(void)
+{
+	return DBcreate_changelog_update_trigger("maintenance_tag", "maintenancetagid");
+}
+
+static int	DBpatch_6030207(void)
+{
+	return DBcreate_changelog_delete_trigger("maintenance_tag", "maintenancetagid");
+}
+
+static int	DBpatch_6030208(void)
+{
+	return DBcreate_changelog_insert_trigger("maintenances_windows", "maintenance_timeperiodid");
+}
+
+static int	DBpatch_6030209(void)
+{
+	return DBcreate_changelog_update_trigger("maintenances_windows", "maintenance_timeperiodid");
+}
+
+static int	DBpatch_6030210(void)
+{
+	return DBcreate_changelog_delete_trigger("maintenances_windows", "maintenance_timeperiodid");
+}
+
+static int	DBpatch_6030211(void)
+{
+	return DBcreate_changelog_insert_trigger("timeperiods", "timeperiodid");
+}
+
+static int	DBpatch_6030212(void)
+{
+	return DBcreate_changelog_update_trigger("timeperiods", "timeperiodid");
+}
+
+static int	DBpatch_6030213(void)
+{
+	return DBcreate_changelog_delete_trigger("timeperiods", "timeperiodid");
+}
+
+static int	DBpatch_6030214(void)
+{
+	return DBcreate_changelog_insert_trigger("maintenances_groups", "maintenance_groupid");
+}
+
+static int	DBpatch_6030215(void)
+{
+	return DBcreate_changelog_update_trigger("maintenances_groups", "maintenance_groupid");
+}
+
+static int	DBpatch_6030216(void)
+{
+	return DBcreate_changelog_delete_trigger("maintenances_groups", "maintenance_groupid");
+}
+
+static int	DBpatch_6030217(void)
+{
+	return DBcreate_changelog_insert_trigger("maintenances_hosts", "maintenance_hostid");
+}
+
+static int	DBpatch_6030218(void)
+{
+	return DBcreate_changelog_update_trigger("maintenances_hosts", "maintenance_hostid");
+}
+
+static int	DBpatch_6030219(void)
+{
+	return DBcreate_changelog_delete_trigger("maintenances_hosts", "maintenance_hostid");
+}
 #endif
 
 DBPATCH_START(6030)
@@ -1662,5 +1962,65 @@ DBPATCH_ADD(6030156, 0, 1)
 DBPATCH_ADD(6030157, 0, 1)
 DBPATCH_ADD(6030158, 0, 1)
 DBPATCH_ADD(6030159, 0, 1)
+DBPATCH_ADD(6030160, 0, 1)
+DBPATCH_ADD(6030161, 0, 1)
+DBPATCH_ADD(6030162, 0, 1)
+DBPATCH_ADD(6030163, 0, 1)
+DBPATCH_ADD(6030164, 0, 1)
+DBPATCH_ADD(6030165, 0, 1)
+DBPATCH_ADD(6030166, 0, 1)
+DBPATCH_ADD(6030167, 0, 1)
+DBPATCH_ADD(6030168, 0, 1)
+DBPATCH_ADD(6030169, 0, 1)
+DBPATCH_ADD(6030170, 0, 1)
+DBPATCH_ADD(6030171, 0, 1)
+DBPATCH_ADD(6030172, 0, 1)
+DBPATCH_ADD(6030173, 0, 1)
+DBPATCH_ADD(6030174, 0, 1)
+DBPATCH_ADD(6030175, 0, 1)
+DBPATCH_ADD(6030176, 0, 1)
+DBPATCH_ADD(6030177, 0, 1)
+DBPATCH_ADD(6030178, 0, 1)
+DBPATCH_ADD(6030179, 0, 1)
+DBPATCH_ADD(6030180, 0, 1)
+DBPATCH_ADD(6030181, 0, 1)
+DBPATCH_ADD(6030182, 0, 1)
+DBPATCH_ADD(6030183, 0, 1)
+DBPATCH_ADD(6030184, 0, 1)
+DBPATCH_ADD(6030185, 0, 1)
+DBPATCH_ADD(6030186, 0, 1)
+DBPATCH_ADD(6030187, 0, 1)
+DBPATCH_ADD(6030188, 0, 1)
+DBPATCH_ADD(6030189, 0, 1)
+DBPATCH_ADD(6030190, 0, 1)
+DBPATCH_ADD(6030191, 0, 1)
+DBPATCH_ADD(6030192, 0, 1)
+DBPATCH_ADD(6030193, 0, 1)
+DBPATCH_ADD(6030194, 0, 1)
+DBPATCH_ADD(6030195, 0, 1)
+DBPATCH_ADD(6030196, 0, 1)
+DBPATCH_ADD(6030197, 0, 1)
+DBPATCH_ADD(6030198, 0, 1)
+DBPATCH_ADD(6030199, 0, 1)
+DBPATCH_ADD(6030200, 0, 1)
+DBPATCH_ADD(6030201, 0, 1)
+DBPATCH_ADD(6030202, 0, 1)
+DBPATCH_ADD(6030203, 0, 1)
+DBPATCH_ADD(6030204, 0, 1)
+DBPATCH_ADD(6030205, 0, 1)
+DBPATCH_ADD(6030206, 0, 1)
+DBPATCH_ADD(6030207, 0, 1)
+DBPATCH_ADD(6030208, 0, 1)
+DBPATCH_ADD(6030209, 0, 1)
+DBPATCH_ADD(6030210, 0, 1)
+DBPATCH_ADD(6030211, 0, 1)
+DBPATCH_ADD(6030212, 0, 1)
+DBPATCH_ADD(6030213, 0, 1)
+DBPATCH_ADD(6030214, 0, 1)
+DBPATCH_ADD(6030215, 0, 1)
+DBPATCH_ADD(6030216, 0, 1)
+DBPATCH_ADD(6030217, 0, 1)
+DBPATCH_ADD(6030218, 0, 1)
+DBPATCH_ADD(6030219, 0, 1)
 
 DBPATCH_END()
@@ -177,6 +177,48 @@ int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int c
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: gets values of multiple items from history storage                      *
+ *                                                                                  *
+ * Parameters:  value_type - [IN] the item value type                               *
+ *              ranges     - [IN/OUT] the item periods and values                   *
+ *              ranges_num - [IN] the number of item periods                        *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads all values from ]<start>,<end>] interval of each   *
+ *           item into its values vector. The item identifiers must be unique.      *
+ *           History backends without multiple item support are queried for each    *
+ *           item separately.                                                       *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_history_get_values_multi(int value_type, zbx_history_range_t *ranges, int ranges_num)
+{
+	int			i, ret = SUCCEED;
+	zbx_history_iface_t	*writer = &history_ifaces[value_type];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() value_type:%d ranges_num:%d", __func__, value_type, ranges_num);
+
+	if (NULL != writer->get_values_multi)
+	{
+		ret = writer->get_values_multi(writer, ranges, ranges_num);
+	}
+	else
+	{
+		for (i = 0; i < ranges_num && SUCCEED == ret; i++)
+		{
+			ret = writer->get_values(writer, ranges[i].itemid, ranges[i].start, 0, ranges[i].end,
+					&ranges[i].values);
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Purpose: checks if the value type requires trends data calculations              *
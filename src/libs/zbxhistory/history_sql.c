@@ -34,6 +34,9 @@ zbx_sql_writer_t;
 
 static zbx_sql_writer_t	writer;
 
+/* the maximum number of items read by one query */
+#define ZBX_HISTORY_SQL_BATCH_SIZE	1000
+
 typedef void (*vc_str2value_func_t)(zbx_history_value_t *value, DB_ROW row);
 
 /* history table data */
@@ -163,6 +166,10 @@ static int	sql_writer_flush(void)
 	{
 		zbx_db_begin();
 
+		/* send inserts of all tables before waiting for results, so the next */
+		/* insert statement is prepared while database executes the previous */
+		zbx_db_pipeline_begin();
+
 		for (i = 0; i < writer.dbinserts.values_num; i++)
 		{
 			zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)writer.dbinserts.values[i];
@@ -199,6 +206,7 @@ static void	add_history_dbl(const zbx_vector_ptr_t *history)
 
 	db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 	zbx_db_insert_prepare(db_insert, "history", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_enable_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -220,6 +228,7 @@ static void	add_history_uint(const zbx_vector_ptr_t *history)
 
 	db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 	zbx_db_insert_prepare(db_insert, "history_uint", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_enable_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -241,6 +250,7 @@ static void	add_history_str(const zbx_vector_ptr_t *history)
 
 	db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 	zbx_db_insert_prepare(db_insert, "history_str", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_enable_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -262,6 +272,7 @@ static void	add_history_text(const zbx_vector_ptr_t *history)
 
 	db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 	zbx_db_insert_prepare(db_insert, "history_text", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_enable_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -284,6 +295,7 @@ static void	add_history_log(const zbx_vector_ptr_t *history)
 	db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 	zbx_db_insert_prepare(db_insert, "history_log", "itemid", "clock", "ns", "timestamp", "source", "severity",
 			"value", "logeventid", NULL);
+	zbx_db_insert_enable_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -572,6 +584,116 @@ out:
 	return ret;
 }
 
+static int	history_range_compare_by_start(const void *d1, const void *d2)
+{
+	const zbx_history_range_t	*r1 = *(const zbx_history_range_t * const *)d1;
+	const zbx_history_range_t	*r2 = *(const zbx_history_range_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r1->start, r2->start);
+
+	return 0;
+}
+
+static int	history_range_compare_by_itemid(const void *d1, const void *d2)
+{
+	const zbx_history_range_t	*r1 = *(const zbx_history_range_t * const *)d1;
+	const zbx_history_range_t	*r2 = *(const zbx_history_range_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r1->itemid, r2->itemid);
+
+	return 0;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: reads history data of multiple items with similar periods from database *
+ *                                                                                  *
+ * Parameters:  value_type - [IN] the value type (see ITEM_VALUE_TYPE_* defs)       *
+ *              ranges     - [IN/OUT] the item periods and values, sorted by itemid *
+ *              ranges_num - [IN] the number of item periods                        *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: The values are read from the union of item periods and the values      *
+ *           outside the item's own period are discarded.                           *
+ *                                                                                  *
+ ************************************************************************************/
+static int	db_read_values_multi(int value_type, zbx_history_range_t **ranges, int ranges_num)
+{
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_vc_history_table_t	*table = &vc_history_tables[value_type];
+	zbx_uint64_t		*itemids;
+	int			i, start, end, ret = FAIL;
+	zbx_history_range_t	range_local, *prange = &range_local, **pprange;
+
+	itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)ranges_num);
+	start = ranges[0]->start;
+	end = ranges[0]->end;
+
+	for (i = 0; i < ranges_num; i++)
+	{
+		itemids[i] = ranges[i]->itemid;
+
+		if (ranges[i]->start < start)
+			start = ranges[i]->start;
+
+		if (ranges[i]->end > end)
+			end = ranges[i]->end;
+	}
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select itemid,clock,ns,%s"
+			" from %s"
+			" where clock>%d",
+			table->fields, table->name, start);
+
+	if (ZBX_JAN_2038 != end)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock<=%d", end);
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and");
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids, ranges_num);
+
+	result = zbx_db_select("%s", sql);
+
+	zbx_free(sql);
+	zbx_free(itemids);
+
+	if (NULL == result)
+		goto out;
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		zbx_history_record_t	value;
+
+		ZBX_STR2UINT64(range_local.itemid, row[0]);
+
+		if (NULL == (pprange = (zbx_history_range_t **)bsearch(&prange, ranges, (size_t)ranges_num,
+				sizeof(zbx_history_range_t *), history_range_compare_by_itemid)))
+		{
+			continue;
+		}
+
+		value.timestamp.sec = atoi(row[1]);
+
+		if (value.timestamp.sec <= (*pprange)->start || value.timestamp.sec > (*pprange)->end)
+			continue;
+
+		value.timestamp.ns = atoi(row[2]);
+		table->rtov(&value.value, row + 3);
+
+		zbx_vector_history_record_append_ptr(&(*pprange)->values, &value);
+	}
+	zbx_db_free_result(result);
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
 /******************************************************************************************************************
  *                                                                                                                *
  * history interface support                                                                                      *
@@ -620,6 +742,59 @@ static int	sql_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int st
 	return db_read_values_by_time_and_count(itemid, hist->value_type, values, end - start, count, end);
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: gets history data of multiple items from history storage                *
+ *                                                                                  *
+ * Parameters:  hist       - [IN] the history storage interface                     *
+ *              ranges     - [IN/OUT] the item periods and values                   *
+ *              ranges_num - [IN] the number of item periods                        *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: The items are grouped by period start and each group is read with a    *
+ *           single query. A period joins the group if its start is not later than  *
+ *           a quarter of the oldest group period, so no item reads much more than  *
+ *           it has requested.                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_get_values_multi(zbx_history_iface_t *hist, zbx_history_range_t *ranges, int ranges_num)
+{
+	zbx_vector_ptr_t	sorted;
+	int			i, j, now, period, ret = SUCCEED;
+
+	zbx_vector_ptr_create(&sorted);
+	zbx_vector_ptr_reserve(&sorted, (size_t)ranges_num);
+
+	for (i = 0; i < ranges_num; i++)
+		zbx_vector_ptr_append(&sorted, &ranges[i]);
+
+	zbx_vector_ptr_sort(&sorted, history_range_compare_by_start);
+
+	now = (int)time(NULL);
+
+	for (i = 0; i < sorted.values_num && SUCCEED == ret; i = j)
+	{
+		zbx_history_range_t	**group = (zbx_history_range_t **)sorted.values + i;
+
+		period = MIN(group[0]->end, now) - group[0]->start;
+
+		for (j = i + 1; j < sorted.values_num && ZBX_HISTORY_SQL_BATCH_SIZE > j - i; j++)
+		{
+			if (((zbx_history_range_t *)sorted.values[j])->start - group[0]->start > period / 4)
+				break;
+		}
+
+		qsort(group, (size_t)(j - i), sizeof(zbx_history_range_t *), history_range_compare_by_itemid);
+		ret = db_read_values_multi(hist->value_type, group, j - i);
+	}
+
+	zbx_vector_ptr_destroy(&sorted);
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Purpose: sends history data to the storage                                       *
@@ -685,6 +860,7 @@ int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, ch
 	hist->add_values = sql_add_values;
 	hist->flush = sql_flush;
 	hist->get_values = sql_get_values;
+	hist->get_values_multi = sql_get_values_multi;
 
 	switch (value_type)
 	{
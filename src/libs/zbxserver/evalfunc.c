@@ -1218,6 +1218,7 @@ static int	evaluate_COUNT(zbx_variant_t *value, const DC_EVALUATE_ITEM *item, co
 	zbx_vector_expression_t		regexps;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() params:%s", __func__, ZBX_NULL2EMPTY_STR(parameters));
 
@@ -1397,6 +1398,19 @@ static int	evaluate_COUNT(zbx_variant_t *value, const DC_EVALUATE_ITEM *item, co
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
+	/* plain count of numeric values over time period is maintained by value cache */
+	if (0 != numeric_search && COUNT_ALL == unique && ZBX_VALUE_SECONDS == arg1_type && '\0' == *pattern &&
+			(NULL == operator || '\0' == *operator) && SUCCEED == zbx_vc_get_aggregate(item->itemid,
+			item->value_type, seconds, &ts_end, 0, &aggregate))
+	{
+		if ((count = aggregate.count) > limit)
+			count = limit;
+
+		zbx_variant_set_dbl(value, count);
+		ret = SUCCEED;
+		goto out;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -1547,6 +1561,7 @@ static int	evaluate_SUM(zbx_variant_t *value, const DC_EVALUATE_ITEM *item, cons
 	zbx_vector_history_record_t	values;
 	zbx_history_value_t		result;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1585,6 +1600,19 @@ static int	evaluate_SUM(zbx_variant_t *value, const DC_EVALUATE_ITEM *item, cons
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
+	if (ZBX_VALUE_SECONDS == arg1_type && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type,
+			seconds, &ts_end, 0, &aggregate))
+	{
+		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+			result.dbl = aggregate.sum_dbl;
+		else
+			result.ui64 = aggregate.sum_ui64;
+
+		zbx_history_value2variant(&result, item->value_type, value);
+		ret = SUCCEED;
+		goto out;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -1638,6 +1666,7 @@ static int	evaluate_AVG(zbx_variant_t *value, const DC_EVALUATE_ITEM *item, cons
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1676,7 +1705,20 @@ static int	evaluate_AVG(zbx_variant_t *value, const DC_EVALUATE_ITEM *item, cons
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	/* the sum of large values can overflow, in that case average is calculated from values */
+	if (ZBX_VALUE_SECONDS == arg1_type && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type,
+			seconds, &ts_end, 0, &aggregate) && FP_INFINITE != fpclassify(aggregate.sum_dbl) &&
+			FP_NAN != fpclassify(aggregate.sum_dbl))
+	{
+		/* empty period is reported below as values vector is empty */
+		if (0 < aggregate.count)
+		{
+			zbx_variant_set_dbl(value, aggregate.sum_dbl / aggregate.count);
+			ret = SUCCEED;
+			goto out;
+		}
+	}
+	else if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
@@ -1782,6 +1824,8 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const DC_EVALUATE_ITEM *ite
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
+	unsigned char			flags;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1820,7 +1864,21 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const DC_EVALUATE_ITEM *ite
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	flags = (EVALUATE_MIN == min_or_max ? ZBX_VC_AGGREGATE_MIN : ZBX_VC_AGGREGATE_MAX);
+
+	if (ZBX_VALUE_SECONDS == arg1_type && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type,
+			seconds, &ts_end, flags, &aggregate))
+	{
+		/* empty period is reported below as values vector is empty */
+		if (0 < aggregate.count)
+		{
+			zbx_history_value2variant(EVALUATE_MIN == min_or_max ? &aggregate.min : &aggregate.max,
+					item->value_type, value);
+			ret = SUCCEED;
+			goto out;
+		}
+	}
+	else if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
@@ -1869,6 +1927,71 @@ out:
 	return ret;
 }
 
+static void	history_record_swap(zbx_vector_history_record_t *values, int i, int j)
+{
+	zbx_history_record_t	tmp = values->values[i];
+
+	values->values[i] = values->values[j];
+	values->values[j] = tmp;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves the value, which would be at the specified position in      *
+ *          sorted vector, to that position                                   *
+ *                                                                            *
+ * Parameters: values  - [IN/OUT] the values                                  *
+ *             k       - [IN] the position (0 based)                          *
+ *             compare - [IN] the value compare function                      *
+ *                                                                            *
+ * Comments: Quickselect with median of three pivot is used, so the value is  *
+ *           found in linear time on average instead of sorting all values.   *
+ *           Other values are reordered.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	history_record_select(zbx_vector_history_record_t *values, int k, zbx_compare_func_t compare)
+{
+	int	left = 0, right = values->values_num - 1;
+
+	while (left < right)
+	{
+		int			i = left, j = right, mid = left + (right - left) / 2;
+		zbx_history_record_t	pivot;
+
+		if (0 < compare(&values->values[left], &values->values[mid]))
+			history_record_swap(values, left, mid);
+
+		if (0 < compare(&values->values[left], &values->values[right]))
+			history_record_swap(values, left, right);
+
+		if (0 < compare(&values->values[mid], &values->values[right]))
+			history_record_swap(values, mid, right);
+
+		pivot = values->values[mid];
+
+		while (i <= j)
+		{
+			while (0 > compare(&values->values[i], &pivot))
+				i++;
+
+			while (0 < compare(&values->values[j], &pivot))
+				j--;
+
+			if (i <= j)
+				history_record_swap(values, i++, j--);
+		}
+
+		/* values in [left, j] are not greater and in [i, right] not less than pivot, */
+		/* values between them are equal to pivot                                     */
+		if (k <= j)
+			right = j;
+		else if (k >= i)
+			left = i;
+		else
+			break;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate function 'percentile' for the item                       *
@@ -1876,7 +1999,7 @@ out:
  * Parameters: value      - [OUT] result                                      *
  *             item       - [IN] item (performance metric)                    *
  *             parameters - [IN] seconds/values, time shift (optional),       *
- *                               percentage                                   *
+ *                               percentage, mode (optional)                  *
  *             ts         - [IN] the starting timestamp                       *
  *             error      - [OUT] the error message                           *
  *                                                                            *
@@ -1888,11 +2011,13 @@ out:
 static int	evaluate_PERCENTILE(zbx_variant_t  *value, const DC_EVALUATE_ITEM *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, time_shift, ret = FAIL, seconds = 0, nvalues = 0;
+	int				arg1, time_shift, num, ret = FAIL, seconds = 0, nvalues = 0, sketch = 0;
 	zbx_value_type_t		arg1_type;
 	double				percentage;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_history_value_t		result;
+	char				*arg3 = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1904,7 +2029,9 @@ static int	evaluate_PERCENTILE(zbx_variant_t  *value, const DC_EVALUATE_ITEM *it
 		goto out;
 	}
 
-	if (2 != zbx_num_param(parameters))
+	num = zbx_num_param(parameters);
+
+	if (2 > num || 3 < num)
 	{
 		*error = zbx_strdup(*error, "invalid number of parameters");
 		goto out;
@@ -1938,6 +2065,23 @@ static int	evaluate_PERCENTILE(zbx_variant_t  *value, const DC_EVALUATE_ITEM *it
 		goto out;
 	}
 
+	if (2 < num && (SUCCEED != get_function_parameter_str(parameters, 3, &arg3) ||
+			('\0' != *arg3 && 0 == (sketch = (0 == strcmp("sketch", arg3))) &&
+			0 != strcmp("exact", arg3))))
+	{
+		*error = zbx_strdup(*error, "invalid fourth parameter");
+		goto out;
+	}
+
+	/* estimated percentile over time period is maintained by value cache */
+	if (0 != sketch && ZBX_VALUE_SECONDS == arg1_type && SUCCEED == zbx_vc_get_percentile(item->itemid,
+			item->value_type, seconds, &ts_end, percentage, &result))
+	{
+		zbx_history_value2variant(&result, item->value_type, value);
+		ret = SUCCEED;
+		goto out;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -1948,16 +2092,16 @@ static int	evaluate_PERCENTILE(zbx_variant_t  *value, const DC_EVALUATE_ITEM *it
 	{
 		int	index;
 
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-			zbx_vector_history_record_sort(&values, (zbx_compare_func_t)history_record_float_compare);
-		else
-			zbx_vector_history_record_sort(&values, (zbx_compare_func_t)history_record_uint64_compare);
-
 		if (0 == percentage)
 			index = 1;
 		else
 			index = (int)ceil(values.values_num * (percentage / 100));
 
+		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+			history_record_select(&values, index - 1, (zbx_compare_func_t)history_record_float_compare);
+		else
+			history_record_select(&values, index - 1, (zbx_compare_func_t)history_record_uint64_compare);
+
 		zbx_history_value2variant(&values.values[index - 1].value, item->value_type, value);
 
 		ret = SUCCEED;
@@ -1968,6 +2112,7 @@ static int	evaluate_PERCENTILE(zbx_variant_t  *value, const DC_EVALUATE_ITEM *it
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
+	zbx_free(arg3);
 	zbx_history_record_vector_destroy(&values, item->value_type);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
@@ -3893,6 +4038,58 @@ int	evaluate_function(zbx_variant_t *value, const DC_EVALUATE_ITEM *item, const
 #undef EVALUATE_MIN
 #undef EVALUATE_MAX
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the history period read by function                           *
+ *                                                                            *
+ * Parameters: function  - [IN] the function name                             *
+ *             parameter - [IN] the function parameters, user macros expanded *
+ *             ts        - [IN] the evaluation timestamp                      *
+ *             seconds   - [OUT] the period length                            *
+ *             ts_end    - [OUT] the period end timestamp                     *
+ *                                                                            *
+ * Return value: SUCCEED - the function reads item values of time based       *
+ *                         period                                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Used to prefetch values of multiple items before evaluating      *
+ *           functions, so the period must match the one read by              *
+ *           evaluate_function().                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_get_function_history_period(const char *function, const char *parameter, const zbx_timespec_t *ts,
+		int *seconds, zbx_timespec_t *ts_end)
+{
+	const char		*functions[] = {"min", "max", "avg", "sum", "percentile", "count", "countunique",
+					"find", "forecast", "timeleft", "first", "kurtosis", "mad", "skewness",
+					"stddevpop", "stddevsamp", "sumofsquares", "varpop", "varsamp", "monoinc",
+					"monodec", "rate", "changecount", NULL};
+	const char		**ptr;
+	int			arg1, time_shift;
+	zbx_value_type_t	arg1_type;
+
+	for (ptr = functions; NULL != *ptr; ptr++)
+	{
+		if (0 == strcmp(*ptr, function))
+			break;
+	}
+
+	if (NULL == *ptr)
+		return FAIL;
+
+	if (SUCCEED != get_function_parameter_hist_range(ts->sec, parameter, 1, &arg1, &arg1_type, &time_shift) ||
+			ZBX_VALUE_SECONDS != arg1_type || 0 >= arg1)
+	{
+		return FAIL;
+	}
+
+	*seconds = arg1;
+	*ts_end = *ts;
+	ts_end->sec -= time_shift;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: check if the specified function is a trigger function             *
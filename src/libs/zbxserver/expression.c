@@ -5566,6 +5566,76 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d", __func__, ifuncs->num_data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache the item values read by history functions with few          *
+ *          multiple item queries instead of reading them item by item        *
+ *                                                                            *
+ * Comments: Functions with user macros in parameters are skipped, their      *
+ *           values are read during evaluation.                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_prefetch_item_functions(zbx_hashset_t *funcs, const zbx_vector_uint64_t *history_itemids,
+		const zbx_history_sync_item_t *history_items, const int *history_errcodes,
+		const zbx_vector_uint64_t *itemids, const zbx_history_sync_item_t *items, const int *items_err)
+{
+	int				i;
+	zbx_func_t			*func;
+	zbx_hashset_iter_t		iter;
+	zbx_vector_vc_request_t		requests;
+
+	zbx_vector_vc_request_create(&requests);
+
+	zbx_hashset_iter_reset(funcs, &iter);
+	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
+	{
+		const zbx_history_sync_item_t	*item;
+		zbx_vc_request_t		request;
+
+		if (ZBX_FUNCTION_TYPE_HISTORY != func->type || NULL != strchr(func->parameter, '{'))
+			continue;
+
+		if (FAIL != (i = zbx_vector_uint64_bsearch(history_itemids, func->itemid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		{
+			if (SUCCEED != history_errcodes[i])
+				continue;
+
+			item = history_items + i;
+		}
+		else
+		{
+			i = zbx_vector_uint64_bsearch(itemids, func->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+			if (SUCCEED != items_err[i])
+				continue;
+
+			item = items + i;
+		}
+
+		if (ITEM_STATUS_ACTIVE != item->status || 0 == item->history ||
+				HOST_STATUS_MONITORED != item->host.status || ITEM_STATE_NOTSUPPORTED == item->state)
+		{
+			continue;
+		}
+
+		if (SUCCEED != zbx_get_function_history_period(func->function, func->parameter, &func->timespec,
+				&request.seconds, &request.ts))
+		{
+			continue;
+		}
+
+		request.itemid = item->itemid;
+		request.value_type = item->value_type;
+		zbx_vector_vc_request_append(&requests, request);
+	}
+
+	if (1 < requests.values_num)
+		zbx_vc_prefetch_values(&requests);
+
+	zbx_vector_vc_request_destroy(&requests);
+}
+
 static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_uint64_t *history_itemids,
 		const zbx_history_sync_item_t *history_items, const int *history_errcodes,
 		zbx_history_sync_item_t **items, int **items_err, int *items_num)
@@ -5601,6 +5671,9 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_u
 				(size_t)itemids.values_num, ZBX_ITEM_GET_SYNC);
 	}
 
+	zbx_prefetch_item_functions(funcs, history_itemids, history_items, history_errcodes, &itemids, *items,
+			*items_err);
+
 	zbx_hashset_iter_reset(funcs, &iter);
 	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
 	{
@@ -5971,7 +6044,7 @@ void	zbx_evaluate_expressions(zbx_vector_ptr_t *triggers, const zbx_vector_uint6
 	zbx_db_event		event;
 	DC_TRIGGER		*tr;
 	zbx_history_sync_item_t	*items = NULL;
-	int			i, *items_err, items_num = 0;
+	int			i, *items_err = NULL, items_num = 0;
 	double			expr_result;
 	zbx_dc_um_handle_t	*um_handle;
 	zbx_vector_uint64_t	hostids;
@@ -82,6 +82,27 @@
  *  lo_bound             `size' fields in chunk B                   hi_bound  *
  *  (aligned)            have SHMEM_FLG_USED bit set               (aligned)  *
  *                                                                            *
+ * (*) slabs: optional (ZBX_SHMEM_FLAG_SLABS) fixed size pieces of memory     *
+ *     carved from the top of chunk area, each serving objects of one size    *
+ *     class without boundary tags                                            *
+ *                                                                            *
+ *                 +------------------ slabs ------------------+              *
+ *                 |                                           |              *
+ *     chunks      v                                           v              *
+ *  ---...----|----|--------- slab ---------|--- slab ---...---|              *
+ *                 ^                                           ^              *
+ *                 |                                           |              *
+ *              hi_bound                                    slab_hi           *
+ *                                                                            *
+ *     hi_bound moves down by SHMEM_SLAB_SIZE when a new slab is carved from  *
+ *     the last (free) chunk and up when the lowest slab becomes empty        *
+ *                                                                            *
+ *     a slab starts with zbx_shmem_slab_t header followed by objects, freed  *
+ *     objects are kept in singly-linked list, never used objects are handed  *
+ *     out sequentially from the slab tail                                    *
+ *                                                                            *
+ *     the slab of an object is found by its offset from slab_hi              *
+ *                                                                            *
  ******************************************************************************/
 
 static void	*ALIGN4(void *ptr);
@@ -118,6 +139,40 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr);
 #define SHMEM_MIN_SIZE		__UINT64_C(128)
 #define SHMEM_MAX_SIZE		__UINT64_C(0x1000000000)	/* 64 GB */
 
+#define SHMEM_SLAB_SIZE		__UINT64_C(65536)
+#define SHMEM_SLAB_MAX_ALLOC	256
+#define SHMEM_SLAB_UNASSIGNED	ZBX_SHMEM_SLAB_CLASS_COUNT
+
+typedef struct zbx_shmem_slab
+{
+	struct zbx_shmem_slab	*prev;
+	struct zbx_shmem_slab	*next;
+	void			*free_list;
+	unsigned int		index;		/* size class index or SHMEM_SLAB_UNASSIGNED */
+	unsigned int		used;
+	unsigned int		capacity;
+	unsigned int		carved;		/* number of objects handed out from the slab tail */
+}
+zbx_shmem_slab_t;
+
+#define SHMEM_SLAB_HEADER_SIZE	((sizeof(zbx_shmem_slab_t) + 7) & ~(size_t)7)
+
+struct zbx_shmem_slab_class
+{
+	zbx_shmem_slab_t	*partial;	/* slabs with free objects */
+	unsigned int		slabs_num;
+	unsigned int		used_objects;
+	unsigned int		free_objects;
+};
+
+static const zbx_uint64_t	slab_class_sizes[ZBX_SHMEM_SLAB_CLASS_COUNT] = {
+		24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256};
+
+/* size class index by allocation size in 8 byte units */
+static const unsigned char	slab_class_by_units[SHMEM_SLAB_MAX_ALLOC / 8 + 1] = {
+		0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9, 9,
+		10, 10, 10, 10, 11, 11, 11, 11, 12, 12, 12, 12, 13, 13, 13, 13};
+
 /* helper functions */
 
 static void	*ALIGN4(void *ptr)
@@ -524,13 +579,675 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr)
 	}
 }
 
+/* size class slab functions */
+
+static void	mem_slab_link(zbx_shmem_slab_t **head, zbx_shmem_slab_t *slab)
+{
+	slab->prev = NULL;
+	slab->next = *head;
+
+	if (NULL != *head)
+		(*head)->prev = slab;
+
+	*head = slab;
+}
+
+static void	mem_slab_unlink(zbx_shmem_slab_t **head, zbx_shmem_slab_t *slab)
+{
+	if (NULL != slab->prev)
+		slab->prev->next = slab->next;
+	else
+		*head = slab->next;
+
+	if (NULL != slab->next)
+		slab->next->prev = slab->prev;
+
+	slab->prev = NULL;
+	slab->next = NULL;
+}
+
+static int	mem_is_slab_ptr(const zbx_shmem_info_t *info, const void *ptr)
+{
+	return (info->hi_bound <= ptr && ptr < info->slab_hi);
+}
+
+static zbx_shmem_slab_t	*mem_slab_by_ptr(const zbx_shmem_info_t *info, const void *ptr)
+{
+	zbx_uint64_t	offset = (zbx_uint64_t)((const char *)info->slab_hi - (const char *)ptr);
+
+	return (zbx_shmem_slab_t *)((char *)info->slab_hi - ((offset - 1) / SHMEM_SLAB_SIZE + 1) * SHMEM_SLAB_SIZE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: carve new slab from the last chunk if it's free and large enough  *
+ *                                                                            *
+ * Comments: Unassigned slab memory is accounted as free, so free size is not *
+ *           changed.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_shmem_slab_t	*mem_slab_carve(zbx_shmem_info_t *info)
+{
+	void		*chunk, *last_size_field = (char *)info->hi_bound - SHMEM_SIZE_FIELD;
+	zbx_uint64_t	chunk_size;
+
+	if (!FREE_CHUNK(last_size_field))
+		return NULL;
+
+	if ((chunk_size = CHUNK_SIZE(last_size_field)) < SHMEM_SLAB_SIZE + SHMEM_MIN_ALLOC)
+		return NULL;
+
+	chunk = (char *)last_size_field - chunk_size - SHMEM_SIZE_FIELD;
+
+	mem_unlink_chunk(info, chunk);
+	mem_set_chunk_size(chunk, chunk_size - SHMEM_SLAB_SIZE);
+	mem_link_chunk(info, chunk);
+
+	info->hi_bound = (char *)info->hi_bound - SHMEM_SLAB_SIZE;
+
+	return (zbx_shmem_slab_t *)info->hi_bound;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: return the lowest slab back to the chunk area                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	mem_slab_return(zbx_shmem_info_t *info)
+{
+	void	*last_size_field = (char *)info->hi_bound - SHMEM_SIZE_FIELD, *chunk;
+
+	if (FREE_CHUNK(last_size_field))
+	{
+		zbx_uint64_t	chunk_size = CHUNK_SIZE(last_size_field);
+
+		chunk = (char *)last_size_field - chunk_size - SHMEM_SIZE_FIELD;
+		mem_unlink_chunk(info, chunk);
+		mem_set_chunk_size(chunk, chunk_size + SHMEM_SLAB_SIZE);
+	}
+	else
+	{
+		chunk = info->hi_bound;
+		mem_set_chunk_size(chunk, SHMEM_SLAB_SIZE - 2 * SHMEM_SIZE_FIELD);
+		info->free_size -= 2 * SHMEM_SIZE_FIELD;
+	}
+
+	mem_link_chunk(info, chunk);
+	info->hi_bound = (char *)info->hi_bound + SHMEM_SLAB_SIZE;
+}
+
+static void	mem_slab_assign(zbx_shmem_info_t *info, zbx_shmem_slab_t *slab, unsigned int index)
+{
+	zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[index];
+	zbx_uint64_t		overhead;
+
+	slab->index = index;
+	slab->used = 0;
+	slab->carved = 0;
+	slab->free_list = NULL;
+	slab->capacity = (unsigned int)((SHMEM_SLAB_SIZE - SHMEM_SLAB_HEADER_SIZE) / slab_class_sizes[index]);
+
+	overhead = SHMEM_SLAB_SIZE - slab->capacity * slab_class_sizes[index];
+	info->free_size -= overhead;
+	info->slab_overhead += overhead;
+
+	slab_class->slabs_num++;
+	slab_class->free_objects += slab->capacity;
+	mem_slab_link(&slab_class->partial, slab);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: release empty slab, returning it to the chunk area if it's the    *
+ *          lowest one                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	mem_slab_release(zbx_shmem_info_t *info, zbx_shmem_slab_t *slab)
+{
+	zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[slab->index];
+	zbx_uint64_t		overhead;
+
+	mem_slab_unlink(&slab_class->partial, slab);
+	slab_class->slabs_num--;
+	slab_class->free_objects -= slab->capacity;
+
+	overhead = SHMEM_SLAB_SIZE - slab->capacity * slab_class_sizes[slab->index];
+	info->free_size += overhead;
+	info->slab_overhead -= overhead;
+
+	slab->index = SHMEM_SLAB_UNASSIGNED;
+
+	if ((void *)slab != info->hi_bound)
+	{
+		mem_slab_link((zbx_shmem_slab_t **)&info->slab_empty, slab);
+		return;
+	}
+
+	mem_slab_return(info);
+
+	while (info->hi_bound < info->slab_hi)
+	{
+		slab = (zbx_shmem_slab_t *)info->hi_bound;
+
+		if (SHMEM_SLAB_UNASSIGNED != slab->index)
+			break;
+
+		mem_slab_unlink((zbx_shmem_slab_t **)&info->slab_empty, slab);
+		mem_slab_return(info);
+	}
+}
+
+static void	*mem_slab_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	unsigned int		index = slab_class_by_units[(size + 7) >> 3];
+	zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[index];
+	zbx_shmem_slab_t	*slab;
+	void			*ptr;
+
+	if (NULL == (slab = slab_class->partial))
+	{
+		if (NULL != (slab = (zbx_shmem_slab_t *)info->slab_empty))
+			mem_slab_unlink((zbx_shmem_slab_t **)&info->slab_empty, slab);
+		else if (NULL == (slab = mem_slab_carve(info)))
+			return NULL;
+
+		mem_slab_assign(info, slab, index);
+	}
+
+	if (NULL != (ptr = slab->free_list))
+		slab->free_list = *(void **)ptr;
+	else
+		ptr = (char *)slab + SHMEM_SLAB_HEADER_SIZE + slab->carved++ * slab_class_sizes[index];
+
+	if (++slab->used == slab->capacity)
+		mem_slab_unlink(&slab_class->partial, slab);
+
+	slab_class->used_objects++;
+	slab_class->free_objects--;
+	info->used_size += slab_class_sizes[index];
+	info->free_size -= slab_class_sizes[index];
+
+	return ptr;
+}
+
+static void	mem_slab_free(zbx_shmem_info_t *info, void *ptr)
+{
+	zbx_shmem_slab_t	*slab = mem_slab_by_ptr(info, ptr);
+	zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[slab->index];
+
+	*(void **)ptr = slab->free_list;
+	slab->free_list = ptr;
+
+	slab_class->used_objects--;
+	slab_class->free_objects++;
+	info->used_size -= slab_class_sizes[slab->index];
+	info->free_size += slab_class_sizes[slab->index];
+
+	if (slab->used-- == slab->capacity)
+		mem_slab_link(&slab_class->partial, slab);
+
+	if (0 == slab->used)
+		mem_slab_release(info, slab);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocate memory, trying size class slabs first if enabled         *
+ *                                                                            *
+ * Return value: pointer to the allocated memory or NULL                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	*mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	void	*chunk;
+
+	if (NULL != info->slab_classes && SHMEM_SLAB_MAX_ALLOC >= size)
+	{
+		void	*ptr;
+
+		if (NULL != (ptr = mem_slab_malloc(info, size)))
+			return ptr;
+	}
+
+	if (NULL == (chunk = __mem_malloc(info, size)))
+		return NULL;
+
+	return (void *)((char *)chunk + SHMEM_SIZE_FIELD);
+}
+
+static void	*mem_slab_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size)
+{
+	zbx_uint64_t	old_size = slab_class_sizes[mem_slab_by_ptr(info, old)->index];
+	void		*ptr;
+
+	if (size <= old_size)
+		return old;
+
+	if (NULL == (ptr = mem_malloc(info, size)))
+		return NULL;
+
+	memcpy(ptr, old, old_size);
+	mem_slab_free(info, old);
+
+	return ptr;
+}
+
+static void	mem_slabs_init(zbx_shmem_info_t *info)
+{
+	void	*chunk;
+
+	if (NULL == (chunk = __mem_malloc(info, sizeof(zbx_shmem_slab_class_t) * ZBX_SHMEM_SLAB_CLASS_COUNT)))
+		return;
+
+	info->slab_classes = (zbx_shmem_slab_class_t *)((char *)chunk + SHMEM_SIZE_FIELD);
+	memset(info->slab_classes, 0, sizeof(zbx_shmem_slab_class_t) * ZBX_SHMEM_SLAB_CLASS_COUNT);
+}
+
+/* configured page backing and NUMA policy of shared memory segments, by configuration parameter name, */
+/* sharded caches create several segments for the same parameter                                       */
+typedef struct
+{
+	char			*param;
+	int			huge_pages;
+	zbx_shmem_numa_t	numa;
+	zbx_shmem_info_t	**segments;
+	int			segments_num;
+	int			segments_alloc;
+}
+zbx_shmem_placement_t;
+
+#define SHMEM_PLACEMENT_MAX	16
+
+static zbx_shmem_placement_t	shmem_placements[SHMEM_PLACEMENT_MAX];
+static int			shmem_placements_num;
+
+#define SHMEM_NUMA_NODES_BITS	(8 * sizeof(unsigned long))
+
+/* kernel memory policy modes, see set_mempolicy(2) */
+#define SHMEM_MPOL_BIND		2
+#define SHMEM_MPOL_INTERLEAVE	3
+
+static zbx_shmem_placement_t	*shmem_get_placement(const char *param)
+{
+	int	i;
+
+	for (i = 0; i < shmem_placements_num; i++)
+	{
+		if (0 == strcmp(shmem_placements[i].param, param))
+			return &shmem_placements[i];
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses NUMA node list in the format used by sysfs (e.g. "0,2-3")  *
+ *                                                                            *
+ * Parameters: str   - [IN] node list                                         *
+ *             nodes - [OUT] node bitmask                                     *
+ *                                                                            *
+ * Return value: SUCCEED - node list was parsed successfully                  *
+ *               FAIL    - invalid node list                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	shmem_parse_numa_nodes(const char *str, unsigned long *nodes)
+{
+	const char	*ptr = str;
+
+	memset(nodes, 0, ZBX_SHMEM_NUMA_NODES_MAX / 8);
+
+	while (1)
+	{
+		char	*end;
+		long	first, last;
+
+		if (0 == isdigit((unsigned char)*ptr))
+			return FAIL;
+
+		first = last = strtol(ptr, &end, 10);
+
+		if ('-' == *end)
+		{
+			ptr = end + 1;
+
+			if (0 == isdigit((unsigned char)*ptr))
+				return FAIL;
+
+			last = strtol(ptr, &end, 10);
+		}
+
+		if (first > last || ZBX_SHMEM_NUMA_NODES_MAX <= last)
+			return FAIL;
+
+		for (; first <= last; first++)
+			nodes[first / SHMEM_NUMA_NODES_BITS] |= 1UL << (first % SHMEM_NUMA_NODES_BITS);
+
+		if ('\0' == *end)
+			return SUCCEED;
+
+		if (',' != *end)
+			return FAIL;
+
+		ptr = end + 1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets size of the default huge page                                *
+ *                                                                            *
+ * Return value: huge page size in bytes or 0 if huge pages are not supported *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	shmem_get_huge_page_size(void)
+{
+	FILE		*f;
+	char		line[MAX_STRING_LEN];
+	zbx_uint64_t	size = 0;
+
+	if (NULL == (f = fopen("/proc/meminfo", "r")))
+		return 0;
+
+	while (NULL != fgets(line, sizeof(line), f))
+	{
+		if (1 == sscanf(line, "Hugepagesize: " ZBX_FS_UI64 " kB", &size))
+		{
+			size *= ZBX_KIBIBYTE;
+			break;
+		}
+	}
+
+	zbx_fclose(f);
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocates shared memory segment, backed by huge pages if          *
+ *          requested and available                                           *
+ *                                                                            *
+ * Parameters: size       - [IN] requested segment size                       *
+ *             huge_pages - [IN] 1 - try huge pages first, 0 - normal pages   *
+ *             descr      - [IN] segment description for logging              *
+ *             pages      - [OUT] page backing the segment got                *
+ *             page_size  - [OUT] size of the backing pages                   *
+ *                                                                            *
+ * Return value: shared memory identifier or -1 on error                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	shmem_get_segment(zbx_uint64_t size, int huge_pages, const char *descr, int *pages,
+		zbx_uint64_t *page_size)
+{
+	*pages = ZBX_SHMEM_PAGES_NORMAL;
+	*page_size = (zbx_uint64_t)getpagesize();
+
+	if (0 != huge_pages)
+	{
+#ifdef SHM_HUGETLB
+		zbx_uint64_t	huge_page_size;
+		int		shm_id;
+
+		if (0 != (huge_page_size = shmem_get_huge_page_size()))
+		{
+			zbx_uint64_t	huge_size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+			if (-1 != (shm_id = shmget(IPC_PRIVATE, huge_size, 0600 | SHM_HUGETLB)))
+			{
+				*pages = ZBX_SHMEM_PAGES_HUGE;
+				*page_size = huge_page_size;
+				return shm_id;
+			}
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot allocate " ZBX_FS_UI64 " bytes of huge pages for %s,"
+					" falling back to normal pages: %s", huge_size, descr, zbx_strerror(errno));
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "huge pages are not supported by the system, using normal"
+					" pages for %s", descr);
+		}
+#else
+		zabbix_log(LOG_LEVEL_WARNING, "huge pages are not supported on this platform, using normal pages"
+				" for %s", descr);
+#endif
+	}
+
+	return shmget(IPC_PRIVATE, size, 0600);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies NUMA memory policy to shared memory segment before its    *
+ *          pages are touched                                                 *
+ *                                                                            *
+ * Parameters: base  - [IN] segment address                                   *
+ *             size  - [IN] segment size                                      *
+ *             numa  - [IN] NUMA policy, NULL for default policy              *
+ *             descr - [IN] segment description for logging                   *
+ *                                                                            *
+ * Return value: NUMA policy actually applied to the segment                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	shmem_apply_numa_policy(void *base, zbx_uint64_t size, const zbx_shmem_numa_t *numa, const char *descr)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+	unsigned long	nodes[ZBX_SHMEM_NUMA_NODES_MAX / SHMEM_NUMA_NODES_BITS];
+	int		mode, i;
+
+	if (NULL == numa || ZBX_SHMEM_NUMA_DEFAULT == numa->policy)
+		return ZBX_SHMEM_NUMA_DEFAULT;
+
+	memcpy(nodes, numa->nodes, sizeof(nodes));
+
+	for (i = 0; i < (int)ARRSIZE(nodes) && 0 == nodes[i]; i++)
+		;
+
+	/* interleaving without explicit node list spreads memory across all online nodes */
+	if (ARRSIZE(nodes) == i)
+	{
+		FILE	*f;
+		char	line[MAX_STRING_LEN];
+		int	ret = FAIL;
+
+		if (NULL != (f = fopen("/sys/devices/system/node/online", "r")))
+		{
+			if (NULL != fgets(line, sizeof(line), f))
+			{
+				zbx_rtrim(line, "\n");
+				ret = shmem_parse_numa_nodes(line, nodes);
+			}
+
+			zbx_fclose(f);
+		}
+
+		if (SUCCEED != ret)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot obtain online NUMA nodes, using default memory policy"
+					" for %s", descr);
+			return ZBX_SHMEM_NUMA_DEFAULT;
+		}
+	}
+
+	mode = (ZBX_SHMEM_NUMA_BIND == numa->policy ? SHMEM_MPOL_BIND : SHMEM_MPOL_INTERLEAVE);
+
+	if (0 != syscall(SYS_mbind, base, (unsigned long)size, mode, nodes, ZBX_SHMEM_NUMA_NODES_MAX + 1, 0))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot set %s NUMA memory policy for %s, using default policy: %s",
+				zbx_shmem_numa_policy_string(numa->policy), descr, zbx_strerror(errno));
+		return ZBX_SHMEM_NUMA_DEFAULT;
+	}
+
+	return numa->policy;
+#else
+	ZBX_UNUSED(base);
+	ZBX_UNUSED(size);
+
+	if (NULL != numa && ZBX_SHMEM_NUMA_DEFAULT != numa->policy)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "NUMA memory policy is not supported on this platform, using default"
+				" policy for %s", descr);
+	}
+
+	return ZBX_SHMEM_NUMA_DEFAULT;
+#endif
+}
+
 /* public memory interface */
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses NUMA memory policy configuration value                     *
+ *                                                                            *
+ * Parameters: str   - [IN] policy: default, interleave[:<nodes>] or          *
+ *                          bind:<nodes>                                      *
+ *             numa  - [OUT] parsed policy                                    *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - policy was parsed successfully                     *
+ *               FAIL    - invalid policy                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_shmem_parse_numa_policy(const char *str, zbx_shmem_numa_t *numa, char **error)
+{
+	const char	*nodes = NULL;
+
+	memset(numa, 0, sizeof(zbx_shmem_numa_t));
+
+	if (NULL == str || '\0' == *str || 0 == strcmp(str, "default"))
+	{
+		numa->policy = ZBX_SHMEM_NUMA_DEFAULT;
+		return SUCCEED;
+	}
+
+	if (0 == strncmp(str, "interleave", ZBX_CONST_STRLEN("interleave")))
+	{
+		numa->policy = ZBX_SHMEM_NUMA_INTERLEAVE;
+		nodes = str + ZBX_CONST_STRLEN("interleave");
+
+		if ('\0' == *nodes)
+			return SUCCEED;
+	}
+	else if (0 == strncmp(str, "bind", ZBX_CONST_STRLEN("bind")))
+	{
+		numa->policy = ZBX_SHMEM_NUMA_BIND;
+		nodes = str + ZBX_CONST_STRLEN("bind");
+	}
+	else
+	{
+		*error = zbx_dsprintf(*error, "unknown policy \"%s\"", str);
+		return FAIL;
+	}
+
+	if (':' != *nodes || SUCCEED != shmem_parse_numa_nodes(nodes + 1, numa->nodes))
+	{
+		*error = zbx_dsprintf(*error, "invalid NUMA node list in \"%s\"", str);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: configures page backing and NUMA policy of shared memory segment  *
+ *          to be created later for the specified configuration parameter     *
+ *                                                                            *
+ * Parameters: param       - [IN] configuration parameter defining segment    *
+ *                                size, e.g. "CacheSize"                      *
+ *             huge_pages  - [IN] 1 - back segment with huge pages if         *
+ *                                available, 0 - use normal pages             *
+ *             numa_policy - [IN] NUMA policy, see                            *
+ *                                zbx_shmem_parse_numa_policy()               *
+ *             error       - [OUT] error message                              *
+ *                                                                            *
+ * Return value: SUCCEED - placement was configured                           *
+ *               FAIL    - invalid NUMA policy                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_shmem_set_placement(const char *param, int huge_pages, const char *numa_policy, char **error)
+{
+	zbx_shmem_placement_t	*placement;
+	zbx_shmem_numa_t	numa;
+
+	if (SUCCEED != zbx_shmem_parse_numa_policy(numa_policy, &numa, error))
+		return FAIL;
+
+	if (NULL == (placement = shmem_get_placement(param)))
+	{
+		if (SHMEM_PLACEMENT_MAX == shmem_placements_num)
+		{
+			*error = zbx_strdup(*error, "too many shared memory segments");
+			return FAIL;
+		}
+
+		placement = &shmem_placements[shmem_placements_num++];
+		placement->param = zbx_strdup(NULL, param);
+		placement->segments = NULL;
+		placement->segments_num = 0;
+		placement->segments_alloc = 0;
+	}
+
+	placement->huge_pages = huge_pages;
+	placement->numa = numa;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets page backing and NUMA policy shared memory segment got       *
+ *                                                                            *
+ * Parameters: param       - [IN] configuration parameter defining segment    *
+ *                                size, e.g. "CacheSize"                      *
+ *             segment     - [IN] index of segment created for the parameter, *
+ *                                sharded caches have several segments        *
+ *             pages       - [OUT] ZBX_SHMEM_PAGES_* page backing             *
+ *             numa_policy - [OUT] ZBX_SHMEM_NUMA_* policy                    *
+ *                                                                            *
+ * Return value: SUCCEED - segment placement was returned                     *
+ *               FAIL    - segment for the parameter is not allocated         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_shmem_get_placement(const char *param, int segment, int *pages, int *numa_policy)
+{
+	zbx_shmem_placement_t	*placement;
+
+	if (NULL == (placement = shmem_get_placement(param)) || 0 > segment || segment >= placement->segments_num)
+		return FAIL;
+
+	*pages = placement->segments[segment]->pages;
+	*numa_policy = placement->segments[segment]->numa_policy;
+
+	return SUCCEED;
+}
+
+const char	*zbx_shmem_pages_string(int pages)
+{
+	return ZBX_SHMEM_PAGES_HUGE == pages ? "huge" : "normal";
+}
+
+const char	*zbx_shmem_numa_policy_string(int numa_policy)
+{
+	switch (numa_policy)
+	{
+		case ZBX_SHMEM_NUMA_INTERLEAVE:
+			return "interleave";
+		case ZBX_SHMEM_NUMA_BIND:
+			return "bind";
+		default:
+			return "default";
+	}
+}
+
 int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
-		int allow_oom, char **error)
+		int allow_oom, int flags, char **error)
 {
-	int	shm_id, index, ret = FAIL;
-	void	*base;
+	int			shm_id, index, pages, numa_policy, ret = FAIL;
+	void			*base;
+	zbx_uint64_t		page_size;
+	zbx_shmem_placement_t	*placement;
 
 	descr = ZBX_NULL2STR(descr);
 	param = ZBX_NULL2STR(param);
@@ -553,7 +1270,10 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 		goto out;
 	}
 
-	if (-1 == (shm_id = shmget(IPC_PRIVATE, size, 0600)))
+	placement = shmem_get_placement(param);
+
+	if (-1 == (shm_id = shmem_get_segment(size, NULL != placement ? placement->huge_pages : 0, descr, &pages,
+			&page_size)))
 	{
 		*error = zbx_dsprintf(*error, "cannot get private shared memory of size " ZBX_FS_SIZE_T " for %s: %s",
 				(zbx_fs_size_t)size, descr, zbx_strerror(errno));
@@ -569,6 +1289,10 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 	if (-1 == shmctl(shm_id, IPC_RMID, NULL))
 		zbx_error("cannot mark shared memory %d for destruction: %s", shm_id, zbx_strerror(errno));
 
+	/* huge page mappings cannot be split, so policy must cover whole pages */
+	numa_policy = shmem_apply_numa_policy(base, (size + page_size - 1) / page_size * page_size,
+			NULL != placement ? &placement->numa : NULL, descr);
+
 	ret = SUCCEED;
 
 	/* allocate zbx_shmem_info_t structure, its buckets, and description inside shared memory */
@@ -614,6 +1338,37 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 	(*info)->used_size = 0;
 	(*info)->free_size = (*info)->total_size;
 
+	(*info)->slab_classes = NULL;
+	(*info)->slab_empty = NULL;
+	(*info)->slab_hi = (*info)->hi_bound;
+	(*info)->slab_overhead = 0;
+
+	(*info)->pages = pages;
+	(*info)->numa_policy = numa_policy;
+	(*info)->page_size = page_size;
+
+	if (NULL != placement)
+	{
+		if (placement->segments_num == placement->segments_alloc)
+		{
+			placement->segments_alloc += 8;
+			placement->segments = (zbx_shmem_info_t **)zbx_realloc(placement->segments,
+					sizeof(zbx_shmem_info_t *) * (size_t)placement->segments_alloc);
+		}
+
+		placement->segments[placement->segments_num++] = *info;
+	}
+
+	if (0 != (flags & ZBX_SHMEM_FLAG_SLABS))
+		mem_slabs_init(*info);
+
+	if (ZBX_SHMEM_PAGES_HUGE == pages || ZBX_SHMEM_NUMA_DEFAULT != numa_policy)
+	{
+		zabbix_log(LOG_LEVEL_INFORMATION, "%s uses %s pages of " ZBX_FS_UI64 " bytes with %s NUMA policy",
+				descr, zbx_shmem_pages_string(pages), page_size,
+				zbx_shmem_numa_policy_string(numa_policy));
+	}
+
 	zabbix_log(LOG_LEVEL_DEBUG, "valid user addresses: [%p, %p] total size: " ZBX_FS_SIZE_T,
 			(void *)((char *)(*info)->lo_bound + SHMEM_SIZE_FIELD),
 			(void *)((char *)(*info)->hi_bound - SHMEM_SIZE_FIELD),
@@ -626,12 +1381,30 @@ out:
 
 void	zbx_shmem_destroy(zbx_shmem_info_t *info)
 {
+	int	i, j;
+
+	for (i = 0; i < shmem_placements_num; i++)
+	{
+		zbx_shmem_placement_t	*placement = &shmem_placements[i];
+
+		for (j = 0; j < placement->segments_num; j++)
+		{
+			if (info != placement->segments[j])
+				continue;
+
+			placement->segments_num--;
+			memmove(&placement->segments[j], &placement->segments[j + 1],
+					sizeof(zbx_shmem_info_t *) * (size_t)(placement->segments_num - j));
+			break;
+		}
+	}
+
 	(void)shmdt(info->base);
 }
 
 void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size)
 {
-	void	*chunk;
+	void	*ptr;
 
 	if (NULL != old)
 	{
@@ -647,9 +1420,9 @@ void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, con
 		exit(EXIT_FAILURE);
 	}
 
-	chunk = __mem_malloc(info, size);
+	ptr = mem_malloc(info, size);
 
-	if (NULL == chunk)
+	if (NULL == ptr)
 	{
 		if (1 == info->allow_oom)
 			return NULL;
@@ -664,12 +1437,12 @@ void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, con
 		exit(EXIT_FAILURE);
 	}
 
-	return (void *)((char *)chunk + SHMEM_SIZE_FIELD);
+	return ptr;
 }
 
 void	*__zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, void *old, size_t size)
 {
-	void	*chunk;
+	void	*ptr;
 
 	if (0 == size || size > SHMEM_MAX_SIZE)
 	{
@@ -679,11 +1452,13 @@ void	*__zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, vo
 	}
 
 	if (NULL == old)
-		chunk = __mem_malloc(info, size);
-	else
-		chunk = __mem_realloc(info, old, size);
+		ptr = mem_malloc(info, size);
+	else if (mem_is_slab_ptr(info, old))
+		ptr = mem_slab_realloc(info, old, size);
+	else if (NULL != (ptr = __mem_realloc(info, old, size)))
+		ptr = (void *)((char *)ptr + SHMEM_SIZE_FIELD);
 
-	if (NULL == chunk)
+	if (NULL == ptr)
 	{
 		if (1 == info->allow_oom)
 			return NULL;
@@ -698,7 +1473,7 @@ void	*__zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, vo
 		exit(EXIT_FAILURE);
 	}
 
-	return (void *)((char *)chunk + SHMEM_SIZE_FIELD);
+	return ptr;
 }
 
 void	__zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *ptr)
@@ -709,7 +1484,10 @@ void	__zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *
 		exit(EXIT_FAILURE);
 	}
 
-	__mem_free(info, ptr);
+	if (mem_is_slab_ptr(info, ptr))
+		mem_slab_free(info, ptr);
+	else
+		__mem_free(info, ptr);
 }
 
 void	zbx_shmem_clear(zbx_shmem_info_t *info)
@@ -718,6 +1496,7 @@ void	zbx_shmem_clear(zbx_shmem_info_t *info)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	info->hi_bound = info->slab_hi;
 	memset(info->buckets, 0, ZBX_SHMEM_BUCKET_COUNT * ZBX_PTR_SIZE);
 	index = mem_bucket_by_size(info->total_size);
 	info->buckets[index] = info->lo_bound;
@@ -727,6 +1506,12 @@ void	zbx_shmem_clear(zbx_shmem_info_t *info)
 	info->used_size = 0;
 	info->free_size = info->total_size;
 
+	info->slab_empty = NULL;
+	info->slab_overhead = 0;
+
+	if (NULL != info->slab_classes)
+		mem_slabs_init(info);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -758,9 +1543,64 @@ void	zbx_shmem_get_stats(const zbx_shmem_info_t *info, zbx_shmem_stats_t *stats)
 	}
 
 	stats->overhead = info->total_size - info->used_size - info->free_size;
-	stats->used_chunks = stats->overhead / (2 * SHMEM_SIZE_FIELD) + 1 - stats->free_chunks;
+	stats->used_chunks = (stats->overhead - info->slab_overhead) / (2 * SHMEM_SIZE_FIELD) + 1 - stats->free_chunks;
 	stats->free_size = info->free_size;
 	stats->used_size = info->used_size;
+
+	stats->slab_classes_num = 0;
+	stats->empty_slabs = 0;
+
+	if (NULL != info->slab_classes)
+	{
+		const zbx_shmem_slab_t	*slab;
+
+		stats->slab_classes_num = ZBX_SHMEM_SLAB_CLASS_COUNT;
+
+		for (i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+		{
+			stats->slabs[i].size = slab_class_sizes[i];
+			stats->slabs[i].slabs_num = info->slab_classes[i].slabs_num;
+			stats->slabs[i].used_objects = info->slab_classes[i].used_objects;
+			stats->slabs[i].free_objects = info->slab_classes[i].free_objects;
+		}
+
+		for (slab = (const zbx_shmem_slab_t *)info->slab_empty; NULL != slab; slab = slab->next)
+			stats->empty_slabs++;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add shared memory allocator statistics to the total statistics    *
+ *          of several memory segments                                        *
+ *                                                                            *
+ * Parameters: total - [IN/OUT] the total statistics, initialized with the    *
+ *                              statistics of the first segment               *
+ *             stats - [IN] the statistics to add                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_shmem_add_stats(zbx_shmem_stats_t *total, const zbx_shmem_stats_t *stats)
+{
+	int	i;
+
+	total->free_size += stats->free_size;
+	total->used_size += stats->used_size;
+	total->min_chunk_size = MIN(total->min_chunk_size, stats->min_chunk_size);
+	total->max_chunk_size = MAX(total->max_chunk_size, stats->max_chunk_size);
+	total->overhead += stats->overhead;
+	total->free_chunks += stats->free_chunks;
+	total->used_chunks += stats->used_chunks;
+	total->empty_slabs += stats->empty_slabs;
+
+	for (i = 0; i < ZBX_SHMEM_BUCKET_COUNT; i++)
+		total->chunks_num[i] += stats->chunks_num[i];
+
+	for (i = 0; i < (int)stats->slab_classes_num && i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+	{
+		total->slabs[i].slabs_num += stats->slabs[i].slabs_num;
+		total->slabs[i].used_objects += stats->slabs[i].used_objects;
+		total->slabs[i].free_objects += stats->slabs[i].free_objects;
+	}
 }
 
 void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
@@ -794,6 +1634,19 @@ void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
 	zabbix_log(level, "of those, %10llu bytes are used by allocation overhead",
 			(unsigned long long)stats.overhead);
 
+	for (i = 0; i < (int)stats.slab_classes_num; i++)
+	{
+		if (0 == stats.slabs[i].slabs_num)
+			continue;
+
+		zabbix_log(level, "slabs of size %3llu bytes: %6u with %8u used and %8u free objects",
+				(unsigned long long)stats.slabs[i].size, stats.slabs[i].slabs_num,
+				stats.slabs[i].used_objects, stats.slabs[i].free_objects);
+	}
+
+	if (0 != stats.slab_classes_num)
+		zabbix_log(level, "empty slabs: %u", stats.empty_slabs);
+
 	zabbix_log(level, "================================");
 }
 
@@ -402,7 +402,7 @@ int	zbx_tfc_init(zbx_uint64_t cache_size, char **error)
 		goto out;
 
 	if (SUCCEED != zbx_shmem_create(&tfc_mem, cache_size, "trend function cache size",
-			"TrendFunctionCacheSize", 1, error))
+			"TrendFunctionCacheSize", 1, 0, error))
 	{
 		goto out;
 	}
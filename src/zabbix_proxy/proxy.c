@@ -287,6 +287,9 @@ zbx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 0;
+int		CONFIG_TRENDS_FLUSH_SPREAD	= 0;
+char		*CONFIG_HISTORY_SPILL_FILE	= NULL;
+zbx_uint64_t	CONFIG_HISTORY_SPILL_SIZE	= ZBX_GIBIBYTE;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
 
@@ -801,6 +804,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheSpillFile",	&CONFIG_HISTORY_SPILL_FILE,		TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"HistoryCacheSpillSize",	&CONFIG_HISTORY_SPILL_SIZE,		TYPE_UINT64,
+			PARM_OPT,	ZBX_MEBIBYTE,		__UINT64_C(1024) * ZBX_GIBIBYTE},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"ProxyLocalBuffer",		&CONFIG_PROXY_LOCAL_BUFFER,		TYPE_INT,
@@ -1505,6 +1512,9 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		thread_args.info.server_num = i + 1;
 		thread_args.args = NULL;
 
+		/* configuration cache lock wait slot is inherited by the forked process */
+		zbx_dc_set_lock_wait_process(thread_args.info.process_type, thread_args.info.process_num);
+
 		switch (thread_args.info.process_type)
 		{
 			case ZBX_PROCESS_TYPE_CONFSYNCER:
@@ -1592,6 +1602,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
 		}
+
+		zbx_dc_set_lock_wait_process(ZBX_PROCESS_TYPE_UNKNOWN, 0);
 	}
 
 	zbx_unset_exit_on_terminate();
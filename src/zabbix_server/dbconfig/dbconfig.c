@@ -40,7 +40,7 @@ extern int		CONFIG_CONFSYNCER_FREQUENCY;
 ZBX_THREAD_ENTRY(dbconfig_thread, args)
 {
 	double			sec = 0.0;
-	int			nextcheck = 0, sleeptime, secrets_reload = 0, cache_reload = 0;
+	int			nextcheck = 0, sleeptime, secrets_reload = 0, cache_reload = 0, snapshot = FAIL;
 	zbx_ipc_async_socket_t	rtc;
 	const zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
 	int			server_num = ((zbx_thread_args_t *)args)->info.server_num;
@@ -63,7 +63,19 @@ ZBX_THREAD_ENTRY(dbconfig_thread, args)
 
 	sec = zbx_time();
 	zbx_setproctitle("%s [syncing configuration]", get_process_type_string(process_type));
+
+	if (NULL != dbconfig_args_in->config_cache_snapshot_file)
+	{
+		snapshot = zbx_dc_config_load_snapshot(dbconfig_args_in->config_cache_snapshot_file,
+				dbconfig_args_in->config_cache_snapshot_source);
+	}
+
 	DCsync_configuration(ZBX_DBSYNC_INIT, ZBX_SYNCED_NEW_CONFIG_NO, NULL, dbconfig_args_in->config_vault);
+
+	/* apply the changes made after configuration cache snapshot was written */
+	if (SUCCEED == snapshot)
+		DCsync_configuration(ZBX_DBSYNC_UPDATE, ZBX_SYNCED_NEW_CONFIG_NO, NULL, dbconfig_args_in->config_vault);
+
 	DCsync_kvs_paths(NULL, dbconfig_args_in->config_vault);
 	zbx_setproctitle("%s [synced configuration in " ZBX_FS_DBL " sec, idle %d sec]",
 			get_process_type_string(process_type), (sec = zbx_time() - sec), CONFIG_CONFSYNCER_FREQUENCY);
@@ -147,6 +159,8 @@ ZBX_THREAD_ENTRY(dbconfig_thread, args)
 				get_process_type_string(process_type), sec, CONFIG_CONFSYNCER_FREQUENCY);
 	}
 stop:
+	zbx_dc_config_save_snapshot();
+
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
 
 	while (1)
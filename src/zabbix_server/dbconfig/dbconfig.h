@@ -27,6 +27,8 @@ typedef struct
 {
 	zbx_config_vault_t	*config_vault;
 	int			config_timeout;
+	const char		*config_cache_snapshot_file;
+	const char		*config_cache_snapshot_source;
 }
 zbx_thread_dbconfig_args;
 
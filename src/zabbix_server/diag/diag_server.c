@@ -84,10 +84,44 @@ static void	diag_valuecache_add_items(struct zbx_json *json, const char *field,
 	zbx_json_close(json);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add valuecache admission/eviction policy statistics to json       *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_valuecache_add_policy(struct zbx_json *json, const char *field,
+		const zbx_vc_policy_stats_t *policy)
+{
+	zbx_uint64_t	requests;
+
+	requests = policy->hits_probation + policy->hits_protected + policy->misses;
+
+	zbx_json_addobject(json, field);
+
+	zbx_json_addobject(json, "probation");
+	zbx_json_adduint64(json, "items", policy->items_probation);
+	zbx_json_adduint64(json, "hits", policy->hits_probation);
+	zbx_json_addfloat(json, "hits.percent", 0 == requests ? 0 : 100.0 * policy->hits_probation / requests);
+	zbx_json_close(json);
+
+	zbx_json_addobject(json, "protected");
+	zbx_json_adduint64(json, "items", policy->items_protected);
+	zbx_json_adduint64(json, "hits", policy->hits_protected);
+	zbx_json_addfloat(json, "hits.percent", 0 == requests ? 0 : 100.0 * policy->hits_protected / requests);
+	zbx_json_close(json);
+
+	zbx_json_adduint64(json, "misses", policy->misses);
+	zbx_json_adduint64(json, "evictions", policy->evictions);
+	zbx_json_adduint64(json, "admission.rejected", policy->admissions_rejected);
+
+	zbx_json_close(json);
+}
+
 #define ZBX_DIAG_VALUECACHE_ITEMS		0x00000001
 #define ZBX_DIAG_VALUECACHE_VALUES		0x00000002
 #define ZBX_DIAG_VALUECACHE_MODE		0x00000004
 #define ZBX_DIAG_VALUECACHE_MEMORY		0x00000008
+#define ZBX_DIAG_VALUECACHE_POLICY		0x00000010
 
 #define ZBX_DIAG_VALUECACHE_SIMPLE	(ZBX_DIAG_VALUECACHE_ITEMS | \
 					ZBX_DIAG_VALUECACHE_VALUES | \
@@ -112,11 +146,13 @@ static int	diag_add_valuecache_info(const struct zbx_json_parse *jp, struct zbx_
 	double			time1, time2, time_total = 0;
 	zbx_uint64_t		fields;
 	zbx_diag_map_t		field_map[] = {
-					{"", ZBX_DIAG_VALUECACHE_SIMPLE | ZBX_DIAG_VALUECACHE_MEMORY},
+					{"", ZBX_DIAG_VALUECACHE_SIMPLE | ZBX_DIAG_VALUECACHE_MEMORY |
+							ZBX_DIAG_VALUECACHE_POLICY},
 					{"items", ZBX_DIAG_VALUECACHE_ITEMS},
 					{"values", ZBX_DIAG_VALUECACHE_VALUES},
 					{"mode", ZBX_DIAG_VALUECACHE_MODE},
 					{"memory", ZBX_DIAG_VALUECACHE_MEMORY},
+					{"policy", ZBX_DIAG_VALUECACHE_POLICY},
 					{NULL, 0}
 					};
 
@@ -156,6 +192,18 @@ static int	diag_add_valuecache_info(const struct zbx_json_parse *jp, struct zbx_
 			zbx_diag_add_mem_stats(json, "memory", &mem);
 		}
 
+		if (0 != (fields & ZBX_DIAG_VALUECACHE_POLICY))
+		{
+			zbx_vc_policy_stats_t	policy;
+
+			time1 = zbx_time();
+			zbx_vc_get_policy_stats(&policy);
+			time2 = zbx_time();
+			time_total += time2 - time1;
+
+			diag_valuecache_add_policy(json, "policy", &policy);
+		}
+
 		if (0 != tops.values_num)
 		{
 			zbx_vector_ptr_t	items;
@@ -216,6 +264,7 @@ out:
 #undef ZBX_DIAG_VALUECACHE_VALUES
 #undef ZBX_DIAG_VALUECACHE_MODE
 #undef ZBX_DIAG_VALUECACHE_MEMORY
+#undef ZBX_DIAG_VALUECACHE_POLICY
 
 /******************************************************************************
  *                                                                            *
@@ -215,7 +215,7 @@ static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, int con
 			case SVC_SNMPv3:
 				memset(&item, 0, sizeof(DC_ITEM));
 
-				zbx_strscpy(item.key_orig, dcheck->key_);
+				item.key_orig = dcheck->key_;
 				item.key = item.key_orig;
 
 				item.interface.useip = 1;
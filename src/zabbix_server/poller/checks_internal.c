@@ -30,6 +30,7 @@
 #include "zbxnum.h"
 #include "zbxsysinfo.h"
 #include "zbx_host_constants.h"
+#include "zbxshmem.h"
 
 extern unsigned char	program_type;
 extern int		CONFIG_FORKS[ZBX_PROCESS_TYPE_COUNT];
@@ -171,6 +172,65 @@ static int	zbx_host_interfaces_discovery(zbx_uint64_t hostid, struct zbx_json *j
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get page backing or NUMA policy of shared memory cache            *
+ *                                                                            *
+ * Parameters: param  - [IN] cache size configuration parameter               *
+ *             mode   - [IN] "pages" or "numa"                                *
+ *             result - [OUT] value of the requested item                     *
+ *                                                                            *
+ * Return value: SUCCEED - value successfully retrieved and stored in result  *
+ *               FAIL    - cache is not allocated, error message is stored in *
+ *                         result                                             *
+ *                                                                            *
+ * Comments: Sharded caches consist of several segments. If the segments are  *
+ *           placed differently, the comma separated list of every segment    *
+ *           placement is returned.                                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_get_shmem_placement_value(const char *param, const char *mode, AGENT_RESULT *result)
+{
+	int		pages, numa_policy, segment, mixed = 0;
+	char		*value = NULL;
+	size_t		value_alloc = 0, value_offset = 0;
+	const char	*str, *first = NULL;
+
+	for (segment = 0; SUCCEED == zbx_shmem_get_placement(param, segment, &pages, &numa_policy); segment++)
+	{
+		if (0 == strcmp(mode, "pages"))
+			str = zbx_shmem_pages_string(pages);
+		else
+			str = zbx_shmem_numa_policy_string(numa_policy);
+
+		if (NULL == first)
+			first = str;
+		else if (0 != strcmp(first, str))
+			mixed = 1;
+
+		if (0 != value_offset)
+			zbx_chrcpy_alloc(&value, &value_alloc, &value_offset, ',');
+
+		zbx_strcpy_alloc(&value, &value_alloc, &value_offset, str);
+	}
+
+	if (NULL == first)
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cache is not allocated."));
+		return FAIL;
+	}
+
+	if (0 == mixed)
+	{
+		zbx_free(value);
+		value = zbx_strdup(NULL, first);
+	}
+
+	SET_STR_RESULT(result, value);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieve data from Zabbix server (internally supported items)     *
@@ -589,6 +649,11 @@ int	get_value_internal(const DC_ITEM *item, AGENT_RESULT *result, const zbx_conf
 				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_HISTORY_FREE));
 			else if (0 == strcmp(tmp1, "pused"))
 				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_HISTORY_PUSED));
+			else if (0 == strcmp(tmp1, "pages") || 0 == strcmp(tmp1, "numa"))
+			{
+				if (SUCCEED != zbx_get_shmem_placement_value("HistoryCacheSize", tmp1, result))
+					goto out;
+			}
 			else
 			{
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
@@ -613,6 +678,11 @@ int	get_value_internal(const DC_ITEM *item, AGENT_RESULT *result, const zbx_conf
 				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_TREND_FREE));
 			else if (0 == strcmp(tmp1, "pused"))
 				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_TREND_PUSED));
+			else if (0 == strcmp(tmp1, "pages") || 0 == strcmp(tmp1, "numa"))
+			{
+				if (SUCCEED != zbx_get_shmem_placement_value("TrendCacheSize", tmp1, result))
+					goto out;
+			}
 			else
 			{
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
@@ -637,6 +707,46 @@ int	get_value_internal(const DC_ITEM *item, AGENT_RESULT *result, const zbx_conf
 				goto out;
 			}
 		}
+		else if (0 == strcmp(tmp, "spill"))
+		{
+			if (NULL == tmp1 || '\0' == *tmp1 || 0 == strcmp(tmp1, "values"))
+				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_SPILL_VALUES));
+			else if (0 == strcmp(tmp1, "total"))
+				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_SPILL_TOTAL));
+			else if (0 == strcmp(tmp1, "used"))
+				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_SPILL_USED));
+			else if (0 == strcmp(tmp1, "free"))
+				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_SPILL_FREE));
+			else if (0 == strcmp(tmp1, "pused"))
+				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_SPILL_PUSED));
+			else
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+		}
+		else if (0 == strcmp(tmp, "sync"))
+		{
+			if (NULL == tmp1 || '\0' == *tmp1 || 0 == strcmp(tmp1, "batches"))
+				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_SYNC_BATCHES));
+			else if (0 == strcmp(tmp1, "items"))
+				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_SYNC_ITEMS));
+			else if (0 == strcmp(tmp1, "history"))
+				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_SYNC_HISTORY));
+			else if (0 == strcmp(tmp1, "trends"))
+				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_SYNC_TRENDS));
+			else if (0 == strcmp(tmp1, "triggers"))
+				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_SYNC_TRIGGERS));
+			else if (0 == strcmp(tmp1, "events"))
+				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_SYNC_EVENTS));
+			else if (0 == strcmp(tmp1, "commit"))
+				SET_DBL_RESULT(result, *(double *)DCget_stats(ZBX_STATS_SYNC_COMMIT));
+			else
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+		}
 		else
 		{
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
@@ -666,12 +776,29 @@ int	get_value_internal(const DC_ITEM *item, AGENT_RESULT *result, const zbx_conf
 				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCconfig_get_stats(ZBX_CONFSTATS_BUFFER_FREE));
 			else if (0 == strcmp(tmp1, "pused"))
 				SET_DBL_RESULT(result, *(double *)DCconfig_get_stats(ZBX_CONFSTATS_BUFFER_PUSED));
+			else if (0 == strcmp(tmp1, "pages") || 0 == strcmp(tmp1, "numa"))
+			{
+				if (SUCCEED != zbx_get_shmem_placement_value("CacheSize", tmp1, result))
+					goto out;
+			}
 			else
 			{
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
 				goto out;
 			}
 		}
+		else if (0 == strcmp(tmp, "lockwait"))	/* zabbix[rcache,lockwait,<process type>] */
+		{
+			int	process_type;
+
+			if (NULL == tmp1 || ZBX_PROCESS_TYPE_UNKNOWN == (process_type = get_process_type_by_name(tmp1)))
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+
+			SET_DBL_RESULT(result, zbx_dc_get_lock_wait((unsigned char)process_type));
+		}
 		else
 		{
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
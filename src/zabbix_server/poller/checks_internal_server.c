@@ -166,6 +166,11 @@ int	zbx_get_value_internal_ext(const char *param1, const AGENT_REQUEST *request,
 			else if (0 == strcmp(param3, "pused"))
 				SET_DBL_RESULT(result, (double)(stats.total_size - stats.free_size) /
 						stats.total_size * 100);
+			else if (0 == strcmp(param3, "pages") || 0 == strcmp(param3, "numa"))
+			{
+				if (SUCCEED != zbx_get_shmem_placement_value("ValueCacheSize", param3, result))
+					goto out;
+			}
 			else
 			{
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
@@ -492,11 +492,6 @@ void	zbx_prepare_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *res
 
 				if (ZBX_IF_SNMP_VERSION_3 == items[i].snmp_version)
 				{
-					ZBX_STRDUP(items[i].snmpv3_securityname, items[i].snmpv3_securityname_orig);
-					ZBX_STRDUP(items[i].snmpv3_authpassphrase, items[i].snmpv3_authpassphrase_orig);
-					ZBX_STRDUP(items[i].snmpv3_privpassphrase, items[i].snmpv3_privpassphrase_orig);
-					ZBX_STRDUP(items[i].snmpv3_contextname, items[i].snmpv3_contextname_orig);
-
 					zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &items[i].host.hostid,
 							NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 							&items[i].snmpv3_securityname, MACRO_TYPE_COMMON, NULL,
@@ -515,9 +510,6 @@ void	zbx_prepare_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *res
 							0);
 				}
 
-				ZBX_STRDUP(items[i].snmp_community, items[i].snmp_community_orig);
-				ZBX_STRDUP(items[i].snmp_oid, items[i].snmp_oid_orig);
-
 				zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
 						NULL, NULL, NULL, NULL, NULL, NULL, &items[i].snmp_community,
 						MACRO_TYPE_COMMON, NULL, 0);
@@ -533,8 +525,6 @@ void	zbx_prepare_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *res
 				if (MACRO_EXPAND_NO == expand_macros)
 					break;
 
-				ZBX_STRDUP(items[i].timeout, items[i].timeout_orig);
-
 				zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL, NULL,
 						NULL, NULL, NULL, NULL, NULL, &items[i].timeout, MACRO_TYPE_COMMON,
 						NULL, 0);
@@ -549,9 +539,6 @@ void	zbx_prepare_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *res
 				if (MACRO_EXPAND_NO == expand_macros)
 					break;
 
-				ZBX_STRDUP(items[i].publickey, items[i].publickey_orig);
-				ZBX_STRDUP(items[i].privatekey, items[i].privatekey_orig);
-
 				zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL, NULL,
 						NULL, NULL, NULL, NULL, NULL, &items[i].publickey, MACRO_TYPE_COMMON,
 						NULL, 0);
@@ -571,9 +558,6 @@ void	zbx_prepare_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *res
 				if (MACRO_EXPAND_NO == expand_macros)
 					break;
 
-				items[i].username = zbx_strdup(items[i].username, items[i].username_orig);
-				items[i].password = zbx_strdup(items[i].password, items[i].password_orig);
-
 				zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
 						NULL, NULL, NULL, NULL, NULL, NULL, &items[i].username,
 						MACRO_TYPE_COMMON, NULL, 0);
@@ -585,10 +569,6 @@ void	zbx_prepare_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *res
 				if (MACRO_EXPAND_NO == expand_macros)
 					break;
 
-				items[i].username = zbx_strdup(items[i].username, items[i].username_orig);
-				items[i].password = zbx_strdup(items[i].password, items[i].password_orig);
-				items[i].jmx_endpoint = zbx_strdup(items[i].jmx_endpoint, items[i].jmx_endpoint_orig);
-
 				zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
 						NULL, NULL, NULL, NULL, NULL, NULL, &items[i].username,
 						MACRO_TYPE_COMMON, NULL, 0);
@@ -602,17 +582,6 @@ void	zbx_prepare_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *res
 			case ITEM_TYPE_HTTPAGENT:
 				if (MACRO_EXPAND_YES == expand_macros)
 				{
-					ZBX_STRDUP(items[i].timeout, items[i].timeout_orig);
-					ZBX_STRDUP(items[i].url, items[i].url_orig);
-					ZBX_STRDUP(items[i].status_codes, items[i].status_codes_orig);
-					ZBX_STRDUP(items[i].http_proxy, items[i].http_proxy_orig);
-					ZBX_STRDUP(items[i].ssl_cert_file, items[i].ssl_cert_file_orig);
-					ZBX_STRDUP(items[i].ssl_key_file, items[i].ssl_key_file_orig);
-					ZBX_STRDUP(items[i].ssl_key_password, items[i].ssl_key_password_orig);
-					ZBX_STRDUP(items[i].username, items[i].username_orig);
-					ZBX_STRDUP(items[i].password, items[i].password_orig);
-					ZBX_STRDUP(items[i].query_fields, items[i].query_fields_orig);
-
 					zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
 							NULL, NULL, NULL, NULL, NULL, NULL, &items[i].timeout,
 							MACRO_TYPE_COMMON, NULL, 0);
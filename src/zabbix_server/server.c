@@ -77,6 +77,7 @@
 #include "diag/diag_server.h"
 #include "zbxip.h"
 #include "zbxsysinfo.h"
+#include "zbxshmem.h"
 #include "zbx_rtc_constants.h"
 #include "zbxthreads.h"
 #include "zbxicmpping.h"
@@ -340,10 +341,24 @@ zbx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 32 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
+int		CONFIG_TRENDS_FLUSH_SPREAD	= 0;
+char		*CONFIG_HISTORY_SPILL_FILE	= NULL;
+zbx_uint64_t	CONFIG_HISTORY_SPILL_SIZE	= ZBX_GIBIBYTE;
 static zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
 
+static int	CONFIG_SHMEM_HUGE_PAGES			= 0;
+static char	*CONFIG_CONF_CACHE_NUMA_POLICY		= NULL;
+static char	*CONFIG_HISTORY_CACHE_NUMA_POLICY	= NULL;
+static char	*CONFIG_TRENDS_CACHE_NUMA_POLICY	= NULL;
+static char	*CONFIG_VALUE_CACHE_NUMA_POLICY		= NULL;
+static char	*CONFIG_CONF_CACHE_SNAPSHOT_FILE	= NULL;
+static char	*CONFIG_VALUE_CACHE_SNAPSHOT_FILE	= NULL;
+
+/* the database identity, cache snapshots can be used only with the database they were written from */
+static char	cache_snapshot_source[MAX_STRING_LEN];
+
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
@@ -673,6 +688,33 @@ static void	zbx_set_defaults(void)
 		CONFIG_NODE_ADDRESS = zbx_strdup(CONFIG_NODE_ADDRESS, "localhost");
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validates and sets huge page and NUMA placement of shared memory  *
+ *          cache                                                             *
+ *                                                                            *
+ * Parameters: param      - [IN] cache size configuration parameter           *
+ *             numa_param - [IN] cache NUMA policy configuration parameter    *
+ *             numa       - [IN] cache NUMA policy                            *
+ *                                                                            *
+ * Return value: SUCCEED - placement is valid                                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	validate_shmem_placement(const char *param, const char *numa_param, const char *numa)
+{
+	char	*error = NULL;
+
+	if (SUCCEED != zbx_shmem_set_placement(param, CONFIG_SHMEM_HUGE_PAGES, numa, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "invalid \"%s\" configuration parameter: %s", numa_param, error);
+		zbx_free(error);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: validate configuration parameters                                 *
@@ -713,6 +755,21 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (NULL != CONFIG_VALUE_CACHE_SNAPSHOT_FILE && NULL != CONFIG_HA_NODE_NAME && '\0' != *CONFIG_HA_NODE_NAME)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"ValueCacheSnapshotFile\" configuration parameter cannot be used in"
+				" high availability cluster");
+		err = 1;
+	}
+
+	err |= (FAIL == validate_shmem_placement("CacheSize", "CacheNUMAPolicy", CONFIG_CONF_CACHE_NUMA_POLICY));
+	err |= (FAIL == validate_shmem_placement("HistoryCacheSize", "HistoryCacheNUMAPolicy",
+			CONFIG_HISTORY_CACHE_NUMA_POLICY));
+	err |= (FAIL == validate_shmem_placement("TrendCacheSize", "TrendCacheNUMAPolicy",
+			CONFIG_TRENDS_CACHE_NUMA_POLICY));
+	err |= (FAIL == validate_shmem_placement("ValueCacheSize", "ValueCacheNUMAPolicy",
+			CONFIG_VALUE_CACHE_NUMA_POLICY));
+
 	if (NULL != CONFIG_SOURCE_IP && SUCCEED != zbx_is_supported_ip(CONFIG_SOURCE_IP))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SourceIP\" configuration parameter: '%s'", CONFIG_SOURCE_IP);
@@ -861,14 +918,34 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheSpillFile",	&CONFIG_HISTORY_SPILL_FILE,		TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"HistoryCacheSpillSize",	&CONFIG_HISTORY_SPILL_SIZE,		TYPE_UINT64,
+			PARM_OPT,	ZBX_MEBIBYTE,		__UINT64_C(1024) * ZBX_GIBIBYTE},
 		{"TrendCacheSize",		&CONFIG_TRENDS_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"TrendFlushSpread",		&CONFIG_TRENDS_FLUSH_SPREAD,		TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_MIN * 30},
 		{"TrendFunctionCacheSize",	&CONFIG_TREND_FUNC_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"ValueCacheSize",		&CONFIG_VALUE_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"ValueCacheSnapshotFile",	&CONFIG_VALUE_CACHE_SNAPSHOT_FILE,	TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"SharedMemoryHugePages",	&CONFIG_SHMEM_HUGE_PAGES,		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"CacheNUMAPolicy",		&CONFIG_CONF_CACHE_NUMA_POLICY,		TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"HistoryCacheNUMAPolicy",	&CONFIG_HISTORY_CACHE_NUMA_POLICY,	TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"TrendCacheNUMAPolicy",	&CONFIG_TRENDS_CACHE_NUMA_POLICY,	TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"ValueCacheNUMAPolicy",	&CONFIG_VALUE_CACHE_NUMA_POLICY,	TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"CacheUpdateFrequency",	&CONFIG_CONFSYNCER_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
+		{"CacheSnapshotFile",		&CONFIG_CONF_CACHE_SNAPSHOT_FILE,	TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"MaxHousekeeperDelete",	&CONFIG_MAX_HOUSEKEEPER_DELETE,		TYPE_INT,
@@ -1120,7 +1197,21 @@ static void	zbx_on_exit(int ret)
 		zbx_ipc_service_free_env();
 		free_configuration_cache();
 
-		/* free history value cache */
+		/* free history value cache, the snapshot is saved only on clean shutdown because */
+		/* after a child process failure the cache might be inconsistent with database   */
+		if (NULL != CONFIG_VALUE_CACHE_SNAPSHOT_FILE)
+		{
+			if (SUCCEED == ret)
+			{
+				zbx_vc_save_snapshot(CONFIG_VALUE_CACHE_SNAPSHOT_FILE, cache_snapshot_source);
+			}
+			else
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "value cache snapshot is not saved because server is"
+						" stopping after failure");
+			}
+		}
+
 		zbx_vc_destroy();
 
 		/* free vmware support */
@@ -1403,7 +1494,8 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 	zbx_thread_housekeeper_args	housekeeper_args = {&db_version_info, config_timeout};
 	zbx_thread_server_trigger_housekeeper_args	trigger_housekeeper_args = {config_timeout};
 	zbx_thread_taskmanager_args	taskmanager_args = {config_timeout, config_startup_time};
-	zbx_thread_dbconfig_args	dbconfig_args = {&zbx_config_vault, config_timeout};
+	zbx_thread_dbconfig_args	dbconfig_args = {&zbx_config_vault, config_timeout,
+							CONFIG_CONF_CACHE_SNAPSHOT_FILE, cache_snapshot_source};
 	zbx_thread_pinger_args		pinger_args = {config_timeout};
 
 #ifdef HAVE_OPENIPMI
@@ -1427,6 +1519,9 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 		return FAIL;
 	}
 
+	zbx_snprintf(cache_snapshot_source, sizeof(cache_snapshot_source), "%s:%d/%s/%s", CONFIG_DBHOST,
+			CONFIG_DBPORT, CONFIG_DBNAME, ZBX_NULL2EMPTY_STR(CONFIG_DBSCHEMA));
+
 	if (SUCCEED != zbx_init_selfmon_collector(get_config_forks, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize self-monitoring: %s", error);
@@ -1448,6 +1543,9 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 		return FAIL;
 	}
 
+	if (NULL != CONFIG_VALUE_CACHE_SNAPSHOT_FILE)
+		zbx_vc_load_snapshot(CONFIG_VALUE_CACHE_SNAPSHOT_FILE, cache_snapshot_source);
+
 	if (SUCCEED != zbx_tfc_init(CONFIG_TREND_FUNC_CACHE_SIZE, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize trends read cache: %s", error);
@@ -1488,6 +1586,9 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 		thread_args.info.server_num = i + 1;
 		thread_args.args = NULL;
 
+		/* configuration cache lock wait slot is inherited by the forked process */
+		zbx_dc_set_lock_wait_process(thread_args.info.process_type, thread_args.info.process_num);
+
 		switch (thread_args.info.process_type)
 		{
 			case ZBX_PROCESS_TYPE_SERVICEMAN:
@@ -1652,6 +1753,8 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
 		}
+
+		zbx_dc_set_lock_wait_process(ZBX_PROCESS_TYPE_UNKNOWN, 0);
 	}
 
 	/* startup/postinit tasks can take a long time, update status */
@@ -160,7 +160,7 @@ int	zbx_trapper_item_test_run(const struct zbx_json_parse *jp_data, zbx_uint64_t
 		table_items = zbx_db_get_table("items");
 
 	db_uchar_from_json(jp_data, ZBX_PROTO_TAG_TYPE, table_items, "type", &item.type);
-	db_string_from_json(jp_data, ZBX_PROTO_TAG_KEY, table_items, "key_", item.key_orig, sizeof(item.key_orig));
+	item.key_orig = db_string_from_json_dyn(jp_data, ZBX_PROTO_TAG_KEY, table_items, "key_");
 	item.key = db_string_from_json_dyn(jp_data, ZBX_PROTO_TAG_KEY, table_items, "key_");
 
 	if (0 != proxy_hostid && FAIL == is_item_processed_by_server(item.type, item.key))
@@ -182,8 +182,7 @@ int	zbx_trapper_item_test_run(const struct zbx_json_parse *jp_data, zbx_uint64_t
 	db_uchar_from_json(jp_data, ZBX_PROTO_TAG_VERIFY_PEER, table_items, "verify_peer", &item.verify_peer);
 	db_uchar_from_json(jp_data, ZBX_PROTO_TAG_VERIFY_HOST, table_items, "verify_host", &item.verify_host);
 
-	db_string_from_json(jp_data, ZBX_PROTO_TAG_IPMI_SENSOR, table_items, "ipmi_sensor", item.ipmi_sensor,
-			sizeof(item.ipmi_sensor));
+	item.ipmi_sensor = db_string_from_json_dyn(jp_data, ZBX_PROTO_TAG_IPMI_SENSOR, table_items, "ipmi_sensor");
 
 	item.snmp_oid = db_string_from_json_dyn(jp_data, ZBX_PROTO_TAG_SNMP_OID, table_items, "snmp_oid");
 	item.params = db_string_from_json_dyn(jp_data, ZBX_PROTO_TAG_PARAMS, table_items, "params");
@@ -399,7 +398,9 @@ int	zbx_trapper_item_test_run(const struct zbx_json_parse *jp_data, zbx_uint64_t
 
 	zbx_clean_items(&item, 1, &result);
 out:
+	zbx_free(item.key_orig);
 	zbx_free(item.key);
+	zbx_free(item.ipmi_sensor);
 	zbx_free(item.snmp_oid);
 	zbx_free(item.params);
 	zbx_free(item.username);
@@ -10022,7 +10022,7 @@ int	zbx_vmware_init(char **error)
 	CONFIG_VMWARE_CACHE_SIZE -= size_reserved;
 
 	if (SUCCEED != zbx_shmem_create(&vmware_mem, CONFIG_VMWARE_CACHE_SIZE, "vmware cache size", "VMwareCacheSize",
-			0, error))
+			0, 0, error))
 	{
 		goto out;
 	}
@@ -0,0 +1,329 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* zbxalgo container benchmarks on config cache like workloads */
+
+#include "zbxbench.h"
+#include "zbxalgo.h"
+
+#define BENCH_ENTRIES_NUM	1000000
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	data[7];
+}
+bench_entry_t;
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	int		nextcheck;
+}
+bench_queue_item_t;
+
+static void	bench_hashset(zbx_bench_t *bench, const zbx_uint64_t *ids, const zbx_uint64_t *lookup, int num)
+{
+	zbx_hashset_t		hs;
+	zbx_hashset_iter_t	iter;
+	bench_entry_t		entry = {0}, *ptr;
+	int			i, found = 0;
+
+	zbx_hashset_create(&hs, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		entry.id = ids[i];
+		zbx_hashset_insert(&hs, &entry, sizeof(entry));
+	}
+	zbx_bench_stop(bench, "hashset_insert", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		if (NULL != zbx_hashset_search(&hs, &lookup[i]))
+			found++;
+	}
+	zbx_bench_stop(bench, "hashset_search_hit", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		zbx_uint64_t	id = ids[i] + 1;
+
+		if (NULL != zbx_hashset_search(&hs, &id))
+			found++;
+	}
+	zbx_bench_stop(bench, "hashset_search_miss", num);
+
+	zbx_bench_start(bench);
+	zbx_hashset_iter_reset(&hs, &iter);
+	while (NULL != (ptr = (bench_entry_t *)zbx_hashset_iter_next(&iter)))
+		found += (int)(ptr->data[0]);
+	zbx_bench_stop(bench, "hashset_iterate", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+		zbx_hashset_remove(&hs, &lookup[i]);
+	zbx_bench_stop(bench, "hashset_remove", num);
+
+	zbx_hashset_destroy(&hs);
+
+	if (found != num)
+		fprintf(stderr, "hashset: found %d entries out of %d\n", found, num);
+}
+
+static void	bench_flatset(zbx_bench_t *bench, const zbx_uint64_t *ids, const zbx_uint64_t *lookup, int num)
+{
+	zbx_flatset_t		fs;
+	zbx_flatset_iter_t	iter;
+	bench_entry_t		entry = {0}, *ptr;
+	int			i, found = 0;
+
+	zbx_flatset_create(&fs, 100);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		entry.id = ids[i];
+		zbx_flatset_insert(&fs, &entry, sizeof(entry));
+	}
+	zbx_bench_stop(bench, "flatset_insert", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		if (NULL != zbx_flatset_search(&fs, &lookup[i]))
+			found++;
+	}
+	zbx_bench_stop(bench, "flatset_search_hit", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		zbx_uint64_t	id = ids[i] + 1;
+
+		if (NULL != zbx_flatset_search(&fs, &id))
+			found++;
+	}
+	zbx_bench_stop(bench, "flatset_search_miss", num);
+
+	zbx_bench_start(bench);
+	zbx_flatset_iter_reset(&fs, &iter);
+	while (NULL != (ptr = (bench_entry_t *)zbx_flatset_iter_next(&iter)))
+		found += (int)(ptr->data[0]);
+	zbx_bench_stop(bench, "flatset_iterate", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+		zbx_flatset_remove(&fs, &lookup[i]);
+	zbx_bench_stop(bench, "flatset_remove", num);
+
+	zbx_flatset_destroy(&fs);
+
+	if (found != num)
+		fprintf(stderr, "flatset: found %d entries out of %d\n", found, num);
+}
+
+static int	bench_nextcheck_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+
+	const bench_queue_item_t	*i1 = (const bench_queue_item_t *)e1->data;
+	const bench_queue_item_t	*i2 = (const bench_queue_item_t *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
+
+	return 0;
+}
+
+/* mimics poller queue: items are scheduled, rescheduled and popped by nextcheck */
+static void	bench_binary_heap(zbx_bench_t *bench, const zbx_uint64_t *ids, int num)
+{
+	zbx_binary_heap_t	heap;
+	bench_queue_item_t	*items;
+	int			i;
+
+	items = (bench_queue_item_t *)zbx_malloc(NULL, sizeof(bench_queue_item_t) * (size_t)num);
+
+	for (i = 0; i < num; i++)
+	{
+		items[i].itemid = ids[i];
+		items[i].nextcheck = rand() % 3600;
+	}
+
+	zbx_binary_heap_create(&heap, bench_nextcheck_compare, ZBX_BINARY_HEAP_OPTION_DIRECT);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		zbx_binary_heap_elem_t	elem = {items[i].itemid, (const void *)&items[i]};
+
+		zbx_binary_heap_insert(&heap, &elem);
+	}
+	zbx_bench_stop(bench, "binary_heap_insert", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		zbx_binary_heap_elem_t	elem = {items[i].itemid, (const void *)&items[i]};
+
+		items[i].nextcheck += 1 + rand() % 60;
+		zbx_binary_heap_update_direct(&heap, &elem);
+	}
+	zbx_bench_stop(bench, "binary_heap_update", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+		zbx_binary_heap_remove_min(&heap);
+	zbx_bench_stop(bench, "binary_heap_remove_min", num);
+
+	zbx_binary_heap_destroy(&heap);
+	zbx_free(items);
+}
+
+static int	bench_node_compare(const void *d1, const void *d2)
+{
+	const zbx_timing_wheel_node_t	*n1 = (const zbx_timing_wheel_node_t *)d1;
+	const zbx_timing_wheel_node_t	*n2 = (const zbx_timing_wheel_node_t *)d2;
+
+	const bench_queue_item_t	*i1 = (const bench_queue_item_t *)n1->data;
+	const bench_queue_item_t	*i2 = (const bench_queue_item_t *)n2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->itemid, i2->itemid);
+
+	return 0;
+}
+
+/* same workload as bench_binary_heap(), items are popped by advancing wheel one second at a time */
+static void	bench_timing_wheel(zbx_bench_t *bench, const zbx_uint64_t *ids, int num)
+{
+	zbx_timing_wheel_t	wheel;
+	zbx_timing_wheel_node_t	*nodes, *node;
+	bench_queue_item_t	*items;
+	int			i, now, popped = 0;
+
+	items = (bench_queue_item_t *)zbx_malloc(NULL, sizeof(bench_queue_item_t) * (size_t)num);
+	nodes = (zbx_timing_wheel_node_t *)zbx_malloc(NULL, sizeof(zbx_timing_wheel_node_t) * (size_t)num);
+
+	for (i = 0; i < num; i++)
+	{
+		items[i].itemid = ids[i];
+		items[i].nextcheck = rand() % 3600;
+		nodes[i].data = &items[i];
+	}
+
+	zbx_timing_wheel_create(&wheel, 0, bench_node_compare);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+		zbx_timing_wheel_insert(&wheel, &nodes[i], items[i].nextcheck);
+	zbx_bench_stop(bench, "timing_wheel_insert", num);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		items[i].nextcheck += 1 + rand() % 60;
+		zbx_timing_wheel_update(&wheel, &nodes[i], items[i].nextcheck);
+	}
+	zbx_bench_stop(bench, "timing_wheel_update", num);
+
+	zbx_bench_start(bench);
+	for (now = 0; popped < num; now++)
+	{
+		zbx_timing_wheel_advance(&wheel, now);
+
+		while (NULL != (node = zbx_timing_wheel_first_expired(&wheel)))
+		{
+			zbx_timing_wheel_remove(&wheel, node);
+			popped++;
+		}
+	}
+	zbx_bench_stop(bench, "timing_wheel_remove_min", num);
+
+	zbx_timing_wheel_destroy(&wheel);
+	zbx_free(nodes);
+	zbx_free(items);
+}
+
+static void	bench_vector_sort(zbx_bench_t *bench, const zbx_uint64_t *lookup, int num)
+{
+	zbx_vector_uint64_t	ids;
+
+	zbx_vector_uint64_create(&ids);
+	zbx_vector_uint64_reserve(&ids, (size_t)num);
+	memcpy(ids.values, lookup, sizeof(zbx_uint64_t) * (size_t)num);
+	ids.values_num = num;
+
+	zbx_bench_start(bench);
+	zbx_vector_uint64_sort(&ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_bench_stop(bench, "vector_uint64_sort_random", num);
+
+	zbx_bench_start(bench);
+	zbx_vector_uint64_sort(&ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_bench_stop(bench, "vector_uint64_sort_sorted", num);
+
+	zbx_bench_start(bench);
+	zbx_vector_uint64_uniq(&ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_bench_stop(bench, "vector_uint64_uniq", num);
+
+	zbx_vector_uint64_destroy(&ids);
+}
+
+int	main(int argc, char **argv)
+{
+	zbx_bench_t	bench;
+	zbx_uint64_t	*ids, *lookup;
+	int		i, num;
+
+	zbx_bench_init(&bench, "algo", argc, argv);
+	num = zbx_bench_scale(&bench, BENCH_ENTRIES_NUM);
+
+	ids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)num);
+	lookup = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)num);
+
+	/* item identifiers are mostly sequential with gaps left by removed items */
+	srand(0);
+	ids[0] = 10000;
+	for (i = 1; i < num; i++)
+		ids[i] = ids[i - 1] + 2 + (zbx_uint64_t)(rand() % 3) * 2;
+
+	memcpy(lookup, ids, sizeof(zbx_uint64_t) * (size_t)num);
+	for (i = num - 1; 0 < i; i--)
+	{
+		int		j = rand() % (i + 1);
+		zbx_uint64_t	tmp = lookup[i];
+
+		lookup[i] = lookup[j];
+		lookup[j] = tmp;
+	}
+
+	bench_hashset(&bench, ids, lookup, num);
+	bench_flatset(&bench, ids, lookup, num);
+	bench_binary_heap(&bench, ids, num);
+	bench_timing_wheel(&bench, ids, num);
+	bench_vector_sort(&bench, lookup, num);
+
+	zbx_free(lookup);
+	zbx_free(ids);
+
+	return 0;
+}
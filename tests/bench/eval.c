@@ -0,0 +1,91 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* expression parsing and evaluation benchmarks */
+
+#include "zbxbench.h"
+#include "zbxeval.h"
+#include "zbxvariant.h"
+
+#define BENCH_EVAL_EXPRESSIONS	100000
+
+#define BENCH_EVAL_RULES	(ZBX_EVAL_PARSE_MATH | ZBX_EVAL_PARSE_COMPARE | ZBX_EVAL_PARSE_LOGIC |	\
+				ZBX_EVAL_PARSE_VAR | ZBX_EVAL_PARSE_GROUP | ZBX_EVAL_PARSE_FUNCTION)
+
+static const char	*bench_expressions[] = {
+	"1 + 2 * 3 - 4 / 5",
+	"(10.5 > 3 and 2 < 7) or not (1 = 0)",
+	"abs(-15.3) + min(1, 2, 3, 4) * max(5, 6) > 20",
+	"\"value\" = \"value\" and length(\"abcdef\") = 6",
+	"((1 + 2) * (3 + 4) - (5 - 6) / 7) * 1K + 1M / 1G"
+};
+
+int	main(int argc, char **argv)
+{
+	zbx_bench_t		bench;
+	zbx_eval_context_t	ctx[ARRSIZE(bench_expressions)];
+	zbx_timespec_t		ts = {0, 0};
+	zbx_variant_t		value;
+	char			*error = NULL;
+	int			i, num;
+
+	zbx_bench_init(&bench, "eval", argc, argv);
+	num = zbx_bench_scale(&bench, BENCH_EVAL_EXPRESSIONS);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < num; i++)
+	{
+		zbx_eval_context_t	eval;
+
+		if (SUCCEED != zbx_eval_parse_expression(&eval, bench_expressions[i % ARRSIZE(bench_expressions)],
+				BENCH_EVAL_RULES, &error))
+		{
+			fprintf(stderr, "cannot parse expression: %s\n", error);
+			exit(EXIT_FAILURE);
+		}
+		zbx_eval_clear(&eval);
+	}
+	zbx_bench_stop(&bench, "eval_parse", num);
+
+	for (i = 0; i < (int)ARRSIZE(bench_expressions); i++)
+	{
+		if (SUCCEED != zbx_eval_parse_expression(&ctx[i], bench_expressions[i], BENCH_EVAL_RULES, &error))
+		{
+			fprintf(stderr, "cannot parse expression: %s\n", error);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != zbx_eval_execute(&ctx[i % ARRSIZE(bench_expressions)], &ts, &value, &error))
+		{
+			fprintf(stderr, "cannot evaluate expression: %s\n", error);
+			exit(EXIT_FAILURE);
+		}
+		zbx_variant_clear(&value);
+	}
+	zbx_bench_stop(&bench, "eval_execute", num);
+
+	for (i = 0; i < (int)ARRSIZE(bench_expressions); i++)
+		zbx_eval_clear(&ctx[i]);
+
+	return 0;
+}
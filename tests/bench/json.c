@@ -0,0 +1,160 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* JSON parsing and JSONPath benchmarks on large master item values */
+
+#include "zbxbench.h"
+#include "zbxjson.h"
+#include "zbxstr.h"
+
+#define BENCH_JSON_SIZE		(10 * ZBX_MEBIBYTE)
+#define BENCH_JSON_PASSES	10
+#define BENCH_JSON_QUERIES	1000
+
+/* generates low level discovery like master item value with the specified size */
+static char	*bench_json_generate(size_t size, int *records_num)
+{
+	char	*data = NULL;
+	size_t	data_alloc = 0, data_offset = 0;
+	int	i;
+
+	zbx_strcpy_alloc(&data, &data_alloc, &data_offset, "{\"items\":[");
+
+	for (i = 0; data_offset < size; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(&data, &data_alloc, &data_offset, ',');
+
+		zbx_snprintf_alloc(&data, &data_alloc, &data_offset,
+				"{\"id\":%d,\"name\":\"item %d cpu utilization\",\"status\":\"%s\","
+				"\"value\":%d.%03d,\"tags\":[{\"tag\":\"component\",\"value\":\"cpu\"},"
+				"{\"tag\":\"host\",\"value\":\"host-%d\"}]}",
+				i, i, 0 == i % 10 ? "error" : "ok", rand() % 100, rand() % 1000, i % 1000);
+	}
+
+	zbx_strcpy_alloc(&data, &data_alloc, &data_offset, "]}");
+	*records_num = i;
+
+	return data;
+}
+
+static void	bench_jsonpath_query(zbx_bench_t *bench, const char *data, const char *name, const char *path)
+{
+	struct zbx_json_parse	jp;
+	char			*output = NULL;
+	int			i;
+
+	if (SUCCEED != zbx_json_open(data, &jp))
+	{
+		fprintf(stderr, "cannot open generated JSON: %s\n", zbx_json_strerror());
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_bench_start(bench);
+	for (i = 0; i < BENCH_JSON_PASSES; i++)
+	{
+		if (SUCCEED != zbx_jsonpath_query(&jp, path, &output))
+		{
+			fprintf(stderr, "cannot execute query \"%s\": %s\n", path, zbx_json_strerror());
+			exit(EXIT_FAILURE);
+		}
+		zbx_free(output);
+	}
+	zbx_bench_stop(bench, name, BENCH_JSON_PASSES);
+}
+
+/* mimics dependent items extracting values from a cached master item value */
+static void	bench_jsonobj_query(zbx_bench_t *bench, const char *data, int records_num)
+{
+	zbx_jsonobj_t	obj;
+	char		*output = NULL, path[MAX_STRING_LEN];
+	int		i;
+
+	zbx_bench_start(bench);
+	for (i = 0; i < BENCH_JSON_PASSES; i++)
+	{
+		if (SUCCEED != zbx_jsonobj_open(data, &obj))
+		{
+			fprintf(stderr, "cannot open generated JSON: %s\n", zbx_json_strerror());
+			exit(EXIT_FAILURE);
+		}
+
+		zbx_jsonobj_clear(&obj);
+	}
+	zbx_bench_stop(bench, "jsonobj_open", BENCH_JSON_PASSES);
+
+	if (SUCCEED != zbx_jsonobj_open(data, &obj))
+		exit(EXIT_FAILURE);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < BENCH_JSON_QUERIES; i++)
+	{
+		zbx_snprintf(path, sizeof(path), "$.items[?(@.id == %d)].value.first()",
+				(int)((zbx_uint64_t)i * 7919 % (zbx_uint64_t)records_num));
+
+		if (SUCCEED != zbx_jsonobj_query(&obj, path, &output))
+		{
+			fprintf(stderr, "cannot execute query \"%s\": %s\n", path, zbx_json_strerror());
+			exit(EXIT_FAILURE);
+		}
+		zbx_free(output);
+	}
+	zbx_bench_stop(bench, "jsonobj_query_filter", BENCH_JSON_QUERIES);
+
+	zbx_jsonobj_clear(&obj);
+}
+
+int	main(int argc, char **argv)
+{
+	zbx_bench_t		bench;
+	struct zbx_json_parse	jp;
+	char			*data, path[MAX_STRING_LEN];
+	int			i, records_num;
+
+	zbx_bench_init(&bench, "json", argc, argv);
+
+	srand(0);
+	data = bench_json_generate((size_t)zbx_bench_scale(&bench, BENCH_JSON_SIZE), &records_num);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < BENCH_JSON_PASSES; i++)
+	{
+		if (SUCCEED != zbx_json_open(data, &jp))
+		{
+			fprintf(stderr, "cannot open generated JSON: %s\n", zbx_json_strerror());
+			exit(EXIT_FAILURE);
+		}
+	}
+	zbx_bench_stop(&bench, "json_open", BENCH_JSON_PASSES);
+
+	zbx_snprintf(path, sizeof(path), "$.items[%d].value", records_num / 2);
+	bench_jsonpath_query(&bench, data, "jsonpath_query_index", path);
+
+	zbx_snprintf(path, sizeof(path), "$.items[?(@.id == %d)].name.first()", records_num / 2);
+	bench_jsonpath_query(&bench, data, "jsonpath_query_filter", path);
+
+	bench_jsonpath_query(&bench, data, "jsonpath_query_sum", "$.items[*].value.sum()");
+	bench_jsonpath_query(&bench, data, "jsonpath_query_deep", "$..tags[?(@.tag == \"host\")].value.length()");
+
+	bench_jsonobj_query(&bench, data, records_num);
+
+	zbx_free(data);
+
+	return 0;
+}
@@ -0,0 +1,191 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* item value preprocessing step benchmarks */
+
+#include "zbxbench.h"
+#include "zbxstr.h"
+#include "zbxvariant.h"
+#include "zbxembed.h"
+#include "../../src/zabbix_server/preprocessor/item_preproc.h"
+
+zbx_es_t	es_engine;
+
+#define BENCH_PREPROC_VALUES		100000
+#define BENCH_PREPROC_DEPENDENT_ITEMS	1000
+#define BENCH_PREPROC_MASTER_RECORDS	5000
+
+typedef struct
+{
+	const char	*name;
+	unsigned char	value_type;
+	unsigned char	type;
+	const char	*params;
+	const char	*value;
+}
+bench_preproc_step_t;
+
+static const bench_preproc_step_t	bench_steps[] = {
+	{"preproc_multiplier", ITEM_VALUE_TYPE_FLOAT, ZBX_PREPROC_MULTIPLIER, "8", "12345.678"},
+	{"preproc_trim", ITEM_VALUE_TYPE_STR, ZBX_PREPROC_TRIM, " \t\n", "  \t value with whitespace \n"},
+	{"preproc_regsub", ITEM_VALUE_TYPE_TEXT, ZBX_PREPROC_REGSUB, "load average: ([0-9.]+)\n\\1",
+			"12:00:01 up 10 days,  2:11,  3 users,  load average: 0.52, 0.58, 0.59"},
+	{"preproc_str_replace", ITEM_VALUE_TYPE_STR, ZBX_PREPROC_STR_REPLACE, ",\n.", "1,5"},
+	{"preproc_validate_range", ITEM_VALUE_TYPE_FLOAT, ZBX_PREPROC_VALIDATE_RANGE, "0\n100", "42.5"},
+	{"preproc_hex2dec", ITEM_VALUE_TYPE_UINT64, ZBX_PREPROC_HEX2DEC, "", "7fffffff"},
+	{"preproc_jsonpath", ITEM_VALUE_TYPE_FLOAT, ZBX_PREPROC_JSONPATH, "$.data[2].value",
+			"{\"data\":[{\"name\":\"a\",\"value\":1},{\"name\":\"b\",\"value\":2},"
+			"{\"name\":\"c\",\"value\":3}],\"status\":\"ok\"}"},
+	{"preproc_prometheus_pattern", ITEM_VALUE_TYPE_FLOAT, ZBX_PREPROC_PROMETHEUS_PATTERN,
+			"cpu_seconds_total{mode=\"idle\"}\nvalue\n",
+			"# TYPE cpu_seconds_total counter\n"
+			"cpu_seconds_total{mode=\"idle\"} 12345.67\n"
+			"cpu_seconds_total{mode=\"user\"} 234.5\n"
+			"cpu_seconds_total{mode=\"system\"} 123.4\n"}
+};
+
+static void	bench_preproc_fail(const char *name, char *error)
+{
+	fprintf(stderr, "%s failed: %s\n", name, ZBX_NULL2STR(error));
+	zbx_free(error);
+	exit(EXIT_FAILURE);
+}
+
+/* allocations per operation include duplicating the input value */
+static void	bench_preproc_step(zbx_bench_t *bench, const bench_preproc_step_t *step, int num)
+{
+	zbx_preproc_op_t	op = {step->type, ZBX_PREPROC_FAIL_DEFAULT, (char *)step->params, NULL};
+	zbx_variant_t		value, history_value;
+	zbx_timespec_t		ts = {0, 0}, history_ts = {0, 0};
+	char			*error = NULL;
+	int			i;
+
+	zbx_variant_set_none(&history_value);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		zbx_variant_set_str(&value, zbx_strdup(NULL, step->value));
+
+		if (SUCCEED != zbx_item_preproc(NULL, step->value_type, &value, &ts, &op, &history_value,
+				&history_ts, &error))
+		{
+			bench_preproc_fail(step->name, error);
+		}
+
+		zbx_variant_clear(&value);
+	}
+	zbx_bench_stop(bench, step->name, num);
+}
+
+static void	bench_preproc_delta_speed(zbx_bench_t *bench, int num)
+{
+	zbx_preproc_op_t	op = {ZBX_PREPROC_DELTA_SPEED, ZBX_PREPROC_FAIL_DEFAULT, "", NULL};
+	zbx_variant_t		value, history_value;
+	zbx_timespec_t		ts = {1700000000, 0}, history_ts = {0, 0};
+	char			*error = NULL;
+	int			i;
+
+	zbx_variant_set_none(&history_value);
+
+	zbx_bench_start(bench);
+	for (i = 0; i < num; i++)
+	{
+		zbx_variant_set_ui64(&value, (zbx_uint64_t)i * 1000);
+		ts.sec++;
+
+		if (SUCCEED != zbx_item_preproc(NULL, ITEM_VALUE_TYPE_FLOAT, &value, &ts, &op, &history_value,
+				&history_ts, &error))
+		{
+			bench_preproc_fail("preproc_delta_speed", error);
+		}
+
+		zbx_variant_clear(&value);
+	}
+	zbx_bench_stop(bench, "preproc_delta_speed", num);
+
+	zbx_variant_clear(&history_value);
+}
+
+/* dependent items extracting values from the same master item value through preprocessing cache */
+static void	bench_preproc_dependent(zbx_bench_t *bench, int records_num)
+{
+	zbx_preproc_cache_t	cache;
+	zbx_preproc_op_t	op = {ZBX_PREPROC_JSONPATH, ZBX_PREPROC_FAIL_DEFAULT, NULL, NULL};
+	zbx_variant_t		value, history_value;
+	zbx_timespec_t		ts = {0, 0}, history_ts = {0, 0};
+	char			*data = NULL, *error = NULL, params[MAX_STRING_LEN];
+	size_t			data_alloc = 0, data_offset = 0;
+	int			i;
+
+	zbx_strcpy_alloc(&data, &data_alloc, &data_offset, "[");
+
+	for (i = 0; i < records_num; i++)
+	{
+		zbx_snprintf_alloc(&data, &data_alloc, &data_offset, "%s{\"{#IFNAME}\":\"eth%d\",\"in\":%d,"
+				"\"out\":%d,\"errors\":0}", 0 == i ? "" : ",", i, rand(), rand());
+	}
+
+	zbx_chrcpy_alloc(&data, &data_alloc, &data_offset, ']');
+
+	zbx_variant_set_none(&history_value);
+	op.params = params;
+
+	zbx_bench_start(bench);
+	zbx_preproc_cache_init(&cache);
+
+	for (i = 0; i < BENCH_PREPROC_DEPENDENT_ITEMS; i++)
+	{
+		zbx_snprintf(params, sizeof(params), "$[?(@['{#IFNAME}'] == \"eth%d\")].in.first()",
+				i % records_num);
+		zbx_variant_set_str(&value, zbx_strdup(NULL, data));
+
+		if (SUCCEED != zbx_item_preproc(&cache, ITEM_VALUE_TYPE_UINT64, &value, &ts, &op, &history_value,
+				&history_ts, &error))
+		{
+			bench_preproc_fail("preproc_jsonpath_dependent", error);
+		}
+
+		zbx_variant_clear(&value);
+	}
+
+	zbx_preproc_cache_clear(&cache);
+	zbx_bench_stop(bench, "preproc_jsonpath_dependent", BENCH_PREPROC_DEPENDENT_ITEMS);
+
+	zbx_free(data);
+}
+
+int	main(int argc, char **argv)
+{
+	zbx_bench_t	bench;
+	int		i, num;
+
+	zbx_bench_init(&bench, "preproc", argc, argv);
+	num = zbx_bench_scale(&bench, BENCH_PREPROC_VALUES);
+
+	srand(0);
+
+	for (i = 0; i < (int)ARRSIZE(bench_steps); i++)
+		bench_preproc_step(&bench, &bench_steps[i], num);
+
+	bench_preproc_delta_speed(&bench, num);
+	bench_preproc_dependent(&bench, zbx_bench_scale(&bench, BENCH_PREPROC_MASTER_RECORDS));
+
+	return 0;
+}
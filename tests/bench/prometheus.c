@@ -0,0 +1,131 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* Prometheus exposition format parsing benchmarks */
+
+#include "zbxbench.h"
+#include "zbxprometheus.h"
+#include "zbxstr.h"
+
+#define BENCH_PROMETHEUS_ROWS		50000
+#define BENCH_PROMETHEUS_SERIES		100
+#define BENCH_PROMETHEUS_PASSES		10
+#define BENCH_PROMETHEUS_QUERIES	1000
+
+/* generates exposition page with the specified number of samples, BENCH_PROMETHEUS_SERIES per metric */
+static char	*bench_prometheus_generate(int rows)
+{
+	char	*data = NULL;
+	size_t	data_alloc = 0, data_offset = 0;
+	int	i;
+
+	for (i = 0; i < rows; i++)
+	{
+		int	metric = i / BENCH_PROMETHEUS_SERIES;
+
+		if (0 == i % BENCH_PROMETHEUS_SERIES)
+		{
+			zbx_snprintf_alloc(&data, &data_alloc, &data_offset,
+					"# HELP http_requests_%d_total The total number of HTTP requests.\n"
+					"# TYPE http_requests_%d_total counter\n", metric, metric);
+		}
+
+		zbx_snprintf_alloc(&data, &data_alloc, &data_offset,
+				"http_requests_%d_total{method=\"%s\",code=\"%d\",instance=\"instance-%d\"} %d %d\n",
+				metric, 0 == i % 2 ? "get" : "post", 0 == i % 7 ? 500 : 200,
+				i % BENCH_PROMETHEUS_SERIES, rand(), 1700000000 + i);
+	}
+
+	return data;
+}
+
+static void	bench_prometheus_fail(const char *op, char *error)
+{
+	fprintf(stderr, "%s failed: %s\n", op, error);
+	zbx_free(error);
+	exit(EXIT_FAILURE);
+}
+
+int	main(int argc, char **argv)
+{
+	zbx_bench_t		bench;
+	zbx_prometheus_t	prom;
+	char			*data, *value = NULL, *error = NULL, filter[MAX_STRING_LEN];
+	int			i, rows, metrics;
+
+	zbx_bench_init(&bench, "prometheus", argc, argv);
+
+	srand(0);
+	rows = zbx_bench_scale(&bench, BENCH_PROMETHEUS_ROWS);
+	metrics = (rows + BENCH_PROMETHEUS_SERIES - 1) / BENCH_PROMETHEUS_SERIES;
+	data = bench_prometheus_generate(rows);
+
+	zbx_snprintf(filter, sizeof(filter), "http_requests_%d_total{instance=\"instance-%d\"}", metrics / 2,
+			BENCH_PROMETHEUS_SERIES / 2);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < BENCH_PROMETHEUS_PASSES; i++)
+	{
+		if (SUCCEED != zbx_prometheus_pattern(data, filter, "value", "", &value, &error))
+			bench_prometheus_fail("zbx_prometheus_pattern()", error);
+		zbx_free(value);
+	}
+	zbx_bench_stop(&bench, "prometheus_pattern", BENCH_PROMETHEUS_PASSES);
+
+	zbx_snprintf(filter, sizeof(filter), "http_requests_%d_total", metrics / 2);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < BENCH_PROMETHEUS_PASSES; i++)
+	{
+		if (SUCCEED != zbx_prometheus_to_json(data, filter, &value, &error))
+			bench_prometheus_fail("zbx_prometheus_to_json()", error);
+		zbx_free(value);
+	}
+	zbx_bench_stop(&bench, "prometheus_to_json", BENCH_PROMETHEUS_PASSES);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < BENCH_PROMETHEUS_PASSES; i++)
+	{
+		if (SUCCEED != zbx_prometheus_init(&prom, data, &error))
+			bench_prometheus_fail("zbx_prometheus_init()", error);
+		zbx_prometheus_clear(&prom);
+	}
+	zbx_bench_stop(&bench, "prometheus_init", BENCH_PROMETHEUS_PASSES);
+
+	/* dependent items querying cached master item value */
+	if (SUCCEED != zbx_prometheus_init(&prom, data, &error))
+		bench_prometheus_fail("zbx_prometheus_init()", error);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < BENCH_PROMETHEUS_QUERIES; i++)
+	{
+		zbx_snprintf(filter, sizeof(filter), "http_requests_%d_total{instance=\"instance-%d\"}",
+				i % metrics, i % BENCH_PROMETHEUS_SERIES);
+
+		if (SUCCEED != zbx_prometheus_pattern_ex(&prom, filter, "value", "", &value, &error))
+			bench_prometheus_fail("zbx_prometheus_pattern_ex()", error);
+		zbx_free(value);
+	}
+	zbx_bench_stop(&bench, "prometheus_pattern_ex", BENCH_PROMETHEUS_QUERIES);
+
+	zbx_prometheus_clear(&prom);
+	zbx_free(data);
+
+	return 0;
+}
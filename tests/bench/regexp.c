@@ -0,0 +1,108 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* regular expression benchmarks on log like values */
+
+#include "zbxbench.h"
+#include "zbxregexp.h"
+
+#define BENCH_REGEXP_LINES	100000
+
+static const char	*bench_lines[] = {
+	"2023-05-17 10:21:33.123 [INFO] worker #12 processed 1534 values in 0.023456 sec",
+	"2023-05-17 10:21:33.456 [ERROR] cannot connect to [[db.example.com]:5432]: timeout",
+	"2023-05-17 10:21:34.001 [DEBUG] In zbx_dc_config_history_sync() itemids_num:42",
+	"Mar  3 12:00:01 host sshd[2041]: Failed password for invalid user admin from 10.0.0.5 port 514"
+};
+
+int	main(int argc, char **argv)
+{
+	zbx_bench_t	bench;
+	zbx_regexp_t	*regexp;
+	const char	*err_msg = NULL, *pattern = "\\[(ERROR|WARNING)\\] (.*): (.*)$";
+	char		*out = NULL;
+	int		i, num, matched = 0;
+
+	zbx_bench_init(&bench, "regexp", argc, argv);
+	num = zbx_bench_scale(&bench, BENCH_REGEXP_LINES);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != zbx_regexp_compile(pattern, &regexp, &err_msg))
+		{
+			fprintf(stderr, "cannot compile \"%s\": %s\n", pattern, err_msg);
+			zbx_regexp_err_msg_free(err_msg);
+			exit(EXIT_FAILURE);
+		}
+		zbx_regexp_free(regexp);
+	}
+	zbx_bench_stop(&bench, "regexp_compile", num);
+
+	if (SUCCEED != zbx_regexp_compile(pattern, &regexp, &err_msg))
+		exit(EXIT_FAILURE);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < num; i++)
+	{
+		if (ZBX_REGEXP_MATCH == zbx_regexp_match_precompiled(bench_lines[i % ARRSIZE(bench_lines)], regexp))
+			matched++;
+	}
+	zbx_bench_stop(&bench, "regexp_match_precompiled", num);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED == zbx_mregexp_sub_precompiled(bench_lines[i % ARRSIZE(bench_lines)], regexp, "\\2",
+				ZBX_MAX_RECV_DATA_SIZE, &out) && NULL != out)
+		{
+			matched++;
+		}
+		zbx_free(out);
+	}
+	zbx_bench_stop(&bench, "regexp_sub_precompiled", num);
+
+	zbx_regexp_free(regexp);
+
+	/* pattern passed as string, compiled regular expressions are cached by zbxregexp */
+	zbx_bench_start(&bench);
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED == zbx_regexp_sub(bench_lines[i % ARRSIZE(bench_lines)], pattern, "\\3", &out) &&
+				NULL != out)
+		{
+			matched++;
+		}
+		zbx_free(out);
+	}
+	zbx_bench_stop(&bench, "regexp_sub", num);
+
+	zbx_bench_start(&bench);
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED == zbx_wildcard_match(bench_lines[i % ARRSIZE(bench_lines)], "*[ERROR]*timeout"))
+			matched++;
+	}
+	zbx_bench_stop(&bench, "wildcard_match", num);
+
+	if (0 == matched)
+		fprintf(stderr, "regexp: no values matched\n");
+
+	return 0;
+}
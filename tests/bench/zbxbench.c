@@ -0,0 +1,161 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxbench.h"
+
+const char	*progname = "zabbix_bench";
+const char	title_message[] = "zabbix_bench";
+const char	*usage_message[] = {NULL};
+const char	*help_message[] = {NULL};
+const char	syslog_app_name[] = "zabbix_bench";
+
+/* heap allocations are counted by wrapping libc allocators at link time (see Makefile.am) */
+static zbx_uint64_t	bench_allocs;
+
+void	*__real_malloc(size_t size);
+void	*__real_calloc(size_t nmemb, size_t size);
+void	*__real_realloc(void *ptr, size_t size);
+char	*__real_strdup(const char *s);
+
+void	*__wrap_malloc(size_t size);
+void	*__wrap_calloc(size_t nmemb, size_t size);
+void	*__wrap_realloc(void *ptr, size_t size);
+char	*__wrap_strdup(const char *s);
+
+void	*__wrap_malloc(size_t size)
+{
+	bench_allocs++;
+	return __real_malloc(size);
+}
+
+void	*__wrap_calloc(size_t nmemb, size_t size)
+{
+	bench_allocs++;
+	return __real_calloc(nmemb, size);
+}
+
+void	*__wrap_realloc(void *ptr, size_t size)
+{
+	bench_allocs++;
+	return __real_realloc(ptr, size);
+}
+
+char	*__wrap_strdup(const char *s)
+{
+	bench_allocs++;
+	return __real_strdup(s);
+}
+
+static double	bench_time(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes benchmark context                                     *
+ *                                                                            *
+ * Parameters: bench - [OUT] the benchmark context                            *
+ *             suite - [IN] the benchmark suite name                          *
+ *             argc  - [IN] the number of command line arguments              *
+ *             argv  - [IN] the command line arguments                        *
+ *                                                                            *
+ * Comments: The only supported option is '-s <scale>' which scales dataset   *
+ *           sizes and iteration counts, for example '-s 0.1' for quick runs. *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_bench_init(zbx_bench_t *bench, const char *suite, int argc, char **argv)
+{
+	int	ch;
+
+	bench->suite = suite;
+	bench->scale = 1.0;
+
+	while (-1 != (ch = getopt(argc, argv, "s:")))
+	{
+		switch (ch)
+		{
+			case 's':
+				if (0 >= (bench->scale = atof(optarg)))
+				{
+					fprintf(stderr, "%s: invalid scale \"%s\"\n", suite, optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-s <scale>]\n", argv[0]);
+				exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: scales dataset size or iteration count                            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_bench_scale(const zbx_bench_t *bench, int num)
+{
+	if (1 > (num = (int)(num * bench->scale)))
+		num = 1;
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts measurement                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_bench_start(zbx_bench_t *bench)
+{
+	bench->allocs_start = bench_allocs;
+	bench->time_start = bench_time();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stops measurement and reports results                             *
+ *                                                                            *
+ * Parameters: bench - [IN] the benchmark context                             *
+ *             name  - [IN] the benchmark name                                *
+ *             ops   - [IN] the number of operations performed since          *
+ *                          measurement was started                           *
+ *                                                                            *
+ * Comments: Results are printed as JSON lines:                               *
+ *           {"suite":"algo","name":"hashset_insert","ops":1000000,           *
+ *            "ns_per_op":120.5,"allocs_per_op":1.000}                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_bench_stop(zbx_bench_t *bench, const char *name, int ops)
+{
+	double		elapsed = bench_time() - bench->time_start;
+	zbx_uint64_t	allocs = bench_allocs - bench->allocs_start;
+
+	if (0 >= ops)
+		ops = 1;
+
+	printf("{\"suite\":\"%s\",\"name\":\"%s\",\"ops\":%d,\"ns_per_op\":%.1f,\"allocs_per_op\":%.3f}\n",
+			bench->suite, name, ops, elapsed / ops, (double)allocs / ops);
+	fflush(stdout);
+}
@@ -0,0 +1,40 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_BENCH_H
+#define ZABBIX_BENCH_H
+
+#include "zbxcommon.h"
+
+/* benchmark run context, results are written to stdout as one JSON object per line */
+typedef struct
+{
+	const char	*suite;
+	double		scale;
+	double		time_start;
+	zbx_uint64_t	allocs_start;
+}
+zbx_bench_t;
+
+void	zbx_bench_init(zbx_bench_t *bench, const char *suite, int argc, char **argv);
+int	zbx_bench_scale(const zbx_bench_t *bench, int num);
+void	zbx_bench_start(zbx_bench_t *bench);
+void	zbx_bench_stop(zbx_bench_t *bench, const char *name, int ops);
+
+#endif
@@ -22,6 +22,7 @@ AC_DEFUN([CONF_TESTS],
 	AM_COND_IF([ZBXCMOCKA],[
 		AC_CONFIG_FILES([
 		tests/Makefile
+		tests/bench/Makefile
 		tests/libs/Makefile
 		tests/libs/zbxalgo/Makefile
 		tests/libs/zbxcommon/Makefile
@@ -0,0 +1,160 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	value;
+}
+zbx_flatset_test_entry_t;
+
+static void	mock_read_ids(const char *path, zbx_vector_uint64_t *ids)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hids, hid;
+
+	hids = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hids, &hid))))
+	{
+		zbx_uint64_t	id;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hid, &id)))
+			fail_msg("Cannot read vector member: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(ids, id);
+	}
+}
+
+static void	flatset_insert_range(zbx_flatset_t *fs, zbx_hashset_t *hs, zbx_uint64_t from, zbx_uint64_t to,
+		zbx_uint64_t step)
+{
+	zbx_uint64_t	id;
+
+	for (id = from; id <= to; id += step)
+	{
+		zbx_flatset_test_entry_t	entry_local = {id, id * 3}, *entry;
+
+		entry = (zbx_flatset_test_entry_t *)zbx_flatset_insert(fs, &entry_local, sizeof(entry_local));
+		zbx_mock_assert_uint64_eq("inserted id", id, entry->id);
+
+		zbx_hashset_insert(hs, &id, sizeof(id));
+	}
+}
+
+static void	flatset_check(zbx_flatset_t *fs, zbx_hashset_t *hs, zbx_uint64_t from, zbx_uint64_t to)
+{
+	zbx_uint64_t			id;
+	zbx_flatset_iter_t		iter;
+	zbx_flatset_test_entry_t	*entry;
+	int				iterated = 0;
+
+	zbx_mock_assert_int_eq("number of entries", hs->num_data, fs->num_data);
+
+	for (id = from; id <= to; id++)
+	{
+		entry = (zbx_flatset_test_entry_t *)zbx_flatset_search(fs, &id);
+
+		if (NULL == zbx_hashset_search(hs, &id))
+		{
+			zbx_mock_assert_ptr_eq("removed entry", NULL, entry);
+			continue;
+		}
+
+		zbx_mock_assert_ptr_ne("entry", NULL, entry);
+		zbx_mock_assert_uint64_eq("entry value", id * 3, entry->value);
+	}
+
+	zbx_flatset_iter_reset(fs, &iter);
+
+	while (NULL != (entry = (zbx_flatset_test_entry_t *)zbx_flatset_iter_next(&iter)))
+	{
+		zbx_mock_assert_ptr_ne("iterated entry", NULL, zbx_hashset_search(hs, &entry->id));
+		iterated++;
+	}
+
+	zbx_mock_assert_int_eq("number of iterated entries", hs->num_data, iterated);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_flatset_t			fs;
+	zbx_hashset_t			hs;
+	zbx_vector_uint64_t		removed;
+	zbx_uint64_t			from, to, step;
+	zbx_flatset_iter_t		iter;
+	zbx_flatset_test_entry_t	*entry;
+	int				i;
+
+	ZBX_UNUSED(state);
+
+	from = zbx_mock_get_parameter_uint64("in.from");
+	to = zbx_mock_get_parameter_uint64("in.to");
+	step = zbx_mock_get_parameter_uint64("in.step");
+
+	zbx_vector_uint64_create(&removed);
+	mock_read_ids("in.remove", &removed);
+
+	zbx_flatset_create(&fs, 0);
+	zbx_hashset_create(&hs, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	flatset_insert_range(&fs, &hs, from, to, step);
+	flatset_check(&fs, &hs, from, to);
+
+	for (i = 0; i < removed.values_num; i++)
+	{
+		zbx_flatset_remove(&fs, &removed.values[i]);
+		zbx_hashset_remove(&hs, &removed.values[i]);
+	}
+
+	flatset_check(&fs, &hs, from, to);
+
+	/* reinsert removed entries, reusing deleted slots */
+	flatset_insert_range(&fs, &hs, from, to, step);
+	flatset_check(&fs, &hs, from, to);
+
+	/* remove every other entry through iterator */
+	zbx_flatset_iter_reset(&fs, &iter);
+
+	for (i = 0; NULL != (entry = (zbx_flatset_test_entry_t *)zbx_flatset_iter_next(&iter)); i++)
+	{
+		if (0 == i % 2)
+		{
+			zbx_hashset_remove(&hs, &entry->id);
+			zbx_flatset_iter_remove(&iter);
+		}
+	}
+
+	flatset_check(&fs, &hs, from, to);
+
+	zbx_flatset_clear(&fs);
+	zbx_hashset_clear(&hs);
+	flatset_check(&fs, &hs, from, to);
+
+	zbx_flatset_destroy(&fs);
+	zbx_hashset_destroy(&hs);
+	zbx_vector_uint64_destroy(&removed);
+}
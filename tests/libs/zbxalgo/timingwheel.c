@@ -0,0 +1,279 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+typedef struct
+{
+	int			id;
+	int			linked;
+	zbx_timing_wheel_node_t	node;
+}
+zbx_tw_test_entry_t;
+
+static int	tw_test_compare(const void *d1, const void *d2)
+{
+	const zbx_timing_wheel_node_t	*n1 = (const zbx_timing_wheel_node_t *)d1;
+	const zbx_timing_wheel_node_t	*n2 = (const zbx_timing_wheel_node_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(n1->expires, n2->expires);
+	ZBX_RETURN_IF_NOT_EQUAL(((const zbx_tw_test_entry_t *)n1->data)->id,
+			((const zbx_tw_test_entry_t *)n2->data)->id);
+
+	return 0;
+}
+
+static void	mock_read_ints(zbx_mock_handle_t hvector, zbx_vector_uint64_t *values)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hvalue;
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvector, &hvalue))))
+	{
+		zbx_uint64_t	value;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hvalue, &value)))
+			fail_msg("Cannot read vector member: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(values, value);
+	}
+}
+
+/* returns the nearest expiry time of linked entries */
+static int	tw_test_next_expiry(const zbx_tw_test_entry_t *entries, int entries_num)
+{
+	int	i, expires = FAIL;
+
+	for (i = 0; i < entries_num; i++)
+	{
+		if (0 != entries[i].linked && (FAIL == expires || entries[i].node.expires < expires))
+			expires = entries[i].node.expires;
+	}
+
+	return expires;
+}
+
+/* checks that expired list is sorted and holds all linked entries expiring up to now */
+static void	tw_test_check_expired(zbx_timing_wheel_t *wheel, const zbx_tw_test_entry_t *entries, int entries_num,
+		int now)
+{
+	int				i, expired_num = 0, linked_num = 0;
+	const zbx_timing_wheel_node_t	*node, *prev = NULL;
+
+	for (node = zbx_timing_wheel_first_expired(wheel); NULL != node; node = node->next)
+	{
+		if (NULL != prev && 0 < tw_test_compare(prev, node))
+			fail_msg("expired list is not sorted at %d", node->expires);
+
+		zbx_mock_assert_ptr_eq("expired node link", NULL != prev ? &prev->next : &wheel->expired,
+				node->pprev);
+		prev = node;
+		expired_num++;
+	}
+
+	zbx_mock_assert_ptr_eq("expired list tail", prev, wheel->expired_tail);
+	zbx_mock_assert_int_eq("number of expired nodes", wheel->expired_num, expired_num);
+
+	for (i = 0; i < entries_num; i++)
+	{
+		if (0 == entries[i].linked)
+			continue;
+
+		linked_num++;
+
+		if (entries[i].node.expires <= now)
+			expired_num--;
+	}
+
+	zbx_mock_assert_int_eq("number of expired entries", 0, expired_num);
+	zbx_mock_assert_int_eq("number of nodes", linked_num, wheel->nodes_num);
+}
+
+static void	tw_test_steps(zbx_timing_wheel_t *wheel, zbx_tw_test_entry_t *entries, int entries_num)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_vector_uint64_t	expected;
+
+	zbx_vector_uint64_create(&expected);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		int				now, i;
+		zbx_timing_wheel_node_t		*node;
+
+		now = (int)zbx_mock_get_object_member_uint64(hstep, "now");
+
+		zbx_mock_assert_int_eq("next expiry", zbx_mock_get_object_member_int(hstep, "next"),
+				zbx_timing_wheel_next_expiry(wheel));
+
+		zbx_timing_wheel_advance(wheel, now);
+		tw_test_check_expired(wheel, entries, entries_num, now);
+
+		zbx_vector_uint64_clear(&expected);
+		mock_read_ints(zbx_mock_get_object_member_handle(hstep, "expired"), &expected);
+
+		for (i = 0; NULL != (node = zbx_timing_wheel_first_expired(wheel)); i++)
+		{
+			if (i == expected.values_num)
+				fail_msg("unexpected expired node %d", node->expires);
+
+			zbx_mock_assert_int_eq("expired node", (int)expected.values[i], node->expires);
+			((zbx_tw_test_entry_t *)node->data)->linked = 0;
+			zbx_timing_wheel_remove(wheel, node);
+		}
+
+		zbx_mock_assert_int_eq("number of expired nodes", expected.values_num, i);
+	}
+
+	zbx_vector_uint64_destroy(&expected);
+}
+
+static void	tw_test_random(zbx_timing_wheel_t *wheel, int now, int seed, int ops)
+{
+#define TW_TEST_ENTRIES_NUM	2000
+	zbx_tw_test_entry_t	*entries;
+	int			i;
+
+	srand((unsigned int)seed);
+	entries = (zbx_tw_test_entry_t *)zbx_calloc(NULL, TW_TEST_ENTRIES_NUM, sizeof(zbx_tw_test_entry_t));
+
+	for (i = 0; i < TW_TEST_ENTRIES_NUM; i++)
+	{
+		entries[i].id = i;
+		entries[i].node.data = &entries[i];
+	}
+
+	for (i = 0; i < ops; i++)
+	{
+		zbx_tw_test_entry_t	*entry = &entries[rand() % TW_TEST_ENTRIES_NUM];
+		int			expires, op = rand() % 100;
+
+		/* mostly short intervals with some long and past ones */
+		switch (rand() % 10)
+		{
+			case 0:
+				expires = now - rand() % 100;
+				break;
+			case 1:
+				expires = now + rand() % 3000000;
+				break;
+			case 2:
+				expires = now + 60000000 + rand() % 10000000;
+				break;
+			default:
+				expires = now + rand() % 600;
+		}
+
+		if (90 <= op)
+		{
+			zbx_timing_wheel_node_t	*node;
+
+			zbx_mock_assert_int_eq("next expiry", tw_test_next_expiry(entries, TW_TEST_ENTRIES_NUM),
+					zbx_timing_wheel_next_expiry(wheel));
+
+			now += rand() % (0 == rand() % 100 ? 3000000 : 30);
+			zbx_timing_wheel_advance(wheel, now);
+			tw_test_check_expired(wheel, entries, TW_TEST_ENTRIES_NUM, now);
+
+			while (0 != rand() % 4 && NULL != (node = zbx_timing_wheel_first_expired(wheel)))
+			{
+				((zbx_tw_test_entry_t *)node->data)->linked = 0;
+				zbx_timing_wheel_remove(wheel, node);
+			}
+		}
+		else if (0 == entry->linked)
+		{
+			zbx_timing_wheel_insert(wheel, &entry->node, expires);
+			entry->linked = 1;
+		}
+		else if (60 <= op)
+		{
+			zbx_timing_wheel_remove(wheel, &entry->node);
+			entry->linked = 0;
+		}
+		else
+			zbx_timing_wheel_update(wheel, &entry->node, expires);
+	}
+
+	tw_test_check_expired(wheel, entries, TW_TEST_ENTRIES_NUM, now - 1);
+	zbx_free(entries);
+#undef TW_TEST_ENTRIES_NUM
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_timing_wheel_t	wheel;
+	zbx_tw_test_entry_t	*entries;
+	zbx_vector_uint64_t	nodes, removed;
+	int			i, now;
+
+	ZBX_UNUSED(state);
+
+	now = (int)zbx_mock_get_parameter_uint64("in.now");
+	zbx_timing_wheel_create(&wheel, now, tw_test_compare);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.random"))
+	{
+		tw_test_random(&wheel, now, (int)zbx_mock_get_parameter_uint64("in.random.seed"),
+				(int)zbx_mock_get_parameter_uint64("in.random.ops"));
+		zbx_timing_wheel_destroy(&wheel);
+
+		return;
+	}
+
+	zbx_vector_uint64_create(&nodes);
+	zbx_vector_uint64_create(&removed);
+
+	mock_read_ints(zbx_mock_get_parameter_handle("in.nodes"), &nodes);
+	mock_read_ints(zbx_mock_get_parameter_handle("in.remove"), &removed);
+
+	entries = (zbx_tw_test_entry_t *)zbx_calloc(NULL, (size_t)nodes.values_num + 1, sizeof(zbx_tw_test_entry_t));
+
+	for (i = 0; i < nodes.values_num; i++)
+	{
+		entries[i].id = i;
+		entries[i].linked = 1;
+		entries[i].node.data = &entries[i];
+		zbx_timing_wheel_insert(&wheel, &entries[i].node, (int)nodes.values[i]);
+	}
+
+	/* removed nodes are referenced by their index */
+	for (i = 0; i < removed.values_num; i++)
+	{
+		entries[removed.values[i]].linked = 0;
+		zbx_timing_wheel_remove(&wheel, &entries[removed.values[i]].node);
+	}
+
+	tw_test_steps(&wheel, entries, nodes.values_num);
+
+	zbx_mock_assert_int_eq("number of nodes", 0, wheel.nodes_num);
+
+	zbx_timing_wheel_destroy(&wheel);
+	zbx_free(entries);
+	zbx_vector_uint64_destroy(&removed);
+	zbx_vector_uint64_destroy(&nodes);
+}
@@ -99,6 +99,16 @@ void	zbx_mock_test_entry(void **state)
 
 		zbx_mock_assert_str_eq("Resolved value", value_exp, value);
 		zbx_free(value);
+
+		/* resolve again to check the memorized value */
+		um_cache_resolve(cache, hostids.values, hostids.values_num, zbx_mock_get_parameter_string("in.macro"),
+				ZBX_MACRO_ENV_SECURE, &value);
+
+		if (NULL == value)
+			fail_msg("Expected to resolve again to '%s' while got nothing", value_exp);
+
+		zbx_mock_assert_str_eq("Resolved again value", value_exp, value);
+		zbx_free(value);
 	}
 
 	um_cache_release(cache);
@@ -21,8 +21,14 @@
 
 void	zbx_vc_set_mode(int mode)
 {
-	vc_cache->mode = mode;
-	vc_cache->mode_time = time(NULL);
+	int	i;
+
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		vc_select_shard(i);
+		vc_cache->mode = mode;
+		vc_cache->mode_time = time(NULL);
+	}
 }
 
 int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values)
@@ -31,6 +37,8 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 	int		i;
 	zbx_vc_chunk_t	*chunk;
 
+	vc_select_shard(vc_get_shard_index(itemid));
+
 	if (NULL == (item = zbx_hashset_search(&vc_cache->items, &itemid)))
 		return FAIL;
 
@@ -39,8 +47,10 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 
 	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
 	{
+		const zbx_history_record_t	*slots = vch_chunk_values(chunk);
+
 		for (i = chunk->first_value; i <= chunk->last_value; i++)
-			vc_history_record_vector_append(values, value_type, &chunk->slots[i]);
+			vc_history_record_vector_append(values, value_type, &slots[i]);
 	}
 
 	return SUCCEED;
@@ -49,9 +59,11 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int count, const zbx_timespec_t *ts)
 {
 	zbx_vc_item_t			*item;
-	int				ret;
+	int				ret, i;
 	zbx_vector_history_record_t	values;
 
+	vc_select_shard(vc_get_shard_index(itemid));
+
 	/* add item to cache if necessary */
 	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
@@ -61,15 +73,19 @@ int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int
 
 	/* perform request to cache values */
 	zbx_history_record_vector_create(&values);
-	RDLOCK_CACHE;
+	RDLOCK_CACHE(vc_get_shard_index(itemid));
 	ret = vch_item_get_values(item, &values, seconds, count, ts);
 	UNLOCK_CACHE;
 	zbx_vc_flush_stats();
 	zbx_history_record_vector_destroy(&values, value_type);
 
 	/* reset cache statistics */
-	vc_cache->hits = 0;
-	vc_cache->misses = 0;
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		vc_select_shard(i);
+		vc_cache->hits = 0;
+		vc_cache->misses = 0;
+	}
 
 	return ret;
 }
@@ -80,6 +96,8 @@ int	zbx_vc_get_item_state(zbx_uint64_t itemid, int *status, int *active_range, i
 	zbx_vc_item_t	*item;
 	int		ret = FAIL;
 
+	vc_select_shard(vc_get_shard_index(itemid));
+
 	if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
 		*status = item->status;
@@ -95,12 +113,36 @@ int	zbx_vc_get_item_state(zbx_uint64_t itemid, int *status, int *active_range, i
 
 int	zbx_vc_get_cache_state(int *mode, zbx_uint64_t *hits, zbx_uint64_t *misses)
 {
+	int	i;
+
 	if (NULL == vc_cache)
 		return FAIL;
 
-	*mode = vc_cache->mode;
-	*hits = vc_cache->hits;
-	*misses = vc_cache->misses;
+	*mode = ZBX_VC_MODE_NORMAL;
+	*hits = 0;
+	*misses = 0;
+
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		vc_select_shard(i);
+
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+			*mode = vc_cache->mode;
+
+		*hits += vc_cache->hits;
+		*misses += vc_cache->misses;
+	}
 
 	return SUCCEED;
 }
+
+void	zbx_vc_encode_decode_values(const zbx_history_record_t *values, int values_num,
+		zbx_history_record_t *decoded)
+{
+	zbx_vc_bitstream_t	bs = {0};
+
+	vc_encode_values(&bs, values, values_num);
+	vc_decode_values(bs.data, decoded, values_num);
+
+	zbx_free(bs.data);
+}
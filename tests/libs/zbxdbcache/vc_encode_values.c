@@ -0,0 +1,64 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcachevalue.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vector_history_record_t	values;
+	zbx_history_record_t		*decoded;
+	zbx_mock_handle_t		hin;
+	unsigned char			value_type;
+	int				i;
+	char				msg[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	hin = zbx_mock_get_parameter_handle("in");
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hin, "value type"));
+
+	zbx_vector_history_record_create(&values);
+	zbx_vcmock_read_values(zbx_mock_get_object_member_handle(hin, "values"), value_type, &values);
+
+	decoded = (zbx_history_record_t *)zbx_malloc(NULL, sizeof(zbx_history_record_t) * (size_t)values.values_num);
+	zbx_vc_encode_decode_values(values.values, values.values_num, decoded);
+
+	/* values are compared by their bit patterns, so that NaN values can be checked too */
+	for (i = 0; i < values.values_num; i++)
+	{
+		zbx_snprintf(msg, sizeof(msg), "value #%d seconds", i);
+		zbx_mock_assert_int_eq(msg, values.values[i].timestamp.sec, decoded[i].timestamp.sec);
+
+		zbx_snprintf(msg, sizeof(msg), "value #%d nanoseconds", i);
+		zbx_mock_assert_int_eq(msg, values.values[i].timestamp.ns, decoded[i].timestamp.ns);
+
+		zbx_snprintf(msg, sizeof(msg), "value #%d", i);
+		zbx_mock_assert_uint64_eq(msg, values.values[i].value.ui64, decoded[i].value.ui64);
+	}
+
+	zbx_free(decoded);
+	zbx_vector_history_record_destroy(&values);
+}
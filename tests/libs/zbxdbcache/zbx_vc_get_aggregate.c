@@ -0,0 +1,167 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxnum.h"
+#include "zbxmutexs.h"
+#include "zbxcachevalue.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
+static void	vc_test_add_values(zbx_mock_handle_t hrequest)
+{
+	zbx_mock_handle_t	hvalues;
+	zbx_vector_ptr_t	history;
+	int			ret_flush;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrequest, "values", &hvalues))
+		return;
+
+	zbx_vector_ptr_create(&history);
+	zbx_vcmock_get_dc_history(hvalues, &history);
+
+	zbx_mock_assert_result_eq("zbx_vc_add_values()", SUCCEED, zbx_vc_add_values(&history, &ret_flush));
+
+	zbx_vector_ptr_clear_ext(&history, zbx_vcmock_free_dc_history);
+	zbx_vector_ptr_destroy(&history);
+}
+
+static void	vc_test_check_value(zbx_mock_handle_t hrequest, const char *name, unsigned char value_type,
+		const zbx_history_value_t *value)
+{
+	zbx_mock_handle_t	hvalue;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrequest, name, &hvalue))
+		return;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		zbx_mock_assert_double_eq(name, zbx_mock_get_object_member_float(hrequest, name), value->dbl);
+	else
+		zbx_mock_assert_uint64_eq(name, zbx_mock_get_object_member_uint64(hrequest, name), value->ui64);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int			err, seconds, count;
+	char			*error;
+	const char		*flags_str;
+	unsigned char		value_type, flags;
+	zbx_mock_handle_t	handle, hitem, hpercentage;
+	zbx_mock_error_t	mock_err;
+	zbx_uint64_t		itemid;
+	zbx_timespec_t		ts;
+	zbx_vc_aggregate_t	aggregate;
+	zbx_history_value_t	sum, percentile;
+	double			percentage;
+
+	ZBX_UNUSED(state);
+
+	/* set small cache size to force smaller cache free request size (5% of cache size) */
+	CONFIG_VALUE_CACHE_SIZE = ZBX_KIBIBYTE;
+
+	err = zbx_locks_create(&error);
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, err);
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+
+	zbx_vcmock_ds_init();
+
+	/* precache values */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.precache", &handle))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+		{
+			zbx_vcmock_set_time(hitem, "time");
+			zbx_vcmock_get_request_params(hitem, &itemid, &value_type, &seconds, &count, &ts);
+			zbx_vc_precache_values(itemid, value_type, seconds, count, &ts);
+		}
+	}
+
+	/* add values and request aggregates */
+	handle = zbx_mock_get_parameter_handle("in.requests");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+	{
+		zbx_vcmock_set_time(hitem, "time");
+		vc_test_add_values(hitem);
+
+		zbx_vcmock_get_request_params(hitem, &itemid, &value_type, &seconds, &count, &ts);
+
+		/* percentile requests have percentage instead of aggregate flags */
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hitem, "percentage", &hpercentage))
+		{
+			percentage = zbx_mock_get_object_member_float(hitem, "percentage");
+
+			err = zbx_vc_get_percentile(itemid, value_type, seconds, &ts, percentage, &percentile);
+			zbx_vc_flush_stats();
+
+			zbx_mock_assert_result_eq("zbx_vc_get_percentile() return value",
+					zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hitem, "return")),
+					err);
+
+			if (SUCCEED == err)
+				vc_test_check_value(hitem, "percentile", value_type, &percentile);
+
+			continue;
+		}
+
+		flags_str = zbx_mock_get_object_member_string(hitem, "flags");
+		flags = 0;
+
+		if (NULL != strstr(flags_str, "ZBX_VC_AGGREGATE_MIN"))
+			flags |= ZBX_VC_AGGREGATE_MIN;
+
+		if (NULL != strstr(flags_str, "ZBX_VC_AGGREGATE_MAX"))
+			flags |= ZBX_VC_AGGREGATE_MAX;
+
+		err = zbx_vc_get_aggregate(itemid, value_type, seconds, &ts, flags, &aggregate);
+		zbx_vc_flush_stats();
+
+		zbx_mock_assert_result_eq("zbx_vc_get_aggregate() return value",
+				zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hitem, "return")), err);
+
+		if (SUCCEED != err)
+			continue;
+
+		zbx_mock_assert_int_eq("count", count, aggregate.count);
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			sum.dbl = aggregate.sum_dbl;
+		else
+			sum.ui64 = aggregate.sum_ui64;
+
+		vc_test_check_value(hitem, "sum", value_type, &sum);
+		vc_test_check_value(hitem, "min", value_type, &aggregate.min);
+		vc_test_check_value(hitem, "max", value_type, &aggregate.max);
+	}
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
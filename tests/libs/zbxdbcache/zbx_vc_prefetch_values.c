@@ -0,0 +1,101 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxcachevalue.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+#include "zbx_vc_common.h"
+
+static void	zbx_vc_test_prefetch_values_setup(zbx_mock_handle_t *handle, zbx_uint64_t *itemid,
+		unsigned char *value_type, zbx_timespec_t *ts, int *err, zbx_vector_history_record_t *expected,
+		zbx_vector_history_record_t *returned, int *seconds, int *count)
+{
+	zbx_vector_vc_request_t	requests;
+	zbx_vc_request_t	request;
+	zbx_mock_handle_t	hrequest, hvalues, hexpected;
+	zbx_uint64_t		hits, misses, prefetch_misses;
+	int			cache_mode;
+
+	/* prefetch values */
+
+	*handle = zbx_mock_get_parameter_handle("in.prefetch");
+	zbx_vcmock_set_time(*handle, "time");
+	zbx_vcmock_set_mode(*handle, "cache mode");
+
+	zbx_vector_vc_request_create(&requests);
+
+	hrequest = zbx_mock_get_object_member_handle(*handle, "requests");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrequest, handle))
+	{
+		zbx_vcmock_get_request_params(*handle, &request.itemid, &request.value_type, &request.seconds, count,
+				&request.ts);
+		zbx_vector_vc_request_append(&requests, request);
+	}
+
+	zbx_vc_prefetch_values(&requests);
+	zbx_vc_flush_stats();
+	zbx_vector_vc_request_destroy(&requests);
+
+	zbx_vc_get_cache_state(&cache_mode, &hits, &prefetch_misses);
+
+	if (FAIL == zbx_is_uint64(zbx_mock_get_parameter_string("out['prefetch misses']"), &misses))
+		fail_msg("Invalid out['prefetch misses'] value");
+
+	zbx_mock_assert_uint64_eq("zbx_vc_prefetch_values() cache misses", misses, prefetch_misses);
+
+	/* perform requests, the prefetched values must be returned from cache */
+
+	hrequest = zbx_mock_get_parameter_handle("in.test");
+	hexpected = zbx_mock_get_parameter_handle("out.values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrequest, handle))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_vector_element(hexpected, &hvalues))
+			fail_msg("Missing expected values of request");
+
+		zbx_vcmock_set_time(*handle, "time");
+		zbx_vcmock_get_request_params(*handle, itemid, value_type, seconds, count, ts);
+
+		*err = zbx_vc_get_values(*itemid, *value_type, returned, *seconds, *count, ts);
+		zbx_vc_flush_stats();
+		zbx_mock_assert_result_eq("zbx_vc_get_values() return value", SUCCEED, *err);
+
+		zbx_vcmock_read_values(hvalues, *value_type, expected);
+		zbx_vcmock_check_records("Returned values", *value_type, expected, returned);
+
+		zbx_history_record_vector_clean(returned, *value_type);
+		zbx_history_record_vector_clean(expected, *value_type);
+	}
+
+	zbx_vc_get_cache_state(&cache_mode, &hits, &misses);
+	zbx_mock_assert_uint64_eq("zbx_vc_get_values() cache misses", prefetch_misses, misses);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vc_common_test_func(state, NULL, NULL, zbx_vc_test_prefetch_values_setup, 1);
+}
@@ -0,0 +1,138 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxdbhigh.h"
+#include "zbxdb.h"
+#include "zbxnum.h"
+#include "zbxstr.h"
+
+static char	*copy_sql = NULL, *copy_data = NULL;
+static size_t	copy_data_alloc = 0, copy_data_offset = 0;
+
+int	__wrap_zbx_db_copy_basic(const char *sql, const char *data, size_t size);
+
+int	__wrap_zbx_db_copy_basic(const char *sql, const char *data, size_t size)
+{
+	size_t	i;
+
+	copy_sql = zbx_strdup(copy_sql, sql);
+
+	/* store the copied data as hexadecimal string for comparison with the expected data */
+	for (i = 0; i < size; i++)
+		zbx_snprintf_alloc(&copy_data, &copy_data_alloc, &copy_data_offset, "%02x", (unsigned char)data[i]);
+
+	return ZBX_DB_OK;
+}
+
+static void	db_value_from_string(const ZBX_FIELD *field, const char *str, zbx_db_value_t *value)
+{
+	switch (field->type)
+	{
+		case ZBX_TYPE_ID:
+		case ZBX_TYPE_UINT:
+			if (SUCCEED != zbx_is_uint64(str, &value->ui64))
+				fail_msg("invalid value \"%s\" of field \"%s\"", str, field->name);
+			break;
+		case ZBX_TYPE_INT:
+			value->i32 = atoi(str);
+			break;
+		case ZBX_TYPE_FLOAT:
+			value->dbl = atof(str);
+			break;
+		default:
+			value->str = (char *)str;
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const ZBX_TABLE		*table;
+	const ZBX_FIELD		*fields[ZBX_MAX_FIELDS];
+	const zbx_db_value_t	*values_ptr[ZBX_MAX_FIELDS];
+	zbx_db_value_t		values[ZBX_MAX_FIELDS];
+	zbx_db_insert_t		db_insert;
+	zbx_mock_handle_t	hfields, hfield, hrows, hrow, hvalue;
+	const char		*table_name, *str;
+	char			*expected_data;
+	int			fields_num = 0, values_num;
+
+	ZBX_UNUSED(state);
+
+#ifndef HAVE_POSTGRESQL
+	skip();
+#endif
+	table_name = zbx_mock_get_parameter_string("in.table");
+
+	if (NULL == (table = zbx_db_get_table(table_name)))
+		fail_msg("unknown table \"%s\"", table_name);
+
+	hfields = zbx_mock_get_parameter_handle("in.fields");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hfields, &hfield))
+	{
+		if (ZBX_MAX_FIELDS == fields_num)
+			fail_msg("too many fields");
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hfield, &str))
+			fail_msg("invalid field name");
+
+		if (NULL == (fields[fields_num++] = zbx_db_get_field(table, str)))
+			fail_msg("unknown field \"%s\" in table \"%s\"", str, table_name);
+	}
+
+	zbx_db_insert_prepare_dyn(&db_insert, table, fields, fields_num);
+	zbx_db_insert_enable_copy(&db_insert);
+
+	hrows = zbx_mock_get_parameter_handle("in.rows");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow))
+	{
+		for (values_num = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrow, &hvalue); values_num++)
+		{
+			if (fields_num == values_num)
+				fail_msg("too many row values");
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &str))
+				fail_msg("invalid row value");
+
+			db_value_from_string(fields[values_num], str, &values[values_num]);
+			values_ptr[values_num] = &values[values_num];
+		}
+
+		zbx_db_insert_add_values_dyn(&db_insert, values_ptr, values_num);
+	}
+
+	zbx_mock_assert_int_eq("return value", SUCCEED, zbx_db_insert_execute(&db_insert));
+	zbx_db_insert_clean(&db_insert);
+
+	zbx_mock_assert_str_eq("copy statement", zbx_mock_get_parameter_string("out.sql"), copy_sql);
+
+	expected_data = zbx_strdup(NULL, zbx_mock_get_parameter_string("out.data"));
+	zbx_remove_chars(expected_data, " \n");
+	zbx_mock_assert_str_eq("copy data", expected_data, copy_data);
+
+	zbx_free(expected_data);
+	zbx_free(copy_data);
+	zbx_free(copy_sql);
+}
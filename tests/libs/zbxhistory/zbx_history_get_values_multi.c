@@ -0,0 +1,213 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "zbxnum.h"
+#include "zbxalgo.h"
+#include "zbxhistory.h"
+#include "zbxdb.h"
+#include "zbxdbhigh.h"
+#include "zbxavailability.h"
+
+#define ZBX_MOCK_HISTORY_RANGES_MAX	16
+
+void	__wrap_zbx_sleep_loop(int sleeptime);
+zbx_uint64_t	__wrap_DCget_nextid(const char *table_name, int num);
+int	__wrap_zbx_interface_availability_is_set(const zbx_interface_availability_t *ha);
+int	__wrap_zbx_add_event(unsigned char source, unsigned char object, zbx_uint64_t objectid,
+		const zbx_timespec_t *timespec, int value, const char *trigger_description,
+		const char *trigger_expression, const char *trigger_recovery_expression, unsigned char trigger_priority,
+		unsigned char trigger_type, const zbx_vector_ptr_t *trigger_tags,
+		unsigned char trigger_correlation_mode, const char *trigger_correlation_tag,
+		unsigned char trigger_value, const char *trigger_opdata, const char *error);
+int	__wrap_zbx_process_events(zbx_vector_ptr_t *trigger_diff, zbx_vector_uint64_t *triggerids_lock);
+void	__wrap_zbx_clean_events(void);
+
+void	__wrap_zbx_sleep_loop(int sleeptime)
+{
+	ZBX_UNUSED(sleeptime);
+}
+
+zbx_uint64_t	__wrap_DCget_nextid(const char *table_name, int num)
+{
+	ZBX_UNUSED(table_name);
+	ZBX_UNUSED(num);
+	return 0;
+}
+
+int	__wrap_zbx_interface_availability_is_set(const zbx_interface_availability_t *ha)
+{
+	ZBX_UNUSED(ha);
+	return SUCCEED;
+}
+
+int	__wrap_zbx_add_event(unsigned char source, unsigned char object, zbx_uint64_t objectid,
+		const zbx_timespec_t *timespec, int value, const char *trigger_description,
+		const char *trigger_expression, const char *trigger_recovery_expression, unsigned char trigger_priority,
+		unsigned char trigger_type, const zbx_vector_ptr_t *trigger_tags,
+		unsigned char trigger_correlation_mode, const char *trigger_correlation_tag,
+		unsigned char trigger_value, const char *trigger_opdata, const char *error)
+{
+	ZBX_UNUSED(source);
+	ZBX_UNUSED(object);
+	ZBX_UNUSED(objectid);
+	ZBX_UNUSED(timespec);
+	ZBX_UNUSED(value);
+	ZBX_UNUSED(trigger_description);
+	ZBX_UNUSED(trigger_expression);
+	ZBX_UNUSED(trigger_recovery_expression);
+	ZBX_UNUSED(trigger_priority);
+	ZBX_UNUSED(trigger_type);
+	ZBX_UNUSED(trigger_tags);
+	ZBX_UNUSED(trigger_correlation_mode);
+	ZBX_UNUSED(trigger_correlation_tag);
+	ZBX_UNUSED(trigger_value);
+	ZBX_UNUSED(trigger_opdata);
+	ZBX_UNUSED(error);
+	return SUCCEED;
+}
+
+int	__wrap_zbx_process_events(zbx_vector_ptr_t *trigger_diff, zbx_vector_uint64_t *triggerids_lock)
+{
+	ZBX_UNUSED(trigger_diff);
+	ZBX_UNUSED(triggerids_lock);
+	return SUCCEED;
+}
+
+void	__wrap_zbx_clean_events(void)
+{
+}
+
+static int	mock_read_time(zbx_mock_handle_t handle, const char *name)
+{
+	zbx_timespec_t		ts;
+	zbx_mock_error_t	err;
+	const char		*data;
+
+	data = zbx_mock_get_object_member_string(handle, name);
+
+	if (ZBX_MOCK_SUCCESS != (err = zbx_strtime_to_timespec(data, &ts)))
+		fail_msg("Invalid %s timestamp \"%s\": %s", name, data, zbx_mock_error_string(err));
+
+	return ts.sec;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares values returned for item period with expected values     *
+ *                                                                            *
+ * Parameters: hvalues    - [IN] handle to the expected values                *
+ *             value_type - [IN] the item value type                          *
+ *             range      - [IN] the item period with returned values         *
+ *                                                                            *
+ * Comments: The returned values are not sorted, the expected values must be  *
+ *           listed in ascending timestamp order.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_range_values(zbx_mock_handle_t hvalues, int value_type, zbx_history_range_t *range)
+{
+	zbx_mock_handle_t	hvalue;
+	zbx_timespec_t		ts;
+	zbx_mock_error_t	err;
+	const char		*data;
+	char			buffer[MAX_STRING_LEN], prefix[MAX_ID_LEN + 32];
+	int			i = 0;
+
+	zbx_snprintf(prefix, sizeof(prefix), "item " ZBX_FS_UI64 " values", range->itemid);
+
+	zbx_vector_history_record_sort(&range->values, (zbx_compare_func_t)zbx_history_record_compare_asc_func);
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		if (i == range->values.values_num)
+			fail_msg("%s: too few values returned", prefix);
+
+		data = zbx_mock_get_object_member_string(hvalue, "ts");
+		if (ZBX_MOCK_SUCCESS != (err = zbx_strtime_to_timespec(data, &ts)))
+			fail_msg("Invalid value timestamp \"%s\": %s", data, zbx_mock_error_string(err));
+
+		zbx_mock_assert_timespec_eq(prefix, &ts, &range->values.values[i].timestamp);
+
+		zbx_history_value2str(buffer, sizeof(buffer), &range->values.values[i].value, value_type);
+		zbx_mock_assert_str_eq(prefix, zbx_mock_get_object_member_string(hvalue, "value"), buffer);
+
+		i++;
+	}
+
+	zbx_mock_assert_int_eq(prefix, i, range->values.values_num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char			*error = NULL;
+	int			err, value_type, i, ranges_num = 0;
+	zbx_history_range_t	ranges[ZBX_MOCK_HISTORY_RANGES_MAX];
+	zbx_mock_handle_t	hranges, hrange, hvalues, hrange_values;
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	err = zbx_history_init(&error);
+	zbx_mock_assert_result_eq("zbx_history_init()", SUCCEED, err);
+
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_parameter_string("in['value type']"));
+	hranges = zbx_mock_get_parameter_handle("in.ranges");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hranges, &hrange))
+	{
+		zbx_history_range_t	*range;
+
+		if (ZBX_MOCK_HISTORY_RANGES_MAX == ranges_num)
+			fail_msg("too many item periods");
+
+		range = &ranges[ranges_num++];
+
+		if (FAIL == zbx_is_uint64(zbx_mock_get_object_member_string(hrange, "itemid"), &range->itemid))
+			fail_msg("Invalid itemid value");
+
+		range->start = mock_read_time(hrange, "start");
+		range->end = mock_read_time(hrange, "end");
+		zbx_history_record_vector_create(&range->values);
+	}
+
+	/* the mocked database fails if more queries are made than there are data sources for */
+	err = zbx_history_get_values_multi(value_type, ranges, ranges_num);
+	zbx_mock_assert_result_eq("zbx_history_get_values_multi()", SUCCEED, err);
+
+	hvalues = zbx_mock_get_parameter_handle("out.values");
+
+	for (i = 0; i < ranges_num; i++)
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_vector_element(hvalues, &hrange_values))
+			fail_msg("Missing expected values of item " ZBX_FS_UI64, ranges[i].itemid);
+
+		mock_check_range_values(hrange_values, value_type, &ranges[i]);
+		zbx_history_record_vector_destroy(&ranges[i].values, value_type);
+	}
+
+	zbx_history_destroy();
+
+	zbx_mockdb_destroy();
+}
@@ -27,9 +27,12 @@
 #include "../../src/libs/zbxserver/evalfunc.h"
 
 #include "zbxnum.h"
+#include "zbxmutexs.h"
 
 #include "mocks/valuecache/valuecache_mock.h"
 
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
 int	__wrap_substitute_simple_macros(zbx_uint64_t *actionid, const zbx_db_event *event, const zbx_db_event *r_event,
 		zbx_uint64_t *userid, const zbx_uint64_t *hostid, const DC_HOST *dc_host, const DC_ITEM *dc_item,
 		zbx_db_alert *alert, const zbx_db_acknowledge *ack, const zbx_service_alarm_t *service_alarm,
@@ -73,7 +76,7 @@ int __wrap_DCget_data_expected_from(zbx_uint64_t itemid, int *seconds)
 
 void	zbx_mock_test_entry(void **state)
 {
-	int			err, expected_ret, returned_ret;
+	int			err, expected_ret, returned_ret, i, repeat = 1;
 	char			*error = NULL;
 	const char		*function, *params;
 	DC_ITEM			item;
@@ -85,6 +88,18 @@ void	zbx_mock_test_entry(void **state)
 
 	zbx_update_epsilon_to_float_precision();
 
+	/* functions using value cache aggregates are calculated from aggregates only on repeated evaluation */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.repeat"))
+	{
+		repeat = (int)zbx_mock_get_parameter_uint64("in.repeat");
+
+		/* aggregates are kept only when value cache is enabled */
+		CONFIG_VALUE_CACHE_SIZE = ZBX_MEBIBYTE;
+
+		err = zbx_locks_create(&error);
+		zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, err);
+	}
+
 	err = zbx_vc_init(&error);
 	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
 
@@ -111,13 +126,20 @@ void	zbx_mock_test_entry(void **state)
 	evaluate_item.host = item.host.host;
 	evaluate_item.key_orig = item.key_orig;
 
-	if (SUCCEED != (returned_ret = evaluate_function(&returned_value, &evaluate_item, function, params, &ts, &error)))
+	for (i = 0; i < repeat; i++)
 	{
-		printf("evaluate_function returned error: %s\n", error);
-		zbx_free(error);
-	}
+		if (0 != i)
+			zbx_variant_clear(&returned_value);
 
-	zbx_vc_flush_stats();
+		if (SUCCEED != (returned_ret = evaluate_function(&returned_value, &evaluate_item, function, params,
+				&ts, &error)))
+		{
+			printf("evaluate_function returned error: %s\n", error);
+			zbx_free(error);
+		}
+
+		zbx_vc_flush_stats();
+	}
 
 	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
 	zbx_mock_assert_result_eq("return value", expected_ret, returned_ret);
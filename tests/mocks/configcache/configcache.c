@@ -24,6 +24,8 @@ zbx_mock_config_t	mock_config;
 
 void	*__wrap_zbx_hashset_search(zbx_hashset_t *hs, const void *data);
 void	*__real_zbx_hashset_search(zbx_hashset_t *hs, const void *data);
+void	*__wrap_zbx_flatset_search(const zbx_flatset_t *fs, const void *data);
+void	*__real_zbx_flatset_search(const zbx_flatset_t *fs, const void *data);
 
 void	mock_config_free_user_macros(void);
 void	mock_config_free_hosts(void);
@@ -32,13 +34,6 @@ void	*__wrap_zbx_hashset_search(zbx_hashset_t *hs, const void *data)
 {
 	int	i;
 
-	if (&mock_config.dc.items == hs)
-	{
-		static ZBX_DC_ITEM	item = {.hostid = 1};
-
-		return &item;
-	}
-
 	if (0 != (mock_config.initialized & ZBX_MOCK_CONFIG_USERMACROS))
 	{
 		if (hs == &mock_config.dc.um_cache->hosts)
@@ -97,6 +92,19 @@ void	*__wrap_zbx_hashset_search(zbx_hashset_t *hs, const void *data)
 	return __real_zbx_hashset_search(hs, data);
 }
 
+void	*__wrap_zbx_flatset_search(const zbx_flatset_t *fs, const void *data)
+{
+	if (&mock_config.dc.items == fs)
+	{
+		static ZBX_DC_ITEM	item = {.hostid = 1};
+
+		return &item;
+	}
+
+	/* perform normal flatset lookup for non configuration cache flatsets */
+	return __real_zbx_flatset_search(fs, data);
+}
+
 void	free_string(const char *str)
 {
 	char	*ptr = (char *)str;
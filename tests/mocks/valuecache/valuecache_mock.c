@@ -45,7 +45,7 @@ static zbx_timespec_t	vcmock_ts;
 int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error);
 void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex);
 int	__wrap_zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
-		int allow_oom, char **error);
+		int allow_oom, int flags, char **error);
 void	__wrap_zbx_shmem_destroy(zbx_shmem_info_t *info);
 void	*__wrap___zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size);
 void	*__wrap___zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, void *old, size_t size);
@@ -53,6 +53,7 @@ void	__wrap___zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info,
 void	__wrap_zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info);
 int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
+int	__wrap_zbx_history_get_values_multi(int value_type, zbx_history_range_t *ranges, int ranges_num);
 int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history);
 int	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
 int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
@@ -499,13 +500,14 @@ void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex)
 }
 
 int	__wrap_zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
-		int allow_oom, char **error)
+		int allow_oom, int flags, char **error)
 {
 	*info = vc_meminfo;
 	ZBX_UNUSED(size);
 	ZBX_UNUSED(descr);
 	ZBX_UNUSED(param);
 	ZBX_UNUSED(allow_oom);
+	ZBX_UNUSED(flags);
 	ZBX_UNUSED(error);
 
 	return SUCCEED;
@@ -617,6 +619,19 @@ int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start
 	return SUCCEED;
 }
 
+int	__wrap_zbx_history_get_values_multi(int value_type, zbx_history_range_t *ranges, int ranges_num)
+{
+	int	i;
+
+	for (i = 0; i < ranges_num; i++)
+	{
+		__wrap_zbx_history_get_values(ranges[i].itemid, value_type, ranges[i].start, 0, ranges[i].end,
+				&ranges[i].values);
+	}
+
+	return SUCCEED;
+}
+
 int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history)
 {
 	int			i;
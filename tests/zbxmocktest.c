@@ -85,6 +85,9 @@ zbx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * 0;
 zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * 0;
 zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * 0;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 4 * 0;
+int		CONFIG_TRENDS_FLUSH_SPREAD	= 0;
+char		*CONFIG_HISTORY_SPILL_FILE	= NULL;
+zbx_uint64_t	CONFIG_HISTORY_SPILL_SIZE	= 0;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * 0;
 zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 0;
@@ -186,7 +186,8 @@ final class CHistFunctionData {
 			['rules' => [
 				['type' => 'regexp', 'pattern' => '/^((\d+(\.\d{0,4})?)|(\.\d{1,4}))$/'],
 				['type' => 'number', 'min' => 0, 'max' => 100]
-			]]
+			]],
+			['rules' => [['type' => 'regexp', 'pattern' => '/^(exact|sketch)$/']], 'required' => false]
 		],
 		'rate' => [
 			['rules' => [['type' => 'query']]],
@@ -1862,7 +1862,7 @@ final class CItemData {
 				'value_type' => ITEM_VALUE_TYPE_UINT64
 			],
 			'zabbix[rcache,<cache>,<mode>]' => [
-				'description' => _('Configuration cache statistics. Cache - buffer (modes: pfree, total, used, free).'),
+				'description' => _('Configuration cache statistics. Cache - buffer (modes: pfree, total, used, free), lockwait (mode - process type, seconds spent waiting for cache lock).'),
 				'value_type' => null
 			],
 			'zabbix[requiredperformance]' => [
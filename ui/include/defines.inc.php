@@ -22,7 +22,7 @@ define('ZABBIX_VERSION',		'6.4.0rc1');
 define('ZABBIX_API_VERSION',	'6.4.0');
 define('ZABBIX_EXPORT_VERSION',	'6.4');
 
-define('ZABBIX_DB_VERSION',		6030159);
+define('ZABBIX_DB_VERSION',		6030219);
 
 define('DB_VERSION_SUPPORTED',						0);
 define('DB_VERSION_LOWER_THAN_MINIMUM',				1);